@@ -24,16 +24,116 @@
 #include "../../nCine/Base/Random.h"
 #include "../../nCine/Base/FrameTimer.h"
 
+#include <array>
+
 using namespace Jazz2::Tiles;
 using namespace nCine;
 
 namespace Jazz2::Actors
 {
+#ifndef DOXYGEN_GENERATING_OUTPUT
+	namespace
+	{
+		/** @brief Packed collision mask of a frame placed in world coordinates */
+		struct PackedMaskView
+		{
+			const std::uint64_t* Rows;
+			std::int32_t Stride;
+			std::int32_t Height;
+			std::int32_t OriginX;
+			std::int32_t OriginY;
+		};
+
+		template<std::int32_t Step>
+		constexpr std::array<std::uint64_t, Step> CreateStepPatterns()
+		{
+			std::array<std::uint64_t, Step> patterns{};
+			for (std::int32_t phase = 0; phase < Step; phase++) {
+				for (std::int32_t i = 0; i < 64; i++) {
+					if ((i + phase) % Step == 0) {
+						patterns[phase] |= (1ull << i);
+					}
+				}
+			}
+			return patterns;
+		}
+
+		/** @brief Returns 64 bits of a packed row starting at the specified offset, pixels outside of the row are zero */
+		std::uint64_t ExtractMaskBits(const std::uint64_t* row, std::int32_t stride, std::int32_t offset)
+		{
+			if (offset <= -64 || offset >= stride * 64) {
+				return 0;
+			}
+			if (offset < 0) {
+				return (row[0] << -offset);
+			}
+
+			std::int32_t word = (offset >> 6);
+			std::int32_t shift = (offset & 63);
+			std::uint64_t result = (row[word] >> shift);
+			if (shift != 0 && word + 1 < stride) {
+				result |= (row[word + 1] << (64 - shift));
+			}
+			return result;
+		}
+
+		/**
+		 * @brief Returns `true` if any sampled pixel inside the specified rectangle is set in the first mask and also in the second mask
+		 *
+		 * Only every @p Step-th pixel in both directions is tested to match the original per-pixel sampling. If the second mask
+		 * is not specified, the rectangle is considered to be solid.
+		 */
+		template<std::int32_t Step>
+		bool IsPackedMaskOverlapping(const PackedMaskView& mask1, const PackedMaskView* mask2, std::int32_t x1, std::int32_t y1, std::int32_t x2, std::int32_t y2)
+		{
+			static constexpr std::array<std::uint64_t, Step> StepPatterns = CreateStepPatterns<Step>();
+
+			for (std::int32_t j = y1; j < y2; j += Step) {
+				std::int32_t row1 = j - mask1.OriginY;
+				if (row1 < 0 || row1 >= mask1.Height) {
+					continue;
+				}
+				const std::uint64_t* rowBits1 = &mask1.Rows[row1 * mask1.Stride];
+				const std::uint64_t* rowBits2 = nullptr;
+				if (mask2 != nullptr) {
+					std::int32_t row2 = j - mask2->OriginY;
+					if (row2 < 0 || row2 >= mask2->Height) {
+						continue;
+					}
+					rowBits2 = &mask2->Rows[row2 * mask2->Stride];
+				}
+
+				std::int32_t phase = 0;
+				for (std::int32_t i = x1; i < x2; i += 64) {
+					std::uint64_t bits = StepPatterns[phase];
+					if (x2 - i < 64) {
+						bits &= (1ull << (x2 - i)) - 1;
+					}
+					bits &= ExtractMaskBits(rowBits1, mask1.Stride, i - mask1.OriginX);
+					if (rowBits2 != nullptr) {
+						bits &= ExtractMaskBits(rowBits2, mask2->Stride, i - mask2->OriginX);
+					}
+					if (bits != 0) {
+						return true;
+					}
+					phase = (phase + 64) % Step;
+				}
+			}
+
+			return false;
+		}
+	}
+#endif
+
+#if defined(WITH_THREADS)
+	thread_local SmallVectorImpl<Function<void()>>* ActorBase::_deferredCallbacks = nullptr;
+#endif
+
 	ActorBase::ActorBase()
 		: _state(ActorState::None), _levelHandler(nullptr), _internalForceY(0.0f), _elasticity(0.0f), _friction(1.5f),
 			_unstuckCooldown(0.0f), _frozenTimeLeft(0.0f), _maxHealth(1), _health(1), _spawnFrames(0.0f), _metadata(nullptr),
 			_renderer(this), _currentAnimation(nullptr), _currentTransition(nullptr), _currentTransitionCancellable(false),
-			_collisionProxyID(Collisions::NullNode)
+			_collisionProxyID(Collisions::NullNode), _isUpdatedInParallel(false)
 	{
 	}
 
@@ -856,100 +956,58 @@ namespace Jazz2::Actors
 				return true;
 			}
 
-			//PixelData p;
-			uint8_t* p;
 			GraphicResource* res;
+			std::int32_t frame, x1, y1, x2, y2;
 			bool isFacingLeftCurrent;
-			std::int32_t x1, y1, x2, y2, xs, dx, dy, stride;
+			AABBf* aabbCurrent;
 			if (perPixel1) {
 				res = res1;
-				p = res->Base->Mask.get();
-
+				frame = std::min(_renderer.CurrentFrame, res->FrameCount - 1);
 				isFacingLeftCurrent = GetState(ActorState::IsFacingLeft);
+				aabbCurrent = &aabb1;
 
 				x1 = (std::int32_t)std::max(inter.L, other->AABBInner.L);
 				y1 = (std::int32_t)std::max(inter.T, other->AABBInner.T);
 				x2 = (std::int32_t)std::min(inter.R, other->AABBInner.R);
 				y2 = (std::int32_t)std::min(inter.B, other->AABBInner.B);
-
-				xs = (std::int32_t)aabb1.L;
-
-				std::int32_t frame1 = std::min(_renderer.CurrentFrame, res->FrameCount - 1);
-				dx = (frame1 % res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.X;
-				dy = (frame1 / res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.Y - (std::int32_t)aabb1.T;
-
 			} else {
 				res = res2;
-				p = res->Base->Mask.get();
-
+				frame = std::min(other->_renderer.CurrentFrame, res->FrameCount - 1);
 				isFacingLeftCurrent = other->GetState(ActorState::IsFacingLeft);
+				aabbCurrent = &aabb2;
 
 				x1 = (std::int32_t)std::max(inter.L, AABBInner.L);
 				y1 = (std::int32_t)std::max(inter.T, AABBInner.T);
 				x2 = (std::int32_t)std::min(inter.R, AABBInner.R);
 				y2 = (std::int32_t)std::min(inter.B, AABBInner.B);
-
-				xs = (std::int32_t)aabb2.L;
-
-				std::int32_t frame2 = std::min(other->_renderer.CurrentFrame, res->FrameCount - 1);
-				dx = (frame2 % res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.X;
-				dy = (frame2 / res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.Y - (std::int32_t)aabb2.T;
 			}
 
-			stride = res->Base->FrameConfiguration.X * res->Base->FrameDimensions.X;
+			const std::uint64_t* rows = res->Base->GetPackedMask(frame, isFacingLeftCurrent);
+			if (rows == nullptr) {
+				return false;
+			}
 
 			// Per-pixel collision check
-			for (std::int32_t i = x1; i < x2; i += PerPixelCollisionStep) {
-				for (std::int32_t j = y1; j < y2; j += PerPixelCollisionStep) {
-					std::int32_t i1 = i - xs;
-					if (isFacingLeftCurrent) {
-						i1 = res->Base->FrameDimensions.X - i1 - 1;
-					}
-
-					if (p[((j + dy) * stride) + i1 + dx] > AlphaThreshold) {
-						return true;
-					}
-				}
-			}
+			PackedMaskView mask = { rows, res->Base->PackedMaskStride, res->Base->FrameDimensions.Y, (std::int32_t)aabbCurrent->L, (std::int32_t)aabbCurrent->T };
+			return IsPackedMaskOverlapping<PerPixelCollisionStep>(mask, nullptr, x1, y1, x2, y2);
 		} else {
 			std::int32_t x1 = (std::int32_t)inter.L;
 			std::int32_t y1 = (std::int32_t)inter.T;
 			std::int32_t x2 = (std::int32_t)inter.R;
 			std::int32_t y2 = (std::int32_t)inter.B;
 
-			std::int32_t x1s = (std::int32_t)aabb1.L;
-			std::int32_t x2s = (std::int32_t)aabb2.L;
-
 			std::int32_t frame1 = std::min(_renderer.CurrentFrame, res1->FrameCount - 1);
-			std::int32_t dx1 = (frame1 % res1->Base->FrameConfiguration.X) * res1->Base->FrameDimensions.X;
-			std::int32_t dy1 = (frame1 / res1->Base->FrameConfiguration.X) * res1->Base->FrameDimensions.Y - (std::int32_t)aabb1.T;
-			std::int32_t stride1 = res1->Base->FrameConfiguration.X * res1->Base->FrameDimensions.X;
-
 			std::int32_t frame2 = std::min(other->_renderer.CurrentFrame, res2->FrameCount - 1);
-			std::int32_t dx2 = (frame2 % res2->Base->FrameConfiguration.X) * res2->Base->FrameDimensions.X;
-			std::int32_t dy2 = (frame2 / res2->Base->FrameConfiguration.X) * res2->Base->FrameDimensions.Y - (std::int32_t)aabb2.T;
-			std::int32_t stride2 = res2->Base->FrameConfiguration.X * res2->Base->FrameDimensions.X;
+			const std::uint64_t* rows1 = res1->Base->GetPackedMask(frame1, GetState(ActorState::IsFacingLeft));
+			const std::uint64_t* rows2 = res2->Base->GetPackedMask(frame2, other->GetState(ActorState::IsFacingLeft));
+			if (rows1 == nullptr || rows2 == nullptr) {
+				return false;
+			}
 
 			// Per-pixel collision check
-			auto p1 = res1->Base->Mask.get();
-			auto p2 = res2->Base->Mask.get();
-
-			for (std::int32_t i = x1; i < x2; i += PerPixelCollisionStep) {
-				for (std::int32_t j = y1; j < y2; j += PerPixelCollisionStep) {
-					std::int32_t i1 = i - x1s;
-					if (GetState(ActorState::IsFacingLeft)) {
-						i1 = res1->Base->FrameDimensions.X - i1 - 1;
-					}
-					std::int32_t i2 = i - x2s;
-					if (other->GetState(ActorState::IsFacingLeft)) {
-						i2 = res2->Base->FrameDimensions.X - i2 - 1;
-					}
-
-					if (p1[((j + dy1) * stride1) + i1 + dx1] > AlphaThreshold && p2[((j + dy2) * stride2) + i2 + dx2] > AlphaThreshold) {
-						return true;
-					}
-				}
-			}
+			PackedMaskView mask1 = { rows1, res1->Base->PackedMaskStride, res1->Base->FrameDimensions.Y, (std::int32_t)aabb1.L, (std::int32_t)aabb1.T };
+			PackedMaskView mask2 = { rows2, res2->Base->PackedMaskStride, res2->Base->FrameDimensions.Y, (std::int32_t)aabb2.L, (std::int32_t)aabb2.T };
+			return IsPackedMaskOverlapping<PerPixelCollisionStep>(mask1, &mask2, x1, y1, x2, y2);
 		}
 
 		return false;
@@ -994,30 +1052,15 @@ namespace Jazz2::Actors
 		std::int32_t x2 = (std::int32_t)std::min(inter.R, aabb.R);
 		std::int32_t y2 = (std::int32_t)std::min(inter.B, aabb.B);
 
-		std::int32_t xs = (std::int32_t)aabbSelf.L;
-
-		std::int32_t frame1 = std::min(_renderer.CurrentFrame, res->FrameCount - 1);
-		std::int32_t dx = (frame1 % res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.X;
-		std::int32_t dy = (frame1 / res->Base->FrameConfiguration.X) * res->Base->FrameDimensions.Y - (int)aabbSelf.T;
-		std::int32_t stride = res->Base->FrameConfiguration.X * res->Base->FrameDimensions.X;
-
-		// Per-pixel collision check
-		auto p = res->Base->Mask.get();
-
-		for (std::int32_t i = x1; i < x2; i += PerPixelCollisionStep) {
-			for (std::int32_t j = y1; j < y2; j += PerPixelCollisionStep) {
-				std::int32_t i1 = i - xs;
-				if (GetState(ActorState::IsFacingLeft)) {
-					i1 = res->Base->FrameDimensions.X - i1 - 1;
-				}
-
-				if (p[((j + dy) * stride) + i1 + dx] > AlphaThreshold) {
-					return true;
-				}
-			}
+		std::int32_t frame = std::min(_renderer.CurrentFrame, res->FrameCount - 1);
+		const std::uint64_t* rows = res->Base->GetPackedMask(frame, GetState(ActorState::IsFacingLeft));
+		if (rows == nullptr) {
+			return false;
 		}
 
-		return false;
+		// Per-pixel collision check
+		PackedMaskView mask = { rows, res->Base->PackedMaskStride, res->Base->FrameDimensions.Y, (std::int32_t)aabbSelf.L, (std::int32_t)aabbSelf.T };
+		return IsPackedMaskOverlapping<PerPixelCollisionStep>(mask, nullptr, x1, y1, x2, y2);
 	}
 
 	bool ActorBase::IsCollidingWithAngled(ActorBase* other)
@@ -1287,7 +1330,13 @@ namespace Jazz2::Actors
 		_metadata = ContentResolver::Get().RequestMetadata(path);
 	}
 	
-#if !defined(WITH_COROUTINES)
+#if defined(WITH_COROUTINES)
+	std::suspend_never ActorBase::RequestMetadataAsync(StringView path)
+	{
+		_metadata = ContentResolver::Get().RequestMetadata(path);
+		return {};
+	}
+#else
 	void ActorBase::RequestMetadataAsync(StringView path)
 	{
 		_metadata = ContentResolver::Get().RequestMetadata(path);
@@ -1397,6 +1446,17 @@ namespace Jazz2::Actors
 		return free;
 	}
 
+	void ActorBase::Defer(Function<void()>&& callback)
+	{
+#if defined(WITH_THREADS)
+		if (_deferredCallbacks != nullptr) {
+			_deferredCallbacks->push_back(std::move(callback));
+			return;
+		}
+#endif
+		callback();
+	}
+
 	void ActorBase::AddExternalForce(float x, float y)
 	{
 		_externalForce.X += x;
@@ -1452,7 +1512,12 @@ namespace Jazz2::Actors
 
 	void ActorBase::ActorRenderer::OnUpdate(float timeMult)
 	{
-		_owner->OnUpdate(timeMult);
+		if (_owner->_isUpdatedInParallel) {
+			// Already updated on a worker thread in this frame
+			_owner->_isUpdatedInParallel = false;
+		} else {
+			_owner->OnUpdate(timeMult);
+		}
 
 		Vector2f pos = _owner->_pos;
 		if (!PreferencesCache::UnalignedViewport || (_owner->_state & ActorState::IsDirty) != ActorState::IsDirty) {
@@ -87,7 +87,8 @@ namespace Jazz2::Actors
 		/** @brief Actor is facing left */
 		IsFacingLeft = 0x1000,
 
-		//Reserved = 0x2000,
+		/** @brief Actor can be updated on a worker thread before other actors, side effects must be executed through @ref ActorBase::Defer() */
+		UpdateInParallel = 0x2000,
 
 		/** @brief Actor should be preserved when state is rolled back to checkpoint */
 		PreserveOnRollback = 0x4000,
@@ -310,7 +311,7 @@ namespace Jazz2::Actors
 		/** @{ @name Constants */
 
 		/** @brief Alpha transparency threshold */
-		static constexpr std::uint8_t AlphaThreshold = 40;
+		static constexpr std::uint8_t AlphaThreshold = GenericGraphicResource::AlphaThreshold;
 		/** @brief Step for collision checking */
 		static constexpr float CollisionCheckStep = 0.5f;
 		/** @brief Step for per-pixel collisions */
@@ -426,31 +427,26 @@ namespace Jazz2::Actors
 		/** @brief Loads specified metadata and its linked assets */
 		void RequestMetadata(StringView path);
 
-		/** @brief Loads specified metadata and its linked assets asynchronously if supported */
+		/**
+		 * @brief Loads specified metadata and its linked assets
+		 *
+		 * The coroutine is never suspended, because callers expect metadata to be available right after
+		 * activation. Use @ref PreloadMetadataAsync() to load assets in background instead.
+		 */
 #if defined(WITH_COROUTINES)
-		auto RequestMetadataAsync(StringView path)
-		{
-			struct awaitable {
-				ActorBase* actor;
-				const StringView& path;
-
-				bool await_ready() {
-					return false;
-				}
-				void await_suspend(std::coroutine_handle<> handle) {
-					// TODO: implement async
-					auto metadata = ContentResolver::Get().RequestMetadata(path);
-					actor->_metadata = metadata;
-					handle();
-				}
-				void await_resume() { }
-			};
-			return awaitable{this, path};
-		}
+		std::suspend_never RequestMetadataAsync(StringView path);
 #else
 		void RequestMetadataAsync(StringView path);
 #endif
 
+		/**
+		 * @brief Executes the callback on the main thread
+		 *
+		 * If the actor is updated on a worker thread, the callback is deferred until all actors are updated, then
+		 * deferred callbacks are executed in a stable order. Otherwise, the callback is executed immediately.
+		 */
+		void Defer(Function<void()>&& callback);
+
 		/** @brief Sets actor state */
 		constexpr void SetState(ActorState flags) noexcept {
 			_state = flags;
@@ -472,6 +468,11 @@ namespace Jazz2::Actors
 		std::int32_t _collisionProxyID;
 		ActorState _state;
 		Function<void()> _currentTransitionCallback;
+		bool _isUpdatedInParallel;
+
+#if defined(WITH_THREADS)
+		static thread_local SmallVectorImpl<Function<void()>>* _deferredCallbacks;
+#endif
 
 		bool IsCollidingWithAngled(ActorBase* other);
 		bool IsCollidingWithAngled(const AABBf& aabb);
@@ -21,7 +21,7 @@ namespace Jazz2::Actors::Collectibles
 	{
 		_elasticity = 0.6f;
 
-		SetState(ActorState::SkipPerPixelCollisions, true);
+		SetState(ActorState::SkipPerPixelCollisions | ActorState::UpdateInParallel, true);
 
 		Vector2f pos = _pos;
 		_phase = ((pos.X / 32) + (pos.Y / 32)) * 2.0f;
@@ -66,8 +66,10 @@ namespace Jazz2::Actors::Collectibles
 		} else if (_timeLeft > 0.0f) {
 			_timeLeft -= timeMult;
 			if (_timeLeft <= 0.0f) {
-				Explosion::Create(_levelHandler, Vector3i((std::int32_t)_pos.X, (std::int32_t)_pos.Y, _renderer.layer()), Explosion::Type::Generator);
-				DecreaseHealth(INT32_MAX);
+				Defer([this]() {
+					Explosion::Create(_levelHandler, Vector3i((std::int32_t)_pos.X, (std::int32_t)_pos.Y, _renderer.layer()), Explosion::Type::Generator);
+					DecreaseHealth(INT32_MAX);
+				});
 			}
 		}
 
@@ -55,7 +55,9 @@ namespace Jazz2::Actors::Collectibles
 	{
 		if (_collected) {
 			if (_collectedPhase > 100.0f) {
-				DecreaseHealth(INT32_MAX);
+				Defer([this]() {
+					DecreaseHealth(INT32_MAX);
+				});
 				return;
 			}
 
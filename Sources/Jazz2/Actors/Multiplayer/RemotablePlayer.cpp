@@ -9,7 +9,7 @@
 namespace Jazz2::Actors::Multiplayer
 {
 	RemotablePlayer::RemotablePlayer(std::shared_ptr<PeerDescriptor> peerDesc)
-		: ChangingWeaponFromServer(false), RespawnPending(false), _warpPending(false)
+		: ChangingWeaponFromServer(false), RespawnPending(false), _warpPending(false), _isReplaying(false), _pendingCorrection(Vector2f::Zero)
 	{
 		_peerDesc = std::move(peerDesc);
 		_peerDesc->Player = this;
@@ -29,11 +29,49 @@ namespace Jazz2::Actors::Multiplayer
 	{
 		Player::OnUpdate(timeMult);
 
+		if (_pendingCorrection != Vector2f::Zero) {
+			Vector2f step = _pendingCorrection * std::min(CorrectionRate * timeMult, 1.0f);
+			if (step.SqrLength() < 0.01f) {
+				step = _pendingCorrection;
+			}
+			MoveInstantly(step, MoveType::Relative | MoveType::Force);
+			_pendingCorrection -= step;
+		}
+
 		if (_levelExiting != LevelExitingState::None) {
 			OnLevelChanging(nullptr, ExitType::None);
 		}
 	}
 
+	void RemotablePlayer::OnHitFloor(float timeMult)
+	{
+		if (_isReplaying) {
+			// Side effects were already handled when the input frame was applied for the first time
+			return;
+		}
+
+		MpPlayer::OnHitFloor(timeMult);
+	}
+
+	void RemotablePlayer::OnHitCeiling(float timeMult)
+	{
+		if (_isReplaying) {
+			return;
+		}
+
+		MpPlayer::OnHitCeiling(timeMult);
+	}
+
+	void RemotablePlayer::OnHitWall(float timeMult)
+	{
+		if (_isReplaying) {
+			_speed.X = 0.0f;
+			return;
+		}
+
+		MpPlayer::OnHitWall(timeMult);
+	}
+
 	void RemotablePlayer::OnWaterSplash(Vector2f pos, bool inwards)
 	{
 		// Already created and broadcasted by the server
@@ -121,6 +159,64 @@ namespace Jazz2::Actors::Multiplayer
 		}
 	}
 
+	void RemotablePlayer::ReconcileWithServer(Vector2f pos, Vector2f speed)
+	{
+		Vector2f error = pos - _pos;
+		if (_warpPending || error.SqrLength() > MaxSmoothedCorrection * MaxSmoothedCorrection) {
+			_pendingCorrection = Vector2f::Zero;
+			MoveRemotely(pos, speed);
+			return;
+		}
+
+		// Small errors are corrected smoothly, so the player doesn't visibly snap
+		_pendingCorrection = error;
+		_speed = speed;
+	}
+
+	void RemotablePlayer::ReplayInput(std::uint64_t pressedActions, float timeMult)
+	{
+		// Only movement is replayed, everything else (e.g., jumping, firing, events) was already handled when the input frame
+		// was applied for the first time and the server state includes it, so only simplified horizontal movement is used,
+		// it's accurate only while the player is walking on the ground, so MpLevelHandler doesn't rely on it in the air
+		bool canWalk = (_controllable && _controllableExternal && _health > 0 && _keepRunningTime <= 0.0f && !_isLifting &&
+			_suspendType == SuspendType::None && _currentSpecialMove == SpecialMoveType::None && _dizzyTime <= 0.0f && _playerType != PlayerType::Frog);
+
+		if (canWalk) {
+			float playerMovement = 0.0f;
+			if ((pressedActions & (1ull << (std::int32_t)PlayerAction::Left)) != 0) {
+				playerMovement = -1.0f;
+			} else if ((pressedActions & (1ull << (std::int32_t)PlayerAction::Right)) != 0) {
+				playerMovement = 1.0f;
+			}
+
+			if (playerMovement != 0.0f) {
+				float maxSpeed;
+				if (_inShallowWater != -1 && _levelHandler->IsReforged() && _playerType != PlayerType::Lori) {
+					maxSpeed = MaxShallowWaterSpeed;
+				} else if (!_inWater && (pressedActions & (1ull << (std::int32_t)PlayerAction::Run)) != 0) {
+					maxSpeed = MaxDashingSpeed;
+				} else {
+					maxSpeed = MaxRunningSpeed;
+				}
+
+				float acceleration = (_levelHandler->IsReforged() ? Acceleration : Acceleration * 2.0f);
+				_speed.X = std::clamp(_speed.X + acceleration * timeMult * playerMovement, -maxSpeed, maxSpeed);
+			} else if (_inTubeTime <= 0.0f) {
+				_speed.X = std::max((std::abs(_speed.X) - Deceleration * timeMult), 0.0f) * (_speed.X < 0.0f ? -1.0f : 1.0f);
+			}
+		}
+
+		_isReplaying = true;
+		Tiles::TileCollisionParams params = { Tiles::TileDestructType::None, _speed.Y >= 0.0f };
+		TryStandardMovement(timeMult, params);
+		_isReplaying = false;
+	}
+
+	bool RemotablePlayer::IsWarpPending() const
+	{
+		return _warpPending;
+	}
+
 	bool RemotablePlayer::Respawn(Vector2f pos)
 	{
 		bool success = MpPlayer::Respawn(pos);
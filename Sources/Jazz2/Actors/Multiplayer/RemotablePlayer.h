@@ -27,6 +27,12 @@ namespace Jazz2::Actors::Multiplayer
 		void WarpIn(ExitType exitType);
 		/** @brief Moves the player remotely */
 		void MoveRemotely(Vector2f pos, Vector2f speed);
+		/** @brief Corrects the predicted state to the state reconciled with the server */
+		void ReconcileWithServer(Vector2f pos, Vector2f speed);
+		/** @brief Replays movement of already applied input frame during reconciliation */
+		void ReplayInput(std::uint64_t pressedActions, float timeMult);
+		/** @brief Returns `true` if the player is waiting for the server to finish warping */
+		bool IsWarpPending() const;
 
 		bool Respawn(Vector2f pos) override;
 
@@ -35,13 +41,23 @@ namespace Jazz2::Actors::Multiplayer
 		bool OnPerish(ActorBase* collider) override;
 		void OnUpdate(float timeMult) override;
 
+		void OnHitFloor(float timeMult) override;
+		void OnHitCeiling(float timeMult) override;
+		void OnHitWall(float timeMult) override;
 		void OnWaterSplash(Vector2f pos, bool inwards) override;
 
 		bool FireCurrentWeapon(WeaponType weaponType) override;
 		void SetCurrentWeapon(WeaponType weaponType, SetCurrentWeaponReason reason) override;
 
 	private:
+		// Corrections smaller than this are applied over several frames instead of snapping (in pixels)
+		static constexpr float MaxSmoothedCorrection = 48.0f;
+		// Portion of the remaining correction applied per frame
+		static constexpr float CorrectionRate = 0.2f;
+
 		bool _warpPending;
+		bool _isReplaying;
+		Vector2f _pendingCorrection;
 	};
 }
 
@@ -2,12 +2,14 @@
 
 #if defined(WITH_MULTIPLAYER)
 
+#include "../../Multiplayer/MpLevelHandler.h"
+
 #include "../../../nCine/Base/Clock.h"
 
 namespace Jazz2::Actors::Multiplayer
 {
 	RemoteActor::RemoteActor()
-		: _stateBufferPos(0), _lastAnim(AnimState::Idle), _isAttachedLocally(false)
+		: _stateBufferPos(0), _lastUpdateId(0), _lastAnim(AnimState::Idle), _isAttachedLocally(false), _isExtrapolating(false)
 	{
 	}
 
@@ -31,7 +33,7 @@ namespace Jazz2::Actors::Multiplayer
 		if (!_isAttachedLocally) {
 			Clock& c = nCine::clock();
 			std::int64_t now = c.now() * 1000 / c.frequency();
-			std::int64_t renderTime = now - ServerDelay;
+			std::int64_t renderTime = now - GetRenderDelay();
 
 			std::int32_t nextIdx = _stateBufferPos - 1;
 			if (nextIdx < 0) {
@@ -39,6 +41,8 @@ namespace Jazz2::Actors::Multiplayer
 			}
 
 			if (renderTime <= _stateBuffer[nextIdx].Time) {
+				_isExtrapolating = false;
+
 				std::int32_t prevIdx;
 				while (true) {
 					prevIdx = nextIdx - 1;
@@ -62,6 +66,33 @@ namespace Jazz2::Actors::Multiplayer
 					pos = _stateBuffer[nextIdx].Pos;
 				}
 
+				MoveInstantly(pos, MoveType::Absolute | MoveType::Force);
+			} else if (_renderer.isDrawEnabled() && IsRelevant()) {
+				// No newer state was received in time, continue in the last known direction for a while
+				// Actors out of relevancy are not updated by the server anymore, so they just stay in place
+				auto* levelHandler = static_cast<Jazz2::Multiplayer::MpLevelHandler*>(_levelHandler);
+				if (!_isExtrapolating) {
+					_isExtrapolating = true;
+					levelHandler->HandleRemoteActorUnderrun();
+				}
+
+				std::int32_t prevIdx = nextIdx - 1;
+				if (prevIdx < 0) {
+					prevIdx += std::int32_t(arraySize(_stateBuffer));
+				}
+
+				std::int64_t extrapolationTime = renderTime - _stateBuffer[nextIdx].Time;
+				if (extrapolationTime > MaxExtrapolationTime) {
+					extrapolationTime = MaxExtrapolationTime;
+					levelHandler->HandleRemoteActorStalled();
+				}
+
+				Vector2f pos = _stateBuffer[nextIdx].Pos;
+				std::int64_t timeRange = (_stateBuffer[nextIdx].Time - _stateBuffer[prevIdx].Time);
+				if (timeRange > 0) {
+					pos += (_stateBuffer[nextIdx].Pos - _stateBuffer[prevIdx].Pos) * ((float)extrapolationTime / timeRange);
+				}
+
 				MoveInstantly(pos, MoveType::Absolute | MoveType::Force);
 			}
 		}
@@ -79,6 +110,16 @@ namespace Jazz2::Actors::Multiplayer
 		_isAttachedLocally = false;
 	}
 
+	std::int64_t RemoteActor::GetRenderDelay() const
+	{
+		return static_cast<Jazz2::Multiplayer::MpLevelHandler*>(_levelHandler)->GetRemoteActorRenderDelay();
+	}
+
+	bool RemoteActor::IsRelevant() const
+	{
+		return static_cast<Jazz2::Multiplayer::MpLevelHandler*>(_levelHandler)->IsRemoteActorRelevant(_lastUpdateId);
+	}
+
 	void RemoteActor::AssignMetadata(std::uint8_t flags, ActorState state, StringView path, AnimState anim, float rotation, float scaleX, float scaleY, ActorRendererType rendererType)
 	{
 		constexpr ActorState RemotedFlags = ActorState::Illuminated | ActorState::IsInvulnerable |
@@ -100,18 +141,18 @@ namespace Jazz2::Actors::Multiplayer
 		Clock& c = nCine::clock();
 		std::int64_t now = c.now() * 1000 / c.frequency();
 
-		if (_renderer.isDrawEnabled()) {
-			// Actor is still visible, enable interpolation
+		if (_renderer.isDrawEnabled() && IsRelevant()) {
+			// Actor is still visible and it was included in the previous update, enable interpolation
 			_stateBuffer[_stateBufferPos].Time = now;
 			_stateBuffer[_stateBufferPos].Pos = pos;
 		} else {
-			// Actor was hidden before, reset state buffer to disable interpolation
+			// Actor was hidden or out of relevancy before, reset state buffer to disable interpolation
 			std::int32_t stateBufferPrevPos = _stateBufferPos - 1;
 			if (stateBufferPrevPos < 0) {
 				stateBufferPrevPos += std::int32_t(arraySize(_stateBuffer));
 			}
 
-			std::int64_t renderTime = now - ServerDelay;
+			std::int64_t renderTime = now - GetRenderDelay();
 
 			_stateBuffer[stateBufferPrevPos].Time = renderTime;
 			_stateBuffer[stateBufferPrevPos].Pos = pos;
@@ -162,6 +203,12 @@ namespace Jazz2::Actors::Multiplayer
 			}
 		}
 	}
+
+	void RemoteActor::SyncRelevancyWithServer(std::uint32_t updateId)
+	{
+		// Must be called after the position is synchronized, the previous update ID is checked there
+		_lastUpdateId = updateId;
+	}
 }
 
 #endif
\ No newline at end of file
@@ -18,6 +18,7 @@ namespace Jazz2::Actors::Multiplayer
 		void SyncPositionWithServer(Vector2f pos);
 		void SyncAnimationWithServer(AnimState anim, float rotation, float scaleX, float scaleY, Actors::ActorRendererType rendererType);
 		void SyncMiscWithServer(std::uint8_t flags);
+		void SyncRelevancyWithServer(std::uint32_t updateId);
 
 	protected:
 #ifndef DOXYGEN_GENERATING_OUTPUT
@@ -26,18 +27,25 @@ namespace Jazz2::Actors::Multiplayer
 			Vector2f Pos;
 		};
 
-		static constexpr std::int64_t ServerDelay = 64;
+		// Movement is extrapolated for at most this time if no newer state was received (in milliseconds)
+		static constexpr std::int64_t MaxExtrapolationTime = 100;
 
-		StateFrame _stateBuffer[8];
+		StateFrame _stateBuffer[16];
 		std::int32_t _stateBufferPos;
+		std::uint32_t _lastUpdateId;
 		AnimState _lastAnim;
 		bool _isAttachedLocally;
+		bool _isExtrapolating;
 #endif
 
 		Task<bool> OnActivatedAsync(const ActorActivationDetails& details) override;
 		void OnUpdate(float timeMult) override;
 		void OnAttach(ActorBase* parent) override;
 		void OnDetach(ActorBase* parent) override;
+
+	private:
+		std::int64_t GetRenderDelay() const;
+		bool IsRelevant() const;
 	};
 }
 
@@ -4,70 +4,17 @@
 
 #include "../Weapons/ShotBase.h"
 #include "../../Multiplayer/MpLevelHandler.h"
-#include "../../../nCine/Base/Clock.h"
 
 namespace Jazz2::Actors::Multiplayer
 {
 	RemotePlayerOnServer::RemotePlayerOnServer(std::shared_ptr<PeerDescriptor> peerDesc)
-		: _stateBufferPos(0), Flags(PlayerFlags::None), PressedKeys(0),
-			PressedKeysLast(0), UpdatedFrame(0)
+		: Flags(PlayerFlags::None), PressedKeys(0), PressedKeysLast(0), UpdatedFrame(0),
+			_queuedInputsFirst(0), _queuedInputsCount(0), _lastQueuedInputSeqNum(0), _inputTimeLeft(0.0f)
 	{
 		_peerDesc = std::move(peerDesc);
 		_peerDesc->Player = this;
 	}
 
-	Task<bool> RemotePlayerOnServer::OnActivatedAsync(const ActorActivationDetails& details)
-	{
-		Clock& c = nCine::clock();
-		std::uint64_t now = c.now() * 1000 / c.frequency();
-		for (std::int32_t i = 0; i < std::int32_t(arraySize(_stateBuffer)); i++) {
-			_stateBuffer[i].Time = now - arraySize(_stateBuffer) + i;
-			_stateBuffer[i].Pos = Vector2f(details.Pos.X, details.Pos.Y);
-		}
-
-		async_return async_await PlayerOnServer::OnActivatedAsync(details);
-	}
-
-	void RemotePlayerOnServer::OnUpdate(float timeMult)
-	{
-		Clock& c = nCine::clock();
-		std::int64_t now = c.now() * 1000 / c.frequency();
-		std::int64_t renderTime = now - ServerDelay;
-
-		std::int32_t nextIdx = _stateBufferPos - 1;
-		if (nextIdx < 0) {
-			nextIdx += std::int32_t(arraySize(_stateBuffer));
-		}
-
-		if (renderTime <= _stateBuffer[nextIdx].Time) {
-			std::int32_t prevIdx;
-			while (true) {
-				prevIdx = nextIdx - 1;
-				if (prevIdx < 0) {
-					prevIdx += std::int32_t(arraySize(_stateBuffer));
-				}
-
-				if (prevIdx == _stateBufferPos || _stateBuffer[prevIdx].Time <= renderTime) {
-					break;
-				}
-
-				nextIdx = prevIdx;
-			}
-
-			std::int64_t timeRange = (_stateBuffer[nextIdx].Time - _stateBuffer[prevIdx].Time);
-			if (timeRange > 0) {
-				float lerp = (float)(renderTime - _stateBuffer[prevIdx].Time) / timeRange;
-				_displayPos = _stateBuffer[prevIdx].Pos + (_stateBuffer[nextIdx].Pos - _stateBuffer[prevIdx].Pos) * lerp;
-			} else {
-				_displayPos = _stateBuffer[nextIdx].Pos;
-			}
-		}
-
-		PlayerOnServer::OnUpdate(timeMult);
-
-		_renderer.setPosition(_displayPos);
-	}
-
 	bool RemotePlayerOnServer::IsLedgeClimbAllowed() const
 	{
 		return (_peerDesc->EnableLedgeClimb && PlayerOnServer::IsLedgeClimbAllowed());
@@ -98,62 +45,64 @@ namespace Jazz2::Actors::Multiplayer
 		return PlayerCarryOver{};
 	}
 
-	void RemotePlayerOnServer::SyncWithServer(Vector2f pos, Vector2f speed, bool isVisible, bool isFacingLeft, bool isActivelyPushing)
+	void RemotePlayerOnServer::QueueInput(std::uint32_t seqNum, std::uint64_t pressedKeys, float timeMult)
 	{
-		if (_health <= 0) {
-			// Don't sync dead players to avoid cheating
+		std::unique_lock lock(_queuedInputsLock);
+
+		if (seqNum <= _lastQueuedInputSeqNum) {
 			return;
 		}
 
-		Clock& c = nCine::clock();
-		std::int64_t now = c.now() * 1000 / c.frequency();
-
-		bool wasVisible = _renderer.isDrawEnabled();
-		// Visibility is not synced from the client, becuase it should be already almost in sync on the server
-		//_renderer.setDrawEnabled(isVisible);
-		SetFacingLeft(isFacingLeft);
-		_isActivelyPushing = isActivelyPushing;
-
-		if (wasVisible) {
-			// Actor is still visible, enable interpolation
-			_stateBuffer[_stateBufferPos].Time = now;
-			_stateBuffer[_stateBufferPos].Pos = pos;
-		} else {
-			// Actor was hidden before, reset state buffer to disable interpolation
-			std::int32_t stateBufferPrevPos = _stateBufferPos - 1;
-			if (stateBufferPrevPos < 0) {
-				stateBufferPrevPos += std::int32_t(arraySize(_stateBuffer));
-			}
+		if (_queuedInputsCount >= MaxQueuedInputs) {
+			// The client is too far ahead, drop the oldest input frame
+			_queuedInputsFirst = (_queuedInputsFirst + 1) % MaxQueuedInputs;
+			_queuedInputsCount--;
+		}
 
-			std::int64_t renderTime = now - ServerDelay;
+		auto& frame = _queuedInputs[(_queuedInputsFirst + _queuedInputsCount) % MaxQueuedInputs];
+		frame.SeqNum = seqNum;
+		frame.PressedKeys = pressedKeys;
+		frame.TimeMult = timeMult;
+		_queuedInputsCount++;
+		_lastQueuedInputSeqNum = seqNum;
+	}
 
-			_stateBuffer[stateBufferPrevPos].Time = renderTime;
-			_stateBuffer[stateBufferPrevPos].Pos = pos;
-			_stateBuffer[_stateBufferPos].Time = renderTime;
-			_stateBuffer[_stateBufferPos].Pos = pos;
-		}
+	void RemotePlayerOnServer::ApplyQueuedInputs(float timeMult)
+	{
+		std::unique_lock lock(_queuedInputsLock);
+
+		PressedKeysLast = PressedKeys;
 
-		_stateBufferPos++;
-		if (_stateBufferPos >= std::int32_t(arraySize(_stateBuffer))) {
-			_stateBufferPos = 0;
+		if (_queuedInputsCount == 0) {
+			// Keys are held until next input frame arrives, but the time is not accumulated to avoid bursts later
+			_inputTimeLeft = std::min(_inputTimeLeft + timeMult, timeMult);
+			return;
 		}
 
-		// TODO: Set actual pos and speed to the newest value
-		_pos = pos;
-		_speed = speed;
-	}
+		// The client can run with different frame rate, so more (or less) than one input frame can be applied in one frame,
+		// keys pressed in any of them are merged, so short key presses are not lost
+		_inputTimeLeft += timeMult;
+
+		std::uint64_t pressedKeys = 0;
+		bool applied = false;
+		while (_queuedInputsCount > 0) {
+			auto& frame = _queuedInputs[_queuedInputsFirst];
+			// Half of the frame is tolerated, because frame times of the client and the server are never exactly the same
+			if (_inputTimeLeft < frame.TimeMult * 0.5f && _queuedInputsCount <= MaxBufferedInputs) {
+				break;
+			}
 
-	void RemotePlayerOnServer::ForceResyncWithServer(Vector2f pos, Vector2f speed)
-	{
-		Clock& c = nCine::clock();
-		std::int64_t now = c.now() * 1000 / c.frequency();
+			_inputTimeLeft -= frame.TimeMult;
+			pressedKeys |= frame.PressedKeys;
+			_peerDesc->LastInputSeqNum = frame.SeqNum;
+			applied = true;
 
-		_pos = pos;
-		_speed = speed;
+			_queuedInputsFirst = (_queuedInputsFirst + 1) % MaxQueuedInputs;
+			_queuedInputsCount--;
+		}
 
-		for (std::size_t i = 0; i < arraySize(_stateBuffer); i++) {
-			_stateBuffer[i].Time = now;
-			_stateBuffer[i].Pos = pos;
+		if (applied) {
+			PressedKeys = pressedKeys;
 		}
 	}
 
@@ -4,6 +4,8 @@
 
 #include "PlayerOnServer.h"
 
+#include <Threading/Spinlock.h>
+
 namespace Jazz2::Actors::Multiplayer
 {
 	/** @brief Remote player in online session */
@@ -63,29 +65,32 @@ namespace Jazz2::Actors::Multiplayer
 		void EmitWeaponFlare() override;
 		void SetCurrentWeapon(WeaponType weaponType, SetCurrentWeaponReason reason) override;
 
-		/** @brief Synchronizes the player with server */
-		void SyncWithServer(Vector2f pos, Vector2f speed, bool isVisible, bool isFacingLeft, bool isActivelyPushing);
-
-		/** @brief Forcefully resynchronizes the player with server (e.g., after respawning or warping) */
-		void ForceResyncWithServer(Vector2f pos, Vector2f speed);
+		/** @brief Queues input frame received from the client, frames that were already queued are ignored */
+		void QueueInput(std::uint32_t seqNum, std::uint64_t pressedKeys, float timeMult);
+		/** @brief Applies queued input frames at the same rate as they were produced by the client */
+		void ApplyQueuedInputs(float timeMult);
 
 	protected:
 #ifndef DOXYGEN_GENERATING_OUTPUT
-		struct StateFrame {
-			std::int64_t Time;
-			Vector2f Pos;
+		struct InputFrame {
+			std::uint32_t SeqNum;
+			std::uint64_t PressedKeys;
+			float TimeMult;
 		};
 
-		static constexpr std::int64_t ServerDelay = 64;
-
-		StateFrame _stateBuffer[8];
-		std::int32_t _stateBufferPos;
-		Vector2f _displayPos;
+		// Maximum number of input frames waiting to be applied (~0.5 seconds)
+		static constexpr std::uint32_t MaxQueuedInputs = 32;
+		// Input frames are applied faster if more of them are waiting (e.g., after a lag spike)
+		static constexpr std::uint32_t MaxBufferedInputs = 8;
+
+		InputFrame _queuedInputs[MaxQueuedInputs];
+		std::uint32_t _queuedInputsFirst;
+		std::uint32_t _queuedInputsCount;
+		std::uint32_t _lastQueuedInputSeqNum;
+		float _inputTimeLeft;
+		Threading::Spinlock _queuedInputsLock;
 #endif
 
-		Task<bool> OnActivatedAsync(const ActorActivationDetails& details) override;
-		void OnUpdate(float timeMult) override;
-
 		void OnHitSpring(Vector2f pos, Vector2f force, bool keepSpeedX, bool keepSpeedY, bool& removeSpecialMove) override;
 	};
 }
@@ -35,6 +35,8 @@ namespace Jazz2::Collisions
 		_moveCapacity = DefaultMoveCapacity;
 		_moveCount = 0;
 		_moveBuffer = new std::int32_t[_moveCapacity];
+
+		_pairUpdate = 0;
 	}
 
 	DynamicTreeBroadPhase::~DynamicTreeBroadPhase()
@@ -54,17 +56,19 @@ namespace Jazz2::Collisions
 	void DynamicTreeBroadPhase::DestroyProxy(std::int32_t proxyId)
 	{
 		UnBufferMove(proxyId);
+		RemoveProxyPairs(proxyId);
 		--_proxyCount;
 		_tree.DestroyProxy(proxyId);
 	}
 
 	void DynamicTreeBroadPhase::MoveProxy(std::int32_t proxyId, const AABBf& aabb, Vector2f displacement)
 	{
-		// NOTE: Touch proxy everytime, because it's called only when something changes
-		/*bool buffer =*/ _tree.MoveProxy(proxyId, aabb, displacement);
-		//if (buffer) {
+		// It's called only when something changes, but pairs must be queried again only if the fat AABB changed
+		if (_tree.MoveProxy(proxyId, aabb, displacement)) {
 			BufferMove(proxyId);
-		//}
+		} else {
+			_touchBuffer.push_back(proxyId);
+		}
 	}
 
 	void DynamicTreeBroadPhase::TouchProxy(std::int32_t proxyId)
@@ -93,6 +97,49 @@ namespace Jazz2::Collisions
 				_moveBuffer[i] = NullNode;
 			}
 		}
+		for (std::int32_t& touchedProxyId : _touchBuffer) {
+			if (touchedProxyId == proxyId) {
+				touchedProxyId = NullNode;
+			}
+		}
+	}
+
+	void DynamicTreeBroadPhase::RemoveProxyPairs(std::int32_t proxyId)
+	{
+		// Proxy IDs are reused, so pairs of the destroyed proxy must be removed immediately
+		auto indexIt = _proxyPairs.find(proxyId);
+		if (indexIt == _proxyPairs.end()) {
+			return;
+		}
+
+		for (std::int32_t otherProxyId : indexIt->second) {
+			_pairCache.erase(GetPairKey(std::min(proxyId, otherProxyId), std::max(proxyId, otherProxyId)));
+			RemovePairFromIndex(otherProxyId, proxyId);
+		}
+
+		_proxyPairs.erase(indexIt);
+	}
+
+	void DynamicTreeBroadPhase::AddPairToIndex(std::int32_t proxyIdA, std::int32_t proxyIdB)
+	{
+		_proxyPairs[proxyIdA].push_back(proxyIdB);
+		_proxyPairs[proxyIdB].push_back(proxyIdA);
+	}
+
+	void DynamicTreeBroadPhase::RemovePairFromIndex(std::int32_t proxyId, std::int32_t otherProxyId)
+	{
+		auto indexIt = _proxyPairs.find(proxyId);
+		if (indexIt == _proxyPairs.end()) {
+			return;
+		}
+
+		auto& otherProxyIds = indexIt->second;
+		for (auto it = otherProxyIds.begin(); it != otherProxyIds.end(); ++it) {
+			if (*it == otherProxyId) {
+				otherProxyIds.eraseUnordered(it);
+				break;
+			}
+		}
 	}
 
 	// This is called from b2DynamicTree::Query when we are gathering pairs.
@@ -23,9 +23,15 @@
 #pragma once
 
 #include "DynamicTree.h"
+#include "../../nCine/Base/HashMap.h"
+
+#include <Containers/SmallVector.h>
 
 namespace Jazz2::Collisions
 {
+	using namespace Death::Containers;
+	using nCine::HashMap;
+
 	/** @brief Collided pair of objects found by collision detection */
 	struct CollisionPair {
 		/** @brief Proxy ID of the first node */
@@ -38,8 +44,10 @@ namespace Jazz2::Collisions
 		@brief Broad-phase for collision detection
 
 		The broad-phase is used for computing pairs and performing volume queries and ray casts.
-		This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
-		It is up to the client to consume the new pairs and to track subsequent overlap.
+		Pairs of overlapping fat AABBs are persisted between updates, so the client is notified
+		when a pair begins to overlap, when a moved pair still overlaps and when a pair stops overlapping.
+		Only proxies that left their fat AABB are queried again, pairs of proxies that moved inside
+		their fat AABB can't change, so they are reported from the persisted pairs.
 	*/
 	class DynamicTreeBroadPhase
 	{
@@ -56,16 +64,15 @@ namespace Jazz2::Collisions
 		 */
 		std::int32_t CreateProxy(const AABBf& aabb, void* userData);
 
-		/** @brief Destroys a proxy */
+		/** @brief Destroys a proxy, all its pairs are removed without notification */
 		void DestroyProxy(std::int32_t proxyId);
 
 		/**
 		 * @brief Moves a proxy with a swepted AABB
 		 *
 		 * If the proxy has moved outside of its fattened AABB, then the proxy is removed from
-		 * the tree and re-inserted. Otherwise the function returns immediately.
-		 *
-		 * @return `true` if the proxy was re-inserted.
+		 * the tree and re-inserted, so its pairs are queried again on the next call to @ref UpdatePairs().
+		 * Otherwise only its persisted pairs are reported again.
 		 */
 		void MoveProxy(std::int32_t proxyId, const AABBf& aabb, Vector2f displacement);
 
@@ -84,7 +91,17 @@ namespace Jazz2::Collisions
 		/** @brief Returns the number of proxies */
 		std::int32_t GetProxyCount() const;
 
-		/** @brief Updates the pairs */
+		/** @brief Returns the number of persisted pairs */
+		std::int32_t GetPairCount() const;
+
+		/**
+		 * @brief Updates the pairs of all moved proxies
+		 *
+		 * The callback class is called with user data of both proxies --- `OnPairAdded()` for pairs
+		 * that have just begun to overlap, `OnPairUpdated()` for already known pairs of moved proxies
+		 * that still overlap and `OnPairRemoved()` for known pairs that no longer overlap. Each pair
+		 * is reported at most once.
+		 */
 		template <typename T>
 		void UpdatePairs(T* callback);
 
@@ -136,14 +153,28 @@ namespace Jazz2::Collisions
 		std::int32_t _moveCapacity;
 		std::int32_t _moveCount;
 
+		// Proxies that moved inside their fat AABB, their persisted pairs are reported without a query
+		SmallVector<std::int32_t, 0> _touchBuffer;
+
 		CollisionPair* _pairBuffer;
 		std::int32_t _pairCapacity;
 		std::int32_t _pairCount;
 
 		std::int32_t _queryProxyId;
 
+		// Persisted pairs, the value is the last update in which the pair was found
+		HashMap<std::uint64_t, std::uint32_t> _pairCache;
+		// Other proxies of all persisted pairs of each proxy
+		HashMap<std::int32_t, SmallVector<std::int32_t, 4>> _proxyPairs;
+		std::uint32_t _pairUpdate;
+
 		void BufferMove(std::int32_t proxyId);
 		void UnBufferMove(std::int32_t proxyId);
+		void RemoveProxyPairs(std::int32_t proxyId);
+		void AddPairToIndex(std::int32_t proxyIdA, std::int32_t proxyIdB);
+		void RemovePairFromIndex(std::int32_t proxyId, std::int32_t otherProxyId);
+
+		static std::uint64_t GetPairKey(std::int32_t proxyIdA, std::int32_t proxyIdB);
 
 		bool OnCollisionQuery(std::int32_t proxyId);
 	};
@@ -170,6 +201,16 @@ namespace Jazz2::Collisions
 		return _proxyCount;
 	}
 
+	inline std::int32_t DynamicTreeBroadPhase::GetPairCount() const
+	{
+		return (std::int32_t)_pairCache.size();
+	}
+
+	inline std::uint64_t DynamicTreeBroadPhase::GetPairKey(std::int32_t proxyIdA, std::int32_t proxyIdB)
+	{
+		return ((std::uint64_t)(std::uint32_t)proxyIdA << 32) | (std::uint32_t)proxyIdB;
+	}
+
 	inline std::int32_t DynamicTreeBroadPhase::GetTreeHeight() const
 	{
 		return _tree.GetHeight();
@@ -190,6 +231,7 @@ namespace Jazz2::Collisions
 	{
 		// Reset pair buffer
 		_pairCount = 0;
+		_pairUpdate++;
 
 		// Perform tree queries for all moving proxies.
 		for (std::int32_t i = 0; i < _moveCount; ++i) {
@@ -206,14 +248,80 @@ namespace Jazz2::Collisions
 			_tree.Query(this, fatAABB);
 		}
 
-		// Send pairs to caller
+		// Send pairs to caller, the pair buffer can contain duplicates if both proxies were touched without moving
 		for (std::int32_t i = 0; i < _pairCount; ++i) {
 			CollisionPair* primaryPair = &_pairBuffer[i];
+			auto [it, inserted] = _pairCache.try_emplace(GetPairKey(primaryPair->ProxyIdA, primaryPair->ProxyIdB), _pairUpdate);
+			if (!inserted) {
+				if (it->second == _pairUpdate) {
+					continue;
+				}
+				it->second = _pairUpdate;
+			}
+
 			void* userDataA = _tree.GetUserData(primaryPair->ProxyIdA);
 			void* userDataB = _tree.GetUserData(primaryPair->ProxyIdB);
 
-			callback->OnPairAdded(userDataA, userDataB);
+			if (inserted) {
+				AddPairToIndex(primaryPair->ProxyIdA, primaryPair->ProxyIdB);
+				callback->OnPairAdded(userDataA, userDataB);
+			} else {
+				callback->OnPairUpdated(userDataA, userDataB);
+			}
+		}
+
+		// Only pairs of moved proxies can stop overlapping, pairs that were not found are still valid as long as their fat AABBs overlap
+		for (std::int32_t i = 0; i < _moveCount; ++i) {
+			std::int32_t proxyId = _moveBuffer[i];
+			if (proxyId == NullNode) {
+				continue;
+			}
+
+			auto indexIt = _proxyPairs.find(proxyId);
+			if (indexIt == _proxyPairs.end()) {
+				continue;
+			}
+
+			auto& otherProxyIds = indexIt->second;
+			for (std::int32_t j = (std::int32_t)otherProxyIds.size() - 1; j >= 0; j--) {
+				std::int32_t otherProxyId = otherProxyIds[j];
+				auto it = _pairCache.find(GetPairKey(std::min(proxyId, otherProxyId), std::max(proxyId, otherProxyId)));
+				if (it == _pairCache.end() || (it->second != _pairUpdate && !TestOverlap(proxyId, otherProxyId))) {
+					if (it != _pairCache.end()) {
+						_pairCache.erase(it);
+						callback->OnPairRemoved(_tree.GetUserData(std::min(proxyId, otherProxyId)), _tree.GetUserData(std::max(proxyId, otherProxyId)));
+					}
+					otherProxyIds.eraseUnordered(otherProxyIds.begin() + j);
+					RemovePairFromIndex(otherProxyId, proxyId);
+				}
+			}
+		}
+
+		// Proxies that moved inside their fat AABB can't form new pairs or lose existing ones, so their pairs are taken
+		// from the cache, this is done after the removal, so pairs with re-inserted proxies are reported only if still valid
+		for (std::int32_t proxyId : _touchBuffer) {
+			if (proxyId == NullNode) {
+				continue;
+			}
+
+			auto indexIt = _proxyPairs.find(proxyId);
+			if (indexIt == _proxyPairs.end()) {
+				continue;
+			}
+
+			for (std::int32_t otherProxyId : indexIt->second) {
+				std::int32_t proxyIdA = std::min(proxyId, otherProxyId);
+				std::int32_t proxyIdB = std::max(proxyId, otherProxyId);
+				auto it = _pairCache.find(GetPairKey(proxyIdA, proxyIdB));
+				if (it == _pairCache.end() || it->second == _pairUpdate) {
+					continue;
+				}
+
+				it->second = _pairUpdate;
+				callback->OnPairUpdated(_tree.GetUserData(proxyIdA), _tree.GetUserData(proxyIdB));
+			}
 		}
+		_touchBuffer.clear();
 
 		// Clear move flags
 		for (std::int32_t i = 0; i < _moveCount; ++i) {
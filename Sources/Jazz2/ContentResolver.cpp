@@ -12,6 +12,7 @@
 #include "../nCine/AppConfiguration.h"
 #include "../nCine/ServiceLocator.h"
 #include "../nCine/tracy.h"
+#include "../nCine/Base/Algorithms.h"
 #include "../nCine/Graphics/ITextureLoader.h"
 #include "../nCine/Graphics/RenderResources.h"
 #include "../nCine/Base/Random.h"
@@ -23,13 +24,22 @@
 #	include <Environment.h>
 #endif
 
+#include <Containers/Array.h>
 #include <Containers/StringConcatenable.h>
 #include <Containers/StringStlView.h>
+#include <Cpu.h>
 #include <IO/MemoryStream.h>
 #include <IO/Compression/DeflateStream.h>
 
 #include "../jsoncpp/json.h"
 
+#if defined(DEATH_ENABLE_SSE2)
+#	include <IntrinsicsSse2.h>
+#endif
+#if defined(DEATH_ENABLE_NEON)
+#	include <arm_neon.h>
+#endif
+
 using namespace Death::IO::Compression;
 using namespace Jazz2::Tiles;
 
@@ -46,6 +56,168 @@ static Vector2i GetVector2iFromJson(const Json::Value& value, Vector2i defaultVa
 
 namespace Jazz2
 {
+	namespace Implementation
+	{
+		// Copies alpha channel of RGBA pixels to the mask (if not null), then converts palette indices stored in red channel
+		// to colors of the palette (if not null), alpha channel is multiplied by alpha of the palette color
+		extern void DEATH_CPU_DISPATCHED_DECLARATION(ApplyPalette)(std::uint8_t* pixels, std::size_t count, const std::uint32_t* palette, std::uint8_t* mask);
+		DEATH_CPU_DISPATCHER_DECLARATION(ApplyPalette)
+
+		namespace
+		{
+			void ApplyPaletteScalar(std::uint8_t* pixels, std::size_t count, const std::uint32_t* palette, std::uint8_t* mask)
+			{
+				if (mask != nullptr) {
+					for (std::size_t i = 0; i < count; i++) {
+						// Save original alpha value for collision checking
+						mask[i] = pixels[(i * ContentResolver::PixelSize) + 3];
+					}
+				}
+				if (palette != nullptr) {
+					for (std::size_t i = 0; i < count; i++) {
+						std::size_t srcIdx = i * ContentResolver::PixelSize;
+						std::uint32_t color = palette[pixels[srcIdx]];
+						std::uint8_t alpha = pixels[srcIdx + 3];
+
+						std::uint8_t r = (color >> 0) & 0xFF;
+						std::uint8_t g = (color >> 8) & 0xFF;
+						std::uint8_t b = (color >> 16) & 0xFF;
+						std::uint8_t a = ((color >> 24) & 0xFF) * alpha / 255;
+
+						pixels[srcIdx + 0] = r;
+						pixels[srcIdx + 1] = g;
+						pixels[srcIdx + 2] = b;
+						pixels[srcIdx + 3] = a;
+					}
+				}
+		}
+
+		DEATH_CPU_MAYBE_UNUSED typename std::decay<decltype(ApplyPalette)>::type ApplyPaletteImplementation(Cpu::ScalarT) {
+			return ApplyPaletteScalar;
+		}
+
+#if defined(DEATH_ENABLE_SSE2)
+		DEATH_CPU_MAYBE_UNUSED DEATH_ENABLE_SSE2 typename std::decay<decltype(ApplyPalette)>::type ApplyPaletteImplementation(Cpu::Sse2T) {
+			return [](std::uint8_t* pixels, std::size_t count, const std::uint32_t* palette, std::uint8_t* mask) DEATH_ENABLE_SSE2 {
+				const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+				const __m128i one = _mm_set1_epi32(1);
+
+				std::size_t i = 0;
+				for (; i + 4 <= count; i += 4) {
+					std::uint8_t* src = pixels + i * ContentResolver::PixelSize;
+					const __m128i srcPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+					const __m128i alpha = _mm_srli_epi32(srcPixels, 24);
+
+					if (mask != nullptr) {
+						// Values are at most 255, so saturation doesn't change them
+						const __m128i alpha8 = _mm_packus_epi16(_mm_packs_epi32(alpha, alpha), alpha);
+						std::int32_t packedAlpha = _mm_cvtsi128_si32(alpha8);
+						std::memcpy(mask + i, &packedAlpha, sizeof(packedAlpha));
+					}
+
+					if (palette != nullptr) {
+						// SSE2 has no gather instruction, so only the lookup is done per pixel
+						const __m128i color = _mm_setr_epi32(std::int32_t(palette[src[0]]), std::int32_t(palette[src[4]]),
+							std::int32_t(palette[src[8]]), std::int32_t(palette[src[12]]));
+						// Both alpha values are in the lower 16 bits of each lane, so the product always fits,
+						// then x / 255 is computed as (x + 1 + (x >> 8)) >> 8, which is exact for x <= 255 * 255
+						const __m128i product = _mm_mullo_epi16(_mm_srli_epi32(color, 24), alpha);
+						const __m128i newAlpha = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(product, one), _mm_srli_epi32(product, 8)), 8);
+						const __m128i result = _mm_or_si128(_mm_and_si128(color, rgbMask), _mm_slli_epi32(newAlpha, 24));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(src), result);
+					}
+				}
+
+				if (i < count) {
+					ApplyPaletteScalar(pixels + i * ContentResolver::PixelSize, count - i, palette, mask != nullptr ? mask + i : nullptr);
+				}
+			};
+		}
+#endif
+
+#if defined(DEATH_ENABLE_NEON)
+		DEATH_CPU_MAYBE_UNUSED DEATH_ENABLE_NEON typename std::decay<decltype(ApplyPalette)>::type ApplyPaletteImplementation(Cpu::NeonT) {
+			return [](std::uint8_t* pixels, std::size_t count, const std::uint32_t* palette, std::uint8_t* mask) DEATH_ENABLE_NEON {
+				const uint32x4_t rgbMask = vdupq_n_u32(0x00FFFFFF);
+				const uint32x4_t one = vdupq_n_u32(1);
+
+				std::size_t i = 0;
+				for (; i + 4 <= count; i += 4) {
+					std::uint8_t* src = pixels + i * ContentResolver::PixelSize;
+					const uint32x4_t srcPixels = vreinterpretq_u32_u8(vld1q_u8(src));
+					const uint32x4_t alpha = vshrq_n_u32(srcPixels, 24);
+
+					if (mask != nullptr) {
+						const uint16x4_t alpha16 = vmovn_u32(alpha);
+						const uint8x8_t alpha8 = vmovn_u16(vcombine_u16(alpha16, alpha16));
+						std::uint32_t packedAlpha = vget_lane_u32(vreinterpret_u32_u8(alpha8), 0);
+						std::memcpy(mask + i, &packedAlpha, sizeof(packedAlpha));
+					}
+
+					if (palette != nullptr) {
+						// NEON has no gather instruction, so only the lookup is done per pixel
+						const std::uint32_t colors[4] = { palette[src[0]], palette[src[4]], palette[src[8]], palette[src[12]] };
+						const uint32x4_t color = vld1q_u32(colors);
+						// x / 255 is computed as (x + 1 + (x >> 8)) >> 8, which is exact for x <= 255 * 255
+						const uint32x4_t product = vmulq_u32(vshrq_n_u32(color, 24), alpha);
+						const uint32x4_t newAlpha = vshrq_n_u32(vaddq_u32(vaddq_u32(product, one), vshrq_n_u32(product, 8)), 8);
+						const uint32x4_t result = vorrq_u32(vandq_u32(color, rgbMask), vshlq_n_u32(newAlpha, 24));
+						vst1q_u8(src, vreinterpretq_u8_u32(result));
+					}
+				}
+
+				if (i < count) {
+					ApplyPaletteScalar(pixels + i * ContentResolver::PixelSize, count - i, palette, mask != nullptr ? mask + i : nullptr);
+				}
+			};
+		}
+#endif
+		}
+
+		DEATH_CPU_DISPATCHER_BASE(ApplyPaletteImplementation)
+		DEATH_CPU_DISPATCHED(ApplyPaletteImplementation, void DEATH_CPU_DISPATCHED_DECLARATION(ApplyPalette)(std::uint8_t* pixels, std::size_t count, const std::uint32_t* palette, std::uint8_t* mask))({
+			return ApplyPaletteImplementation(Cpu::DefaultBase)(pixels, count, palette, mask);
+		})
+	}
+
+
+#ifndef DOXYGEN_GENERATING_OUTPUT
+	struct ContentResolver::DecodedGraphics
+	{
+		std::unique_ptr<GenericGraphicResource> Resource;
+		std::unique_ptr<ITextureLoader> TextureLoader;
+		std::unique_ptr<std::uint8_t[]> OwnedPixels;
+		std::uint8_t* Pixels = nullptr;
+		Vector2i Size;
+		bool LinearSampling = false;
+		String TextureName;
+	};
+
+	struct ContentResolver::PendingGraphics
+	{
+		JobHandle Job;
+		DecodedGraphics Result;
+		bool Succeeded = false;
+		std::uint32_t Palette[ColorsPerPalette] = {};
+	};
+
+	struct ContentResolver::PendingMetadata
+	{
+		String Path;
+		JobHandle Job;
+		Json::Value Doc;
+		bool Succeeded = false;
+		bool AssetsScheduled = false;
+	};
+
+	struct ContentResolver::PendingFile
+	{
+		JobHandle Job;
+		Array<std::uint8_t> Data;
+		bool Succeeded = false;
+	};
+#endif
+
 	ContentResolver& ContentResolver::Get()
 	{
 		static ContentResolver current;
@@ -53,7 +225,7 @@ namespace Jazz2
 	}
 
 	ContentResolver::ContentResolver()
-		: _isHeadless(false), _isLoading(false), _cachedMetadata(64), _cachedGraphics(256),
+		: _isHeadless(false), _isAsyncLoadingEnabled(true), _isLoading(false), _suspendedAsyncCount(0), _cachedMetadata(64), _cachedGraphics(256),
 #if defined(WITH_AUDIO)
 			_cachedSounds(192),
 #endif
@@ -68,6 +240,8 @@ namespace Jazz2
 
 	void ContentResolver::Release()
 	{
+		DiscardPendingLoads();
+
 		_cachedMetadata.clear();
 		_cachedGraphics.clear();
 #if defined(WITH_AUDIO)
@@ -136,6 +310,16 @@ namespace Jazz2
 		_isHeadless = value;
 	}
 
+	bool ContentResolver::IsAsyncLoadingEnabled() const
+	{
+		return _isAsyncLoadingEnabled;
+	}
+
+	void ContentResolver::SetAsyncLoadingEnabled(bool value)
+	{
+		_isAsyncLoadingEnabled = value;
+	}
+
 	void ContentResolver::InitializePaths()
 	{
 #if defined(DEATH_TARGET_ANDROID)
@@ -289,7 +473,8 @@ namespace Jazz2
 #if !defined(DEATH_TARGET_EMSCRIPTEN)
 	void ContentResolver::RemountPaks()
 	{
-		// Unload all already loaded .paks
+		// Unload all already loaded .paks, pending loads could still read from them
+		DiscardPendingLoads();
 		_mountedPaks.clear();
 
 		// Load all .paks from `Content` and `Cache` directory
@@ -301,7 +486,7 @@ namespace Jazz2
 
 			auto& pak = _mountedPaks.emplace_back(std::make_unique<PakFile>(item));
 			if (pak->IsValid()) {
-				LOGI("File \"{}\" mounted successfully", item);
+				LOGI("File \"{}\" mounted successfully{}", item, pak->IsMemoryMapped() ? " (memory-mapped)" : "");
 			} else {
 				LOGE("Failed to mount file \"{}\"", item);
 				_mountedPaks.pop_back();
@@ -316,7 +501,7 @@ namespace Jazz2
 
 			auto& pak = _mountedPaks.emplace_back(std::make_unique<PakFile>(item));
 			if (pak->IsValid()) {
-				LOGI("File \"{}\" mounted successfully", item);
+				LOGI("File \"{}\" mounted successfully{}", item, pak->IsMemoryMapped() ? " (memory-mapped)" : "");
 			} else {
 				LOGE("Failed to mount file \"{}\"", item);
 				_mountedPaks.pop_back();
@@ -355,6 +540,10 @@ namespace Jazz2
 	void ContentResolver::BeginLoading()
 	{
 		_isLoading = true;
+		_loadingStarted = TimeStamp::now();
+
+		// Palettes will be changed, so results of pending loads cannot be used anymore
+		DiscardPendingLoads();
 
 		// Reset Referenced flag
 		for (auto& resource : _cachedMetadata) {
@@ -396,7 +585,7 @@ namespace Jazz2
 			}
 		}
 
-		// Released unreferenced graphics
+		// Released unreferenced graphics, only referenced graphics with outdated palette are decoded again
 		{
 			auto it = _cachedGraphics.begin();
 			while (it != _cachedGraphics.end()) {
@@ -406,6 +595,9 @@ namespace Jazz2
 					animationsReleased++;
 #endif
 				} else {
+					if ((it->second->Flags & GenericGraphicResourceFlags::PaletteStale) == GenericGraphicResourceFlags::PaletteStale) {
+						RefreshGraphics(it->first.first(), it->first.second(), *it->second);
+					}
 					++it;
 #if defined(DEATH_DEBUG)
 					animationsKept++;
@@ -439,6 +631,12 @@ namespace Jazz2
 			animationsKept, animationsReleased, soundsKept, soundsReleased);
 #endif
 
+		LOGI("Loading took {:.1f} ms, {} assets are still being loaded in background", _loadingStarted.millisecondsSince(),
+			_pendingMetadata.size() + _pendingGraphics.size() + _pendingFiles.size());
+		if (_pendingMetadata.empty() && _pendingGraphics.empty() && _pendingFiles.empty()) {
+			_loadingStarted = TimeStamp();
+		}
+
 		_isLoading = false;
 	}
 
@@ -449,8 +647,39 @@ namespace Jazz2
 
 	void ContentResolver::PreloadMetadataAsync(StringView path)
 	{
-		// TODO: Reimplement async preloading
-		RequestMetadata(path);
+		String pathNormalized = fs::ToNativeSeparators(path);
+		if (_cachedMetadata.find(pathNormalized) != _cachedMetadata.end()) {
+			// Already loaded - Mark as referenced
+			RequestMetadata(pathNormalized);
+			return;
+		}
+
+		for (const auto& pending : _pendingMetadata) {
+			if (pending->Path == pathNormalized) {
+				return;
+			}
+		}
+
+		if (!_isAsyncLoadingEnabled || theServiceLocator().GetThreadPool().GetWorkerCount() == 0) {
+			// No worker threads are available, so load it immediately
+			RequestMetadata(pathNormalized);
+			return;
+		}
+
+		auto pending = std::make_shared<PendingMetadata>();
+		pending->Path = std::move(pathNormalized);
+		_deferredMetadata.push_back(pending);
+		_pendingMetadata.push_back(std::move(pending));
+
+		if (_suspendedAsyncCount == 0) {
+			ScheduleDeferredLoads();
+		}
+	}
+
+	bool ContentResolver::IsMetadataLoaded(StringView path) const
+	{
+		String pathNormalized = fs::ToNativeSeparators(path);
+		return (_cachedMetadata.find(pathNormalized) != _cachedMetadata.end());
 	}
 
 	Metadata* ContentResolver::RequestMetadata(StringView path)
@@ -476,27 +705,60 @@ namespace Jazz2
 			return it->second.get();
 		}
 
+		// Already being preloaded - Wait for the background job instead of loading it again
+		for (std::size_t i = 0; i < _pendingMetadata.size(); i++) {
+			if (_pendingMetadata[i]->Path == pathNormalized) {
+				std::shared_ptr<PendingMetadata> pending = std::move(_pendingMetadata[i]);
+				_pendingMetadata.erase(_pendingMetadata.begin() + i);
+
+				// The job may not be scheduled yet if scheduling is suspended
+				ScheduleDeferredLoads();
+				theServiceLocator().GetThreadPool().Wait(pending->Job);
+				return (pending->Succeeded ? CreateMetadata(std::move(pending->Path), pending->Doc) : nullptr);
+			}
+		}
+
 		// Try to load it
-		auto s = fs::Open(fs::CombinePath({ GetContentPath(), "Metadata"_s, String(pathNormalized + ".res"_s) }), FileAccess::Read);
+		Json::Value doc;
+		if (!ReadMetadataFile(pathNormalized, doc)) {
+			return nullptr;
+		}
+
+		return CreateMetadata(std::move(pathNormalized), doc);
+	}
+
+	bool ContentResolver::ReadMetadataFile(StringView path, Json::Value& doc) const
+	{
+		// This function can be called from a worker thread, so it must not access any cache
+		auto s = fs::Open(fs::CombinePath({ GetContentPath(), "Metadata"_s, String(path + ".res"_s) }), FileAccess::Read);
 		auto fileSize = s->GetSize();
 		if (fileSize < 4 || fileSize > 64 * 1024 * 1024) {
 			// 64 MB file size limit
-			return nullptr;
+			return false;
 		}
 
 		auto buffer = std::make_unique<char[]>(fileSize);
 		s->Read(buffer.get(), fileSize);
 
+		Json::CharReaderBuilder builder;
+		auto reader = std::unique_ptr<Json::CharReader>(builder.newCharReader());
+		std::string errors;
+		if (!reader->parse(buffer.get(), buffer.get() + fileSize, &doc, &errors)) {
+			// Metadata file is invalid, but empty metadata are still created
+			doc = Json::Value();
+		}
+		return true;
+	}
+
+	Metadata* ContentResolver::CreateMetadata(String&& path, const Json::Value& doc)
+	{
 		bool multipleAnimsNoStatesWarning = false;
 
 		std::unique_ptr<Metadata> metadata = std::make_unique<Metadata>();
-		metadata->Path = std::move(pathNormalized);
+		metadata->Path = std::move(path);
 		metadata->Flags |= MetadataFlags::Referenced;
 
-		Json::CharReaderBuilder builder;
-		auto reader = std::unique_ptr<Json::CharReader>(builder.newCharReader());
-		Json::Value doc; std::string errors;
-		if (reader->parse(buffer.get(), buffer.get() + fileSize, &doc, &errors)) {
+		if (!doc.isNull()) {
 			metadata->BoundingBox = GetVector2iFromJson(doc["BoundingBox"], Vector2i(InvalidValue, InvalidValue));
 
 			const auto& animations = doc["Animations"];
@@ -574,7 +836,7 @@ namespace Jazz2
 								// Additional checks only for Debug configuration
 								for (const auto& anim : metadata->Animations) {
 									if (anim.State == (AnimState)state) {
-										LOGW("Animation state {} defined twice in file \"{}\"", state, path);
+										LOGW("Animation state {} defined twice in file \"{}\"", state, metadata->Path);
 										break;
 									}
 								}
@@ -586,7 +848,7 @@ namespace Jazz2
 					} else if (count > 1) {
 						if (!multipleAnimsNoStatesWarning) {
 							multipleAnimsNoStatesWarning = true;
-							LOGW("Multiple animations defined but no states specified in file \"{}\"", path);
+							LOGW("Multiple animations defined but no states specified in file \"{}\"", metadata->Path);
 						}
 					} else {
 						graphics.State = AnimState::Default;
@@ -623,7 +885,11 @@ namespace Jazz2
 									it->second->Flags |= GenericSoundResourceFlags::Referenced;
 									sound.Buffers.push_back(it->second.get());
 								} else {
-									auto s = OpenContentFile(fs::CombinePath("Animations"_s, assetPathNormalized));
+									auto soundPath = fs::CombinePath("Animations"_s, assetPathNormalized);
+									auto s = OpenPendingFile(soundPath);
+									if (s == nullptr) {
+										s = OpenContentFile(soundPath);
+									}
 									auto res = _cachedSounds.emplace(assetPathNormalized, std::make_unique<GenericSoundResource>(std::move(s), assetPathNormalized));
 									res.first->second->Flags |= GenericSoundResourceFlags::Referenced;
 									sound.Buffers.push_back(res.first->second.get());
@@ -640,6 +906,327 @@ namespace Jazz2
 		return _cachedMetadata.emplace(metadata->Path, std::move(metadata)).first->second.get();
 	}
 
+	bool ContentResolver::PrepareMetadataAssets(const Json::Value& doc, bool scheduleMissing)
+	{
+		bool isReady = true;
+
+		const auto& animations = doc["Animations"];
+		if (animations.isObject()) {
+			for (auto it = animations.begin(); it != animations.end(); ++it) {
+				std::string_view assetPath;
+				if ((*it)["Path"].get(assetPath) != Json::SUCCESS || assetPath.empty()) {
+					continue;
+				}
+
+				std::int64_t paletteOffset;
+				if ((*it)["PaletteOffset"].get(paletteOffset) != Json::SUCCESS || paletteOffset < 0) {
+					paletteOffset = 0;
+				}
+
+				auto pathNormalized = fs::ToNativeSeparators(assetPath);
+				auto key = Pair(String::nullTerminatedView(pathNormalized), (std::uint16_t)paletteOffset);
+				if (_cachedGraphics.find(key) != _cachedGraphics.end()) {
+					continue;
+				}
+
+				if (_pendingGraphics.find(key) != _pendingGraphics.end()) {
+					isReady = false;
+				} else if (scheduleMissing) {
+					SchedulePendingGraphics(std::move(pathNormalized), (std::uint16_t)paletteOffset);
+					isReady = false;
+				}
+			}
+		}
+
+#if defined(WITH_AUDIO)
+		// Sound files are only read in background, buffers are created in CreateMetadata()
+		const auto& sounds = doc["Sounds"];
+		if (sounds.isObject() && !_isHeadless) {
+			for (auto it = sounds.begin(); it != sounds.end(); ++it) {
+				const auto& assetPaths = (*it)["Paths"];
+				if (!assetPaths.isArray()) {
+					continue;
+				}
+
+				for (auto assetPathItem : assetPaths) {
+					std::string_view assetPath;
+					if (assetPathItem.get(assetPath) != Json::SUCCESS || assetPath.empty()) {
+						continue;
+					}
+
+					auto assetPathNormalized = fs::ToNativeSeparators(assetPath);
+					if (_cachedSounds.find(assetPathNormalized) != _cachedSounds.end()) {
+						continue;
+					}
+
+					auto soundPath = fs::CombinePath("Animations"_s, assetPathNormalized);
+					auto pendingIt = _pendingFiles.find(soundPath);
+					if (pendingIt != _pendingFiles.end()) {
+						// Read files are kept in the map until they are consumed by CreateMetadata()
+						if (!pendingIt->second->Job.IsCompleted() || IsFileDeferred(pendingIt->second.get())) {
+							isReady = false;
+						}
+					} else if (scheduleMissing) {
+						SchedulePendingFile(std::move(soundPath));
+						isReady = false;
+					}
+				}
+			}
+		}
+#endif
+
+		return isReady;
+	}
+
+	void ContentResolver::SchedulePendingGraphics(String&& path, std::uint16_t paletteOffset)
+	{
+		auto pending = std::make_shared<PendingGraphics>();
+
+		// Palettes can be changed on the main thread in the meantime, so the worker uses its own copy
+		std::int32_t colorCount = std::min(ColorsPerPalette, PaletteCount * ColorsPerPalette - paletteOffset);
+		std::memcpy(pending->Palette, _palettes + paletteOffset, colorCount * sizeof(std::uint32_t));
+
+		_deferredGraphics.emplace_back(path, pending);
+		_pendingGraphics.emplace(Pair(std::move(path), paletteOffset), std::move(pending));
+
+		if (_suspendedAsyncCount == 0) {
+			ScheduleDeferredLoads();
+		}
+	}
+
+	void ContentResolver::SchedulePendingFile(String&& path)
+	{
+		auto pending = std::make_shared<PendingFile>();
+		_deferredFiles.emplace_back(path, pending);
+		_pendingFiles.emplace(std::move(path), std::move(pending));
+
+		if (_suspendedAsyncCount == 0) {
+			ScheduleDeferredLoads();
+		}
+	}
+
+	bool ContentResolver::IsFileDeferred(const PendingFile* pending) const
+	{
+		for (const auto& deferred : _deferredFiles) {
+			if (deferred.second().get() == pending) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::unique_ptr<Stream> ContentResolver::OpenPendingFile(StringView path)
+	{
+		auto it = _pendingFiles.find(String::nullTerminatedView(path));
+		if (it == _pendingFiles.end()) {
+			return nullptr;
+		}
+
+		std::shared_ptr<PendingFile> pending = std::move(it->second);
+		_pendingFiles.erase(it);
+
+		// The job may not be scheduled yet if scheduling is suspended
+		ScheduleDeferredLoads();
+		theServiceLocator().GetThreadPool().Wait(pending->Job);
+		if (!pending->Succeeded) {
+			return nullptr;
+		}
+
+		// Growable memory stream is positioned at the end of the data, so it has to be rewound before reading
+		auto s = std::make_unique<MemoryStream>(std::move(pending->Data));
+		s->Seek(0, SeekOrigin::Begin);
+		return s;
+	}
+
+	void ContentResolver::PreloadTileSetAsync(StringView path)
+	{
+		if (_pathHandler || !_isAsyncLoadingEnabled || theServiceLocator().GetThreadPool().GetWorkerCount() == 0) {
+			// Path handler cannot be called from worker threads, without worker threads it would be loaded twice
+			return;
+		}
+
+		String tileSetPath = fs::CombinePath("Tilesets"_s, String(path + ".j2t"_s));
+		if (_pendingFiles.find(tileSetPath) == _pendingFiles.end()) {
+			SchedulePendingFile(std::move(tileSetPath));
+		}
+	}
+
+	void ContentResolver::ScheduleDeferredLoads()
+	{
+		if (_deferredMetadata.empty() && _deferredGraphics.empty() && _deferredFiles.empty()) {
+			return;
+		}
+
+		ZoneScoped;
+
+		auto& threadPool = theServiceLocator().GetThreadPool();
+		for (auto& pending : _deferredMetadata) {
+			pending->Job = threadPool.Schedule([this, pending]() {
+				pending->Succeeded = ReadMetadataFile(pending->Path, pending->Doc);
+			});
+		}
+		_deferredMetadata.clear();
+
+		// Graphics and other files are scheduled in the order they are stored in .pak files, so the files are read
+		// mostly sequentially and worker threads decompress and decode them in parallel, files are indexed after graphics
+		std::uint32_t graphicsCount = (std::uint32_t)_deferredGraphics.size();
+		SmallVector<Pair<std::uint64_t, std::uint32_t>, 0> order;
+		order.reserve(graphicsCount + _deferredFiles.size());
+		for (std::uint32_t i = 0; i < graphicsCount; i++) {
+			order.emplace_back(GetContentFileSortKey(fs::CombinePath("Animations"_s, _deferredGraphics[i].first())), i);
+		}
+		for (std::uint32_t i = 0; i < _deferredFiles.size(); i++) {
+			order.emplace_back(GetContentFileSortKey(_deferredFiles[i].first()), graphicsCount + i);
+		}
+		nCine::sort(order.begin(), order.end(), [](const Pair<std::uint64_t, std::uint32_t>& a, const Pair<std::uint64_t, std::uint32_t>& b) {
+			return (a.first() < b.first() || (a.first() == b.first() && a.second() < b.second()));
+		});
+
+		for (const auto& item : order) {
+			if (item.second() < graphicsCount) {
+				auto& deferred = _deferredGraphics[item.second()];
+				std::shared_ptr<PendingGraphics> pending = deferred.second();
+				pending->Job = threadPool.Schedule([this, pending, path = std::move(deferred.first())]() {
+					pending->Succeeded = DecodeGraphics(path, pending->Palette, pending->Result);
+				});
+			} else {
+				auto& deferred = _deferredFiles[item.second() - graphicsCount];
+				std::shared_ptr<PendingFile> pending = deferred.second();
+				pending->Job = threadPool.Schedule([this, pending, path = std::move(deferred.first())]() {
+					auto s = OpenContentFile(path);
+					std::int64_t fileSize = s->GetSize();
+					if (!s->IsValid() || fileSize <= 0 || fileSize > 64 * 1024 * 1024) {
+						return;
+					}
+					pending->Data = Array<std::uint8_t>(NoInit, (std::size_t)fileSize);
+					pending->Succeeded = (s->Read(pending->Data.data(), fileSize) == fileSize);
+				});
+			}
+		}
+		_deferredGraphics.clear();
+		_deferredFiles.clear();
+	}
+
+	void ContentResolver::SuspendAsync()
+	{
+		_suspendedAsyncCount++;
+	}
+
+	void ContentResolver::ResumeAsync()
+	{
+		DEATH_DEBUG_ASSERT(_suspendedAsyncCount > 0);
+		_suspendedAsyncCount--;
+		if (_suspendedAsyncCount == 0) {
+			ScheduleDeferredLoads();
+		}
+	}
+
+	std::uint64_t ContentResolver::GetContentFileSortKey(StringView path)
+	{
+#if !defined(DEATH_TARGET_EMSCRIPTEN)
+		// Files are sorted by .pak file first and then by offset in the .pak file
+		for (std::size_t i = 0; i < _mountedPaks.size(); i++) {
+			auto mountPoint = _mountedPaks[i]->GetMountPoint();
+			if (path.hasPrefix(mountPoint)) {
+				std::int64_t offset = _mountedPaks[i]->GetFileOffset(path.exceptPrefix(mountPoint.size()));
+				if (offset >= 0) {
+					return (std::uint64_t(i) << 48) | std::uint64_t(offset);
+				}
+			}
+		}
+#endif
+		// Files outside of .pak files are read last
+		return UINT64_MAX;
+	}
+
+	void ContentResolver::ProcessPendingLoads()
+	{
+		if ((_pendingMetadata.empty() && _pendingGraphics.empty() && _pendingFiles.empty()) || _suspendedAsyncCount > 0) {
+			// Don't process anything while scheduling is suspended, because some jobs may not be scheduled yet
+			return;
+		}
+
+		ZoneScoped;
+
+		// Upload only limited number of pixels per frame, the rest is uploaded in the next frames
+		std::int32_t uploadBudget = MaxUploadedPixelsPerFrame;
+		for (auto it = _pendingGraphics.begin(); it != _pendingGraphics.end() && uploadBudget > 0; ) {
+			PendingGraphics& pending = *it->second;
+			if (!pending.Job.IsCompleted()) {
+				++it;
+				continue;
+			}
+
+			if (pending.Succeeded) {
+				uploadBudget -= pending.Result.Size.X * pending.Result.Size.Y;
+				FinishGraphics(it->first.first(), it->first.second(), pending.Result);
+			}
+			it = _pendingGraphics.erase(it);
+		}
+
+		// Graphics linked from all finished metadata are scheduled together in one batch
+		SuspendAsync();
+		for (std::size_t i = 0; i < _pendingMetadata.size(); ) {
+			PendingMetadata& pending = *_pendingMetadata[i];
+			if (!pending.Job.IsCompleted()) {
+				i++;
+				continue;
+			}
+
+			if (pending.Succeeded) {
+				// Linked assets are scheduled only once, failed ones are requested again synchronously in CreateMetadata()
+				bool isReady = PrepareMetadataAssets(pending.Doc, !pending.AssetsScheduled);
+				pending.AssetsScheduled = true;
+				if (!isReady) {
+					i++;
+					continue;
+				}
+
+				CreateMetadata(std::move(pending.Path), pending.Doc);
+			}
+
+			_pendingMetadata.erase(_pendingMetadata.begin() + i);
+		}
+		ResumeAsync();
+
+		if (_pendingMetadata.empty()) {
+			// Files that were read but not consumed by any metadata are not needed anymore
+			for (auto it = _pendingFiles.begin(); it != _pendingFiles.end(); ) {
+				if (it->second->Job.IsCompleted() && !IsFileDeferred(it->second.get())) {
+					it = _pendingFiles.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+
+		if (_loadingStarted.ticks() != 0 && _pendingMetadata.empty() && _pendingGraphics.empty() && _pendingFiles.empty()) {
+			LOGI("All preloaded assets finished {:.1f} ms after loading started", _loadingStarted.millisecondsSince());
+			_loadingStarted = TimeStamp();
+		}
+	}
+
+	void ContentResolver::DiscardPendingLoads()
+	{
+		auto& threadPool = theServiceLocator().GetThreadPool();
+		for (const auto& pending : _pendingMetadata) {
+			threadPool.Wait(pending->Job);
+		}
+		for (const auto& [key, pending] : _pendingGraphics) {
+			threadPool.Wait(pending->Job);
+		}
+		for (const auto& [key, pending] : _pendingFiles) {
+			threadPool.Wait(pending->Job);
+		}
+
+		_pendingMetadata.clear();
+		_pendingGraphics.clear();
+		_pendingFiles.clear();
+		_deferredMetadata.clear();
+		_deferredGraphics.clear();
+		_deferredFiles.clear();
+	}
+
 	GenericGraphicResource* ContentResolver::RequestGraphics(StringView path, std::uint16_t paletteOffset)
 	{
 		// First resources are requested, reset _isLoading flag, because palette should be already applied
@@ -650,18 +1237,67 @@ namespace Jazz2
 		if (it != _cachedGraphics.end()) {
 			// Already loaded - Mark as referenced
 			it->second->Flags |= GenericGraphicResourceFlags::Referenced;
+			if ((it->second->Flags & GenericGraphicResourceFlags::PaletteStale) == GenericGraphicResourceFlags::PaletteStale) {
+				RefreshGraphics(it->first.first(), it->first.second(), *it->second);
+			}
 			return it->second.get();
 		}
 
-		if (fs::GetExtension(pathNormalized) == "aura"_s) {
-			return RequestGraphicsAura(pathNormalized, paletteOffset);
+		// Already being preloaded - Wait for the background job instead of decoding it again
+		auto pendingIt = _pendingGraphics.find(Pair(String::nullTerminatedView(pathNormalized), paletteOffset));
+		if (pendingIt != _pendingGraphics.end()) {
+			std::shared_ptr<PendingGraphics> pending = std::move(pendingIt->second);
+			_pendingGraphics.erase(pendingIt);
+
+			// The job may not be scheduled yet if scheduling is suspended
+			ScheduleDeferredLoads();
+			theServiceLocator().GetThreadPool().Wait(pending->Job);
+			return (pending->Succeeded ? FinishGraphics(pathNormalized, paletteOffset, pending->Result) : nullptr);
+		}
+
+		DecodedGraphics decoded;
+		if (!DecodeGraphics(pathNormalized, _palettes + paletteOffset, decoded)) {
+			return nullptr;
+		}
+
+		return FinishGraphics(pathNormalized, paletteOffset, decoded);
+	}
+
+	GenericGraphicResource* ContentResolver::FinishGraphics(StringView path, std::uint16_t paletteOffset, DecodedGraphics& decoded)
+	{
+		std::unique_ptr<GenericGraphicResource>& graphics = decoded.Resource;
+		graphics->Flags |= GenericGraphicResourceFlags::Referenced;
+
+		if (!_isHeadless) {
+			// Don't load textures in headless mode, only collision masks
+			std::int32_t w = decoded.Size.X;
+			std::int32_t h = decoded.Size.Y;
+			graphics->TextureDiffuse = std::make_unique<Texture>(decoded.TextureName.data(), Texture::Format::RGBA8, w, h);
+			graphics->TextureDiffuse->LoadFromTexels(decoded.Pixels, 0, 0, w, h);
+			graphics->TextureDiffuse->SetMinFiltering(decoded.LinearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
+			graphics->TextureDiffuse->SetMagFiltering(decoded.LinearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
 		}
 
-		auto s = fs::Open(fs::CombinePath({ GetContentPath(), "Animations"_s, String(pathNormalized + ".res"_s) }), FileAccess::Read);
+#if defined(DEATH_DEBUG)
+		if (fs::GetExtension(path) != "aura"_s) {
+			MigrateGraphics(path);
+		}
+#endif
+		return _cachedGraphics.emplace(Pair(String(path), paletteOffset), std::move(graphics)).first->second.get();
+	}
+
+	bool ContentResolver::DecodeGraphics(StringView path, const std::uint32_t* palette, DecodedGraphics& result)
+	{
+		// This function can be called from a worker thread, so it must not access any cache
+		if (fs::GetExtension(path) == "aura"_s) {
+			return DecodeGraphicsAura(path, palette, result);
+		}
+
+		auto s = OpenContentFile(fs::CombinePath("Animations"_s, String(path + ".res"_s)));
 		auto fileSize = s->GetSize();
 		if (fileSize < 4 || fileSize > 64 * 1024 * 1024) {
 			// 64 MB file size limit, also if not found try to use cache
-			return nullptr;
+			return false;
 		}
 
 		auto buffer = std::make_unique<char[]>(fileSize);
@@ -671,111 +1307,89 @@ namespace Jazz2
 		Json::CharReaderBuilder builder;
 		auto reader = std::unique_ptr<Json::CharReader>(builder.newCharReader());
 		Json::Value doc; std::string errors;
-		if (reader->parse(buffer.get(), buffer.get() + fileSize, &doc, &errors)) {
-			// Try to load it
-			std::unique_ptr<GenericGraphicResource> graphics = std::make_unique<GenericGraphicResource>();
-			graphics->Flags |= GenericGraphicResourceFlags::Referenced;
-
-			String fullPath = fs::CombinePath({ GetContentPath(), "Animations"_s, pathNormalized });
-			std::unique_ptr<ITextureLoader> texLoader = ITextureLoader::createFromFile(fullPath);
-			if (texLoader->hasLoaded()) {
-				auto texFormat = texLoader->texFormat().internalFormat();
-				if (texFormat != GL_RGBA8 && texFormat != GL_RGB8) {
-					return nullptr;
-				}
+		if (!reader->parse(buffer.get(), buffer.get() + fileSize, &doc, &errors)) {
+			return false;
+		}
 
-				std::int32_t w = texLoader->width();
-				std::int32_t h = texLoader->height();
-				std::uint8_t* pixels = (std::uint8_t*)texLoader->pixels();
-				const std::uint32_t* palette = _palettes + paletteOffset;
-				bool linearSampling = false;
-				bool needsMask = true;
+		String fullPath = fs::CombinePath({ GetContentPath(), "Animations"_s, path });
+		std::unique_ptr<ITextureLoader> texLoader = ITextureLoader::createFromStream(OpenContentFile(fs::CombinePath("Animations"_s, path)), path);
+		if (!texLoader->hasLoaded()) {
+			return false;
+		}
 
-				std::int64_t flags;
-				if (doc["Flags"].get(flags) == Json::SUCCESS) {
-					// Palette already applied, keep as is
-					if ((flags & 0x01) != 0x01) {
-						palette = nullptr;
-						// TODO: Apply linear sampling only to these images
-						if ((flags & 0x02) == 0x02) {
-							linearSampling = true;
-						}
-					}
-					if ((flags & 0x08) == 0x08) {
-						needsMask = false;
-					}
-				}
+		auto texFormat = texLoader->texFormat().internalFormat();
+		if (texFormat != GL_RGBA8 && texFormat != GL_RGB8) {
+			return false;
+		}
 
-				if (needsMask) {
-					graphics->Mask = std::make_unique<std::uint8_t[]>(w * h);
-					for (std::int32_t i = 0; i < w * h; i++) {
-						// Save original alpha value for collision checking
-						graphics->Mask[i] = pixels[(i * PixelSize) + 3];
-					}
-				}
-				if (palette != nullptr) {
-					for (std::uint32_t i = 0; i < w * h; i++) {
-						std::uint32_t srcIdx = i * PixelSize;
-						std::uint32_t color = palette[pixels[srcIdx]];
-						std::uint8_t alpha = pixels[srcIdx + 3];
+		std::unique_ptr<GenericGraphicResource> graphics = std::make_unique<GenericGraphicResource>();
 
-						std::uint8_t r = (color >> 0) & 0xFF;
-						std::uint8_t g = (color >> 8) & 0xFF;
-						std::uint8_t b = (color >> 16) & 0xFF;
-						std::uint8_t a = ((color >> 24) & 0xFF) * alpha / 255;
+		std::int32_t w = texLoader->width();
+		std::int32_t h = texLoader->height();
+		std::uint8_t* pixels = (std::uint8_t*)texLoader->pixels();
+		bool linearSampling = false;
+		bool needsMask = true;
 
-						pixels[srcIdx + 0] = r;
-						pixels[srcIdx + 1] = g;
-						pixels[srcIdx + 2] = b;
-						pixels[srcIdx + 3] = a;
-					}
+		std::int64_t flags;
+		if (doc["Flags"].get(flags) == Json::SUCCESS) {
+			// Palette already applied, keep as is
+			if ((flags & 0x01) != 0x01) {
+				palette = nullptr;
+				// TODO: Apply linear sampling only to these images
+				if ((flags & 0x02) == 0x02) {
+					linearSampling = true;
 				}
+			}
+			if ((flags & 0x08) == 0x08) {
+				needsMask = false;
+			}
+		}
 
-				if (!_isHeadless) {
-					// Don't load textures in headless mode, only collision masks
-					graphics->TextureDiffuse = std::make_unique<Texture>(fullPath.data(), Texture::Format::RGBA8, w, h);
-					graphics->TextureDiffuse->LoadFromTexels(pixels, 0, 0, w, h);
-					graphics->TextureDiffuse->SetMinFiltering(linearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
-					graphics->TextureDiffuse->SetMagFiltering(linearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
-				}
+		if (needsMask) {
+			graphics->Mask = std::make_unique<std::uint8_t[]>(w * h);
+		}
+		if (palette != nullptr) {
+			graphics->Flags |= GenericGraphicResourceFlags::PaletteApplied;
+		}
+		Implementation::ApplyPalette(pixels, w * h, palette, graphics->Mask.get());
 
-				double animDuration;
-				if (doc["Duration"].get(animDuration) != Json::SUCCESS) {
-					animDuration = 0.0;
-				}
-				graphics->AnimDuration = (float)animDuration;
+		double animDuration;
+		if (doc["Duration"].get(animDuration) != Json::SUCCESS) {
+			animDuration = 0.0;
+		}
+		graphics->AnimDuration = (float)animDuration;
 
-				std::int64_t frameCount;
-				if (doc["FrameCount"].get(frameCount) != Json::SUCCESS) {
-					frameCount = 0;
-				}
-				graphics->FrameCount = (std::int32_t)frameCount;
+		std::int64_t frameCount;
+		if (doc["FrameCount"].get(frameCount) != Json::SUCCESS) {
+			frameCount = 0;
+		}
+		graphics->FrameCount = (std::int32_t)frameCount;
 
-				graphics->FrameDimensions = GetVector2iFromJson(doc["FrameSize"]);
-				graphics->FrameConfiguration = GetVector2iFromJson(doc["FrameConfiguration"]);
-				
-				graphics->Hotspot = GetVector2iFromJson(doc["Hotspot"]);
-				graphics->Coldspot = GetVector2iFromJson(doc["Coldspot"], Vector2i(InvalidValue, InvalidValue));
-				graphics->Gunspot = GetVector2iFromJson(doc["Gunspot"], Vector2i(InvalidValue, InvalidValue));
+		graphics->FrameDimensions = GetVector2iFromJson(doc["FrameSize"]);
+		graphics->FrameConfiguration = GetVector2iFromJson(doc["FrameConfiguration"]);
+		graphics->CreatePackedMask();
 
-#if defined(DEATH_DEBUG)
-				MigrateGraphics(pathNormalized);
-#endif
-				return _cachedGraphics.emplace(Pair(String(pathNormalized), paletteOffset), std::move(graphics)).first->second.get();
-			}
-		}
+		graphics->Hotspot = GetVector2iFromJson(doc["Hotspot"]);
+		graphics->Coldspot = GetVector2iFromJson(doc["Coldspot"], Vector2i(InvalidValue, InvalidValue));
+		graphics->Gunspot = GetVector2iFromJson(doc["Gunspot"], Vector2i(InvalidValue, InvalidValue));
 
-		return nullptr;
+		result.Resource = std::move(graphics);
+		result.TextureLoader = std::move(texLoader);
+		result.Pixels = pixels;
+		result.Size = Vector2i(w, h);
+		result.LinearSampling = linearSampling;
+		result.TextureName = std::move(fullPath);
+		return true;
 	}
 
-	GenericGraphicResource* ContentResolver::RequestGraphicsAura(StringView path, std::uint16_t paletteOffset)
+	bool ContentResolver::DecodeGraphicsAura(StringView path, const std::uint32_t* palette, DecodedGraphics& result)
 	{
 		auto s = OpenContentFile(fs::CombinePath("Animations"_s, path));
 
 		auto fileSize = s->GetSize();
 		if (fileSize < 16 || fileSize > 64 * 1024 * 1024) {
 			// 64 MB file size limit, also if not found try to use cache
-			return nullptr;
+			return false;
 		}
 
 		std::uint64_t signature1 = s->ReadValueAsLE<std::uint64_t>();
@@ -784,7 +1398,7 @@ namespace Jazz2
 		std::uint8_t flags = s->ReadValue<std::uint8_t>();
 
 		if (signature1 != 0xB8EF8498E2BFBBEF || signature2 != 0x208F || version != 2 || (flags & 0x80) != 0x80) {
-			return nullptr;
+			return false;
 		}
 
 		std::uint8_t channelCount = s->ReadValue<std::uint8_t>();
@@ -813,9 +1427,7 @@ namespace Jazz2
 		ReadImageFromFile(s, pixels.get(), width, height, channelCount);
 
 		std::unique_ptr<GenericGraphicResource> graphics = std::make_unique<GenericGraphicResource>();
-		graphics->Flags |= GenericGraphicResourceFlags::Referenced;
 
-		const std::uint32_t* palette = _palettes + paletteOffset;
 		bool linearSampling = false;
 		bool needsMask = true;
 		if ((flags & 0x01) == 0x01) {
@@ -828,42 +1440,18 @@ namespace Jazz2
 
 		if (needsMask) {
 			graphics->Mask = std::make_unique<std::uint8_t[]>(width * height);
-			for (std::uint32_t i = 0; i < width * height; i++) {
-				// Save original alpha value for collision checking
-				graphics->Mask[i] = pixels[(i * PixelSize) + 3];
-			}
 		}
 		if (palette != nullptr) {
-			for (std::uint32_t i = 0; i < width * height; i++) {
-				std::uint32_t srcIdx = i * PixelSize;
-				std::uint32_t color = palette[pixels[srcIdx]];
-				std::uint8_t alpha = pixels[srcIdx + 3];
-
-				std::uint8_t r = (color >> 0) & 0xFF;
-				std::uint8_t g = (color >> 8) & 0xFF;
-				std::uint8_t b = (color >> 16) & 0xFF;
-				std::uint8_t a = ((color >> 24) & 0xFF) * alpha / 255;
-
-				pixels[srcIdx + 0] = r;
-				pixels[srcIdx + 1] = g;
-				pixels[srcIdx + 2] = b;
-				pixels[srcIdx + 3] = a;
-			}
-		}
-
-		if (!_isHeadless) {
-			// Don't load textures in headless mode, only collision masks
-			graphics->TextureDiffuse = std::make_unique<Texture>(path.data(), Texture::Format::RGBA8, width, height);
-			graphics->TextureDiffuse->LoadFromTexels(pixels.get(), 0, 0, width, height);
-			graphics->TextureDiffuse->SetMinFiltering(linearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
-			graphics->TextureDiffuse->SetMagFiltering(linearSampling ? SamplerFilter::Linear : SamplerFilter::Nearest);
+			graphics->Flags |= GenericGraphicResourceFlags::PaletteApplied;
 		}
+		Implementation::ApplyPalette(pixels.get(), width * height, palette, graphics->Mask.get());
 
 		// AnimDuration is multiplied by 256 before saving, so divide it here back
 		graphics->AnimDuration = animDuration / 256.0f;
 		graphics->FrameDimensions = Vector2i(frameDimensionsX, frameDimensionsY);
 		graphics->FrameConfiguration = Vector2i(frameConfigurationX, frameConfigurationY);
 		graphics->FrameCount = frameCount;
+		graphics->CreatePackedMask();
 
 		if (hotspotX != UINT16_MAX || hotspotY != UINT16_MAX) {
 			graphics->Hotspot = Vector2i(hotspotX, hotspotY);
@@ -883,7 +1471,73 @@ namespace Jazz2
 			graphics->Gunspot = Vector2i(InvalidValue, InvalidValue);
 		}
 
-		return _cachedGraphics.emplace(Pair(String(path), paletteOffset), std::move(graphics)).first->second.get();
+		result.Resource = std::move(graphics);
+		result.Pixels = pixels.get();
+		result.OwnedPixels = std::move(pixels);
+		result.Size = Vector2i((std::int32_t)width, (std::int32_t)height);
+		result.LinearSampling = linearSampling;
+		result.TextureName = path;
+		return true;
+	}
+
+	void ContentResolver::ReapplyPalettes()
+	{
+		// Deferred graphics are not decoded yet, so only their copy of the palette is updated, already scheduled
+		// graphics were decoded with the old palette, so they are finished now and updated with the rest of the cache
+		auto& threadPool = theServiceLocator().GetThreadPool();
+		for (auto it = _pendingGraphics.begin(); it != _pendingGraphics.end(); ) {
+			PendingGraphics& pending = *it->second;
+			bool isDeferred = false;
+			for (const auto& deferred : _deferredGraphics) {
+				if (deferred.second() == it->second) {
+					isDeferred = true;
+					break;
+				}
+			}
+
+			if (isDeferred) {
+				std::int32_t colorCount = std::min(ColorsPerPalette, PaletteCount * ColorsPerPalette - it->first.second());
+				std::memcpy(pending.Palette, _palettes + it->first.second(), colorCount * sizeof(std::uint32_t));
+				++it;
+				continue;
+			}
+
+			threadPool.Wait(pending.Job);
+			if (pending.Succeeded) {
+				FinishGraphics(it->first.first(), it->first.second(), pending.Result);
+			}
+			it = _pendingGraphics.erase(it);
+		}
+
+		// Textures with applied palette are only marked as stale, they are decoded again when requested or in EndLoading()
+		// if they are still referenced by the new level, so graphics released at the end of loading are never decoded
+		for (auto& [key, graphics] : _cachedGraphics) {
+			if ((graphics->Flags & GenericGraphicResourceFlags::PaletteApplied) == GenericGraphicResourceFlags::PaletteApplied &&
+				graphics->TextureDiffuse != nullptr) {
+				graphics->Flags |= GenericGraphicResourceFlags::PaletteStale;
+			}
+		}
+
+		for (std::int32_t i = 0; i < (std::int32_t)FontType::Count; i++) {
+			_fonts[i] = nullptr;
+		}
+	}
+
+	void ContentResolver::RefreshGraphics(StringView path, std::uint16_t paletteOffset, GenericGraphicResource& graphics)
+	{
+		graphics.Flags &= ~GenericGraphicResourceFlags::PaletteStale;
+
+		DecodedGraphics decoded;
+		if (!DecodeGraphics(path, _palettes + paletteOffset, decoded)) {
+			return;
+		}
+
+		// Decoded pixels are uploaded to the existing texture, so pointers to cached resources remain valid
+		std::int32_t w = graphics.TextureDiffuse->GetWidth();
+		std::int32_t h = graphics.TextureDiffuse->GetHeight();
+		if (decoded.Size.X == w && decoded.Size.Y == h) {
+			graphics.TextureDiffuse->LoadFromTexels(decoded.Pixels, 0, 0, w, h);
+		}
 	}
 
 	void ContentResolver::ReadImageFromFile(std::unique_ptr<Stream>& s, std::uint8_t* data, std::int32_t width, std::int32_t height, std::int32_t channelCount)
@@ -906,51 +1560,98 @@ namespace Jazz2
 
 		#define QOI_COLOR_HASH(C) (C.rgba.r*3 + C.rgba.g*5 + C.rgba.b*7 + C.rgba.a*11)
 
+		// Every opcode outputs at most 62 pixels, so at least this number of bytes still belongs to the image,
+		// the stream can continue with other data, so it must never be read past the end of the image
+		constexpr std::int32_t MaxRunLength = 62;
+		constexpr std::int32_t BufferSize = 16384;
+
+		std::uint8_t buffer[BufferSize];
+		std::int32_t bufferPos = 0;
+		std::int32_t bufferEnd = 0;
+
 		rgba_t index[64] { };
 		rgba_t px;
-		std::int32_t run = 0;
 		std::int32_t px_len = width * height * channelCount;
+		std::int32_t px_pos = 0;
 
 		px.rgba.r = 0;
 		px.rgba.g = 0;
 		px.rgba.b = 0;
 		px.rgba.a = 255;
 
-		for (std::int32_t px_pos = 0; px_pos < px_len; px_pos += channelCount) {
-			if (run > 0) {
-				run--;
-			} else {
-				std::int32_t b1 = s->ReadValue<std::uint8_t>();
-
-				if (b1 == QOI_OP_RGB) {
-					px.rgba.r = s->ReadValue<std::uint8_t>();
-					px.rgba.g = s->ReadValue<std::uint8_t>();
-					px.rgba.b = s->ReadValue<std::uint8_t>();
-				} else if (b1 == QOI_OP_RGBA) {
-					px.rgba.r = s->ReadValue<std::uint8_t>();
-					px.rgba.g = s->ReadValue<std::uint8_t>();
-					px.rgba.b = s->ReadValue<std::uint8_t>();
-					px.rgba.a = s->ReadValue<std::uint8_t>();
-				} else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
-					px = index[b1];
-				} else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
-					px.rgba.r += ((b1 >> 4) & 0x03) - 2;
-					px.rgba.g += ((b1 >> 2) & 0x03) - 2;
-					px.rgba.b += (b1 & 0x03) - 2;
-				} else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
-					std::int32_t b2 = s->ReadValue<std::uint8_t>();
-					std::int32_t vg = (b1 & 0x3f) - 32;
-					px.rgba.r += vg - 8 + ((b2 >> 4) & 0x0f);
-					px.rgba.g += vg;
-					px.rgba.b += vg - 8 + (b2 & 0x0f);
-				} else if ((b1 & QOI_MASK_2) == QOI_OP_RUN) {
-					run = (b1 & 0x3f);
+		while (px_pos < px_len) {
+			if (bufferPos >= bufferEnd) {
+				std::int32_t remainingPixels = (px_len - px_pos) / channelCount;
+				std::int32_t bytesToRead = std::min((remainingPixels + MaxRunLength - 1) / MaxRunLength, BufferSize);
+				bufferEnd = (std::int32_t)s->Read(buffer, bytesToRead);
+				bufferPos = 0;
+				if (bufferEnd <= 0) {
+					break;
 				}
+			}
 
-				index[QOI_COLOR_HASH(px) & (64 - 1)] = px;
+			std::int32_t b1 = buffer[bufferPos++];
+
+			if (b1 >= QOI_OP_RGB || (b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+				// Data of the opcode can be split across the end of the buffer, so read only the missing bytes
+				std::int32_t dataSize = (b1 == QOI_OP_RGBA ? 4 : (b1 == QOI_OP_RGB ? 3 : 1));
+				std::int32_t available = bufferEnd - bufferPos;
+				if (available < dataSize) {
+					std::memmove(buffer, buffer + bufferPos, available);
+					bufferEnd = available + std::max((std::int32_t)s->Read(buffer + available, dataSize - available), 0);
+					bufferPos = 0;
+					if (bufferEnd < dataSize) {
+						break;
+					}
+				}
 			}
 
+			if (b1 == QOI_OP_RGB) {
+				px.rgba.r = buffer[bufferPos];
+				px.rgba.g = buffer[bufferPos + 1];
+				px.rgba.b = buffer[bufferPos + 2];
+				bufferPos += 3;
+			} else if (b1 == QOI_OP_RGBA) {
+				px.rgba.r = buffer[bufferPos];
+				px.rgba.g = buffer[bufferPos + 1];
+				px.rgba.b = buffer[bufferPos + 2];
+				px.rgba.a = buffer[bufferPos + 3];
+				bufferPos += 4;
+			} else {
+				switch (b1 & QOI_MASK_2) {
+					case QOI_OP_INDEX: {
+						px = index[b1];
+						break;
+					}
+					case QOI_OP_DIFF: {
+						px.rgba.r += ((b1 >> 4) & 0x03) - 2;
+						px.rgba.g += ((b1 >> 2) & 0x03) - 2;
+						px.rgba.b += (b1 & 0x03) - 2;
+						break;
+					}
+					case QOI_OP_LUMA: {
+						std::int32_t b2 = buffer[bufferPos++];
+						std::int32_t vg = (b1 & 0x3f) - 32;
+						px.rgba.r += vg - 8 + ((b2 >> 4) & 0x0f);
+						px.rgba.g += vg;
+						px.rgba.b += vg - 8 + (b2 & 0x0f);
+						break;
+					}
+					default: {
+						// Color of the run is the same, so all pixels can be written at once
+						index[QOI_COLOR_HASH(px) & (64 - 1)] = px;
+						std::int32_t runEnd = std::min(px_pos + ((b1 & 0x3f) + 1) * channelCount, px_len);
+						for (; px_pos < runEnd; px_pos += channelCount) {
+							*(rgba_t*)(data + px_pos) = px;
+						}
+						continue;
+					}
+				}
+			}
+
+			index[QOI_COLOR_HASH(px) & (64 - 1)] = px;
 			*(rgba_t*)(data + px_pos) = px;
+			px_pos += channelCount;
 		}
 	}
 
@@ -1021,7 +1722,11 @@ namespace Jazz2
 			}
 		}
 
-		auto s = fs::Open(fullPath, FileAccess::Read);
+		// Use the file preloaded by PreloadTileSetAsync() if possible
+		std::unique_ptr<Stream> s = OpenPendingFile(fs::CombinePath("Tilesets"_s, String(path + ".j2t"_s)));
+		if (s == nullptr) {
+			s = fs::Open(fullPath, FileAccess::Read);
+		}
 		if (!s->IsValid()) {
 			return nullptr;
 		}
@@ -1051,21 +1756,16 @@ namespace Jazz2
 			}
 
 			if (std::memcmp(_palettes, newPalette, ColorsPerPalette * sizeof(std::uint32_t)) != 0) {
-				// Palettes differs, drop all cached resources, so it will be reloaded with new palette
+				std::memcpy(_palettes, newPalette, ColorsPerPalette * sizeof(std::uint32_t));
+				RecreateGemPalettes();
+
+				// Palettes differs, apply the new palette to all cached resources
 				if (_isLoading) {
 #if defined(DEATH_DEBUG)
-					LOGW("Releasing all animations because of different palette - Metadata: 0|{}, Animations: 0|{}", _cachedMetadata.size(), _cachedGraphics.size());
+					LOGW("Reapplying palette to all animations - Metadata: {}, Animations: {}", _cachedMetadata.size(), _cachedGraphics.size());
 #endif
-					_cachedMetadata.clear();
-					_cachedGraphics.clear();
-
-					for (std::int32_t i = 0; i < (std::int32_t)FontType::Count; i++) {
-						_fonts[i] = nullptr;
-					}
+					ReapplyPalettes();
 				}
-
-				std::memcpy(_palettes, newPalette, ColorsPerPalette * sizeof(std::uint32_t));
-				RecreateGemPalettes();
 			}
 		} else {
 			uc.Seek(ColorsPerPalette * sizeof(std::uint32_t), SeekOrigin::Current);
@@ -1081,15 +1781,15 @@ namespace Jazz2
 		}
 
 		// Mask
+		// Bits are stored LSB-first, so each tile row is exactly one little-endian word
 		std::uint32_t maskSize = uc.ReadValueAsLE<std::uint32_t>();
-		std::unique_ptr<uint8_t[]> mask = std::make_unique<std::uint8_t[]>(maskSize * 8);
-		for (std::uint32_t j = 0; j < maskSize; j++) {
-			std::uint8_t idx = uc.ReadValue<std::uint8_t>();
-			for (std::uint32_t k = 0; k < 8; k++) {
-				std::uint32_t pixelIdx = 8 * j + k;
-				mask[pixelIdx] = (((idx >> k) & 0x01) != 0);
-			}
+		std::uint32_t maskRowCount = tileCount * TileSet::DefaultTileSize;
+		std::uint32_t maskRowsToRead = std::min(maskSize / std::uint32_t(sizeof(std::uint32_t)), maskRowCount);
+		std::unique_ptr<std::uint32_t[]> mask = std::make_unique<std::uint32_t[]>(maskRowCount);
+		for (std::uint32_t j = 0; j < maskRowsToRead; j++) {
+			mask[j] = uc.ReadValueAsLE<std::uint32_t>();
 		}
+		uc.Seek(maskSize - maskRowsToRead * sizeof(std::uint32_t), SeekOrigin::Current);
 
 		std::unique_ptr<Texture> textureDiffuse;
 		std::unique_ptr<Color[]> captionTile;
@@ -1206,7 +1906,7 @@ namespace Jazz2
 			return nullptr;
 		}
 
-		return std::make_unique<Tiles::TileSet>(path, tileCount, std::move(textureDiffuse), std::move(mask), maskSize * 8, std::move(captionTile));
+		return std::make_unique<Tiles::TileSet>(path, tileCount, std::move(textureDiffuse), std::move(mask), std::move(captionTile));
 	}
 
 	bool ContentResolver::LevelExists(StringView levelName)
@@ -1297,18 +1997,13 @@ namespace Jazz2
 			}
 
 			if (!_isHeadless && std::memcmp(_palettes, newPalette, ColorsPerPalette * sizeof(std::uint32_t)) != 0) {
-				// Palettes differs, drop all cached resources, so it will be reloaded with new palette
-				if (_isLoading) {
-					_cachedMetadata.clear();
-					_cachedGraphics.clear();
-
-					for (std::int32_t i = 0; i < (std::int32_t)FontType::Count; i++) {
-						_fonts[i] = nullptr;
-					}
-				}
-
 				std::memcpy(_palettes, newPalette, ColorsPerPalette * sizeof(std::uint32_t));
 				RecreateGemPalettes();
+
+				// Palettes differs, apply the new palette to all cached resources
+				if (_isLoading) {
+					ReapplyPalettes();
+				}
 			}
 		}
 
@@ -1325,34 +2020,53 @@ namespace Jazz2
 			// TODO: Store and use the palette (if not headless)
 		}
 
-		descriptor.TileMap = std::make_unique<Tiles::TileMap>(defaultTileset, captionTileId, !hasCustomPalette);
-		descriptor.TileMap->SetPitType(pitType);
-
 		// Extra Tilesets
+		struct ExtraTileSet {
+			String Path;
+			std::uint16_t Offset;
+			std::uint16_t Count;
+			bool IsRemapped;
+			std::uint8_t PaletteRemapping[ColorsPerPalette];
+		};
+
 		std::uint8_t extraTilesetCount = uc.ReadValue<std::uint8_t>();
+		SmallVector<ExtraTileSet, 0> extraTilesets(extraTilesetCount);
 		for (std::uint32_t i = 0; i < extraTilesetCount; i++) {
+			auto& extraTileset = extraTilesets[i];
 			std::uint8_t tilesetFlags = uc.ReadValue<std::uint8_t>();
 
 			stringSize = uc.ReadValue<std::uint8_t>();
-			String extraTileset{NoInit, stringSize};
-			uc.Read(extraTileset.data(), stringSize);
+			extraTileset.Path = String(NoInit, stringSize);
+			uc.Read(extraTileset.Path.data(), stringSize);
 
-			std::uint16_t offset = uc.ReadValueAsLE<std::uint16_t>();
-			std::uint16_t count = uc.ReadValueAsLE<std::uint16_t>();
+			extraTileset.Offset = uc.ReadValueAsLE<std::uint16_t>();
+			extraTileset.Count = uc.ReadValueAsLE<std::uint16_t>();
 
-			std::uint8_t paletteRemapping[ColorsPerPalette];
-			bool isRemapped = ((tilesetFlags & 0x01) == 0x01);
+			extraTileset.IsRemapped = ((tilesetFlags & 0x01) == 0x01);
 			bool is24bit = ((tilesetFlags & 0x02) == 0x02);
-			if (isRemapped) {
+			if (extraTileset.IsRemapped) {
 				if (is24bit) {
 					// Alternate palette index
-					paletteRemapping[0] = uc.ReadValue<std::uint8_t>();
+					extraTileset.PaletteRemapping[0] = uc.ReadValue<std::uint8_t>();
 				} else {
-					uc.Read(paletteRemapping, sizeof(paletteRemapping));
+					uc.Read(extraTileset.PaletteRemapping, sizeof(extraTileset.PaletteRemapping));
 				}
 			}
+		}
 
-			descriptor.TileMap->AddTileSet(extraTileset, offset, count, isRemapped ? paletteRemapping : nullptr);
+		// All tilesets are read from files in one batch, but they have to be loaded in order, because the default one can change the palette
+		SuspendAsync();
+		PreloadTileSetAsync(defaultTileset);
+		for (const auto& extraTileset : extraTilesets) {
+			PreloadTileSetAsync(extraTileset.Path);
+		}
+		ResumeAsync();
+
+		descriptor.TileMap = std::make_unique<Tiles::TileMap>(defaultTileset, captionTileId, !hasCustomPalette);
+		descriptor.TileMap->SetPitType(pitType);
+
+		for (const auto& extraTileset : extraTilesets) {
+			descriptor.TileMap->AddTileSet(extraTileset.Path, extraTileset.Offset, extraTileset.Count, extraTileset.IsRemapped ? extraTileset.PaletteRemapping : nullptr);
 		}
 
 		if (!descriptor.TileMap->IsValid()) {
@@ -1427,18 +2141,13 @@ namespace Jazz2
 		static_assert(sizeof(SpritePalette) == ColorsPerPalette * sizeof(std::uint32_t));
 
 		if (!_isHeadless && std::memcmp(_palettes, SpritePalette, ColorsPerPalette * sizeof(std::uint32_t)) != 0) {
-			// Palettes differs, drop all cached resources, so it will be reloaded with new palette
-			if (_isLoading) {
-				_cachedMetadata.clear();
-				_cachedGraphics.clear();
-
-				for (std::int32_t i = 0; i < (std::int32_t)FontType::Count; i++) {
-					_fonts[i] = nullptr;
-				}
-			}
-
 			std::memcpy(_palettes, SpritePalette, ColorsPerPalette * sizeof(std::uint32_t));
 			RecreateGemPalettes();
+
+			// Palettes differs, apply the new palette to all cached resources
+			if (_isLoading) {
+				ReapplyPalettes();
+			}
 		}
 	}
 
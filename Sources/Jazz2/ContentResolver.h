@@ -10,6 +10,8 @@
 #include "../nCine/Audio/AudioStreamPlayer.h"
 #include "../nCine/Graphics/Texture.h"
 #include "../nCine/Base/HashMap.h"
+#include "../nCine/Base/TimeStamp.h"
+#include "../jsoncpp/forwards.h"
 
 #include <Containers/Function.h>
 #include <Containers/Pair.h>
@@ -32,9 +34,20 @@ namespace Jazz2
 		class TileSet;
 	}
 
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+	namespace Multiplayer
+	{
+		class ContentBenchmark;
+	}
+#endif
+
 	/** @brief Manages loading of assets */
 	class ContentResolver
 	{
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+		friend class Multiplayer::ContentBenchmark;
+#endif
+
 	public:
 		/** @{ @name Constants */
 
@@ -46,6 +59,8 @@ namespace Jazz2
 		static constexpr std::int32_t ColorsPerPalette = 256;
 		/** @brief Invalid value */
 		static constexpr std::int32_t InvalidValue = INT_MAX;
+		/** @brief Maximum number of preloaded pixels uploaded to GPU per frame */
+		static constexpr std::int32_t MaxUploadedPixelsPerFrame = 1024 * 1024;
 
 #ifndef DOXYGEN_GENERATING_OUTPUT
 		static constexpr std::uint8_t LevelFile = 1;
@@ -78,6 +93,11 @@ namespace Jazz2
 		bool IsHeadless() const;
 		/** @brief Sets whether the application is running in headless mode */
 		void SetHeadless(bool value);
+		/** @brief Returns `true` if assets can be preloaded asynchronously on worker threads */
+		bool IsAsyncLoadingEnabled() const;
+		/** @brief Sets whether assets can be preloaded asynchronously on worker threads */
+		/*! If disabled or if no worker threads are available, all assets are loaded synchronously on the main thread. */
+		void SetAsyncLoadingEnabled(bool value);
 
 #if !defined(DEATH_TARGET_EMSCRIPTEN)
 		/** @brief Scans the `"Content"` and `"Cache"` directories for `.pak` files and mounts them  */
@@ -95,12 +115,26 @@ namespace Jazz2
 		void OverridePathHandler(Function<String(StringView)>&& callback);
 
 		/** @brief Preloads specified metadata and its linked assets to cache */
+		/*! Files are read and decoded on worker threads, textures are uploaded later in @ref ProcessPendingLoads(). */
 		void PreloadMetadataAsync(StringView path);
+		/** @brief Returns `true` if specified metadata are already loaded in cache */
+		bool IsMetadataLoaded(StringView path) const;
 		/** @brief Loads specified metadata and its linked assets if not in cache already and returns it */
+		/*! If the metadata are being preloaded, it waits for the background load to finish instead of loading them again. */
 		Metadata* RequestMetadata(StringView path);
 		/** @brief Loads specified graphics asset if not in cache already and returns it */
 		GenericGraphicResource* RequestGraphics(StringView path, std::uint16_t paletteOffset);
-
+		/** @brief Finishes preloaded assets that are ready, should be called once per frame on the main thread */
+		void ProcessPendingLoads();
+		/** @brief Suspends scheduling of preloaded assets, so they can be scheduled later in a batch */
+		/*! Calls can be nested. Assets requested in the meantime are scheduled in @ref ResumeAsync() sorted by
+		 *  their offset in `.pak` files, so they are read mostly sequentially and decoded in parallel on worker threads. */
+		void SuspendAsync();
+		/** @brief Resumes scheduling of preloaded assets */
+		void ResumeAsync();
+
+		/** @brief Preloads specified tile set file to memory, so it can be loaded faster by @ref RequestTileSet() */
+		void PreloadTileSetAsync(StringView path);
 		/** @brief Loads specified tile set and its palette */
 		std::unique_ptr<Tiles::TileSet> RequestTileSet(StringView path, std::uint16_t captionTileId, bool applyPalette, const std::uint8_t* paletteRemapping = nullptr);
 		/** @brief Returns `true` if specified level exists */
@@ -139,6 +173,11 @@ namespace Jazz2
 				return a.get() == b.get();
 			}
 		};
+
+		struct DecodedGraphics;
+		struct PendingGraphics;
+		struct PendingMetadata;
+		struct PendingFile;
 #endif
 
 		ContentResolver();
@@ -148,7 +187,21 @@ namespace Jazz2
 
 		void InitializePaths();
 
-		GenericGraphicResource* RequestGraphicsAura(StringView path, std::uint16_t paletteOffset);
+		bool ReadMetadataFile(StringView path, Json::Value& doc) const;
+		Metadata* CreateMetadata(String&& path, const Json::Value& doc);
+		bool PrepareMetadataAssets(const Json::Value& doc, bool scheduleMissing);
+		void SchedulePendingGraphics(String&& path, std::uint16_t paletteOffset);
+		void SchedulePendingFile(String&& path);
+		bool IsFileDeferred(const PendingFile* pending) const;
+		std::unique_ptr<Stream> OpenPendingFile(StringView path);
+		void ScheduleDeferredLoads();
+		void DiscardPendingLoads();
+		std::uint64_t GetContentFileSortKey(StringView path);
+		bool DecodeGraphics(StringView path, const std::uint32_t* palette, DecodedGraphics& result);
+		bool DecodeGraphicsAura(StringView path, const std::uint32_t* palette, DecodedGraphics& result);
+		GenericGraphicResource* FinishGraphics(StringView path, std::uint16_t paletteOffset, DecodedGraphics& decoded);
+		void ReapplyPalettes();
+		void RefreshGraphics(StringView path, std::uint16_t paletteOffset, GenericGraphicResource& graphics);
 		static void ReadImageFromFile(std::unique_ptr<Stream>& s, std::uint8_t* data, std::int32_t width, std::int32_t height, std::int32_t channelCount);
 		static void ExpandTileDiffuse(std::uint8_t* pixelsOffset, std::uint32_t widthWithPadding);
 
@@ -161,7 +214,9 @@ namespace Jazz2
 #endif
 
 		bool _isHeadless;
+		bool _isAsyncLoadingEnabled;
 		bool _isLoading;
+		std::int32_t _suspendedAsyncCount;
 		std::uint32_t _palettes[PaletteCount * ColorsPerPalette];
 		HashMap<Reference<const String>, std::unique_ptr<Metadata>, 
 #if defined(DEATH_TARGET_32BIT)
@@ -171,6 +226,13 @@ namespace Jazz2
 #endif
 			StringRefEqualTo> _cachedMetadata;
 		HashMap<Pair<String, std::uint16_t>, std::unique_ptr<GenericGraphicResource>> _cachedGraphics;
+		SmallVector<std::shared_ptr<PendingMetadata>, 0> _pendingMetadata;
+		HashMap<Pair<String, std::uint16_t>, std::shared_ptr<PendingGraphics>> _pendingGraphics;
+		SmallVector<std::shared_ptr<PendingMetadata>, 0> _deferredMetadata;
+		SmallVector<Pair<String, std::shared_ptr<PendingGraphics>>, 0> _deferredGraphics;
+		HashMap<String, std::shared_ptr<PendingFile>> _pendingFiles;
+		SmallVector<Pair<String, std::shared_ptr<PendingFile>>, 0> _deferredFiles;
+		TimeStamp _loadingStarted;
 #if defined(WITH_AUDIO)
 		HashMap<String, std::unique_ptr<GenericSoundResource>> _cachedSounds;
 #endif
@@ -1,4 +1,5 @@
 ﻿#include "EventMap.h"
+#include "../ContentResolver.h"
 #include "../Tiles/TileMap.h"
 #include "../WeatherType.h"
 
@@ -9,7 +10,8 @@
 namespace Jazz2::Events
 {
 	EventMap::EventMap(Vector2i layoutSize)
-		: _levelHandler(nullptr), _layoutSize(layoutSize), _pitType(PitType::FallForever)
+		: _levelHandler(nullptr), _layoutSize(layoutSize), _pitType(PitType::FallForever),
+			_chunkCount((layoutSize.X + ActivationChunkSize - 1) / ActivationChunkSize, (layoutSize.Y + ActivationChunkSize - 1) / ActivationChunkSize)
 	{
 	}
 
@@ -100,6 +102,8 @@ namespace Jazz2::Events
 			}
 		}
 
+		RebuildActivationIndex();
+
 		// Reset cooldown of all generators
 		// TODO: Save also cooldown of all generators to be able to restore them
 		for (auto& generator : _generators) {
@@ -114,6 +118,7 @@ namespace Jazz2::Events
 		}
 
 		EventTile& previousEvent = _eventLayout[x + y * _layoutSize.X];
+		bool wasPending = IsPendingActivation(previousEvent);
 
 		EventTile newEvent = {};
 		newEvent.Event = eventType,
@@ -126,16 +131,21 @@ namespace Jazz2::Events
 		}
 
 		previousEvent = newEvent;
+		UpdateActivationIndex(x, y, wasPending, IsPendingActivation(newEvent));
 	}
 
 	void EventMap::PreloadEventsAsync()
 	{
-		ZoneScopedC(0x9D5BA3);
+		PreloadEventsAsync(_levelHandler->EventSpawner());
+	}
 
-		auto eventSpawner = _levelHandler->EventSpawner();
+	void EventMap::PreloadEventsAsync(EventSpawner* eventSpawner)
+	{
+		ZoneScopedC(0x9D5BA3);
 
-		// TODO
-		//ContentResolver::Get().SuspendAsync();
+		// Schedule all assets in one batch, so they can be read in the order they are stored in .pak files
+		auto& resolver = ContentResolver::Get();
+		resolver.SuspendAsync();
 
 		// Preload all events
 		for (std::int32_t i = 0; i < _layoutSize.X * _layoutSize.Y; i++) {
@@ -152,7 +162,7 @@ namespace Jazz2::Events
 		}
 
 		// Don't wait for finalization of resources, it will be done in a few next frames
-		//ContentResolver::Get().ResumeAsync();
+		resolver.ResumeAsync();
 	}
 
 	void EventMap::ProcessGenerators(float timeMult)
@@ -196,11 +206,28 @@ namespace Jazz2::Events
 		std::int32_t y1 = std::max(0, ty1);
 		std::int32_t y2 = std::min(_layoutSize.Y - 1, ty2);
 
+		std::int32_t cy1 = y1 / ActivationChunkSize;
+		std::int32_t cy2 = y2 / ActivationChunkSize;
+
+		// Events are still activated in column-major order, so actors are spawned in the same order as before
 		for (std::int32_t x = x1; x <= x2; x++) {
-			for (std::int32_t y = y1; y <= y2; y++) {
-				auto& tile = _eventLayout[x + y * _layoutSize.X];
-				if (!tile.IsEventActive && tile.Event != EventType::Empty) {
+			std::int32_t cx = x / ActivationChunkSize;
+			for (std::int32_t cy = cy1; cy <= cy2; cy++) {
+				std::uint16_t& pendingCount = _pendingEventCounts[cx + cy * _chunkCount.X];
+				if (pendingCount == 0) {
+					continue;
+				}
+
+				std::int32_t yStart = std::max(y1, cy * ActivationChunkSize);
+				std::int32_t yEnd = std::min(y2, cy * ActivationChunkSize + ActivationChunkSize - 1);
+				for (std::int32_t y = yStart; y <= yEnd; y++) {
+					auto& tile = _eventLayout[x + y * _layoutSize.X];
+					if (!IsPendingActivation(tile)) {
+						continue;
+					}
+
 					tile.IsEventActive = true;
+					pendingCount--;
 
 					if (tile.Event == EventType::AreaWeather) {
 						_levelHandler->SetWeather((WeatherType)tile.EventParams[0], tile.EventParams[1]);
@@ -223,7 +250,11 @@ namespace Jazz2::Events
 	void EventMap::Deactivate(std::int32_t x, std::int32_t y)
 	{
 		if (HasEventByPosition(x, y)) {
-			_eventLayout[x + y * _layoutSize.X].IsEventActive = false;
+			auto& tile = _eventLayout[x + y * _layoutSize.X];
+			if (tile.IsEventActive) {
+				tile.IsEventActive = false;
+				UpdateActivationIndex(x, y, false, true);
+			}
 		}
 	}
 
@@ -270,13 +301,18 @@ namespace Jazz2::Events
 			_eventLayout[x + y * _layoutSize.X].Event != EventType::Empty);
 	}
 
-	void EventMap::ForEachEvent(Function<bool(EventTile&, std::int32_t, std::int32_t)>&& forEachCallback) const
+	void EventMap::ForEachEvent(Function<bool(EventTile&, std::int32_t, std::int32_t)>&& forEachCallback)
 	{
 		for (std::int32_t y = 0; y < _layoutSize.Y; y++) {
 			for (std::int32_t x = 0; x < _layoutSize.X; x++) {
 				auto& event = _eventLayout[x + y * _layoutSize.X];
-				if (event.Event != EventType::Empty && !forEachCallback(event, x, y)) {
-					return;
+				if (event.Event != EventType::Empty) {
+					bool wasPending = IsPendingActivation(event);
+					bool shouldContinue = forEachCallback(event, x, y);
+					UpdateActivationIndex(x, y, wasPending, IsPendingActivation(event));
+					if (!shouldContinue) {
+						return;
+					}
 				}
 			}
 		}
@@ -332,6 +368,7 @@ namespace Jazz2::Events
 	void EventMap::ReadEvents(Stream& s, const std::unique_ptr<Tiles::TileMap>& tileMap, GameDifficulty difficulty)
 	{
 		_eventLayout = std::make_unique<EventTile[]>(_layoutSize.X * _layoutSize.Y);
+		_pendingEventCounts = std::make_unique<std::uint16_t[]>(_chunkCount.X * _chunkCount.Y);
 
 		std::uint8_t difficultyBit;
 		switch (difficulty) {
@@ -500,6 +537,8 @@ namespace Jazz2::Events
 			tile.EventFlags = (Actors::ActorState)src.ReadVariableUint32();
 			src.Read(tile.EventParams, sizeof(tile.EventParams));
 		}
+
+		RebuildActivationIndex();
 	}
 
 	void EventMap::SerializeResumableToStream(Stream& dest, bool fromCheckpoint)
@@ -514,4 +553,34 @@ namespace Jazz2::Events
 			dest.Write(tile.EventParams, sizeof(tile.EventParams)); // TODO: Optimize this
 		}
 	}
+
+	bool EventMap::IsPendingActivation(const EventTile& tile)
+	{
+		return (!tile.IsEventActive && tile.Event != EventType::Empty);
+	}
+
+	void EventMap::UpdateActivationIndex(std::int32_t x, std::int32_t y, bool wasPending, bool isPending)
+	{
+		if (wasPending != isPending) {
+			std::uint16_t& pendingCount = _pendingEventCounts[(x / ActivationChunkSize) + (y / ActivationChunkSize) * _chunkCount.X];
+			if (isPending) {
+				pendingCount++;
+			} else {
+				pendingCount--;
+			}
+		}
+	}
+
+	void EventMap::RebuildActivationIndex()
+	{
+		std::memset(_pendingEventCounts.get(), 0, _chunkCount.X * _chunkCount.Y * sizeof(std::uint16_t));
+
+		for (std::int32_t y = 0; y < _layoutSize.Y; y++) {
+			for (std::int32_t x = 0; x < _layoutSize.X; x++) {
+				if (IsPendingActivation(_eventLayout[x + y * _layoutSize.X])) {
+					_pendingEventCounts[(x / ActivationChunkSize) + (y / ActivationChunkSize) * _chunkCount.X]++;
+				}
+			}
+		}
+	}
 }
\ No newline at end of file
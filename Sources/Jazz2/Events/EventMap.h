@@ -54,6 +54,8 @@ namespace Jazz2::Events
 		void StoreTileEvent(std::int32_t x, std::int32_t y, EventType eventType, Actors::ActorState eventFlags = Actors::ActorState::None, std::uint8_t* tileParams = nullptr);
 		/** @brief Preloads assets of all contained events */
 		void PreloadEventsAsync();
+		/** @brief Preloads assets of all contained events using specified event spawner */
+		void PreloadEventsAsync(EventSpawner* eventSpawner);
 
 		/** @brief Processes all generators */
 		void ProcessGenerators(float timeMult);
@@ -72,8 +74,8 @@ namespace Jazz2::Events
 		EventType GetEventByPosition(std::int32_t x, std::int32_t y, std::uint8_t** eventParams);
 		/** @brief Returns `true` if specified tile position contains an event */
 		bool HasEventByPosition(std::int32_t x, std::int32_t y) const;
-		/** @brief Calls specified callback function for each event */
-		void ForEachEvent(Function<bool(EventTile&, std::int32_t, std::int32_t)>&& forEachCallback) const;
+		/** @brief Calls specified callback function for each event, the event can be modified in the callback */
+		void ForEachEvent(Function<bool(EventTile&, std::int32_t, std::int32_t)>&& forEachCallback);
 		/** @brief Returns `true` if specified position contains hurt event */
 		bool IsHurting(float x, float y, Direction dir);
 		/** @overload */
@@ -96,6 +98,9 @@ namespace Jazz2::Events
 		void SerializeResumableToStream(Stream& dest, bool fromCheckpoint = false);
 
 	private:
+		/** @brief Size of a chunk in the activation index in tiles */
+		static constexpr std::int32_t ActivationChunkSize = 16;
+
 #ifndef DOXYGEN_GENERATING_OUTPUT
 		// Doxygen 1.12.0 outputs also private structs/unions even if it shouldn't
 		struct GeneratorInfo {
@@ -128,5 +133,12 @@ namespace Jazz2::Events
 		SmallVector<GeneratorInfo, 0> _generators;
 		SmallVector<SpawnPoint, 0> _spawnPoints;
 		SmallVector<WarpTarget, 0> _warpTargets;
+		// Number of events waiting for activation in each chunk, chunks without such events are skipped
+		Vector2i _chunkCount;
+		std::unique_ptr<std::uint16_t[]> _pendingEventCounts;
+
+		static bool IsPendingActivation(const EventTile& tile);
+		void UpdateActivationIndex(std::int32_t x, std::int32_t y, bool wasPending, bool isPending);
+		void RebuildActivationIndex();
 	};
 }
\ No newline at end of file
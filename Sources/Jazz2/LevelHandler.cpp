@@ -111,7 +111,7 @@ namespace Jazz2
 			_cheatsUsed(false), _checkpointCreated(false), _nextLevelType(ExitType::None),
 			_nextLevelTime(0.0f), _elapsedMillisecondsBegin(0), _elapsedFrames(0.0f), _checkpointFrames(0.0f),
 			_waterLevel(FLT_MAX), _weatherType(WeatherType::None), _pressedKeys(ValueInit, (std::size_t)Keys::Count),
-			_overrideActions(0)
+			_overrideActions(0), _deactivationPass(0)
 	{
 	}
 
@@ -418,6 +418,7 @@ namespace Jazz2
 
 		_eventMap = std::move(descriptor.EventMap);
 		_eventMap->SetLevelHandler(this);
+		InitializeDeactivationBuckets();
 
 		Vector2i levelBounds = _tileMap->GetLevelBounds();
 		_levelBounds = Recti(0, 0, levelBounds.X, levelBounds.Y);
@@ -588,6 +589,9 @@ namespace Jazz2
 				_scripts->OnLevelUpdate(timeMult);
 			}
 #endif
+
+			// Actors updated in parallel are updated before the scene graph, so they can't depend on the state of other actors in the same frame
+			UpdateActorsInParallel(timeMult);
 		}
 	}
 
@@ -851,6 +855,7 @@ namespace Jazz2
 			actor->_collisionProxyID = _collisions.CreateProxy(actor->AABB, actor.get());
 		}
 
+		AddToDeactivationBucket(actor.get());
 		_actors.push_back(std::move(actor));
 	}
 
@@ -1542,27 +1547,7 @@ namespace Jazz2
 				playerZones.emplace_back(activationRange.L - 4, activationRange.T - 4, activationRange.R + 4, activationRange.B + 4);
 			}
 
-			for (auto& actor : _actors) {
-				if ((actor->_state & (Actors::ActorState::IsCreatedFromEventMap | Actors::ActorState::IsFromGenerator)) != Actors::ActorState::None) {
-					Vector2i originTile = actor->_originTile;
-					bool isInside = false;
-					for (std::size_t i = 1; i < playerZones.size(); i += 2) {
-						if (playerZones[i].Contains(originTile)) {
-							isInside = true;
-							break;
-						}
-					}
-
-					if (!isInside && actor->OnTileDeactivated()) {
-						if ((actor->_state & Actors::ActorState::IsFromGenerator) == Actors::ActorState::IsFromGenerator) {
-							_eventMap->ResetGenerator(originTile.X, originTile.Y);
-						}
-
-						_eventMap->Deactivate(originTile.X, originTile.Y);
-						actor->_state |= Actors::ActorState::IsDestroyed;
-					}
-				}
-			}
+			DeactivateDistantActors(playerZones);
 
 			for (std::size_t i = 0; i < playerZones.size(); i += 2) {
 				const auto& activationZone = playerZones[i];
@@ -1585,6 +1570,171 @@ namespace Jazz2
 		_eventMap->ProcessGenerators(timeMult);
 	}
 
+	void LevelHandler::InitializeDeactivationBuckets()
+	{
+		Vector2i layoutSize = _eventMap->GetSize();
+		_deactivationChunkCount = Vector2i(std::max((layoutSize.X + DeactivationChunkSize - 1) / DeactivationChunkSize, 1),
+			std::max((layoutSize.Y + DeactivationChunkSize - 1) / DeactivationChunkSize, 1));
+		_deactivationBuckets = std::make_unique<DeactivationBucket[]>(_deactivationChunkCount.X * _deactivationChunkCount.Y);
+		_pendingDeactivationChunks.clear();
+		_lastPlayerChunkRanges.clear();
+	}
+
+	std::int32_t LevelHandler::GetDeactivationBucketIndex(Vector2i originTile) const
+	{
+		// Actors with origin outside of the level are stored in the nearest bucket on the edge
+		std::int32_t cx = std::clamp(originTile.X / DeactivationChunkSize, 0, _deactivationChunkCount.X - 1);
+		std::int32_t cy = std::clamp(originTile.Y / DeactivationChunkSize, 0, _deactivationChunkCount.Y - 1);
+		return cx + cy * _deactivationChunkCount.X;
+	}
+
+	void LevelHandler::AddToDeactivationBucket(Actors::ActorBase* actor)
+	{
+		if (_deactivationBuckets == nullptr ||
+			(actor->_state & (Actors::ActorState::IsCreatedFromEventMap | Actors::ActorState::IsFromGenerator)) == Actors::ActorState::None) {
+			return;
+		}
+
+		std::int32_t bucketIndex = GetDeactivationBucketIndex(actor->_originTile);
+		auto& bucket = _deactivationBuckets[bucketIndex];
+		bucket.Items.push_back(actor);
+
+		// The actor could be spawned outside of all player zones (e.g., on rollback), so check the bucket in the next pass
+		if (!bucket.IsPending) {
+			bucket.IsPending = true;
+			_pendingDeactivationChunks.push_back(bucketIndex);
+		}
+	}
+
+	void LevelHandler::RemoveFromDeactivationBucket(Actors::ActorBase* actor)
+	{
+		if (_deactivationBuckets == nullptr ||
+			(actor->_state & (Actors::ActorState::IsCreatedFromEventMap | Actors::ActorState::IsFromGenerator)) == Actors::ActorState::None) {
+			return;
+		}
+
+		auto& items = _deactivationBuckets[GetDeactivationBucketIndex(actor->_originTile)].Items;
+		for (auto it = items.begin(); it != items.end(); ++it) {
+			if (*it == actor) {
+				items.eraseUnordered(it);
+				break;
+			}
+		}
+	}
+
+	void LevelHandler::DeactivateDistantActors(ArrayView<const AABBi> playerZones)
+	{
+		ZoneScopedC(0x4876AF);
+
+		// Player zones contain activation range followed by extended range, only the extended range is used here
+		SmallVector<Recti, ControlScheme::MaxSupportedPlayers> chunkRanges;
+		for (std::size_t i = 1; i < playerZones.size(); i += 2) {
+			const auto& zone = playerZones[i];
+			std::int32_t cx1 = std::clamp(zone.L / DeactivationChunkSize, 0, _deactivationChunkCount.X - 1);
+			std::int32_t cy1 = std::clamp(zone.T / DeactivationChunkSize, 0, _deactivationChunkCount.Y - 1);
+			std::int32_t cx2 = std::clamp(zone.R / DeactivationChunkSize, 0, _deactivationChunkCount.X - 1);
+			std::int32_t cy2 = std::clamp(zone.B / DeactivationChunkSize, 0, _deactivationChunkCount.Y - 1);
+			chunkRanges.emplace_back(cx1, cy1, cx2 - cx1 + 1, cy2 - cy1 + 1);
+		}
+
+		_deactivationPass++;
+
+		std::int32_t checkedChunks = 0;
+		std::int32_t checkedActors = 0;
+
+		// Only chunks partially covered by a player zone, chunks that left player zones since the last pass and chunks
+		// with actors that refused to be deactivated need to be checked, all other actors are either inside a player zone
+		// or they were already deactivated
+		SmallVector<std::int32_t, 0> pendingChunks = std::move(_pendingDeactivationChunks);
+		_pendingDeactivationChunks.clear();
+		for (std::int32_t bucketIndex : pendingChunks) {
+			_deactivationBuckets[bucketIndex].IsPending = false;
+		}
+		for (std::int32_t bucketIndex : pendingChunks) {
+			if (CheckDeactivationBucket(bucketIndex, playerZones, checkedActors)) {
+				checkedChunks++;
+			}
+		}
+
+		for (auto* ranges : { &_lastPlayerChunkRanges, &chunkRanges }) {
+			for (const auto& range : *ranges) {
+				for (std::int32_t cy = range.Y; cy < range.Y + range.H; cy++) {
+					for (std::int32_t cx = range.X; cx < range.X + range.W; cx++) {
+						if (CheckDeactivationBucket(cx + cy * _deactivationChunkCount.X, playerZones, checkedActors)) {
+							checkedChunks++;
+						}
+					}
+				}
+			}
+		}
+
+		_lastPlayerChunkRanges = std::move(chunkRanges);
+
+		TracyPlot("Deactivation Chunks", static_cast<std::int64_t>(checkedChunks));
+		TracyPlot("Deactivation Actors", static_cast<std::int64_t>(checkedActors));
+	}
+
+	bool LevelHandler::CheckDeactivationBucket(std::int32_t bucketIndex, ArrayView<const AABBi> playerZones, std::int32_t& checkedActors)
+	{
+		auto& bucket = _deactivationBuckets[bucketIndex];
+		if (bucket.LastCheckedPass == _deactivationPass || bucket.Items.empty()) {
+			return false;
+		}
+		bucket.LastCheckedPass = _deactivationPass;
+
+		// Chunks on the edge of the level can also contain actors with origin outside of the level, so they are never skipped
+		std::int32_t cx = bucketIndex % _deactivationChunkCount.X;
+		std::int32_t cy = bucketIndex / _deactivationChunkCount.X;
+		AABBi chunkBounds(cx == 0 ? INT32_MIN : cx * DeactivationChunkSize,
+			cy == 0 ? INT32_MIN : cy * DeactivationChunkSize,
+			cx == _deactivationChunkCount.X - 1 ? INT32_MAX : (cx + 1) * DeactivationChunkSize - 1,
+			cy == _deactivationChunkCount.Y - 1 ? INT32_MAX : (cy + 1) * DeactivationChunkSize - 1);
+		for (std::size_t i = 1; i < playerZones.size(); i += 2) {
+			if (playerZones[i].Contains(chunkBounds)) {
+				return false;
+			}
+		}
+
+		bool shouldRetry = false;
+		// Deactivated actors are removed from the bucket later in ResolveCollisions(), but new actors can be added
+		for (std::size_t j = 0; j < bucket.Items.size(); j++) {
+			Actors::ActorBase* actor = bucket.Items[j];
+			Vector2i originTile = actor->_originTile;
+			bool isInside = false;
+			for (std::size_t i = 1; i < playerZones.size(); i += 2) {
+				if (playerZones[i].Contains(originTile)) {
+					isInside = true;
+					break;
+				}
+			}
+
+			if (isInside) {
+				continue;
+			}
+
+			if (actor->OnTileDeactivated()) {
+				if ((actor->_state & Actors::ActorState::IsFromGenerator) == Actors::ActorState::IsFromGenerator) {
+					_eventMap->ResetGenerator(originTile.X, originTile.Y);
+				}
+
+				_eventMap->Deactivate(originTile.X, originTile.Y);
+				actor->_state |= Actors::ActorState::IsDestroyed;
+			} else if (!actor->GetState(Actors::ActorState::IsDestroyed)) {
+				// The actor refused to be deactivated, try it again in the next pass
+				shouldRetry = true;
+			}
+		}
+
+		checkedActors += (std::int32_t)bucket.Items.size();
+
+		if (shouldRetry && !bucket.IsPending) {
+			bucket.IsPending = true;
+			_pendingDeactivationChunks.push_back(bucketIndex);
+		}
+
+		return true;
+	}
+
 	void LevelHandler::ProcessQueuedNextLevel()
 	{
 		bool playersReady = true;
@@ -1783,6 +1933,60 @@ namespace Jazz2
 		}
 	}
 
+	void LevelHandler::UpdateActorsInParallel(float timeMult)
+	{
+#if defined(WITH_THREADS)
+		auto& threadPool = theServiceLocator().GetThreadPool();
+		if (!PreferencesCache::EnableParallelUpdate || threadPool.GetWorkerCount() == 0 || !_rootNode->isUpdateEnabled()) {
+			return;
+		}
+
+		ZoneScopedC(0x4876AF);
+
+		constexpr Actors::ActorState RequiredState = Actors::ActorState::Initialized | Actors::ActorState::UpdateInParallel;
+
+		_parallelActors.clear();
+		for (auto& actor : _actors) {
+			// Frozen actors are excluded, because changing of the frozen state needs to access renderer resources
+			if ((actor->_state & (RequiredState | Actors::ActorState::IsDestroyed)) == RequiredState &&
+				actor->_frozenTimeLeft <= 0.0f && actor->_renderer.isUpdateEnabled()) {
+				_parallelActors.push_back(actor.get());
+			}
+		}
+
+		std::size_t batchCount = (_parallelActors.size() + ActorsPerParallelBatch - 1) / ActorsPerParallelBatch;
+		if (batchCount < 2) {
+			// Not worth it, all actors will be updated by the scene graph as usual
+			return;
+		}
+
+		if (_deferredCallbacks.size() < batchCount) {
+			_deferredCallbacks.resize(batchCount);
+		}
+
+		threadPool.ParallelFor(_parallelActors.size(), ActorsPerParallelBatch, [this, timeMult](std::size_t first, std::size_t last) {
+			ZoneScopedC(0x4876AF);
+
+			Actors::ActorBase::_deferredCallbacks = &_deferredCallbacks[first / ActorsPerParallelBatch];
+			for (std::size_t i = first; i < last; i++) {
+				Actors::ActorBase* actor = _parallelActors[i];
+				actor->OnUpdate(timeMult);
+				actor->_isUpdatedInParallel = true;
+			}
+			Actors::ActorBase::_deferredCallbacks = nullptr;
+		});
+
+		// Batches contain contiguous ranges of actors, so the callbacks are executed in the same order as if
+		// the actors were updated serially, regardless of the number of threads and their scheduling
+		for (std::size_t i = 0; i < batchCount; i++) {
+			for (auto& callback : _deferredCallbacks[i]) {
+				callback();
+			}
+			_deferredCallbacks[i].clear();
+		}
+#endif
+	}
+
 	void LevelHandler::ResolveCollisions(float timeMult)
 	{
 		ZoneScopedC(0x4876AF);
@@ -1796,6 +2000,7 @@ namespace Jazz2
 					_collisions.DestroyProxy(actor->_collisionProxyID);
 					actor->_collisionProxyID = Collisions::NullNode;
 				}
+				RemoveFromDeactivationBucket(actor);
 				it = _actors.eraseUnordered(it);
 				continue;
 			}
@@ -1814,6 +2019,10 @@ namespace Jazz2
 
 		struct UpdatePairsHelper {
 			void OnPairAdded(void* proxyA, void* proxyB) {
+				OnPairUpdated(proxyA, proxyB);
+			}
+
+			void OnPairUpdated(void* proxyA, void* proxyB) {
 				Actors::ActorBase* actorA = (Actors::ActorBase*)proxyA;
 				Actors::ActorBase* actorB = (Actors::ActorBase*)proxyB;
 				if (((actorA->GetState() | actorB->GetState()) & (Actors::ActorState::CollideWithOtherActors | Actors::ActorState::IsDestroyed)) != Actors::ActorState::CollideWithOtherActors) {
@@ -1821,13 +2030,16 @@ namespace Jazz2
 				}
 
 				if (actorA->IsCollidingWith(actorB)) {
-					std::shared_ptr<Actors::ActorBase> actorSharedA = actorA->shared_from_this();
-					std::shared_ptr<Actors::ActorBase> actorSharedB = actorB->shared_from_this();
-					if (!actorSharedA->OnHandleCollision(actorSharedB->shared_from_this())) {
-						actorSharedB->OnHandleCollision(actorSharedA->shared_from_this());
+					// Actors are owned by the level handler and they can't be removed here, so only the passed reference is needed
+					if (!actorA->OnHandleCollision(actorB->shared_from_this())) {
+						actorB->OnHandleCollision(actorA->shared_from_this());
 					}
 				}
 			}
+
+			void OnPairRemoved(void* proxyA, void* proxyB) {
+				// Actors are notified only while they overlap
+			}
 		};
 		UpdatePairsHelper helper;
 		_collisions.UpdatePairs(&helper);
@@ -268,6 +268,10 @@ namespace Jazz2
 		RumbleProcessor _rumble;
 		HashMap<String, std::shared_ptr<RumbleDescription>> _rumbleEffects;
 #endif
+#if defined(WITH_THREADS)
+		SmallVector<Actors::ActorBase*, 0> _parallelActors;
+		SmallVector<SmallVector<Function<void()>, 0>, 0> _deferredCallbacks;
+#endif
 #endif
 
 		/** @brief Invokes the specified callback asynchronously, usually at the end of current frame */
@@ -297,6 +301,13 @@ namespace Jazz2
 		Recti GetPlayerViewportBounds(std::int32_t w, std::int32_t h, std::int32_t index);
 		/** @brief Processes weather */
 		void ProcessWeather(float timeMult);
+		/**
+		 * @brief Updates actors with @ref Actors::ActorState::UpdateInParallel on worker threads if enabled
+		 *
+		 * These actors are updated at the end of @ref OnBeginFrame(), i.e., before all other actors
+		 * in the scene graph, instead of in the scene graph order.
+		 */
+		void UpdateActorsInParallel(float timeMult);
 		/** @brief Resolves collisions */
 		void ResolveCollisions(float timeMult);
 		/** @brief Assigns viewport */
@@ -322,6 +333,35 @@ namespace Jazz2
 #endif
 
 	private:
+#if defined(WITH_THREADS)
+		static constexpr std::size_t ActorsPerParallelBatch = 32;
+#endif
+		/** @brief Size of a chunk used for deactivation of distant actors in tiles */
+		static constexpr std::int32_t DeactivationChunkSize = 16;
+
+#ifndef DOXYGEN_GENERATING_OUTPUT
+		// Doxygen 1.12.0 outputs also private structs/unions even if it shouldn't
+		struct DeactivationBucket {
+			SmallVector<Actors::ActorBase*, 0> Items;
+			std::uint32_t LastCheckedPass;
+			bool IsPending;
+		};
+#endif
+
+		// Actors created from the event map or from generators bucketed by their origin chunk
+		Vector2i _deactivationChunkCount;
+		std::unique_ptr<DeactivationBucket[]> _deactivationBuckets;
+		SmallVector<std::int32_t, 0> _pendingDeactivationChunks;
+		SmallVector<Recti, ControlScheme::MaxSupportedPlayers> _lastPlayerChunkRanges;
+		std::uint32_t _deactivationPass;
+
+		void InitializeDeactivationBuckets();
+		std::int32_t GetDeactivationBucketIndex(Vector2i originTile) const;
+		void AddToDeactivationBucket(Actors::ActorBase* actor);
+		void RemoveFromDeactivationBucket(Actors::ActorBase* actor);
+		void DeactivateDistantActors(ArrayView<const AABBi> playerZones);
+		bool CheckDeactivationBucket(std::int32_t bucketIndex, ArrayView<const AABBi> playerZones, std::int32_t& checkedActors);
+
 		bool CheatKill();
 		bool CheatGod();
 		bool CheatNext();
@@ -0,0 +1,146 @@
+﻿#pragma once
+
+#if defined(WITH_MULTIPLAYER) || defined(DOXYGEN_GENERATING_OUTPUT)
+
+#include "../../Main.h"
+
+#include <Containers/ArrayView.h>
+#include <IO/MemoryStream.h>
+
+using namespace Death::Containers;
+using namespace Death::IO;
+
+namespace Jazz2::Multiplayer
+{
+	/**
+		@brief Writes values with arbitrary number of bits to @ref MemoryStream
+
+		Bits are packed from the least significant bit of each byte. Variable-width values are prefixed with 2-bit
+		index to the table of 4 widths, so small values (e.g., deltas) need only a few bits. The last byte
+		is padded with zeros in @ref Flush().
+	*/
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(MemoryStream& target)
+			: _target(target), _buffer(0), _bitCount(0) {}
+
+		~BitWriter() {
+			Flush();
+		}
+
+		BitWriter(const BitWriter&) = delete;
+		BitWriter& operator=(const BitWriter&) = delete;
+
+		/** @brief Writes the lowest @p bitCount bits of the value, @p bitCount must be in range 1–32 */
+		void WriteBits(std::uint32_t value, std::uint32_t bitCount) {
+			DEATH_DEBUG_ASSERT(bitCount > 0 && bitCount <= 32);
+			_buffer |= (std::uint64_t(value) & ((1ull << bitCount) - 1)) << _bitCount;
+			_bitCount += bitCount;
+			while (_bitCount >= 8) {
+				_target.WriteValue<std::uint8_t>(std::uint8_t(_buffer));
+				_buffer >>= 8;
+				_bitCount -= 8;
+			}
+		}
+
+		/** @brief Writes a single bit */
+		void WriteBool(bool value) {
+			WriteBits(value ? 1 : 0, 1);
+		}
+
+		/** @brief Writes unsigned value using the smallest sufficient width from the table */
+		void WriteVariableBits(std::uint32_t value, const std::uint8_t (&widths)[4]) {
+			std::uint32_t index = 0;
+			while (index < 3 && widths[index] < 32 && (value >> widths[index]) != 0) {
+				index++;
+			}
+			DEATH_DEBUG_ASSERT(widths[index] >= 32 || (value >> widths[index]) == 0, "Value doesn't fit to any width", );
+			WriteBits(index, 2);
+			WriteBits(value, widths[index]);
+		}
+
+		/** @brief Writes signed value using the smallest sufficient width from the table */
+		void WriteVariableSignedBits(std::int32_t value, const std::uint8_t (&widths)[4]) {
+			// ZigZag encoding keeps small negative values small
+			WriteVariableBits((std::uint32_t(value) << 1) ^ std::uint32_t(value >> 31), widths);
+		}
+
+		/** @brief Writes all pending bits to the stream, the last byte is padded with zeros */
+		void Flush() {
+			if (_bitCount > 0) {
+				_target.WriteValue<std::uint8_t>(std::uint8_t(_buffer));
+				_buffer = 0;
+				_bitCount = 0;
+			}
+		}
+
+	private:
+		MemoryStream& _target;
+		std::uint64_t _buffer;
+		std::uint32_t _bitCount;
+	};
+
+	/**
+		@brief Reads values written by @ref BitWriter
+
+		Reading past the end returns zeros and marks the reader as invalid, so the caller can check
+		@ref IsValid() once after all values are read.
+	*/
+	class BitReader
+	{
+	public:
+		explicit BitReader(ArrayView<const std::uint8_t> data)
+			: _data(data), _position(0), _buffer(0), _bitCount(0), _isValid(true) {}
+
+		/** @brief Reads @p bitCount bits, @p bitCount must be in range 1–32 */
+		std::uint32_t ReadBits(std::uint32_t bitCount) {
+			DEATH_DEBUG_ASSERT(bitCount > 0 && bitCount <= 32);
+			while (_bitCount < bitCount) {
+				std::uint64_t value = 0;
+				if DEATH_LIKELY(_position < _data.size()) {
+					value = _data[_position++];
+				} else {
+					_isValid = false;
+				}
+				_buffer |= value << _bitCount;
+				_bitCount += 8;
+			}
+			std::uint32_t result = std::uint32_t(_buffer & ((1ull << bitCount) - 1));
+			_buffer >>= bitCount;
+			_bitCount -= bitCount;
+			return result;
+		}
+
+		/** @brief Reads a single bit */
+		bool ReadBool() {
+			return (ReadBits(1) != 0);
+		}
+
+		/** @brief Reads unsigned value written by @ref BitWriter::WriteVariableBits() with the same table */
+		std::uint32_t ReadVariableBits(const std::uint8_t (&widths)[4]) {
+			std::uint32_t index = ReadBits(2);
+			return ReadBits(widths[index]);
+		}
+
+		/** @brief Reads signed value written by @ref BitWriter::WriteVariableSignedBits() with the same table */
+		std::int32_t ReadVariableSignedBits(const std::uint8_t (&widths)[4]) {
+			std::uint32_t value = ReadVariableBits(widths);
+			return std::int32_t((value >> 1) ^ (0u - (value & 1)));
+		}
+
+		/** @brief Returns `false` if the reader tried to read past the end */
+		bool IsValid() const {
+			return _isValid;
+		}
+
+	private:
+		ArrayView<const std::uint8_t> _data;
+		std::size_t _position;
+		std::uint64_t _buffer;
+		std::uint32_t _bitCount;
+		bool _isValid;
+	};
+}
+
+#endif
@@ -0,0 +1,233 @@
+﻿#include "ContentBenchmark.h"
+
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+
+#include "../ContentResolver.h"
+#include "../Events/EventMap.h"
+#include "../Events/EventSpawner.h"
+#include "../Tiles/TileMap.h"
+#include "../../nCine/ServiceLocator.h"
+#include "../../nCine/Base/Algorithms.h"
+#include "../../nCine/Base/TimeStamp.h"
+#include "../../nCine/Threading/Thread.h"
+
+#include <Containers/Array.h>
+#include <IO/FileSystem.h>
+#include <IO/PakFile.h>
+
+#include <cstdio>
+
+#if defined(DEATH_TARGET_UNIX)
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+using namespace Death::Containers::Literals;
+using namespace Death::IO;
+using namespace nCine;
+
+namespace Jazz2::Multiplayer
+{
+	bool ContentBenchmark::RunAnimations(std::uint32_t runCount)
+	{
+		SmallVector<String, 0> paths;
+		CollectSprites(paths);
+		if (paths.empty()) {
+			fputs("No sprites found in \"Cache/Animations\"\n", stdout);
+			return false;
+		}
+
+		auto& resolver = ContentResolver::Get();
+		Array<float> runTimesMs(NoInit, runCount);
+		std::uint64_t totalPixels = 0;
+		std::uint32_t failedCount = 0;
+
+		for (std::uint32_t i = 0; i < runCount; i++) {
+			ReleaseCachedAssets();
+
+			totalPixels = 0;
+			failedCount = 0;
+			TimeStamp startTime = TimeStamp::now();
+			for (const String& path : paths) {
+				GenericGraphicResource* graphics = resolver.RequestGraphics(path, 0);
+				if (graphics != nullptr) {
+					totalPixels += (std::uint64_t)(graphics->FrameDimensions.X * graphics->FrameConfiguration.X) *
+						(std::uint64_t)(graphics->FrameDimensions.Y * graphics->FrameConfiguration.Y);
+				} else {
+					failedCount++;
+				}
+			}
+			runTimesMs[i] = startTime.millisecondsSince();
+		}
+
+		ReleaseCachedAssets();
+
+		nCine::sort(runTimesMs.begin(), runTimesMs.end());
+		float minTimeMs = runTimesMs[0];
+
+		fprintf(stdout, "\nAnimations benchmark: %u sprites, %.1f Mpx, %u runs\n\n", (std::uint32_t)paths.size(), totalPixels / 1000000.0, runCount);
+		fprintf(stdout, "%-24s min %8.1f | p50 %8.1f | max %8.1f\n", "Decoding time (ms)", minTimeMs, runTimesMs[runCount / 2], runTimesMs[runCount - 1]);
+		fprintf(stdout, "%-24s %8.1f Mpx/s\n", "Throughput", (minTimeMs > 0.0f ? totalPixels / 1000.0 / minTimeMs : 0.0));
+		if (failedCount > 0) {
+			fprintf(stdout, "%u sprites cannot be loaded\n", failedCount);
+		}
+
+		return (failedCount == 0);
+	}
+
+	bool ContentBenchmark::RunLevel(StringView levelName, std::uint32_t runCount)
+	{
+		auto& resolver = ContentResolver::Get();
+		bool wasAsyncLoadingEnabled = resolver.IsAsyncLoadingEnabled();
+
+		fprintf(stdout, "\nLevel loading benchmark: %s, %u runs\n\n", String::nullTerminatedView(levelName).data(), runCount);
+		if (theServiceLocator().GetThreadPool().GetWorkerCount() == 0) {
+			fputs("No worker threads are available, asynchronous loading falls back to synchronous loading\n", stdout);
+		}
+#if !defined(DEATH_TARGET_UNIX)
+		fputs("File cache cannot be evicted on this platform, files may be read from memory\n", stdout);
+#endif
+
+		Array<float> loadTimesMs(NoInit, runCount);
+		Array<float> totalTimesMs(NoInit, runCount);
+
+		for (bool asyncLoading : { false, true }) {
+			resolver.SetAsyncLoadingEnabled(asyncLoading);
+
+			for (std::uint32_t i = 0; i < runCount; i++) {
+				ReleaseCachedAssets();
+				EvictFileCache();
+
+				TimeStamp startTime = TimeStamp::now();
+				resolver.BeginLoading();
+
+				// TryLoadLevel() also fails if any tileset cannot be loaded, including tilesets preloaded asynchronously
+				LevelDescriptor descriptor;
+				if (!resolver.TryLoadLevel(levelName, GameDifficulty::Normal, descriptor)) {
+					resolver.EndLoading();
+					resolver.SetAsyncLoadingEnabled(wasAsyncLoadingEnabled);
+					fprintf(stdout, "Level \"%s\" cannot be loaded\n", String::nullTerminatedView(levelName).data());
+					return false;
+				}
+
+				// Events are preloaded without any level handler, preload functions don't depend on it
+				Events::EventSpawner eventSpawner(nullptr);
+				descriptor.EventMap->PreloadEventsAsync(&eventSpawner);
+
+				resolver.EndLoading();
+				loadTimesMs[i] = startTime.millisecondsSince();
+
+				while (HasPendingLoads()) {
+					resolver.ProcessPendingLoads();
+					Thread::Sleep(1);
+				}
+				totalTimesMs[i] = startTime.millisecondsSince();
+			}
+
+			nCine::sort(loadTimesMs.begin(), loadTimesMs.end());
+			nCine::sort(totalTimesMs.begin(), totalTimesMs.end());
+
+			fprintf(stdout, "%s loading:\n", asyncLoading ? "Asynchronous" : "Synchronous");
+			fprintf(stdout, "%-24s min %8.1f | p50 %8.1f | max %8.1f\n", "  Blocking time (ms)", loadTimesMs[0], loadTimesMs[runCount / 2], loadTimesMs[runCount - 1]);
+			fprintf(stdout, "%-24s min %8.1f | p50 %8.1f | max %8.1f\n", "  Total time (ms)", totalTimesMs[0], totalTimesMs[runCount / 2], totalTimesMs[runCount - 1]);
+		}
+
+		ReleaseCachedAssets();
+		resolver.SetAsyncLoadingEnabled(wasAsyncLoadingEnabled);
+		return true;
+	}
+
+	void ContentBenchmark::CollectSprites(SmallVectorImpl<String>& paths)
+	{
+		auto& resolver = ContentResolver::Get();
+
+		// Sprites are usually stored in "Cache/Source.pak", only .pak files mounted to the root are searched
+		for (auto& pak : resolver._mountedPaks) {
+			if (!pak->GetMountPoint().empty()) {
+				continue;
+			}
+
+			SmallVector<String, 0> queue;
+			queue.emplace_back("Animations"_s);
+			for (std::size_t i = 0; i < queue.size(); i++) {
+				for (auto item : PakFile::Directory(*pak, queue[i], fs::EnumerationOptions::SkipFiles)) {
+					queue.emplace_back(item);
+				}
+				for (auto item : PakFile::Directory(*pak, queue[i], fs::EnumerationOptions::SkipDirectories)) {
+					if (fs::GetExtension(item) == "aura"_s) {
+						// Paths are relative to "Animations" directory
+						paths.emplace_back(item.exceptPrefix(queue[0].size() + 1));
+					}
+				}
+			}
+		}
+
+		if (!paths.empty()) {
+			return;
+		}
+
+		// Sprites were extracted directly to "Cache/Animations" in older versions
+		String rootPath = fs::CombinePath(resolver.GetCachePath(), "Animations"_s);
+		SmallVector<String, 0> queue;
+		queue.push_back(rootPath);
+		for (std::size_t i = 0; i < queue.size(); i++) {
+			for (auto item : fs::Directory(queue[i], fs::EnumerationOptions::SkipFiles)) {
+				queue.emplace_back(item);
+			}
+			for (auto item : fs::Directory(queue[i], fs::EnumerationOptions::SkipDirectories)) {
+				if (fs::GetExtension(item) == "aura"_s) {
+					paths.emplace_back(item.exceptPrefix(rootPath.size() + 1));
+				}
+			}
+		}
+	}
+
+	void ContentBenchmark::ReleaseCachedAssets()
+	{
+		auto& resolver = ContentResolver::Get();
+		resolver.DiscardPendingLoads();
+		resolver._cachedMetadata.clear();
+		resolver._cachedGraphics.clear();
+#if defined(WITH_AUDIO)
+		resolver._cachedSounds.clear();
+#endif
+	}
+
+	bool ContentBenchmark::HasPendingLoads()
+	{
+		auto& resolver = ContentResolver::Get();
+		return !(resolver._pendingMetadata.empty() && resolver._pendingGraphics.empty() && resolver._pendingFiles.empty());
+	}
+
+	void ContentBenchmark::EvictFileCache()
+	{
+		auto& resolver = ContentResolver::Get();
+		EvictFileCache(resolver.GetContentPath());
+		EvictFileCache(resolver.GetCachePath());
+	}
+
+	void ContentBenchmark::EvictFileCache(StringView path)
+	{
+#if defined(DEATH_TARGET_UNIX)
+		// Drop cached pages of all files, so they have to be read from the disk again (only clean pages can be dropped)
+		SmallVector<String, 0> queue;
+		queue.emplace_back(path);
+		for (std::size_t i = 0; i < queue.size(); i++) {
+			for (auto item : fs::Directory(queue[i], fs::EnumerationOptions::SkipFiles)) {
+				queue.emplace_back(item);
+			}
+			for (auto item : fs::Directory(queue[i], fs::EnumerationOptions::SkipDirectories)) {
+				std::int32_t fd = ::open(String::nullTerminatedView(item).data(), O_RDONLY);
+				if (fd >= 0) {
+					::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+					::close(fd);
+				}
+			}
+		}
+#else
+		static_cast<void>(path);
+#endif
+	}
+}
+
+#endif
\ No newline at end of file
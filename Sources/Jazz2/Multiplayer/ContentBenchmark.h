@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#if (defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)) || defined(DOXYGEN_GENERATING_OUTPUT)
+
+#include "../../Main.h"
+
+#include <Containers/SmallVector.h>
+#include <Containers/String.h>
+#include <Containers/StringView.h>
+
+using namespace Death::Containers;
+
+namespace Jazz2::Multiplayer
+{
+	/**
+		@brief Headless benchmark of loading assets
+
+		Decodes all sprites from `Cache/Animations` repeatedly with empty caches and measures the total time.
+		Levels are loaded with cold file cache (if supported by the platform) once synchronously and once with
+		asynchronous preloading on worker threads. Assets are decoded the same way as by the dedicated server,
+		i.e. without creating any textures.
+
+		@experimental
+	*/
+	class ContentBenchmark
+	{
+	public:
+		ContentBenchmark() = delete;
+		~ContentBenchmark() = delete;
+
+		/** @brief Decodes all sprites the specified number of times, returns `false` if any of them cannot be loaded */
+		static bool RunAnimations(std::uint32_t runCount);
+		/** @brief Loads the level the specified number of times in each mode, returns `false` if it cannot be loaded */
+		static bool RunLevel(StringView levelName, std::uint32_t runCount);
+
+	private:
+		static void CollectSprites(SmallVectorImpl<String>& paths);
+		static void ReleaseCachedAssets();
+		static bool HasPendingLoads();
+		static void EvictFileCache();
+		static void EvictFileCache(StringView path);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,770 @@
+﻿#include "MpBenchmark.h"
+
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+
+#include "INetworkHandler.h"
+#include "MpLevelHandler.h"
+#include "NetworkManagerBase.h"
+#include "PacketTypes.h"
+#include "SnapshotCompressor.h"
+#include "../PlayerAction.h"
+#include "../PlayerType.h"
+#include "../Actors/ActorBase.h"
+#include "../Collisions/DynamicTreeBroadPhase.h"
+#include "../../nCine/Application.h"
+#include "../../nCine/Base/Algorithms.h"
+#include "../../nCine/Base/Clock.h"
+#include "../../nCine/Base/FrameTimer.h"
+#include "../../nCine/Base/HashMap.h"
+#include "../../nCine/Base/Random.h"
+
+#include <IO/FileSystem.h>
+#include <IO/MemoryStream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(DEATH_TARGET_WINDOWS)
+#	include <CommonWindows.h>
+#else
+#	include <time.h>
+#endif
+
+using namespace Death::Containers::Literals;
+using namespace Death::IO;
+using namespace nCine;
+
+namespace
+{
+	// Allocations of all threads (including worker threads and the network thread of the server) are counted,
+	// only threads of bots are excluded, so they don't affect the server
+	std::atomic<std::uint64_t> AllocationCount{0};
+	thread_local bool IsAllocationCountExcluded = false;
+
+	void CountAllocation()
+	{
+		if (!IsAllocationCountExcluded) {
+			AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void* AllocateCounted(std::size_t count) noexcept
+	{
+		CountAllocation();
+		return std::malloc(count != 0 ? count : 1);
+	}
+
+	void* AllocateAlignedCounted(std::size_t count, std::align_val_t alignment) noexcept
+	{
+		CountAllocation();
+		if (count == 0) {
+			count = 1;
+		}
+#if defined(DEATH_TARGET_WINDOWS)
+		return ::_aligned_malloc(count, (std::size_t)alignment);
+#else
+		void* ptr;
+		std::size_t align = std::max((std::size_t)alignment, sizeof(void*));
+		return (::posix_memalign(&ptr, align, count) == 0 ? ptr : nullptr);
+#endif
+	}
+
+	void FreeAligned(void* ptr) noexcept
+	{
+#if defined(DEATH_TARGET_WINDOWS)
+		::_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+
+	void* CheckAllocation(void* ptr)
+	{
+		if DEATH_UNLIKELY(ptr == nullptr) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+			throw std::bad_alloc();
+#else
+			std::abort();
+#endif
+		}
+		return ptr;
+	}
+}
+
+// Tracy replaces the global allocator on its own in "tracy_memory.cpp"
+#if !defined(WITH_TRACY)
+void* operator new(std::size_t count)
+{
+	return CheckAllocation(AllocateCounted(count));
+}
+
+void* operator new[](std::size_t count)
+{
+	return CheckAllocation(AllocateCounted(count));
+}
+
+void* operator new(std::size_t count, const std::nothrow_t&) noexcept
+{
+	return AllocateCounted(count);
+}
+
+void* operator new[](std::size_t count, const std::nothrow_t&) noexcept
+{
+	return AllocateCounted(count);
+}
+
+void* operator new(std::size_t count, std::align_val_t alignment)
+{
+	return CheckAllocation(AllocateAlignedCounted(count, alignment));
+}
+
+void* operator new[](std::size_t count, std::align_val_t alignment)
+{
+	return CheckAllocation(AllocateAlignedCounted(count, alignment));
+}
+
+void* operator new(std::size_t count, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAlignedCounted(count, alignment);
+}
+
+void* operator new[](std::size_t count, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAlignedCounted(count, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t size) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size, std::align_val_t alignment) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t size, std::align_val_t alignment) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	FreeAligned(ptr);
+}
+#endif
+
+namespace Jazz2::Multiplayer
+{
+	/** @brief Simulated player connected to the local server */
+	class MpBenchmark::Bot : public INetworkHandler
+	{
+	public:
+		Bot(std::uint32_t index, std::uint16_t serverPort, std::uint32_t clientData, std::uint64_t gameVersion);
+		~Bot();
+
+		bool IsSpawned() const {
+			return _isSpawned.load(std::memory_order_acquire);
+		}
+
+		std::uint64_t GetReceivedBytes() const {
+			return _receivedBytes.load(std::memory_order_relaxed);
+		}
+
+		ConnectionResult OnPeerConnected(const Peer& peer, std::uint32_t clientData) override;
+		void OnPeerDisconnected(const Peer& peer, Reason reason) override;
+		void OnPacketReceived(const Peer& peer, std::uint8_t channelId, std::uint8_t packetType, ArrayView<const std::uint8_t> data) override;
+
+	private:
+		// Scripted input changes every N received updates
+		static constexpr std::uint32_t UpdatesPerInputPhase = 20;
+
+		NetworkManagerBase _networkManager;
+		SnapshotCompressor _snapshotCompressor;
+		std::uint32_t _index;
+		std::uint64_t _gameVersion;
+		Uuid _uniquePlayerId;
+		Uuid _uniqueServerId;
+		std::uint32_t _playerIndex;
+		std::uint32_t _lastUpdated;
+		std::uint32_t _receivedUpdates;
+		std::uint32_t _inputSeqNum;
+		std::uint64_t _lastSentTime;
+		std::atomic_bool _isSpawned;
+		std::atomic<std::uint64_t> _receivedBytes;
+
+		void OnUpdateAllActors(ArrayView<const std::uint8_t> data);
+		void SendPlayerUpdate();
+		std::uint64_t GetScriptedKeys() const;
+	};
+
+	MpBenchmark::Bot::Bot(std::uint32_t index, std::uint16_t serverPort, std::uint32_t clientData, std::uint64_t gameVersion)
+		: _index(index), _gameVersion(gameVersion), _uniqueServerId{}, _playerIndex(0), _lastUpdated(0), _receivedUpdates(0),
+			_inputSeqNum(0), _lastSentTime(0), _isSpawned(false), _receivedBytes(0)
+	{
+		// Each bot must look like a different player to the server
+		Random().Uuid(_uniquePlayerId);
+
+		_networkManager.CreateClient(this, "127.0.0.1"_s, serverPort, clientData);
+	}
+
+	MpBenchmark::Bot::~Bot()
+	{
+		_networkManager.Dispose();
+	}
+
+	ConnectionResult MpBenchmark::Bot::OnPeerConnected(const Peer& peer, std::uint32_t clientData)
+	{
+		// Callbacks of each bot are called on its own network thread
+		IsAllocationCountExcluded = true;
+
+		char playerName[16];
+		std::size_t playerNameLength = formatInto(playerName, "Bot {}", _index + 1);
+
+		MemoryStream packet(64);
+		packet.Write("J2R ", 4);
+		packet.WriteVariableUint64(_gameVersion);
+		packet.Write(_uniquePlayerId.data(), _uniquePlayerId.size());
+		packet.WriteVariableUint32(0);	// Password
+		packet.WriteValue<std::uint8_t>((std::uint8_t)playerNameLength);
+		packet.Write(playerName, (std::uint32_t)playerNameLength);
+		packet.WriteValue<std::uint8_t>(0);	// Device ID
+		packet.WriteVariableUint64(0);	// User ID
+
+		_networkManager.SendTo(peer, NetworkChannel::Main, (std::uint8_t)ClientPacketType::Auth, packet);
+		return true;
+	}
+
+	void MpBenchmark::Bot::OnPeerDisconnected(const Peer& peer, Reason reason)
+	{
+		IsAllocationCountExcluded = true;
+
+		LOGW("[MP] Bot {} disconnected: {} ({})", _index + 1, NetworkManagerBase::ReasonToString(reason), reason);
+		_isSpawned.store(false, std::memory_order_release);
+	}
+
+	void MpBenchmark::Bot::OnPacketReceived(const Peer& peer, std::uint8_t channelId, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
+	{
+		IsAllocationCountExcluded = true;
+		_receivedBytes.fetch_add(data.size() + 1, std::memory_order_relaxed);
+
+		switch ((ServerPacketType)packetType) {
+			case ServerPacketType::AuthResponse: {
+				MemoryStream packet(data);
+				/*std::uint8_t flags =*/ packet.ReadValue<std::uint8_t>();
+				packet.Read(_uniqueServerId.data(), _uniqueServerId.size());
+				break;
+			}
+			case ServerPacketType::ValidateAssets: {
+				// Assets are validated the same way as by the regular client, but they are always present locally
+				MemoryStream packet(data);
+				std::uint32_t assetCount = packet.ReadVariableUint32();
+
+				MemoryStream packetOut(8 + assetCount * 64);
+				packetOut.WriteVariableUint32(assetCount);
+				for (std::uint32_t i = 0; i < assetCount; i++) {
+					MpLevelHandler::AssetType type = (MpLevelHandler::AssetType)packet.ReadValue<std::uint8_t>();
+					std::uint32_t pathLength = packet.ReadVariableUint32();
+					String path{NoInit, pathLength};
+					packet.Read(path.data(), pathLength);
+
+					packetOut.WriteValue<std::uint8_t>((std::uint8_t)type);
+					packetOut.WriteVariableUint32((std::uint32_t)path.size());
+					packetOut.Write(path.data(), (std::int64_t)path.size());
+
+					auto fullPath = MpLevelHandler::GetAssetFullPath(type, path, _uniqueServerId);
+					if (!fullPath.empty()) {
+						auto s = fs::Open(fullPath, FileAccess::Read);
+						packetOut.WriteVariableInt64(s->GetSize());
+						packetOut.WriteValue<std::uint32_t>(nCine::crc32(*s));
+					} else {
+						packetOut.WriteVariableInt64(0);
+						packetOut.WriteValue<std::uint32_t>(0);
+					}
+				}
+
+				_networkManager.SendTo(peer, NetworkChannel::Main, (std::uint8_t)ClientPacketType::ValidateAssetsResponse, packetOut);
+				break;
+			}
+			case ServerPacketType::LoadLevel: {
+				// The level is already loaded by the server in the same process, so the bot is ready immediately
+				MemoryStream packet = NetworkManagerBase::CreatePacket(21);
+				packet.WriteValue<std::uint8_t>(0);	// Flags
+				packet.WriteVariableUint32((std::uint32_t)MpLevelHandler::DefaultWidth);
+				packet.WriteVariableUint32((std::uint32_t)MpLevelHandler::DefaultHeight);
+				packet.WriteVariableUint32(SnapshotCompressor::GetSupportedMethods());
+				packet.WriteVariableUint32(_snapshotCompressor.GetDictionaryId());
+				_networkManager.SendTo(peer, NetworkChannel::Main, (std::uint8_t)ClientPacketType::LevelReady, std::move(packet));
+				break;
+			}
+			case ServerPacketType::ShowInGameLobby: {
+				static const PlayerType PlayerTypes[] = { PlayerType::Jazz, PlayerType::Spaz, PlayerType::Lori };
+
+				MemoryStream packet = NetworkManagerBase::CreatePacket(2);
+				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerTypes[_index % arraySize(PlayerTypes)]);
+				packet.WriteValue<std::uint8_t>(0);	// Team
+				_networkManager.SendTo(peer, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerReady, std::move(packet));
+				break;
+			}
+			case ServerPacketType::CreateControllablePlayer: {
+				MemoryStream packet(data);
+				_playerIndex = packet.ReadVariableUint32();
+				/*PlayerType playerType =*/ packet.ReadValue<std::uint8_t>();
+				/*std::int32_t health =*/ packet.ReadVariableInt32();
+				/*std::uint8_t flags =*/ packet.ReadValue<std::uint8_t>();
+				/*std::uint8_t teamId =*/ packet.ReadValue<std::uint8_t>();
+				/*std::int32_t posX =*/ packet.ReadVariableInt32();
+				/*std::int32_t posY =*/ packet.ReadVariableInt32();
+				_isSpawned.store(true, std::memory_order_release);
+				break;
+			}
+			case ServerPacketType::UpdateAllActors: {
+				OnUpdateAllActors(data);
+				break;
+			}
+		}
+	}
+
+	void MpBenchmark::Bot::OnUpdateAllActors(ArrayView<const std::uint8_t> data)
+	{
+		MemoryStream packet(1024);
+		if (!_snapshotCompressor.Decompress(data, packet)) {
+			LOGW("[MP] Bot {} failed to decompress {} bytes", _index + 1, data.size());
+			return;
+		}
+		packet.Seek(0, SeekOrigin::Begin);
+		std::uint32_t updateId = packet.ReadVariableUint32();
+		/*std::uint64_t elapsedFrames =*/ packet.ReadVariableUint64();
+		/*std::uint32_t baselineId =*/ packet.ReadVariableUint32();
+
+		if (_lastUpdated >= updateId) {
+			return;
+		}
+
+		// Content of the snapshot is not needed by the bot, it's only acknowledged
+		_lastUpdated = updateId;
+		_receivedUpdates++;
+
+		if (_playerIndex != 0) {
+			SendPlayerUpdate();
+		}
+	}
+
+	void MpBenchmark::Bot::SendPlayerUpdate()
+	{
+		Clock& c = nCine::clock();
+		std::uint64_t now = c.now() * 1000 / c.frequency();
+		// The server drops updates that are not newer than the previous one
+		if (now <= _lastSentTime) {
+			now = _lastSentTime + 1;
+		}
+		float timeMult = (_lastSentTime != 0 ? (now - _lastSentTime) * FrameTimer::FramesPerSecond / 1000.0f : 1.0f);
+		_lastSentTime = now;
+
+		_inputSeqNum++;
+
+		// The bot doesn't simulate anything, so it sends only one input frame per update, which covers the whole update interval
+		MemoryStream packet = NetworkManagerBase::CreatePacket(32);
+		packet.WriteVariableUint32(_playerIndex);
+		packet.WriteVariableUint64(now);
+		packet.WriteVariableUint32(_lastUpdated);
+		packet.WriteVariableUint32(_inputSeqNum);
+		packet.WriteVariableUint32(1);
+		packet.WriteVariableUint64(GetScriptedKeys());
+		packet.WriteValue<std::uint8_t>((std::uint8_t)std::clamp((std::int32_t)(timeMult * MpLevelHandler::InputTimeMultScale), 1, 255));
+		_networkManager.SendTo(AllPeers, NetworkChannel::UnreliableUpdates, (std::uint8_t)ClientPacketType::PlayerUpdate, std::move(packet));
+	}
+
+	std::uint64_t MpBenchmark::Bot::GetScriptedKeys() const
+	{
+		// Bots run back and forth, jump and shoot, each bot starts in a different phase
+		constexpr std::uint64_t Left = (1ull << (std::uint32_t)PlayerAction::Left);
+		constexpr std::uint64_t Right = (1ull << (std::uint32_t)PlayerAction::Right);
+		constexpr std::uint64_t Fire = (1ull << (std::uint32_t)PlayerAction::Fire);
+		constexpr std::uint64_t Jump = (1ull << (std::uint32_t)PlayerAction::Jump);
+		constexpr std::uint64_t Run = (1ull << (std::uint32_t)PlayerAction::Run);
+
+		switch ((_receivedUpdates / UpdatesPerInputPhase + _index) % 6) {
+			default:
+			case 0: return Right | Run;
+			case 1: return Right | Run | Jump;
+			case 2: return Right | Fire;
+			case 3: return Left | Run;
+			case 4: return Left | Run | Jump;
+			case 5: return Left | Fire;
+		}
+	}
+
+	MpBenchmark::MpBenchmark(std::uint16_t serverPort, std::uint32_t botCount, std::uint32_t tickCount, std::uint32_t clientData, std::uint64_t gameVersion)
+		: _serverPort(serverPort), _clientData(clientData), _botCount(botCount), _gameVersion(gameVersion), _tickCount(tickCount), _measuredTicks(0),
+			_botsStarted(false), _measuring(false), _warmupFrames(0.0f), _tickStartTime(0), _tickStartCpuTime(0), _tickStartAllocations(0),
+			_tickTimesMs(ValueInit, tickCount), _tickCpuTimesMs(ValueInit, tickCount), _tickAllocations(ValueInit, tickCount),
+			_updateSizesAtStart{}, _updateSizesAtEnd{}, _receivedBytesAtStart(0), _receivedBytesAtEnd(0), _spawnedBotCount(0)
+	{
+		_bots.reserve(botCount);
+	}
+
+	MpBenchmark::~MpBenchmark()
+	{
+	}
+
+	void MpBenchmark::OnBeginTick()
+	{
+		if (!_measuring) {
+			return;
+		}
+
+		Clock& c = nCine::clock();
+		_tickStartTime = c.now();
+		_tickStartCpuTime = GetThreadCpuTime();
+		_tickStartAllocations = GetAllocationCount();
+	}
+
+	bool MpBenchmark::OnEndTick(MpLevelHandler* levelHandler)
+	{
+		if (levelHandler == nullptr) {
+			// Level is not loaded yet
+			return true;
+		}
+
+		if (!_botsStarted) {
+			_botsStarted = true;
+			StartBots();
+			return true;
+		}
+
+		if (!_measuring) {
+			std::uint32_t spawnedBotCount = 0;
+			for (const auto& bot : _bots) {
+				if (bot->IsSpawned()) {
+					spawnedBotCount++;
+				}
+			}
+
+			_warmupFrames += theApplication().GetTimeMult();
+			bool timedOut = (_warmupFrames * FrameTimer::SecondsPerFrame >= MaxWarmupSecs);
+			if (spawnedBotCount < _botCount && !timedOut) {
+				return true;
+			}
+			if (spawnedBotCount < _botCount) {
+				LOGW("[MP] Only {} of {} bots spawned in {} seconds", spawnedBotCount, _botCount, (std::int32_t)MaxWarmupSecs);
+			}
+
+			LOGI("[MP] Measuring {} ticks with {} bots...", _tickCount, spawnedBotCount);
+			_spawnedBotCount = spawnedBotCount;
+			_updateSizesAtStart = GetUpdateSizes(levelHandler);
+			_receivedBytesAtStart = GetReceivedBytes();
+			_measuring = true;
+			return true;
+		}
+
+		std::uint64_t allocations = GetAllocationCount() - _tickStartAllocations;
+		std::uint64_t cpuTime = GetThreadCpuTime() - _tickStartCpuTime;
+		Clock& c = nCine::clock();
+		std::uint64_t time = c.now() - _tickStartTime;
+
+		_tickTimesMs[_measuredTicks] = (float)(time * 1000.0 / c.frequency());
+		_tickCpuTimesMs[_measuredTicks] = (float)(cpuTime / 1000000.0);
+		_tickAllocations[_measuredTicks] = (std::uint32_t)allocations;
+		_measuredTicks++;
+
+		RecordActorTrace(levelHandler);
+
+		if (_measuredTicks < _tickCount) {
+			return true;
+		}
+
+		_updateSizesAtEnd = GetUpdateSizes(levelHandler);
+		_receivedBytesAtEnd = GetReceivedBytes();
+		return false;
+	}
+
+	void MpBenchmark::PrintReport() const
+	{
+		if (_measuredTicks == 0) {
+			fputs("No ticks were measured\n", stdout);
+			return;
+		}
+
+		auto printStats = [this](const char* name, ArrayView<const float> values) {
+			Array<float> sorted(NoInit, _measuredTicks);
+			std::memcpy(sorted.data(), values.data(), _measuredTicks * sizeof(float));
+			nCine::sort(sorted.begin(), sorted.end());
+
+			double total = 0.0;
+			for (float value : sorted) {
+				total += value;
+			}
+
+			fprintf(stdout, "%-24s avg %8.3f | p50 %8.3f | p99 %8.3f | max %8.3f\n", name, total / _measuredTicks,
+				sorted[_measuredTicks / 2], sorted[std::min(_measuredTicks - 1, _measuredTicks * 99 / 100)], sorted[_measuredTicks - 1]);
+		};
+
+		fprintf(stdout, "\nMultiplayer benchmark: %u ticks, %u of %u bots\n\n", _measuredTicks, _spawnedBotCount, _botCount);
+
+		printStats("Tick time (ms)", arrayView(_tickTimesMs.data(), _measuredTicks));
+		printStats("Tick CPU time (ms)", arrayView(_tickCpuTimesMs.data(), _measuredTicks));
+
+#if !defined(WITH_TRACY)
+		std::uint64_t totalAllocations = 0;
+		std::uint32_t maxAllocations = 0;
+		for (std::uint32_t i = 0; i < _measuredTicks; i++) {
+			totalAllocations += _tickAllocations[i];
+			maxAllocations = std::max(maxAllocations, _tickAllocations[i]);
+		}
+		fprintf(stdout, "%-24s avg %8.1f | max %8u\n", "Allocations per tick", (double)totalAllocations / _measuredTicks, maxAllocations);
+#else
+		fputs("Allocations are not counted with Tracy enabled\n", stdout);
+#endif
+
+		std::uint32_t packetCount = _updateSizesAtEnd.PacketCount - _updateSizesAtStart.PacketCount;
+		std::uint64_t totalSize = _updateSizesAtEnd.TotalSize - _updateSizesAtStart.TotalSize;
+		std::uint64_t totalCompressedSize = _updateSizesAtEnd.TotalCompressedSize - _updateSizesAtStart.TotalCompressedSize;
+		std::uint64_t receivedBytes = _receivedBytesAtEnd - _receivedBytesAtStart;
+
+		fprintf(stdout, "\nSnapshots sent: %u\n", packetCount);
+		if (packetCount > 0) {
+			fprintf(stdout, "%-24s %8.1f bytes per snapshot, %8.1f bytes per tick\n", "Raw size", (double)totalSize / packetCount, (double)totalSize / _measuredTicks);
+			fprintf(stdout, "%-24s %8.1f bytes per snapshot, %8.1f bytes per tick (%.1f%%)\n", "Compressed size", (double)totalCompressedSize / packetCount,
+				(double)totalCompressedSize / _measuredTicks, totalSize > 0 ? totalCompressedSize * 100.0 / totalSize : 0.0);
+		}
+		fprintf(stdout, "%-24s %8.1f bytes per tick (all packets received by bots)\n\n", "Received", (double)receivedBytes / _measuredTicks);
+
+		PrintBroadPhaseReport();
+		fflush(stdout);
+	}
+
+	std::uint64_t MpBenchmark::GetAllocationCount()
+	{
+		return AllocationCount.load(std::memory_order_relaxed);
+	}
+
+	void MpBenchmark::StartBots()
+	{
+		LOGI("[MP] Connecting {} bots to port {}...", _botCount, _serverPort);
+
+		for (std::uint32_t i = 0; i < _botCount; i++) {
+			_bots.push_back(std::make_unique<Bot>(i, _serverPort, _clientData, _gameVersion));
+		}
+	}
+
+	void MpBenchmark::RecordActorTrace(MpLevelHandler* levelHandler)
+	{
+		float timeMult = theApplication().GetTimeMult();
+		for (const auto& actor : levelHandler->_actors) {
+			if (actor->GetState(Actors::ActorState::ForceDisableCollisions) || actor->GetState(Actors::ActorState::IsDestroyed)) {
+				continue;
+			}
+			_actorTrace.push_back({ actor.get(), actor->AABB, actor->GetSpeed() * timeMult });
+		}
+		_actorTraceTicks.push_back((std::uint32_t)_actorTrace.size());
+	}
+
+	void MpBenchmark::PrintBroadPhaseReport() const
+	{
+		if (_actorTraceTicks.empty()) {
+			return;
+		}
+
+		enum class OpType : std::uint8_t {
+			Create,
+			Move,
+			Destroy
+		};
+
+		struct Op {
+			OpType Type;
+			std::uint32_t Slot;
+			AABBf Aabb;
+			Vector2f Displacement;
+		};
+
+		struct SlotState {
+			std::uint32_t Slot;
+			std::uint32_t LastTick;
+			AABBf Aabb;
+		};
+
+		struct PairCounter {
+			std::uint64_t ReportedPairs = 0;
+
+			void OnPairAdded(void* proxyA, void* proxyB) {
+				ReportedPairs++;
+			}
+			void OnPairUpdated(void* proxyA, void* proxyB) {
+				ReportedPairs++;
+			}
+			void OnPairRemoved(void* proxyA, void* proxyB) {
+			}
+		};
+
+		// The trace is converted to operations first, so only calls of the broad-phase are measured during replays,
+		// proxies are moved only if their bounding box changed, the same way as by LevelHandler
+		SmallVector<Op, 0> ops;
+		SmallVector<std::uint32_t, 0> opTicks;
+		HashMap<const void*, SlotState> slots;
+		std::uint32_t slotCount = 0;
+		std::uint32_t first = 0;
+		for (std::uint32_t tick = 0; tick < _actorTraceTicks.size(); tick++) {
+			std::uint32_t last = _actorTraceTicks[tick];
+			for (std::uint32_t i = first; i < last; i++) {
+				const TracedActor& traced = _actorTrace[i];
+				auto [it, inserted] = slots.try_emplace(traced.Actor);
+				if (inserted) {
+					it->second.Slot = slotCount++;
+					ops.push_back({ OpType::Create, it->second.Slot, traced.Aabb, traced.Displacement });
+				} else if (!(it->second.Aabb == traced.Aabb)) {
+					ops.push_back({ OpType::Move, it->second.Slot, traced.Aabb, traced.Displacement });
+				}
+				it->second.Aabb = traced.Aabb;
+				it->second.LastTick = tick;
+			}
+			for (auto it = slots.begin(); it != slots.end(); ) {
+				if (it->second.LastTick != tick) {
+					ops.push_back({ OpType::Destroy, it->second.Slot, {}, {} });
+					it = slots.erase(it);
+				} else {
+					++it;
+				}
+			}
+			opTicks.push_back((std::uint32_t)ops.size());
+			first = last;
+		}
+
+		auto replay = [&](bool requeryMoved, std::uint64_t& reportedPairs) -> double {
+			Array<std::int32_t> proxyIds(ValueInit, slotCount);
+			double minTimeMs = 0.0;
+			for (std::int32_t run = 0; run < BroadPhaseReplayRuns; run++) {
+				Collisions::DynamicTreeBroadPhase broadPhase;
+				PairCounter counter;
+
+				Clock& c = nCine::clock();
+				std::uint64_t startTime = c.now();
+				std::uint32_t opIndex = 0;
+				for (std::uint32_t opTick : opTicks) {
+					for (; opIndex < opTick; opIndex++) {
+						const Op& op = ops[opIndex];
+						switch (op.Type) {
+							case OpType::Create:
+								proxyIds[op.Slot] = broadPhase.CreateProxy(op.Aabb, nullptr);
+								break;
+							case OpType::Move:
+								broadPhase.MoveProxy(proxyIds[op.Slot], op.Aabb, op.Displacement);
+								if (requeryMoved) {
+									// Previous behavior, pairs of all moved proxies were queried again
+									broadPhase.TouchProxy(proxyIds[op.Slot]);
+								}
+								break;
+							case OpType::Destroy:
+								broadPhase.DestroyProxy(proxyIds[op.Slot]);
+								break;
+						}
+					}
+					broadPhase.UpdatePairs(&counter);
+				}
+				double timeMs = (c.now() - startTime) * 1000.0 / c.frequency();
+
+				if (run == 0 || timeMs < minTimeMs) {
+					minTimeMs = timeMs;
+				}
+				reportedPairs = counter.ReportedPairs;
+			}
+			return minTimeMs;
+		};
+
+		std::uint64_t requeryPairs = 0, persistedPairs = 0;
+		double requeryTimeMs = replay(true, requeryPairs);
+		double persistedTimeMs = replay(false, persistedPairs);
+		std::uint32_t tickCount = (std::uint32_t)opTicks.size();
+
+		fprintf(stdout, "Broad-phase replay: %u ticks, %u actors\n", tickCount, slotCount);
+		fprintf(stdout, "%-24s %8.4f ms per tick, %8.1f pairs per tick\n", "Re-query moved proxies", requeryTimeMs / tickCount, (double)requeryPairs / tickCount);
+		fprintf(stdout, "%-24s %8.4f ms per tick, %8.1f pairs per tick (%.1f%%)\n", "Persisted pairs", persistedTimeMs / tickCount, (double)persistedPairs / tickCount,
+			requeryTimeMs > 0.0 ? persistedTimeMs * 100.0 / requeryTimeMs : 0.0);
+		if (requeryPairs != persistedPairs) {
+			fputs("Warning: Both modes reported different number of pairs\n", stdout);
+		}
+		fputs("\n", stdout);
+	}
+
+	std::uint64_t MpBenchmark::GetReceivedBytes() const
+	{
+		std::uint64_t receivedBytes = 0;
+		for (const auto& bot : _bots) {
+			receivedBytes += bot->GetReceivedBytes();
+		}
+		return receivedBytes;
+	}
+
+	MpBenchmark::UpdateSizes MpBenchmark::GetUpdateSizes(MpLevelHandler* levelHandler)
+	{
+		const auto& s = levelHandler->_updateStats;
+		return { s.PacketCount, s.TotalSize, s.TotalCompressedSize };
+	}
+
+	std::uint64_t MpBenchmark::GetThreadCpuTime()
+	{
+#if defined(DEATH_TARGET_WINDOWS)
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (!::GetThreadTimes(::GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+			return 0;
+		}
+		// FILETIME is in 100 ns units
+		std::uint64_t kernel = ((std::uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+		std::uint64_t user = ((std::uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+		return (kernel + user) * 100;
+#else
+		struct timespec ts;
+		if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+			return 0;
+		}
+		return (std::uint64_t)ts.tv_sec * 1000000000ull + (std::uint64_t)ts.tv_nsec;
+#endif
+	}
+}
+
+#endif
\ No newline at end of file
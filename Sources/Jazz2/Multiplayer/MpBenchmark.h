@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#if (defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)) || defined(DOXYGEN_GENERATING_OUTPUT)
+
+#include "../PreferencesCache.h"
+#include "../../nCine/Primitives/AABB.h"
+#include "../../nCine/Primitives/Vector2.h"
+
+#include <Containers/Array.h>
+#include <Containers/SmallVector.h>
+#include <Containers/StringView.h>
+
+#include <memory>
+
+using namespace Death::Containers;
+
+namespace Jazz2::Multiplayer
+{
+	class MpLevelHandler;
+
+	/**
+		@brief Headless benchmark of the multiplayer server
+
+		Connects simulated players (bots) to the local server over loopback, drives them with scripted input
+		and measures the cost of each server tick — main thread CPU time, allocations of the server (including worker threads) and size
+		of @ref ServerPacketType::UpdateAllActors before and after compression. Bots run the same protocol
+		as regular clients, but they don't simulate anything, they only send scripted input frames.
+
+		Bounding boxes of all actors are recorded in each measured tick. The recorded movement is then replayed
+		through @ref Collisions::DynamicTreeBroadPhase with and without re-querying all moved proxies
+		to compare the cost of broad-phase collision detection.
+
+		@experimental
+	*/
+	class MpBenchmark
+	{
+	public:
+		MpBenchmark(std::uint16_t serverPort, std::uint32_t botCount, std::uint32_t tickCount, std::uint32_t clientData, std::uint64_t gameVersion);
+		~MpBenchmark();
+
+		MpBenchmark(const MpBenchmark&) = delete;
+		MpBenchmark& operator=(const MpBenchmark&) = delete;
+
+		/** @brief Called at the beginning of each server tick */
+		void OnBeginTick();
+		/** @brief Called at the end of each server tick, returns `false` once all ticks were measured */
+		bool OnEndTick(MpLevelHandler* levelHandler);
+		/** @brief Prints results to the standard output */
+		void PrintReport() const;
+
+		/** @brief Returns number of allocations made by all threads except threads of bots */
+		static std::uint64_t GetAllocationCount();
+
+	private:
+		class Bot;
+
+		/** @brief Maximum time to wait until all bots are spawned, in seconds */
+		static constexpr float MaxWarmupSecs = 30.0f;
+
+		/** @brief Number of replays of the recorded movement in each mode, the fastest one is reported */
+		static constexpr std::int32_t BroadPhaseReplayRuns = 5;
+
+		struct UpdateSizes {
+			std::uint32_t PacketCount;
+			std::uint64_t TotalSize;
+			std::uint64_t TotalCompressedSize;
+		};
+
+		struct TracedActor {
+			const void* Actor;
+			nCine::AABBf Aabb;
+			nCine::Vector2f Displacement;
+		};
+
+		SmallVector<std::unique_ptr<Bot>, 0> _bots;
+		std::uint16_t _serverPort;
+		std::uint32_t _clientData;
+		std::uint32_t _botCount;
+		std::uint64_t _gameVersion;
+		std::uint32_t _tickCount;
+		std::uint32_t _measuredTicks;
+		bool _botsStarted;
+		bool _measuring;
+		float _warmupFrames;
+		std::uint64_t _tickStartTime;
+		std::uint64_t _tickStartCpuTime;
+		std::uint64_t _tickStartAllocations;
+		Array<float> _tickTimesMs;
+		Array<float> _tickCpuTimesMs;
+		Array<std::uint32_t> _tickAllocations;
+		UpdateSizes _updateSizesAtStart;
+		UpdateSizes _updateSizesAtEnd;
+		std::uint64_t _receivedBytesAtStart;
+		std::uint64_t _receivedBytesAtEnd;
+		std::uint32_t _spawnedBotCount;
+		SmallVector<TracedActor, 0> _actorTrace;
+		SmallVector<std::uint32_t, 0> _actorTraceTicks;
+
+		void StartBots();
+		void RecordActorTrace(MpLevelHandler* levelHandler);
+		void PrintBroadPhaseReport() const;
+		std::uint64_t GetReceivedBytes() const;
+		static UpdateSizes GetUpdateSizes(MpLevelHandler* levelHandler);
+		static std::uint64_t GetThreadCpuTime();
+	};
+}
+
+#endif
\ No newline at end of file
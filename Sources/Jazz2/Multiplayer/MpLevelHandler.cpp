@@ -2,6 +2,7 @@
 
 #if defined(WITH_MULTIPLAYER)
 
+#include "BitStream.h"
 #include "PacketTypes.h"
 #include "../ContentResolver.h"
 #include "../PreferencesCache.h"
@@ -18,6 +19,7 @@
 #include "../../nCine/I18n.h"
 #include "../../nCine/Base/Random.h"
 #include "../../nCine/Primitives/Half.h"
+#include "../../nCine/tracy.h"
 
 #include "../Actors/Player.h"
 #include "../Actors/Multiplayer/LocalPlayerOnServer.h"
@@ -47,15 +49,19 @@
 #include <Containers/StringConcatenable.h>
 #include <Containers/StringUtils.h>
 #include <IO/MemoryStream.h>
-#include <IO/Compression/DeflateStream.h>
 #include <Utf8.h>
 
-using namespace Death::IO::Compression;
 using namespace nCine;
 using namespace Jazz2::Actors::Multiplayer;
 
 namespace Jazz2::Multiplayer
 {
+	// Widths of variable-width fields of remoting actors in UpdateAllActors
+	static constexpr std::uint8_t ActorIdDeltaBits[4] = { 3, 6, 12, 32 };
+	static constexpr std::uint8_t PositionDeltaBits[4] = { 5, 8, 12, 32 };
+	static constexpr std::uint8_t PositionBits[4] = { 12, 16, 20, 32 };
+	static constexpr std::uint8_t AnimationBits[4] = { 8, 16, 24, 32 };
+
 	// The first 15 positions are awarded with points
 	static const std::uint32_t PointsPerPosition[] = {
 		20, 17, 15, 13, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
@@ -64,8 +70,10 @@ namespace Jazz2::Multiplayer
 	// TODO: levelState is unused, it needs to be set after LevelState::InitialUpdatePending is processed
 	MpLevelHandler::MpLevelHandler(IRootController* root, NetworkManager* networkManager, MpLevelHandler::LevelState levelState, bool enableLedgeClimb)
 		: LevelHandler(root), _networkManager(networkManager), _updateTimeLeft(1.0f), _gameTimeLeft(0.0f),
-			_levelState(LevelState::InitialUpdatePending), _forceResyncPending(true), _enableSpawning(true), _lastSpawnedActorId(-1), _waitingForPlayerCount(0),
-			_lastUpdated(0), _seqNumWarped(0), _suppressRemoting(false), _ignorePackets(false), _enableLedgeClimb(enableLedgeClimb),
+			_levelState(LevelState::InitialUpdatePending), _enableSpawning(true), _lastUpdateArrivalTime(0), _lastRoundTripTimeMs(0),
+			_arrivalJitterMs(0.0f), _roundTripJitterMs(0.0f), _remoteRenderDelayMs((float)ServerDelay), _remoteRenderDelay((std::int32_t)ServerDelay),
+			_lastAppliedUpdate(0), _snapshotSampleCount(0), _nextSnapshotSample(0), _recordSnapshotSamples(false), _lastSpawnedActorId(-1), _waitingForPlayerCount(0),
+			_lastUpdated(0), _seqNumWarped(0), _inputSeqNum(0), _lastAckedInputSeqNum(0), _suppressRemoting(false), _ignorePackets(false), _enableLedgeClimb(enableLedgeClimb),
 			_controllableExternal(true), _autoWeightTreasure(false), _activePoll(VoteType::None), _activePollTimeLeft(0.0f), _recalcPositionInRoundTime(0.0f),
 			_limitCameraLeft(0), _limitCameraWidth(0), _totalTreasureCount(0)
 #if defined(DEATH_DEBUG)
@@ -96,6 +104,12 @@ namespace Jazz2::Multiplayer
 
 		InitializeRequiredAssets();
 
+		// Both sides must have the same dictionary to use it, it's negotiated in ClientPacketType::LevelReady
+		auto& resolver = ContentResolver::Get();
+		if (!_snapshotCompressor.LoadDictionary(fs::CombinePath({ resolver.GetContentPath(), "Multiplayer"_s, "Snapshots.dict"_s }))) {
+			_snapshotCompressor.LoadDictionary(fs::CombinePath({ resolver.GetCachePath(), "Multiplayer"_s, "Snapshots.dict"_s }));
+		}
+
 		if (_isServer) {
 			// Reserve first 255 indices for players
 			auto& serverConfig = _networkManager->GetServerConfiguration();
@@ -105,13 +119,16 @@ namespace Jazz2::Multiplayer
 			for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
 				peerDesc->LevelState = PeerLevelState::ValidatingAssets;
 				peerDesc->LastUpdated = 0;
+				peerDesc->LastAckedUpdate = 0;
+				peerDesc->UpdateCompression = SnapshotCompression::Deflate;
+				peerDesc->UseUpdateDictionary = false;
+				peerDesc->LastInputSeqNum = 0;
 				if (peerDesc->RemotePeer) {
 					peerDesc->Player = nullptr;
 				}
 			}
 		}
 
-		auto& resolver = ContentResolver::Get();
 		resolver.PreloadMetadataAsync("Interactive/PlayerJazz"_s);
 		resolver.PreloadMetadataAsync("Interactive/PlayerSpaz"_s);
 		resolver.PreloadMetadataAsync("Interactive/PlayerLori"_s);
@@ -185,6 +202,17 @@ namespace Jazz2::Multiplayer
 		LevelHandler::OnBeginFrame();
 
 		if (_isServer) {
+			float timeMult = theApplication().GetTimeMult();
+			std::uint32_t frameCount = theApplication().GetFrameCount();
+
+			// Input frames received from clients are applied before remote players are updated
+			for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
+				if (auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player)) {
+					remotePlayerOnServer->ApplyQueuedInputs(timeMult);
+					remotePlayerOnServer->UpdatedFrame = frameCount;
+				}
+			}
+
 			// Send pending SFX
 			for (const auto& sfx : _pendingSfx) {
 				std::uint32_t actorId;
@@ -197,7 +225,7 @@ namespace Jazz2::Multiplayer
 					actorId = it->second.ActorID;
 				}
 
-				MemoryStream packet(12 + sfx.Identifier.size());
+				MemoryStream packet = NetworkManager::CreatePacket(12 + sfx.Identifier.size());
 				packet.WriteVariableUint32(actorId);
 				// TODO: sourceRelative
 				// TODO: looping
@@ -209,17 +237,9 @@ namespace Jazz2::Multiplayer
 				_networkManager->SendTo([this](const Peer& peer) {
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlaySfx, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlaySfx, std::move(packet));
 			}
 			_pendingSfx.clear();
-		} else {
-			auto& input = _playerInputs[0];
-			if (input.PressedActions != input.PressedActionsLast) {
-				MemoryStream packet(12);
-				packet.WriteVariableUint32(_lastSpawnedActorId);
-				packet.WriteVariableUint64(_console->IsVisible() ? 0 : input.PressedActions);
-				_networkManager->SendTo(AllPeers, NetworkChannel::UnreliableUpdates, (std::uint8_t)ClientPacketType::PlayerKeyPress, packet);
-			}
 		}
 	}
 
@@ -228,18 +248,11 @@ namespace Jazz2::Multiplayer
 		LevelHandler::OnEndFrame();
 
 		float timeMult = theApplication().GetTimeMult();
-		std::uint32_t frameCount = theApplication().GetFrameCount();
 		auto& serverConfig = _networkManager->GetServerConfiguration();
 
 		if (_isServer) {
-			// Update last pressed keys only if it wasn't done this frame yet (because of PlayerKeyPress packet)
 			for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
 				if (auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player)) {
-					if (remotePlayerOnServer->UpdatedFrame != frameCount) {
-						remotePlayerOnServer->UpdatedFrame = frameCount;
-						remotePlayerOnServer->PressedKeysLast = remotePlayerOnServer->PressedKeys;
-					}
-
 					if (remotePlayerOnServer->PressedKeys == 0) {
 						peerDesc->IdleElapsedFrames += timeMult;
 						if (serverConfig.IdleKickTimeSecs > 0 && serverConfig.IdleKickTimeSecs <= (std::int32_t)(peerDesc->IdleElapsedFrames * FrameTimer::SecondsPerFrame)) {
@@ -258,6 +271,12 @@ namespace Jazz2::Multiplayer
 					EndActivePoll();
 				}
 			}
+		} else if (!_players.empty()) {
+			// Input frames are recorded together with the predicted state, so they can be replayed when the server corrects it
+			auto& input = _playerInputs[0];
+			auto* player = _players[0];
+			_inputSeqNum++;
+			_inputHistory.Record(_inputSeqNum, _console->IsVisible() ? 0 : input.PressedActions, timeMult, player->_pos, player->_speed, player->CanJump());
 		}
 
 		_updateTimeLeft -= timeMult;
@@ -294,9 +313,13 @@ namespace Jazz2::Multiplayer
 							flags |= 0x02;
 						}
 
-						MemoryStream packet(1);
+						MemoryStream packet = NetworkManager::CreatePacket(21);
 						packet.WriteValue<std::uint8_t>(flags);
-						_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::LevelReady, packet);
+						packet.WriteVariableUint32((std::uint32_t)_viewSize.X);
+						packet.WriteVariableUint32((std::uint32_t)_viewSize.Y);
+						packet.WriteVariableUint32(SnapshotCompressor::GetSupportedMethods());
+						packet.WriteVariableUint32(_snapshotCompressor.GetDictionaryId());
+						_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::LevelReady, std::move(packet));
 					}
 					break;
 				}
@@ -376,12 +399,12 @@ namespace Jazz2::Multiplayer
 							player->SetInvulnerability(serverConfig.SpawnInvulnerableSecs * FrameTimer::FramesPerSecond, Actors::Player::InvulnerableType::Blinking);
 
 							if (peerDesc->RemotePeer) {
-								MemoryStream packet(13);
+								MemoryStream packet = NetworkManager::CreatePacket(13);
 								packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Laps);
 								packet.WriteVariableUint32(mpPlayer->_playerIndex);
 								packet.WriteVariableUint32(peerDesc->Laps);
 								packet.WriteVariableUint32(serverConfig.TotalLaps);
-								_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+								_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 							}
 						}
 					}
@@ -453,13 +476,11 @@ namespace Jazz2::Multiplayer
 
 			if (_isServer) {
 				if (_networkManager->HasInboundConnections()) {
-					std::uint32_t actorCount = (std::uint32_t)(_players.size() + _remotingActors.size());
-
-					MemoryStream packet(8 + actorCount * 24);
-					packet.WriteVariableUint32(_lastUpdated);
-					packet.WriteVariableUint64((std::uint64_t)_elapsedFrames);
-					packet.WriteVariableUint32((actorCount << 1) | (_forceResyncPending ? 1 : 0));
+					ZoneScopedNC("UpdateAllActors", 0x4876AF);
+					TimeStamp updateStarted = TimeStamp::now();
 
+					// Player states are the same for all peers, so they are serialized only once
+					MemoryStream playersPacket(_players.size() * 24);
 					for (Actors::Player* player : _players) {
 						auto* mpPlayer = static_cast<PlayerOnServer*>(player);
 
@@ -489,7 +510,7 @@ namespace Jazz2::Multiplayer
 						}*/
 						Vector2f pos = player->_pos;
 
-						packet.WriteVariableUint32(player->_playerIndex);
+						playersPacket.WriteVariableUint32(player->_playerIndex);
 
 						std::uint8_t flags = 0x01 | 0x02; // PositionChanged | AnimationChanged
 						if (player->_renderer.isDrawEnabled()) {
@@ -508,54 +529,46 @@ namespace Jazz2::Multiplayer
 							mpPlayer->_justWarped = false;
 							flags |= 0x40;
 						}
-						packet.WriteValue<std::uint8_t>(flags);
+						playersPacket.WriteValue<std::uint8_t>(flags);
 
-						packet.WriteValue<std::int32_t>((std::int32_t)(pos.X * 512.0f));
-						packet.WriteValue<std::int32_t>((std::int32_t)(pos.Y * 512.0f));
-						packet.WriteVariableUint32((std::uint32_t)(player->_currentTransition != nullptr ? player->_currentTransition->State : player->_currentAnimation->State));
+						playersPacket.WriteValue<std::int32_t>((std::int32_t)(pos.X * 512.0f));
+						playersPacket.WriteValue<std::int32_t>((std::int32_t)(pos.Y * 512.0f));
+						playersPacket.WriteVariableUint32((std::uint32_t)(player->_currentTransition != nullptr ? player->_currentTransition->State : player->_currentAnimation->State));
 
 						float rotation = player->_renderer.rotation();
 						if (rotation < 0.0f) rotation += fRadAngle360;
-						packet.WriteValue<std::uint16_t>((std::uint16_t)(rotation * UINT16_MAX / fRadAngle360));
+						playersPacket.WriteValue<std::uint16_t>((std::uint16_t)(rotation * UINT16_MAX / fRadAngle360));
 						Vector2f scale = player->_renderer.scale();
-						packet.WriteValue<std::uint16_t>((std::uint16_t)Half{scale.X});
-						packet.WriteValue<std::uint16_t>((std::uint16_t)Half{scale.Y});
+						playersPacket.WriteValue<std::uint16_t>((std::uint16_t)Half{scale.X});
+						playersPacket.WriteValue<std::uint16_t>((std::uint16_t)Half{scale.Y});
 						Actors::ActorRendererType rendererType = player->_renderer.GetRendererType();
 						if (rendererType == Actors::ActorRendererType::Outline) {
 							// Outline renderer type is local-only
 							rendererType = Actors::ActorRendererType::Default;
 						}
-						packet.WriteValue<std::uint8_t>((std::uint8_t)rendererType);
+						playersPacket.WriteValue<std::uint8_t>((std::uint8_t)rendererType);
 					}
 
-					// TODO: Does this need to be locked?
+					// Capture the current state of all remoting actors only once, it's filtered for each peer separately
+					_remotingActorStates.clear();
 					{
 						std::unique_lock lock(_lock);
 						for (auto& [remotingActor, remotingActorInfo] : _remotingActors) {
-							packet.WriteVariableUint32(remotingActorInfo.ActorID);
-
-							std::int32_t newPosX = (std::int32_t)(remotingActor->_pos.X * 512.0f);
-							std::int32_t newPosY = (std::int32_t)(remotingActor->_pos.Y * 512.0f);
-							bool positionChanged = (_forceResyncPending || newPosX != remotingActorInfo.LastPosX || newPosY != remotingActorInfo.LastPosY);
-
-							std::uint32_t newAnimation = (std::uint32_t)(remotingActor->_currentTransition != nullptr ? remotingActor->_currentTransition->State : (remotingActor->_currentAnimation != nullptr ? remotingActor->_currentAnimation->State : AnimState::Idle));
+							auto& state = _remotingActorStates.emplace_back();
+							state.ActorID = remotingActorInfo.ActorID;
+							state.Pos = remotingActor->_pos;
+							state.PosX = (std::int32_t)(remotingActor->_pos.X * ActorPositionScale);
+							state.PosY = (std::int32_t)(remotingActor->_pos.Y * ActorPositionScale);
+							state.Animation = (std::uint32_t)(remotingActor->_currentTransition != nullptr ? remotingActor->_currentTransition->State : (remotingActor->_currentAnimation != nullptr ? remotingActor->_currentAnimation->State : AnimState::Idle));
 							float rotation = remotingActor->_renderer.rotation();
 							if (rotation < 0.0f) rotation += fRadAngle360;
-							std::uint16_t newRotation = (std::uint16_t)(rotation * UINT16_MAX / fRadAngle360);
-							Vector2f newScale = remotingActor->_renderer.scale();
-							std::uint16_t newScaleX = (std::uint16_t)Half{newScale.X};
-							std::uint16_t newScaleY = (std::uint16_t)Half{newScale.Y};
-							std::uint8_t newRendererType = (std::uint8_t)remotingActor->_renderer.GetRendererType();
-							bool animationChanged = (_forceResyncPending || newAnimation != remotingActorInfo.LastAnimation || newRotation != remotingActorInfo.LastRotation ||
-								newScaleX != remotingActorInfo.LastScaleX || newScaleY != remotingActorInfo.LastScaleY || newRendererType != remotingActorInfo.LastRendererType);
+							state.Rotation = (std::uint16_t)(rotation * UINT16_MAX / fRadAngle360);
+							Vector2f scale = remotingActor->_renderer.scale();
+							state.ScaleX = (std::uint16_t)Half{scale.X};
+							state.ScaleY = (std::uint16_t)Half{scale.Y};
+							state.RendererType = (std::uint8_t)remotingActor->_renderer.GetRendererType();
 
 							std::uint8_t flags = 0;
-							if (positionChanged) {
-								flags |= 0x01;
-							}
-							if (animationChanged) {
-								flags |= 0x02;
-							}
 							if (remotingActor->_renderer.isDrawEnabled()) {
 								flags |= 0x04;
 							}
@@ -568,53 +581,199 @@ namespace Jazz2::Multiplayer
 							if (remotingActor->_renderer.isFlippedY()) {
 								flags |= 0x20;
 							}
-							packet.WriteValue<std::uint8_t>(flags);
+							state.Flags = flags;
+						}
+					}
 
-							if (positionChanged) {
-								packet.WriteValue<std::int32_t>(newPosX);
-								packet.WriteValue<std::int32_t>(newPosY);
+					// Sorted states allow to merge them with snapshots of each peer in a single pass
+					nCine::sort(_remotingActorStates.begin(), _remotingActorStates.end(), [](const ActorSnapshot& a, const ActorSnapshot& b) {
+						return (a.ActorID < b.ActorID);
+					});
 
-								remotingActorInfo.LastPosX = newPosX;
-								remotingActorInfo.LastPosY = newPosY;
+					SmallVector<std::pair<Peer, std::shared_ptr<PeerDescriptor>>, 32> peers;
+					for (const auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
+						if (peer && peerDesc->LevelState >= PeerLevelState::LevelSynchronized) {
+							peers.emplace_back(peer, peerDesc);
+						}
+					}
+
+					std::uint32_t updateId = _lastUpdated + 1;
+					std::int64_t totalPacketSize = 0, totalCompressedPacketSize = 0;
+
+					for (auto& [peer, peerDesc] : peers) {
+						auto& history = _peerSnapshots[peer];
+						// Actors are encoded as delta against the last snapshot acknowledged by the peer, or with full state if it's not available
+						const auto* baseline = history.Find(peerDesc->LastAckedUpdate, updateId);
+						const auto* lastSent = history.Find(_lastUpdated, updateId);
+						auto& current = history.Reset(updateId);
+
+						// Peers without spawned player (e.g., spectators) receive all actors
+						bool filterByRelevancy = (peerDesc->Player != nullptr);
+						Vector2f viewPos, viewHalfSize;
+						if (filterByRelevancy) {
+							viewPos = peerDesc->Player->_pos;
+							viewHalfSize = Vector2f(peerDesc->ViewSize.X > 0 ? (float)std::min(peerDesc->ViewSize.X, DefaultWidth) : (float)DefaultWidth,
+								peerDesc->ViewSize.Y > 0 ? (float)std::min(peerDesc->ViewSize.Y, DefaultHeight) : (float)DefaultHeight) * 0.5f;
+						}
+
+						std::size_t lastSentCursor = 0;
+						for (const auto& state : _remotingActorStates) {
+							if (filterByRelevancy) {
+								// Hysteresis prevents actors near the edge from repeatedly entering and leaving the relevant area
+								bool wasRelevant = (lastSent != nullptr && FindActorSnapshot(lastSent->Actors, lastSentCursor, state.ActorID) != nullptr);
+								float margin = (wasRelevant ? RelevancyLeaveMargin : RelevancyEnterMargin);
+								if (std::abs(state.Pos.X - viewPos.X) > viewHalfSize.X + margin ||
+									std::abs(state.Pos.Y - viewPos.Y) > viewHalfSize.Y + margin) {
+									continue;
+								}
 							}
-							if (animationChanged) {
-								packet.WriteVariableUint32(newAnimation);
-								packet.WriteValue<std::uint16_t>(newRotation);
-								packet.WriteValue<std::uint16_t>(newScaleX);
-								packet.WriteValue<std::uint16_t>(newScaleY);
-								packet.WriteValue<std::uint8_t>(newRendererType);
-
-								remotingActorInfo.LastAnimation = newAnimation;
-								remotingActorInfo.LastRotation = newRotation;
-								remotingActorInfo.LastScaleX = newScaleX;
-								remotingActorInfo.LastScaleY = newScaleY;
-								remotingActorInfo.LastRendererType = newRendererType;
+							current.Actors.push_back(state);
+						}
+
+						MemoryStream packet(24 + playersPacket.GetSize() + current.Actors.size() * 8);
+						packet.WriteVariableUint32(updateId);
+						packet.WriteVariableUint64((std::uint64_t)_elapsedFrames);
+						packet.WriteVariableUint32(baseline != nullptr ? baseline->UpdateId : 0);
+						packet.WriteVariableUint32((std::uint32_t)_players.size());
+						packet.Write(playersPacket.GetBuffer(), playersPacket.GetSize());
+						packet.WriteVariableUint32((std::uint32_t)current.Actors.size());
+
+						// Remoting actors are bit-packed, each field is written only if it differs from the baseline,
+						// positions are written as delta against the baseline and IDs as delta against the previous actor
+						{
+							BitWriter bw(packet);
+							std::size_t baselineCursor = 0;
+							std::uint32_t lastActorId = UINT32_MAX;
+							lastSentCursor = 0;
+							for (const auto& state : current.Actors) {
+								const ActorSnapshot* prevState = (baseline != nullptr ? FindActorSnapshot(baseline->Actors, baselineCursor, state.ActorID) : nullptr);
+
+								bw.WriteVariableBits(state.ActorID - (lastActorId + 1), ActorIdDeltaBits);
+								lastActorId = state.ActorID;
+
+								// The peer must know which actors are encoded as delta, otherwise it couldn't decode the rest of the packet
+								bw.WriteBool(prevState != nullptr);
+
+								// Actor just became relevant, the peer has no up-to-date position to interpolate from
+								bool justWarped = (lastSent == nullptr || FindActorSnapshot(lastSent->Actors, lastSentCursor, state.ActorID) == nullptr);
+								bw.WriteBool(justWarped);
+
+								bool positionChanged = (prevState == nullptr || state.PosX != prevState->PosX || state.PosY != prevState->PosY);
+								bw.WriteBool(positionChanged);
+								if (positionChanged) {
+									if (prevState != nullptr) {
+										bw.WriteVariableSignedBits(state.PosX - prevState->PosX, PositionDeltaBits);
+										bw.WriteVariableSignedBits(state.PosY - prevState->PosY, PositionDeltaBits);
+									} else {
+										bw.WriteVariableSignedBits(state.PosX, PositionBits);
+										bw.WriteVariableSignedBits(state.PosY, PositionBits);
+									}
+								}
+
+								bool animationChanged = (prevState == nullptr || state.Animation != prevState->Animation);
+								bool rotationChanged = (prevState == nullptr || state.Rotation != prevState->Rotation);
+								bool scaleChanged = (prevState == nullptr || state.ScaleX != prevState->ScaleX || state.ScaleY != prevState->ScaleY);
+								bool rendererTypeChanged = (prevState == nullptr || state.RendererType != prevState->RendererType);
+								bool flagsChanged = (prevState == nullptr || state.Flags != prevState->Flags);
+								bool otherChanged = (animationChanged || rotationChanged || scaleChanged || rendererTypeChanged || flagsChanged);
+								bw.WriteBool(otherChanged);
+								if (!otherChanged) {
+									continue;
+								}
+
+								bw.WriteBool(animationChanged);
+								bw.WriteBool(rotationChanged);
+								bw.WriteBool(scaleChanged);
+								bw.WriteBool(rendererTypeChanged);
+								bw.WriteBool(flagsChanged);
+
+								if (animationChanged) {
+									bw.WriteVariableBits(state.Animation, AnimationBits);
+								}
+								if (rotationChanged) {
+									bw.WriteBits(state.Rotation, 16);
+								}
+								if (scaleChanged) {
+									// Most actors have uniform scale
+									bool uniformScale = (state.ScaleX == state.ScaleY);
+									bw.WriteBool(uniformScale);
+									bw.WriteBits(state.ScaleX, 16);
+									if (!uniformScale) {
+										bw.WriteBits(state.ScaleY, 16);
+									}
+								}
+								if (rendererTypeChanged) {
+									bw.WriteBits(state.RendererType, 4);
+								}
+								if (flagsChanged) {
+									bw.WriteBits(state.Flags >> 2, 4);
+								}
 							}
 						}
+
+						ArrayView<const std::uint8_t> uncompressed { packet.GetBuffer(), (std::size_t)packet.GetSize() };
+						MemoryStream packetCompressed = NetworkManager::CreatePacket(1024);
+						if (!_snapshotCompressor.Compress(peerDesc->UpdateCompression, peerDesc->UseUpdateDictionary, uncompressed, packetCompressed)) {
+							LOGW("[MP] Failed to compress ServerPacketType::UpdateAllActors with {}", SnapshotCompressor::GetMethodName(peerDesc->UpdateCompression));
+							continue;
+						}
+						if DEATH_UNLIKELY(_recordSnapshotSamples) {
+							RecordSnapshotSample(uncompressed);
+						}
+
+						totalPacketSize += packet.GetSize();
+						totalCompressedPacketSize += packetCompressed.GetSize();
+						_updateStats.TotalActorCount += current.Actors.size();
+						_updateStats.MaxCompressedSize = std::max(_updateStats.MaxCompressedSize, (std::uint32_t)packetCompressed.GetSize());
+
+						_networkManager->SendTo(peer, NetworkChannel::UnreliableUpdates, (std::uint8_t)ServerPacketType::UpdateAllActors, std::move(packetCompressed));
 					}
 
-					MemoryStream packetCompressed(1024);
-					{
-						DeflateWriter dw(packetCompressed);
-						dw.Write(packet.GetBuffer(), packet.GetSize());
+					float updateTimeMs = updateStarted.millisecondsSince();
+					_updateStats.UpdateCount++;
+					_updateStats.PacketCount += (std::uint32_t)peers.size();
+					_updateStats.TotalTimeMs += updateTimeMs;
+					_updateStats.MaxTimeMs = std::max(_updateStats.MaxTimeMs, updateTimeMs);
+					_updateStats.TotalSize += totalPacketSize;
+					_updateStats.TotalCompressedSize += totalCompressedPacketSize;
+
+					TracyPlot("UpdateAllActors Time (us)", static_cast<std::int64_t>(updateTimeMs * 1000.0f));
+					TracyPlot("UpdateAllActors Size", static_cast<std::int64_t>(totalPacketSize));
+					TracyPlot("UpdateAllActors Compressed Size", static_cast<std::int64_t>(totalCompressedPacketSize));
+
+					if (!peers.empty()) {
+						totalPacketSize /= (std::int64_t)peers.size();
+						totalCompressedPacketSize /= (std::int64_t)peers.size();
 					}
 
 #if defined(DEATH_DEBUG)
-					_debugAverageUpdatePacketSize = lerp(_debugAverageUpdatePacketSize, (std::int32_t)(packet.GetSize() * UpdatesPerSecond), 0.04f * timeMult);
+					_debugAverageUpdatePacketSize = lerp(_debugAverageUpdatePacketSize, (std::int32_t)(totalPacketSize * UpdatesPerSecond), 0.04f * timeMult);
 #endif
 #if defined(DEATH_DEBUG) && defined(WITH_IMGUI)
-					_updatePacketSize[_plotIndex] = packet.GetSize();
+					_updatePacketSize[_plotIndex] = totalPacketSize;
 					_updatePacketMaxSize = std::max(_updatePacketMaxSize, _updatePacketSize[_plotIndex]);
-					_compressedUpdatePacketSize[_plotIndex] = packetCompressed.GetSize();
+					_compressedUpdatePacketSize[_plotIndex] = totalCompressedPacketSize;
 #endif
 
-					_networkManager->SendTo([this](const Peer& peer) {
-						auto peerDesc = _networkManager->GetPeerDescriptor(peer);
-						return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-					}, _forceResyncPending ? NetworkChannel::Main : NetworkChannel::UnreliableUpdates, (std::uint8_t)ServerPacketType::UpdateAllActors, packetCompressed);
+					_lastUpdated = updateId;
 
-					_lastUpdated++;
-					_forceResyncPending = false;
+					// Each client receives the authoritative state of its player after the last applied input frame,
+					// so it can replay the rest of its input frames on top of it if the prediction was wrong
+					for (auto& [peer, peerDesc] : peers) {
+						auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player);
+						if (remotePlayerOnServer == nullptr || peerDesc->LastInputSeqNum == 0) {
+							continue;
+						}
+
+						MemoryStream packet = NetworkManager::CreatePacket(24);
+						packet.WriteVariableUint32(remotePlayerOnServer->_playerIndex);
+						packet.WriteVariableUint32(peerDesc->LastInputSeqNum);
+						packet.WriteValue<std::int32_t>((std::int32_t)(remotePlayerOnServer->_pos.X * 512.0f));
+						packet.WriteValue<std::int32_t>((std::int32_t)(remotePlayerOnServer->_pos.Y * 512.0f));
+						packet.WriteValue<std::int16_t>((std::int16_t)(remotePlayerOnServer->_speed.X * 512.0f));
+						packet.WriteValue<std::int16_t>((std::int16_t)(remotePlayerOnServer->_speed.Y * 512.0f));
+						_networkManager->SendTo(peer, NetworkChannel::UnreliableUpdates, (std::uint8_t)ServerPacketType::PlayerAckInput, std::move(packet));
+					}
 
 					SynchronizePeers();
 				} else {
@@ -626,33 +785,27 @@ namespace Jazz2::Multiplayer
 				if (!_players.empty()) {
 					Clock& c = nCine::clock();
 					std::uint64_t now = c.now() * 1000 / c.frequency();
-					auto player = _players[0];
 
-					RemotePlayerOnServer::PlayerFlags flags = (RemotePlayerOnServer::PlayerFlags)player->_currentSpecialMove;
-					if (player->IsFacingLeft()) {
-						flags |= RemotePlayerOnServer::PlayerFlags::IsFacingLeft;
-					}
-					if (player->_renderer.isDrawEnabled()) {
-						flags |= RemotePlayerOnServer::PlayerFlags::IsVisible;
-					}
-					if (player->_isActivelyPushing) {
-						flags |= RemotePlayerOnServer::PlayerFlags::IsActivelyPushing;
-					}
-					if (_seqNumWarped != 0) {
-						flags |= RemotePlayerOnServer::PlayerFlags::JustWarped;
+					// Only input frames are sent, the server simulates the player on its own and acknowledges the result,
+					// frames not acknowledged yet are sent repeatedly, so a lost packet doesn't cause a misprediction
+					std::uint32_t firstSeqNum = _lastAckedInputSeqNum + 1;
+					if (_inputSeqNum >= MaxInputFramesPerUpdate && firstSeqNum < _inputSeqNum - MaxInputFramesPerUpdate + 1) {
+						firstSeqNum = _inputSeqNum - MaxInputFramesPerUpdate + 1;
 					}
+					std::uint32_t frameCount = (_inputSeqNum >= firstSeqNum ? _inputSeqNum - firstSeqNum + 1 : 0);
 
-					MemoryStream packet(20);
+					MemoryStream packet(24 + frameCount * 11);
 					packet.WriteVariableUint32(_lastSpawnedActorId);
 					packet.WriteVariableUint64(now);
-					packet.WriteValue<std::int32_t>((std::int32_t)(player->_pos.X * 512.0f));
-					packet.WriteValue<std::int32_t>((std::int32_t)(player->_pos.Y * 512.0f));
-					packet.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
-					packet.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
-					packet.WriteVariableUint32((std::uint32_t)flags);
-
-					if (_seqNumWarped != 0) {
-						packet.WriteVariableUint64(_seqNumWarped);
+					packet.WriteVariableUint32(_lastUpdated);
+					packet.WriteVariableUint32(firstSeqNum);
+					packet.WriteVariableUint32(frameCount);
+					for (std::uint32_t i = 0; i < frameCount; i++) {
+						const auto* frame = _inputHistory.Find(firstSeqNum + i);
+						packet.WriteVariableUint64(frame != nullptr ? frame->PressedActions : 0);
+						packet.WriteValue<std::uint8_t>(frame != nullptr
+							? (std::uint8_t)std::clamp((std::int32_t)(frame->TimeMult * InputTimeMultScale + 0.5f), 1, 255)
+							: (std::uint8_t)InputTimeMultScale);
 					}
 
 #if defined(DEATH_DEBUG) && defined(WITH_IMGUI)
@@ -771,7 +924,7 @@ namespace Jazz2::Multiplayer
 			_console->WriteLine(UI::MessageLevel::Echo, prefixedMessage);
 
 			// Chat message
-			MemoryStream packet(9 + prefixedMessage.size());
+			MemoryStream packet = NetworkManager::CreatePacket(9 + prefixedMessage.size());
 			packet.WriteVariableUint32(0); // TODO: Player index
 			packet.WriteValue<std::uint8_t>((std::uint8_t)UI::MessageLevel::Chat);
 			packet.WriteVariableUint32((std::uint32_t)prefixedMessage.size());
@@ -780,15 +933,15 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState != PeerLevelState::Unknown);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, std::move(packet));
 		} else {
 			// Chat message
-			MemoryStream packet(9 + line.size());
+			MemoryStream packet = NetworkManager::CreatePacket(9 + line.size());
 			packet.WriteVariableUint32(_lastSpawnedActorId);
 			packet.WriteValue<std::uint8_t>(0); // Reserved
 			packet.WriteVariableUint32((std::uint32_t)line.size());
 			packet.Write(line.data(), (std::uint32_t)line.size());
-			_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::ChatMessage, packet);
+			_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::ChatMessage, std::move(packet));
 		}
 
 		return true;
@@ -824,7 +977,7 @@ namespace Jazz2::Multiplayer
 				Vector2i originTile = actorPtr->_originTile;
 				const auto& eventTile = _eventMap->GetEventTile(originTile.X, originTile.Y);
 				if (eventTile.Event != EventType::Empty) {
-					MemoryStream packet(24 + Events::EventSpawner::SpawnParamsSize);
+					MemoryStream packet = NetworkManager::CreatePacket(24 + Events::EventSpawner::SpawnParamsSize);
 					packet.WriteVariableUint32(actorId);
 					packet.WriteVariableUint32((std::uint32_t)eventTile.Event);
 					packet.Write(eventTile.EventParams, Events::EventSpawner::SpawnParamsSize);
@@ -836,7 +989,7 @@ namespace Jazz2::Multiplayer
 					_networkManager->SendTo([this](const Peer& peer) {
 						auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 						return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateMirroredActor, packet);
+					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateMirroredActor, std::move(packet));
 				}
 			} else {
 				MemoryStream packet;
@@ -877,7 +1030,7 @@ namespace Jazz2::Multiplayer
 			}
 
 			if (actorId != UINT32_MAX) {
-				MemoryStream packet(12 + identifier.size());
+				MemoryStream packet = NetworkManager::CreatePacket(12 + identifier.size());
 				packet.WriteVariableUint32(actorId);
 				// TODO: sourceRelative
 				// TODO: looping
@@ -890,7 +1043,7 @@ namespace Jazz2::Multiplayer
 				_networkManager->SendTo([this, excludedPlayer](const Peer& peer) {
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized && (excludedPlayer == nullptr || excludedPlayer != peerDesc->Player));
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlaySfx, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlaySfx, std::move(packet));
 			} else {
 				// Actor is probably not fully created yet, try it later again
 				_pendingSfx.emplace_back(self, identifier, floatToHalf(gain), floatToHalf(pitch));
@@ -903,7 +1056,7 @@ namespace Jazz2::Multiplayer
 	std::shared_ptr<AudioBufferPlayer> MpLevelHandler::PlayCommonSfx(StringView identifier, const Vector3f& pos, float gain, float pitch)
 	{
 		if (_isServer) {
-			MemoryStream packet(16 + identifier.size());
+			MemoryStream packet = NetworkManager::CreatePacket(16 + identifier.size());
 			packet.WriteVariableInt32((std::int32_t)pos.X);
 			packet.WriteVariableInt32((std::int32_t)pos.Y);
 			// TODO: looping
@@ -915,7 +1068,7 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayCommonSfx, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayCommonSfx, std::move(packet));
 		}
 
 		return LevelHandler::PlayCommonSfx(identifier, pos, gain, pitch);
@@ -988,13 +1141,13 @@ namespace Jazz2::Multiplayer
 		if ((exitType & ExitType::FastTransition) != ExitType::FastTransition) {
 			float fadeOutDelay = _nextLevelTime - 40.0f;
 
-			MemoryStream packet(4);
+			MemoryStream packet = NetworkManager::CreatePacket(4);
 			packet.WriteVariableInt32((std::int32_t)fadeOutDelay);
 
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelLoaded);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::FadeOut, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::FadeOut, std::move(packet));
 		}
 	}
 
@@ -1010,14 +1163,14 @@ namespace Jazz2::Multiplayer
 				}
 			}
 			if (targetActorId != 0) {
-				MemoryStream packet(4 + data.size());
+				MemoryStream packet = NetworkManager::CreatePacket(4 + data.size());
 				packet.WriteVariableUint32(targetActorId);
 				packet.Write(data.data(), data.size());
 
 				_networkManager->SendTo([this](const Peer& peer) {
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelLoaded);
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::Rpc, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::Rpc, std::move(packet));
 			} else {
 				LOGW("Remote actor not found");
 			}
@@ -1033,11 +1186,11 @@ namespace Jazz2::Multiplayer
 				}
 			}
 			if (targetActorId != 0) {
-				MemoryStream packet(4 + data.size());
+				MemoryStream packet = NetworkManager::CreatePacket(4 + data.size());
 				packet.WriteVariableUint32(targetActorId);
 				packet.Write(data.data(), data.size());
 
-				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::Rpc, packet);
+				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::Rpc, std::move(packet));
 			} else {
 				LOGW("Remote actor not found");
 			}
@@ -1131,11 +1284,11 @@ namespace Jazz2::Multiplayer
 								peerDesc->LastUpdated = UINT64_MAX;
 								static_cast<PlayerOnServer*>(peerDesc->Player)->_canTakeDamage = false;
 
-								MemoryStream packet2(12);
+								MemoryStream packet2 = NetworkManager::CreatePacket(12);
 								packet2.WriteVariableUint32(peerDesc->Player->_playerIndex);
 								packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.X * 512.0f));
 								packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.Y * 512.0f));
-								_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, packet2);
+								_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, std::move(packet2));
 							}
 						}
 					}
@@ -1157,11 +1310,11 @@ namespace Jazz2::Multiplayer
 					peerDesc->LastUpdated = UINT64_MAX;
 					mpPlayer->_canTakeDamage = false;
 
-					MemoryStream packet2(12);
+					MemoryStream packet2 = NetworkManager::CreatePacket(12);
 					packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.X * 512.0f));
 					packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.Y * 512.0f));
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, packet2);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, std::move(packet2));
 				}
 				return canRespawn;
 			}
@@ -1174,11 +1327,11 @@ namespace Jazz2::Multiplayer
 				peerDesc->LastUpdated = UINT64_MAX;
 				mpPlayer->_canTakeDamage = false;
 
-				MemoryStream packet2(12);
+				MemoryStream packet2 = NetworkManager::CreatePacket(12);
 				packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.X * 512.0f));
 				packet2.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_checkpointPos.Y * 512.0f));
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, packet2);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, std::move(packet2));
 			}
 
 			CheckGameEnds();
@@ -1193,14 +1346,14 @@ namespace Jazz2::Multiplayer
 				Clock& c = nCine::clock();
 				std::uint64_t now = c.now() * 1000 / c.frequency();
 
-				MemoryStream packetAck(24);
+				MemoryStream packetAck = NetworkManager::CreatePacket(24);
 				packetAck.WriteVariableUint32(_lastSpawnedActorId);
 				packetAck.WriteVariableUint64(now);
 				packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_checkpointPos.X * 512.0f));
 				packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_checkpointPos.Y * 512.0f));
 				packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
 				packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
-				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, packetAck);
+				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, std::move(packetAck));
 
 				return true;
 			}
@@ -1217,10 +1370,10 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(5);
+				MemoryStream packet = NetworkManager::CreatePacket(5);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)exitType);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerWarpIn, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerWarpIn, std::move(packet));
 			}
 		}
 	}
@@ -1241,14 +1394,14 @@ namespace Jazz2::Multiplayer
 					flags |= 0x02;
 				}
 
-				MemoryStream packet(17);
+				MemoryStream packet = NetworkManager::CreatePacket(17);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::int32_t>((std::int32_t)(pos.X * 512.0f));
 				packet.WriteValue<std::int32_t>((std::int32_t)(pos.Y * 512.0f));
 				packet.WriteValue<std::int16_t>((std::int16_t)(force.X * 512.0f));
 				packet.WriteValue<std::int16_t>((std::int16_t)(force.Y * 512.0f));
 				packet.WriteValue<std::uint8_t>(flags);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerActivateSpring, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerActivateSpring, std::move(packet));
 			}
 		}
 
@@ -1259,7 +1412,7 @@ namespace Jazz2::Multiplayer
 	{
 		if (_isServer) {
 			if ((flags & (WarpFlags::Fast | WarpFlags::SkipWarpIn)) != WarpFlags::Default) {
-				// Nothing to do, sending PlayerMoveInstantly packet is enough
+				// Nothing to do, sending hard move (PlayerMoveInstantly packet) is enough
 				return;
 			}
 
@@ -1267,10 +1420,10 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(5);
+				MemoryStream packet = NetworkManager::CreatePacket(5);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>(0xFF);	// Only temporary, no level changing
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerWarpIn, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerWarpIn, std::move(packet));
 			}
 		}
 	}
@@ -1294,12 +1447,12 @@ namespace Jazz2::Multiplayer
 					}
 				}
 
-				MemoryStream packet(10);
+				MemoryStream packet = NetworkManager::CreatePacket(10);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Modifier);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)modifier);
 				packet.WriteVariableUint32(actorId);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1312,11 +1465,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Freeze);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)timeLeft);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1329,12 +1482,12 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(10);
+				MemoryStream packet = NetworkManager::CreatePacket(10);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Invulnerable);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)timeLeft);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)type);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1347,11 +1500,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Score);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)value);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1364,11 +1517,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Health);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)count);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1381,11 +1534,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Lives);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)count);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1399,11 +1552,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(10);
+				MemoryStream packet = NetworkManager::CreatePacket(10);
 				packet.WriteVariableUint32(player->_playerIndex);
 				packet.WriteVariableInt32(player->_health);
 				packet.WriteValue<std::int16_t>((std::int16_t)(pushForce * 512.0f));
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerTakeDamage, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerTakeDamage, std::move(packet));
 			}
 
 			if (serverConfig.GameMode == MpGameMode::TreasureHunt || serverConfig.GameMode == MpGameMode::TeamTreasureHunt) {
@@ -1418,11 +1571,11 @@ namespace Jazz2::Multiplayer
 					peerDesc->TreasureCollected -= treasureLost;
 
 					if (peerDesc->RemotePeer) {
-						MemoryStream packet2(9);
+						MemoryStream packet2 = NetworkManager::CreatePacket(9);
 						packet2.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::TreasureCollected);
 						packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 						packet2.WriteVariableUint32(peerDesc->TreasureCollected);
-						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet2);
+						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet2));
 					}
 
 					Vector2f pos = mpPlayer->_pos;
@@ -1444,11 +1597,11 @@ namespace Jazz2::Multiplayer
 				peerDesc->Deaths++;
 
 				if (peerDesc->RemotePeer) {
-					MemoryStream packet3(9);
+					MemoryStream packet3 = NetworkManager::CreatePacket(9);
 					packet3.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Deaths);
 					packet3.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet3.WriteVariableUint32(peerDesc->Deaths);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet3);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet3));
 				}
 
 				if (auto* attacker = GetWeaponOwner(mpPlayer->_lastAttacker.get())) {
@@ -1456,17 +1609,17 @@ namespace Jazz2::Multiplayer
 					attackerPeerDesc->Kills++;
 
 					if (attackerPeerDesc->RemotePeer) {
-						MemoryStream packet4(9);
+						MemoryStream packet4 = NetworkManager::CreatePacket(9);
 						packet4.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Kills);
 						packet4.WriteVariableUint32(attacker->_playerIndex);
 						packet4.WriteVariableUint32(attackerPeerDesc->Kills);
-						_networkManager->SendTo(attackerPeerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet4);
+						_networkManager->SendTo(attackerPeerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet4));
 					}
 
 					_console->WriteLine(UI::MessageLevel::Info, _f("\f[c:#d0705d]{}\f[/c] was roasted by \f[c:#d0705d]{}\f[/c]",
 						peerDesc->PlayerName, attackerPeerDesc->PlayerName));
 
-					MemoryStream packet5(19 + peerDesc->PlayerName.size() + attackerPeerDesc->PlayerName.size());
+					MemoryStream packet5 = NetworkManager::CreatePacket(19 + peerDesc->PlayerName.size() + attackerPeerDesc->PlayerName.size());
 					packet5.WriteValue<std::uint8_t>((std::uint8_t)PeerPropertyType::Roasted);
 					packet5.WriteVariableUint64((std::uint64_t)peerDesc->RemotePeer._enet);
 					packet5.WriteValue<std::uint8_t>((std::uint8_t)peerDesc->PlayerName.size());
@@ -1478,12 +1631,12 @@ namespace Jazz2::Multiplayer
 					_networkManager->SendTo([this](const Peer& peer) {
 						auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 						return (peerDesc && peerDesc->IsAuthenticated);
-					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, packet5);
+					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, std::move(packet5));
 				} else {
 					_console->WriteLine(UI::MessageLevel::Info, _f("\f[c:#d0705d]{}\f[/c] was roasted by environment",
 						peerDesc->PlayerName));
 
-					MemoryStream packet6(19 + peerDesc->PlayerName.size());
+					MemoryStream packet6 = NetworkManager::CreatePacket(19 + peerDesc->PlayerName.size());
 					packet6.WriteValue<std::uint8_t>((std::uint8_t)PeerPropertyType::Roasted);
 					packet6.WriteVariableUint64((std::uint64_t)peerDesc->RemotePeer._enet);
 					packet6.WriteValue<std::uint8_t>((std::uint8_t)peerDesc->PlayerName.size());
@@ -1494,7 +1647,7 @@ namespace Jazz2::Multiplayer
 					_networkManager->SendTo([this](const Peer& peer) {
 						auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 						return (peerDesc && peerDesc->IsAuthenticated);
-					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, packet6);
+					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, std::move(packet6));
 				}
 			}
 		}
@@ -1508,12 +1661,12 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(8);
+				MemoryStream packet = NetworkManager::CreatePacket(8);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::WeaponAmmo);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)weaponType);
 				packet.WriteValue<std::uint16_t>((std::uint16_t)mpPlayer->_weaponAmmo[(std::uint8_t)weaponType]);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1527,21 +1680,21 @@ namespace Jazz2::Multiplayer
 
 			String metadataPath = fs::FromNativeSeparators(mpPlayer->_metadata->Path);
 
-			MemoryStream packet(9 + metadataPath.size());
+			MemoryStream packet = NetworkManager::CreatePacket(9 + metadataPath.size());
 			packet.WriteVariableUint32(mpPlayer->_playerIndex);
 			packet.WriteValue<std::uint8_t>(0); // Flags (Reserved)
 			packet.WriteVariableUint32((std::uint32_t)metadataPath.size());
 			packet.Write(metadataPath.data(), (std::uint32_t)metadataPath.size());
 			_networkManager->SendTo([otherPeer = peerDesc->RemotePeer](const Peer& peer) {
 				return (peer != otherPeer);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChangeRemoteActorMetadata, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChangeRemoteActorMetadata, std::move(packet));
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet2(6);
+				MemoryStream packet2 = NetworkManager::CreatePacket(6);
 				packet2.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::PlayerType);
 				packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet2.WriteValue<std::uint8_t>((std::uint8_t)type);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet2);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet2));
 			}
 		}
 	}
@@ -1554,11 +1707,11 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Dizzy);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)timeLeft);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1571,12 +1724,12 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Shield);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)shieldType);
 				packet.WriteVariableInt32((std::int32_t)timeLeft);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1589,12 +1742,12 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(7);
+				MemoryStream packet = NetworkManager::CreatePacket(7);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::WeaponUpgrades);
 				packet.WriteVariableUint32(player->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)weaponType);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)player->_weaponUpgrades[(std::uint8_t)weaponType]);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -1607,9 +1760,9 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(4);
+				MemoryStream packet = NetworkManager::CreatePacket(4);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerEmitWeaponFlare, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerEmitWeaponFlare, std::move(packet));
 			}
 		}
 	}
@@ -1621,23 +1774,45 @@ namespace Jazz2::Multiplayer
 			auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(6);
+				MemoryStream packet = NetworkManager::CreatePacket(6);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)mpPlayer->_currentWeapon);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)reason);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerChangeWeapon, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerChangeWeapon, std::move(packet));
 			}
 		} else {
 			auto* remotablePlayer = static_cast<Actors::Multiplayer::RemotablePlayer*>(player);
 			if (!remotablePlayer->ChangingWeaponFromServer) {
-				MemoryStream packet(5);
+				MemoryStream packet = NetworkManager::CreatePacket(5);
 				packet.WriteVariableUint32(_lastSpawnedActorId);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)player->_currentWeapon);
-				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerChangeWeaponRequest, packet);
+				_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerChangeWeaponRequest, std::move(packet));
 			}
 		}
 	}
 
+	std::int64_t MpLevelHandler::GetRemoteActorRenderDelay() const
+	{
+		return _remoteRenderDelay.load(std::memory_order_relaxed);
+	}
+
+	bool MpLevelHandler::IsRemoteActorRelevant(std::uint32_t lastUpdateId) const
+	{
+		// The server sends only actors relevant to the local player, so actors missing in the last update are out of relevancy
+		return (lastUpdateId != 0 && lastUpdateId == _lastAppliedUpdate.load(std::memory_order_acquire));
+	}
+
+	void MpLevelHandler::HandleRemoteActorUnderrun()
+	{
+		_interpolationStats.UnderrunCount++;
+		TracyPlot("Remote Interpolation Underruns", static_cast<std::int64_t>(_interpolationStats.UnderrunCount));
+	}
+
+	void MpLevelHandler::HandleRemoteActorStalled()
+	{
+		_interpolationStats.StalledFrameCount++;
+	}
+
 	void MpLevelHandler::HandlePlayerWarped(Actors::Player* player, Vector2f prevPos, WarpFlags flags)
 	{
 		LevelHandler::HandlePlayerWarped(player, prevPos, flags);
@@ -1676,34 +1851,28 @@ namespace Jazz2::Multiplayer
 				if ((flags & WarpFlags::IncrementLaps) == WarpFlags::IncrementLaps && _levelState == LevelState::Running) {
 					auto& serverConfig = _networkManager->GetServerConfiguration();
 
-					MemoryStream packet2(13);
+					MemoryStream packet2 = NetworkManager::CreatePacket(13);
 					packet2.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Laps);
 					packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet2.WriteVariableUint32(peerDesc->Laps);
 					packet2.WriteVariableUint32(serverConfig.TotalLaps);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet2);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet2));
 				}
 
-				MemoryStream packet(16);
-				packet.WriteVariableUint32(mpPlayer->_playerIndex);
-				packet.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_pos.X * 512.0f));
-				packet.WriteValue<std::int32_t>((std::int32_t)(mpPlayer->_pos.Y * 512.0f));
-				packet.WriteValue<std::int16_t>((std::int16_t)(mpPlayer->_speed.X * 512.0f));
-				packet.WriteValue<std::int16_t>((std::int16_t)(mpPlayer->_speed.Y * 512.0f));
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerMoveInstantly, packet);
+				SendPlayerHardMove(peerDesc.get());
 			}
 		} else {
 			Clock& c = nCine::clock();
 			std::uint64_t now = c.now() * 1000 / c.frequency();
 
-			MemoryStream packetAck(24);
+			MemoryStream packetAck = NetworkManager::CreatePacket(24);
 			packetAck.WriteVariableUint32(_lastSpawnedActorId);
 			packetAck.WriteVariableUint64(now);
 			packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_pos.X * 512.0f));
 			packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_pos.Y * 512.0f));
 			packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
 			packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
-			_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, packetAck);
+			_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, std::move(packetAck));
 		}
 	}
 
@@ -1726,11 +1895,11 @@ namespace Jazz2::Multiplayer
 
 				for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
 					if (peerDesc->RemotePeer && peerDesc->Player) {
-						MemoryStream packet(9);
+						MemoryStream packet = NetworkManager::CreatePacket(9);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Coins);
 						packet.WriteVariableUint32(peerDesc->Player->_playerIndex);
 						packet.WriteVariableInt32(peerDesc->Player->_coins);
-						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 					}
 				}
 
@@ -1740,11 +1909,11 @@ namespace Jazz2::Multiplayer
 				auto peerDesc = mpPlayer->GetPeerDescriptor();
 
 				if (peerDesc->RemotePeer) {
-					MemoryStream packet(9);
+					MemoryStream packet = NetworkManager::CreatePacket(9);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Coins);
 					packet.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet.WriteVariableInt32(newCount);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}
 
 				// Show notification only for local players (which have assigned viewport)
@@ -1772,11 +1941,11 @@ namespace Jazz2::Multiplayer
 					peerDesc->TreasureCollected += (newCount - prevCount) * weightedCount;
 
 					if (peerDesc->RemotePeer) {
-						MemoryStream packet(9);
+						MemoryStream packet = NetworkManager::CreatePacket(9);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::TreasureCollected);
 						packet.WriteVariableUint32(mpPlayer->_playerIndex);
 						packet.WriteVariableUint32(peerDesc->TreasureCollected);
-						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+						_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 					}
 
 					CheckGameEnds();
@@ -1784,18 +1953,18 @@ namespace Jazz2::Multiplayer
 			} else {
 				// Show standard gems notification
 				if (peerDesc->RemotePeer) {
-					MemoryStream packet(10);
+					MemoryStream packet = NetworkManager::CreatePacket(10);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Gems);
 					packet.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet.WriteValue<std::uint8_t>(gemType);
 					packet.WriteVariableInt32(newCount);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 
-					MemoryStream packet2(9);
+					MemoryStream packet2 = NetworkManager::CreatePacket(9);
 					packet2.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::TreasureCollected);
 					packet2.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet2.WriteVariableUint32(peerDesc->TreasureCollected);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet2);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet2));
 				}
 
 				// Show notification only for local players (which have assigned viewport)
@@ -1851,7 +2020,7 @@ namespace Jazz2::Multiplayer
 				}
 			}
 			if (targetActorId != 0) {
-				MemoryStream packet(13);
+				MemoryStream packet = NetworkManager::CreatePacket(13);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)effect);
 				packet.WriteVariableUint32(targetActorId);
 				packet.WriteVariableInt32((std::int32_t)(speed.X * 100.0f));
@@ -1860,7 +2029,7 @@ namespace Jazz2::Multiplayer
 				_networkManager->SendTo([this](const Peer& peer) {
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateDebris, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateDebris, std::move(packet));
 			} else {
 				LOGW("Remote actor not found");
 			}
@@ -1881,7 +2050,7 @@ namespace Jazz2::Multiplayer
 				}
 			}
 			if (targetActorId != 0) {
-				MemoryStream packet(13);
+				MemoryStream packet = NetworkManager::CreatePacket(13);
 				packet.WriteValue<std::uint8_t>(UINT8_MAX); // Effect
 				packet.WriteVariableUint32(targetActorId);
 				packet.WriteVariableUint32((std::uint32_t)state);
@@ -1890,7 +2059,7 @@ namespace Jazz2::Multiplayer
 				_networkManager->SendTo([this](const Peer& peer) {
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateDebris, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateDebris, std::move(packet));
 			} else {
 				LOGW("Remote actor not found");
 			}
@@ -1917,7 +2086,7 @@ namespace Jazz2::Multiplayer
 		if (_isServer) {
 			std::uint32_t textLength = (std::uint32_t)value.size();
 
-			MemoryStream packet(9 + textLength);
+			MemoryStream packet = NetworkManager::CreatePacket(9 + textLength);
 			packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::LevelText);
 			packet.WriteVariableUint32(textId);
 			packet.WriteVariableUint32(textLength);
@@ -1926,7 +2095,7 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelLoaded);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 		}
 	}
 
@@ -2029,7 +2198,7 @@ namespace Jazz2::Multiplayer
 	void MpLevelHandler::OnAdvanceDestructibleTileAnimation(std::int32_t tx, std::int32_t ty, std::int32_t amount)
 	{
 		if (_isServer) {
-			MemoryStream packet(12);
+			MemoryStream packet = NetworkManager::CreatePacket(12);
 			packet.WriteVariableInt32(tx);
 			packet.WriteVariableInt32(ty);
 			packet.WriteVariableInt32(amount);
@@ -2037,7 +2206,7 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::AdvanceTileAnimation, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::AdvanceTileAnimation, std::move(packet));
 		}
 	}
 
@@ -2274,7 +2443,7 @@ namespace Jazz2::Multiplayer
 				continue;
 			}
 
-			MemoryStream packet(24);
+			MemoryStream packet = NetworkManager::CreatePacket(24);
 			packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::GameMode);
 			packet.WriteValue<std::uint8_t>(flags);
 			packet.WriteValue<std::uint8_t>((std::uint8_t)serverConfig.GameMode);
@@ -2285,7 +2454,7 @@ namespace Jazz2::Multiplayer
 			packet.WriteVariableUint32(serverConfig.TotalLaps);
 			packet.WriteVariableUint32(serverConfig.TotalTreasureCollected);
 
-			_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+			_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 		}
 
 		return true;
@@ -2534,6 +2703,26 @@ namespace Jazz2::Multiplayer
 					return true;
 				}
 			}
+		} else if (line == "/netstats"_s) {
+			if (isAdmin) {
+				SendUpdateStatistics(peer);
+			}
+			return true;
+		} else if (line == "/netbench"_s) {
+			if (isAdmin) {
+				SendCompressionBenchmark(peer);
+			}
+			return true;
+		} else if (line == "/netbench record"_s) {
+			if (isAdmin) {
+				ToggleSnapshotRecording(peer);
+			}
+			return true;
+		} else if (line == "/netbench train"_s) {
+			if (isAdmin) {
+				TrainSnapshotDictionary(peer);
+			}
+			return true;
 		} else if (line == "/refresh"_s) {
 			if (isAdmin) {
 				auto& serverConfig = _networkManager->GetServerConfiguration();
@@ -2742,13 +2931,13 @@ namespace Jazz2::Multiplayer
 			return;
 		}
 
-		MemoryStream packetOut(9 + message.size());
+		MemoryStream packetOut = NetworkManager::CreatePacket(9 + message.size());
 		packetOut.WriteVariableUint32(0); // Local player ID
 		packetOut.WriteValue<std::uint8_t>((std::uint8_t)level);
 		packetOut.WriteVariableUint32((std::uint32_t)message.size());
 		packetOut.Write(message.data(), (std::uint32_t)message.size());
 
-		_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, packetOut);
+		_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, std::move(packetOut));
 	}
 
 	void MpLevelHandler::SendMessageToAll(StringView message, bool asChatFromServer)
@@ -2759,7 +2948,7 @@ namespace Jazz2::Multiplayer
 			prefixedMessage = "\f[c:#907060]Server:\f[/c] "_s + prefixedMessage;
 		}
 
-		MemoryStream packetOut(9 + message.size());
+		MemoryStream packetOut = NetworkManager::CreatePacket(9 + message.size());
 		packetOut.WriteVariableUint32(0); // Local player ID
 		packetOut.WriteValue<std::uint8_t>((std::uint8_t)UI::MessageLevel::Chat);
 		packetOut.WriteVariableUint32((std::uint32_t)prefixedMessage.size());
@@ -2768,7 +2957,7 @@ namespace Jazz2::Multiplayer
 		_networkManager->SendTo([this](const Peer& peer) {
 			auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 			return (peerDesc && peerDesc->IsAuthenticated);
-		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, packetOut);
+		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, std::move(packetOut));
 
 		InvokeAsync([this, message = std::move(prefixedMessage)]() mutable {
 			_console->WriteLine(UI::MessageLevel::Info, message);
@@ -2784,11 +2973,12 @@ namespace Jazz2::Multiplayer
 				peerDesc->IsAuthenticated = false;
 				peerDesc->LevelState = PeerLevelState::Unknown;
 
-				InvokeAsync([this, peerDesc]() mutable {
+				InvokeAsync([this, peer, peerDesc]() mutable {
+					_peerSnapshots.erase(peer);
 					_console->WriteLine(UI::MessageLevel::Info, _f("\f[c:#d0705d]{}\f[/c] disconnected", peerDesc->PlayerName));
 				});
 
-				MemoryStream packet(10 + peerDesc->PlayerName.size());
+				MemoryStream packet = NetworkManager::CreatePacket(10 + peerDesc->PlayerName.size());
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PeerPropertyType::Disconnected);
 				packet.WriteVariableUint64((std::uint64_t)peer._enet);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)peerDesc->PlayerName.size());
@@ -2796,7 +2986,7 @@ namespace Jazz2::Multiplayer
 
 				_networkManager->SendTo([otherPeer = peer](const Peer& peer) {
 					return (peer != otherPeer);
-				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, packet);
+				}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, std::move(packet));
 
 				if (MpPlayer* player = peerDesc->Player) {
 					std::int32_t playerIndex = player->_playerIndex;
@@ -2813,12 +3003,12 @@ namespace Jazz2::Multiplayer
 					player->_pos = OutOfBounds;
 					player->SetState(Actors::ActorState::IsDestroyed, true);
 
-					MemoryStream packet(4);
+					MemoryStream packet = NetworkManager::CreatePacket(4);
 					packet.WriteVariableUint32(playerIndex);
 
 					_networkManager->SendTo([otherPeer = peer](const Peer& peer) {
 						return (peer != otherPeer);
-					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::DestroyRemoteActor, packet);
+					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::DestroyRemoteActor, std::move(packet));
 
 					const auto& serverConfig = _networkManager->GetServerConfiguration();
 					if (_levelState == LevelState::WaitingForMinPlayers) {
@@ -2882,11 +3072,11 @@ namespace Jazz2::Multiplayer
 											peerDesc->LastUpdated = UINT64_MAX;
 											static_cast<PlayerOnServer*>(peerDesc->Player)->_canTakeDamage = false;
 
-											MemoryStream packet2(12);
+											MemoryStream packet2 = NetworkManager::CreatePacket(12);
 											packet2.WriteVariableUint32(peerDesc->Player->_playerIndex);
 											packet2.WriteValue<std::int32_t>((std::int32_t)(checkpointPos.X * 512.0f));
 											packet2.WriteValue<std::int32_t>((std::int32_t)(checkpointPos.Y * 512.0f));
-											_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, packet2);
+											_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerRespawn, std::move(packet2));
 										}
 									}
 								}
@@ -2940,7 +3130,7 @@ namespace Jazz2::Multiplayer
 							_console->WriteLine(UI::MessageLevel::Info, _f("\f[c:#d0705d]{}\f[/c] connected", peerDesc->PlayerName));
 						});
 
-						MemoryStream packet(10 + peerDesc->PlayerName.size());
+						MemoryStream packet = NetworkManager::CreatePacket(10 + peerDesc->PlayerName.size());
 						packet.WriteValue<std::uint8_t>((std::uint8_t)PeerPropertyType::Connected);
 						packet.WriteVariableUint64((std::uint64_t)peer._enet);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)peerDesc->PlayerName.size());
@@ -2948,7 +3138,7 @@ namespace Jazz2::Multiplayer
 
 						_networkManager->SendTo([otherPeer = peer](const Peer& peer) {
 							return (peer != otherPeer);
-						}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, packet);
+						}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PeerSetProperty, std::move(packet));
 					}
 
 					MemoryStream packet;
@@ -2959,12 +3149,31 @@ namespace Jazz2::Multiplayer
 				case ClientPacketType::LevelReady: {
 					MemoryStream packet(data);
 					std::uint8_t flags = packet.ReadValue<std::uint8_t>();
+					Vector2i viewSize;
+					if (packet.GetPosition() < packet.GetSize()) {
+						viewSize.X = (std::int32_t)packet.ReadVariableUint32();
+						viewSize.Y = (std::int32_t)packet.ReadVariableUint32();
+					}
+					// Deflate without dictionary is used if the client doesn't specify supported methods
+					std::uint32_t compressionMethods = (1u << std::uint32_t(SnapshotCompression::Deflate));
+					std::uint32_t dictionaryId = 0;
+					if (packet.GetPosition() < packet.GetSize()) {
+						compressionMethods = packet.ReadVariableUint32();
+						dictionaryId = packet.ReadVariableUint32();
+					}
+
+					SnapshotCompression compression = SnapshotCompressor::SelectMethod(compressionMethods);
+					bool useDictionary = (dictionaryId != 0 && dictionaryId == _snapshotCompressor.GetDictionaryId() && compression != SnapshotCompression::Deflate);
 
-					LOGD("[MP] ClientPacketType::LevelReady [{:.8x}] - flags: 0x{:.2x}", std::uint64_t(peer._enet), flags);
+					LOGD("[MP] ClientPacketType::LevelReady [{:.8x}] - flags: 0x{:.2x}, view: {}x{}, compression: {}{}", std::uint64_t(peer._enet),
+						flags, viewSize.X, viewSize.Y, SnapshotCompressor::GetMethodName(compression), useDictionary ? " (dictionary)"_s : ""_s);
 
 					if (auto peerDesc = _networkManager->GetPeerDescriptor(peer)) {
 						bool enableLedgeClimb = (flags & 0x02) != 0;
 						peerDesc->EnableLedgeClimb = enableLedgeClimb;
+						peerDesc->ViewSize = viewSize;
+						peerDesc->UpdateCompression = compression;
+						peerDesc->UseUpdateDictionary = useDictionary;
 						if (peerDesc->LevelState < PeerLevelState::LevelLoaded) {
 							peerDesc->LevelState = PeerLevelState::LevelLoaded;
 						}
@@ -2976,13 +3185,13 @@ namespace Jazz2::Multiplayer
 							std::uint8_t flags = 0x01 | 0x02 | 0x04; // Set Visibility | Show | SetWelcomeMessage
 							std::uint8_t allowedCharacters = serverConfig.AllowedPlayerTypes;
 
-							MemoryStream packet(6 + serverConfig.WelcomeMessage.size());
+							MemoryStream packet = NetworkManager::CreatePacket(6 + serverConfig.WelcomeMessage.size());
 							packet.WriteValue<std::uint8_t>(flags);
 							packet.WriteValue<std::uint8_t>(allowedCharacters);
 							packet.WriteVariableUint32(serverConfig.WelcomeMessage.size());
 							packet.Write(serverConfig.WelcomeMessage.data(), serverConfig.WelcomeMessage.size());
 
-							_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowInGameLobby, packet);
+							_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowInGameLobby, std::move(packet));
 						}
 					}
 					return true;
@@ -3021,7 +3230,7 @@ namespace Jazz2::Multiplayer
 						prefixedMessage = "\f[c:#709060]"_s + peerDesc->PlayerName + ":\f[/c] "_s + line;
 					}
 
-					MemoryStream packetOut(9 + prefixedMessage.size());
+					MemoryStream packetOut = NetworkManager::CreatePacket(9 + prefixedMessage.size());
 					packetOut.WriteVariableUint32(playerIndex);
 					packetOut.WriteValue<std::uint8_t>((std::uint8_t)UI::MessageLevel::Chat);
 					packetOut.WriteVariableUint32((std::uint32_t)prefixedMessage.size());
@@ -3030,7 +3239,7 @@ namespace Jazz2::Multiplayer
 					_networkManager->SendTo([this](const Peer& peer) {
 						auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 						return (peerDesc && peerDesc->LevelState != PeerLevelState::Unknown);
-					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, packetOut);
+					}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ChatMessage, std::move(packetOut));
 
 					InvokeAsync([this, line = std::move(prefixedMessage)]() mutable {
 						_console->WriteLine(UI::MessageLevel::Chat, std::move(line));
@@ -3123,13 +3332,13 @@ namespace Jazz2::Multiplayer
 
 							const RequiredAsset& asset = *missingAssets[i];
 
-							MemoryStream packetBegin(14 + asset.Path.size());
+							MemoryStream packetBegin = NetworkManager::CreatePacket(14 + asset.Path.size());
 							packetBegin.WriteValue<std::uint8_t>(1);	// Begin
 							packetBegin.WriteValue<std::uint8_t>((std::uint8_t)asset.Type);
 							packetBegin.WriteVariableUint32((std::uint32_t)asset.Path.size());
 							packetBegin.Write(asset.Path.data(), (std::int64_t)asset.Path.size());
 							packetBegin.WriteVariableInt64(asset.Size);
-							_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, packetBegin);
+							_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, std::move(packetBegin));
 
 							auto s = fs::Open(asset.FullPath, FileAccess::Read);
 							if (s->IsValid()) {
@@ -3145,17 +3354,17 @@ namespace Jazz2::Multiplayer
 										break;
 									}
 
-									MemoryStream packetChunk(9 + bytesRead);
+									MemoryStream packetChunk = NetworkManager::CreatePacket(9 + bytesRead);
 									packetChunk.WriteValue<std::uint8_t>(2);	// Chunk
 									packetChunk.WriteVariableInt64(bytesRead);
 									packetChunk.Write(buffer, bytesRead);
-									_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, packetChunk);
+									_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, std::move(packetChunk));
 								}
 							}
 
-							MemoryStream packetEnd(1);
+							MemoryStream packetEnd = NetworkManager::CreatePacket(1);
 							packetEnd.WriteValue<std::uint8_t>(3);	// End
-							_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, packetEnd);
+							_this->_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::StreamAsset, std::move(packetEnd));
 						}
 
 						LOGI("[MP] Finished streaming {} assets to peer [{:.8x}] - took {:.1f} ms",
@@ -3204,7 +3413,10 @@ namespace Jazz2::Multiplayer
 				}
 				case ClientPacketType::ForceResyncActors: {
 					LOGD("[MP] ClientPacketType::ForceResyncActors [{:.8x}] - update: {}", std::uint64_t(peer._enet), _lastUpdated);
-					_forceResyncPending = true;
+					// Forget the acknowledged snapshot, so the next update will contain full state of all relevant actors
+					if (auto peerDesc = _networkManager->GetPeerDescriptor(peer)) {
+						peerDesc->LastAckedUpdate = 0;
+					}
 					return true;
 				}
 				case ClientPacketType::PlayerUpdate: {
@@ -3223,12 +3435,23 @@ namespace Jazz2::Multiplayer
 					}
 
 					peerDesc->LastUpdated = now;
+					peerDesc->LastAckedUpdate = packet.ReadVariableUint32();
+					std::uint32_t firstSeqNum = packet.ReadVariableUint32();
+					std::uint32_t frameCount = packet.ReadVariableUint32();
+					if (frameCount > MaxInputFramesPerUpdate) {
+						LOGD("[MP] ClientPacketType::PlayerUpdate [{:.8x}] - too many input frames ({})", std::uint64_t(peer._enet), frameCount);
+						return true;
+					}
 
-					float posX = packet.ReadValue<std::int32_t>() / 512.0f;
-					float posY = packet.ReadValue<std::int32_t>() / 512.0f;
-					float speedX = packet.ReadValue<std::int16_t>() / 512.0f;
-					float speedY = packet.ReadValue<std::int16_t>() / 512.0f;
-					RemotePlayerOnServer::PlayerFlags flags = (RemotePlayerOnServer::PlayerFlags)packet.ReadVariableUint32();
+					// Player is simulated only by the server from the received input frames, positions are never accepted from clients
+					auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player);
+					for (std::uint32_t i = 0; i < frameCount; i++) {
+						std::uint64_t pressedKeys = packet.ReadVariableUint64();
+						float frameTimeMult = packet.ReadValue<std::uint8_t>() / InputTimeMultScale;
+						if (remotePlayerOnServer != nullptr) {
+							remotePlayerOnServer->QueueInput(firstSeqNum + i, pressedKeys, frameTimeMult);
+						}
+					}
 
 					/*bool justWarped = (flags & PlayerFlags::JustWarped) == PlayerFlags::JustWarped;
 					if (justWarped) {
@@ -3239,12 +3462,12 @@ namespace Jazz2::Multiplayer
 							LOGD("Acknowledged player {} warp for sequence #{}", playerIndex, seqNumWarped);
 							it2->second.WarpSeqNum = seqNumWarped;
 
-							MemoryStream packet2(13);
+							MemoryStream packet2 = NetworkManager::CreatePacket(13);
 							packet2.WriteValue<std::uint8_t>((std::uint8_t)ServerPacketType::PlayerAckWarped);
 							packet2.WriteVariableUint32(playerIndex);
 							packet2.WriteVariableUint64(seqNumWarped);
 
-							_networkManager->SendTo(peer, NetworkChannel::Main, packet2);
+							_networkManager->SendTo(peer, NetworkChannel::Main, std::move(packet2));
 						}
 					}
 		
@@ -3279,46 +3502,18 @@ namespace Jazz2::Multiplayer
 							posX = player->_pos.X;
 							posY = player->_pos.Y;
 
-							MemoryStream packet2(13);
+							MemoryStream packet2 = NetworkManager::CreatePacket(13);
 							packet2.WriteValue<std::uint8_t>((std::uint8_t)ServerPacketType::PlayerMoveInstantly);
 							packet2.WriteVariableUint32(player->_playerIndex);
 							packet2.WriteValue<std::int32_t>((std::int32_t)(posX * 512.0f));
 							packet2.WriteValue<std::int32_t>((std::int32_t)(posY * 512.0f));
 							packet2.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
 							packet2.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
-							_networkManager->SendTo(peer, NetworkChannel::Main, packet2);
+							_networkManager->SendTo(peer, NetworkChannel::Main, std::move(packet2));
 						}
 					}*/
 
 					// TODO: Special move
-
-					if (auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player)) {
-						remotePlayerOnServer->SyncWithServer(Vector2f(posX, posY), Vector2f(speedX, speedY),
-							(flags & RemotePlayerOnServer::PlayerFlags::IsVisible) != RemotePlayerOnServer::PlayerFlags::None,
-							(flags & RemotePlayerOnServer::PlayerFlags::IsFacingLeft) != RemotePlayerOnServer::PlayerFlags::None,
-							(flags & RemotePlayerOnServer::PlayerFlags::IsActivelyPushing) != RemotePlayerOnServer::PlayerFlags::None);
-					}
-					return true;
-				}
-				case ClientPacketType::PlayerKeyPress: {
-					MemoryStream packet(data);
-					std::uint32_t playerIndex = packet.ReadVariableUint32();
-
-					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
-					if (peerDesc->Player == nullptr || peerDesc->Player->_playerIndex != playerIndex) {
-						return true;
-					}
-					
-					if (auto* remotePlayerOnServer = runtime_cast<RemotePlayerOnServer>(peerDesc->Player)) {
-						std::uint32_t frameCount = theApplication().GetFrameCount();
-						if (remotePlayerOnServer->UpdatedFrame != frameCount) {
-							remotePlayerOnServer->UpdatedFrame = frameCount;
-							remotePlayerOnServer->PressedKeysLast = remotePlayerOnServer->PressedKeys;
-						}
-						remotePlayerOnServer->PressedKeys = packet.ReadVariableUint64();
-					}
-
-					//LOGD("Player {} pressed 0x{:.8x}, last state was 0x{:.8x}", playerIndex, it->second.PressedKeys & 0xffffffffu, prevState);
 					return true;
 				}
 				case ClientPacketType::PlayerChangeWeaponRequest: {
@@ -3351,10 +3546,8 @@ namespace Jazz2::Multiplayer
 					MemoryStream packet(data);
 					std::uint32_t playerIndex = packet.ReadVariableUint32();
 					std::uint64_t seqNum = packet.ReadVariableUint64();
-					float posX = packet.ReadValue<std::int32_t>() / 512.0f;
-					float posY = packet.ReadValue<std::int32_t>() / 512.0f;
-					float speedX = packet.ReadValue<std::int16_t>() / 512.0f;
-					float speedY = packet.ReadValue<std::int16_t>() / 512.0f;
+					// Position and speed reported by the client are not used, the player is already warped on the server
+					packet.Seek(2 * sizeof(std::int32_t) + 2 * sizeof(std::int16_t), SeekOrigin::Current);
 
 					auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 					if (peerDesc->Player == nullptr || peerDesc->Player->_playerIndex != playerIndex) {
@@ -3362,12 +3555,10 @@ namespace Jazz2::Multiplayer
 						return true;
 					}
 
-					LOGD("[MP] ClientPacketType::PlayerAckWarped [{:.8x}] - playerIndex: {}, seqNum: {}, x: {}, y: {}",
-						std::uint64_t(peer._enet), playerIndex, seqNum, posX, posY);
+					LOGD("[MP] ClientPacketType::PlayerAckWarped [{:.8x}] - playerIndex: {}, seqNum: {}", std::uint64_t(peer._enet), playerIndex, seqNum);
 
 					peerDesc->LastUpdated = seqNum;
 					if (auto* mpPlayer = static_cast<RemotePlayerOnServer*>(peerDesc->Player)) {
-						mpPlayer->ForceResyncWithServer(Vector2f(posX, posY), Vector2f(speedX, speedY));
 						mpPlayer->_canTakeDamage = true;
 						mpPlayer->_justWarped = true;
 					}
@@ -3900,80 +4091,182 @@ namespace Jazz2::Multiplayer
 					return true;
 				}
 				case ServerPacketType::UpdateAllActors: {
-					MemoryStream packetCompressed(data);
-					DeflateStream packet(packetCompressed);
+					MemoryStream packet(1024);
+					if (!_snapshotCompressor.Decompress(data, packet)) {
+						LOGW("[MP] ServerPacketType::UpdateAllActors - failed to decompress {} bytes", data.size());
+						return true;
+					}
+					packet.Seek(0, SeekOrigin::Begin);
 					std::uint32_t now = packet.ReadVariableUint32();
 					float elapsedFrames = (float)packet.ReadVariableUint64();
-					std::uint32_t actorCount = packet.ReadVariableUint32();
+					std::uint32_t baselineId = packet.ReadVariableUint32();
 
-					bool forceResyncInvoked = (actorCount & 1) == 1;
-					if DEATH_UNLIKELY(!forceResyncInvoked && _lastUpdated >= now) {
+					if DEATH_UNLIKELY(_lastUpdated >= now) {
 						return true;
 					}
 
-					bool forceResyncRequired = (!forceResyncInvoked && _lastUpdated + 1 < now);
-					if (forceResyncRequired) {
-						LOGD("[MP] ServerPacketType::UpdateAllActors - FORCE RESYNC REQUIRED ({} -> {})", _lastUpdated, now);
-					} else if (forceResyncInvoked) {
-						LOGD("[MP] ServerPacketType::UpdateAllActors - FORCE RESYNC INVOKED ({} -> {})", _lastUpdated, now);
+					std::unique_lock lock(_lock);
+
+					// Actors are encoded as delta against the specified snapshot that was acknowledged by this client
+					const SnapshotHistory::Entry* baseline = nullptr;
+					if (baselineId != 0) {
+						baseline = _receivedSnapshots.Find(baselineId, now);
+						if DEATH_UNLIKELY(baseline == nullptr) {
+							// The server will use newer acknowledged snapshot soon, so it can be safely skipped
+							LOGD("[MP] ServerPacketType::UpdateAllActors - BASELINE NOT FOUND ({} -> {})", baselineId, now);
+							return true;
+						}
 					}
 
-					std::unique_lock lock(_lock);
+					// The whole packet is decoded first, so it can be dropped without any side effects if it's invalid
+					// Players are always sent with full state
+					std::uint32_t playerCount = packet.ReadVariableUint32();
+					SmallVector<std::pair<ActorSnapshot, std::uint8_t>, ControlScheme::MaxSupportedPlayers> players;
+					players.reserve(playerCount);
+					for (std::uint32_t i = 0; i < playerCount; i++) {
+						auto& [state, flags] = players.emplace_back();
+						state = {};
+						state.ActorID = packet.ReadVariableUint32();
+						flags = packet.ReadValue<std::uint8_t>();
+
+						if ((flags & 0x01) != 0) {
+							state.PosX = packet.ReadValue<std::int32_t>();
+							state.PosY = packet.ReadValue<std::int32_t>();
+						}
+						if ((flags & 0x02) != 0) {
+							state.Animation = packet.ReadVariableUint32();
+							state.Rotation = packet.ReadValue<std::uint16_t>();
+							state.ScaleX = packet.ReadValue<std::uint16_t>();
+							state.ScaleY = packet.ReadValue<std::uint16_t>();
+							state.RendererType = packet.ReadValue<std::uint8_t>();
+						}
+					}
 
-					_lastUpdated = now;
-					_elapsedFrames = lerp(_elapsedFrames, elapsedFrames + _networkManager->GetRoundTripTimeMs() * FrameTimer::FramesPerSecond * 0.002f, 0.05f);
+					std::uint32_t actorCount = packet.ReadVariableUint32();
 
-					actorCount >>= 1;
+					SmallVector<ActorSnapshot, 0> actors;
+					SmallVector<bool, 0> actorsWarped;
+					actors.reserve(actorCount);
+					actorsWarped.reserve(actorCount);
 
+					BitReader br({ packet.GetBuffer() + packet.GetPosition(), (std::size_t)(packet.GetSize() - packet.GetPosition()) });
+					std::size_t baselineCursor = 0;
+					std::uint32_t lastActorId = UINT32_MAX;
 					for (std::uint32_t i = 0; i < actorCount; i++) {
-						std::uint32_t actorId = packet.ReadVariableUint32();
-						std::uint8_t flags = packet.ReadValue<std::uint8_t>();
+						std::uint32_t actorId = lastActorId + 1 + br.ReadVariableBits(ActorIdDeltaBits);
+						lastActorId = actorId;
+
+						// Missing values are taken from the baseline snapshot
+						bool isInBaseline = br.ReadBool();
+						const ActorSnapshot* baselineState = (baseline != nullptr ? FindActorSnapshot(baseline->Actors, baselineCursor, actorId) : nullptr);
+						if DEATH_UNLIKELY(isInBaseline && baselineState == nullptr) {
+							// Received snapshots differ from sent ones, request full state of all actors and drop the packet
+							LOGD("[MP] ServerPacketType::UpdateAllActors - actor {} not found in baseline {}", actorId, baselineId);
+							_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::ForceResyncActors, ArrayView<const std::uint8_t>{});
+							return true;
+						}
 
-						bool positionChanged = (flags & 0x01) != 0;
-						bool animationChanged = (flags & 0x02) != 0;
+						auto& state = actors.emplace_back();
+						if (isInBaseline) {
+							state = *baselineState;
+						} else {
+							state = {};
+							state.ActorID = actorId;
+						}
 
-						float posX, posY, rotation, scaleX, scaleY;
-						AnimState anim; Actors::ActorRendererType rendererType;
+						actorsWarped.push_back(br.ReadBool());
+						bool hasPosition = br.ReadBool();
+						if (hasPosition) {
+							if (isInBaseline) {
+								state.PosX += br.ReadVariableSignedBits(PositionDeltaBits);
+								state.PosY += br.ReadVariableSignedBits(PositionDeltaBits);
+							} else {
+								state.PosX = br.ReadVariableSignedBits(PositionBits);
+								state.PosY = br.ReadVariableSignedBits(PositionBits);
+							}
+						}
 
-						if (positionChanged) {
-							posX = packet.ReadValue<std::int32_t>() / 512.0f;
-							posY = packet.ReadValue<std::int32_t>() / 512.0f;
-						} else {
-							posX = 0.0f;
-							posY = 0.0f;
+						bool hasAnimation = false, hasRotation = false, hasScale = false, hasRendererType = false, hasFlags = false;
+						if (br.ReadBool()) {
+							hasAnimation = br.ReadBool();
+							hasRotation = br.ReadBool();
+							hasScale = br.ReadBool();
+							hasRendererType = br.ReadBool();
+							hasFlags = br.ReadBool();
+
+							if (hasAnimation) {
+								state.Animation = br.ReadVariableBits(AnimationBits);
+							}
+							if (hasRotation) {
+								state.Rotation = (std::uint16_t)br.ReadBits(16);
+							}
+							if (hasScale) {
+								bool uniformScale = br.ReadBool();
+								state.ScaleX = (std::uint16_t)br.ReadBits(16);
+								state.ScaleY = (uniformScale ? state.ScaleX : (std::uint16_t)br.ReadBits(16));
+							}
+							if (hasRendererType) {
+								state.RendererType = (std::uint8_t)br.ReadBits(4);
+							}
+							if (hasFlags) {
+								state.Flags = (std::uint8_t)(br.ReadBits(4) << 2);
+							}
 						}
 
-						if (animationChanged) {
-							anim = (AnimState)packet.ReadVariableUint32();
-							rotation = packet.ReadValue<std::uint16_t>() * fRadAngle360 / UINT16_MAX;
-							scaleX = (float)Half{packet.ReadValue<std::uint16_t>()};
-							scaleY = (float)Half{packet.ReadValue<std::uint16_t>()};
-							rendererType = (Actors::ActorRendererType)packet.ReadValue<std::uint8_t>();
-						} else {
-							anim = AnimState::Idle;
-							rotation = 0.0f;
-							scaleX = 0.0f;
-							scaleY = 0.0f;
-							rendererType = Actors::ActorRendererType::Default;
+						if DEATH_UNLIKELY(!br.IsValid()) {
+							// Partial snapshot must not be used as baseline, so the whole packet is dropped
+							LOGD("[MP] ServerPacketType::UpdateAllActors - truncated state of actor {}", actorId);
+							return true;
 						}
+						if DEATH_UNLIKELY(!isInBaseline && !(hasPosition && hasAnimation && hasRotation && hasScale && hasRendererType && hasFlags)) {
+							LOGD("[MP] ServerPacketType::UpdateAllActors - incomplete state of actor {} without baseline", actorId);
+							return true;
+						}
+					}
 
-						auto it = _remoteActors.find(actorId);
+					const auto* previous = _receivedSnapshots.Find(_lastUpdated, now);
+					auto& current = _receivedSnapshots.Reset(now);
+					current.Actors = std::move(actors);
+
+					UpdateRemoteRenderDelay(now, _lastUpdated);
+					_lastUpdated = now;
+					_elapsedFrames = lerp(_elapsedFrames, elapsedFrames + _networkManager->GetRoundTripTimeMs() * FrameTimer::FramesPerSecond * 0.002f, 0.05f);
+
+					auto applyState = [this, now](const ActorSnapshot& state, std::uint8_t flags, float positionScale, bool positionChanged, bool animationChanged) {
+						auto it = _remoteActors.find(state.ActorID);
 						if (it != _remoteActors.end()) {
 							if (auto* remoteActor = runtime_cast<Actors::Multiplayer::RemoteActor>(it->second.get())) {
 								if (positionChanged) {
-									remoteActor->SyncPositionWithServer(Vector2f(posX, posY));
+									remoteActor->SyncPositionWithServer(Vector2f(state.PosX / positionScale, state.PosY / positionScale));
 								}
 								if (animationChanged) {
-									remoteActor->SyncAnimationWithServer(anim, rotation, scaleX, scaleY, rendererType);
+									remoteActor->SyncAnimationWithServer((AnimState)state.Animation, state.Rotation * fRadAngle360 / UINT16_MAX,
+										(float)Half{state.ScaleX}, (float)Half{state.ScaleY}, (Actors::ActorRendererType)state.RendererType);
 								}
 								remoteActor->SyncMiscWithServer(flags);
+								remoteActor->SyncRelevancyWithServer(now);
 							}
 						}
+					};
+
+					for (const auto& [state, flags] : players) {
+						applyState(state, flags, 512.0f, (flags & 0x01) != 0, (flags & 0x02) != 0);
 					}
 
-					if (forceResyncRequired) {
-						_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::ForceResyncActors, {});
+					std::size_t previousCursor = 0;
+					for (std::size_t i = 0; i < current.Actors.size(); i++) {
+						const auto& state = current.Actors[i];
+
+						// Only changes since the previously received snapshot are applied, but position is applied always,
+						// so the interpolation knows that the actor stopped and it doesn't extrapolate its movement
+						const ActorSnapshot* prevState = (previous != nullptr ? FindActorSnapshot(previous->Actors, previousCursor, state.ActorID) : nullptr);
+						bool animationChanged = (prevState == nullptr || state.Animation != prevState->Animation || state.Rotation != prevState->Rotation ||
+							state.ScaleX != prevState->ScaleX || state.ScaleY != prevState->ScaleY || state.RendererType != prevState->RendererType);
+
+						applyState(state, state.Flags | (actorsWarped[i] ? 0x40 : 0), ActorPositionScale, true, animationChanged);
 					}
+
+					_lastAppliedUpdate.store(now, std::memory_order_release);
 					return true;
 				}
 				case ServerPacketType::ChangeRemoteActorMetadata: {
@@ -4337,14 +4630,14 @@ namespace Jazz2::Multiplayer
 							Clock& c = nCine::clock();
 							std::uint64_t now = c.now() * 1000 / c.frequency();
 
-							MemoryStream packetAck(24);
+							MemoryStream packetAck = NetworkManager::CreatePacket(24);
 							packetAck.WriteVariableUint32(_lastSpawnedActorId);
 							packetAck.WriteVariableUint64(now);
 							packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_pos.X * 512.0f));
 							packetAck.WriteValue<std::int32_t>((std::int32_t)(player->_pos.Y * 512.0f));
 							packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
 							packetAck.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
-							_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, packetAck);
+							_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerAckWarped, std::move(packetAck));
 						}
 					});
 					return true;
@@ -4360,15 +4653,31 @@ namespace Jazz2::Multiplayer
 					float posY = packet.ReadValue<std::int32_t>() / 512.0f;
 					float speedX = packet.ReadValue<std::int16_t>() / 512.0f;
 					float speedY = packet.ReadValue<std::int16_t>() / 512.0f;
+					std::uint32_t seqNum = packet.ReadVariableUint32();
 
-					LOGD("[MP] ServerPacketType::PlayerMoveInstantly - playerIndex: {}, x: {}, y: {}, sx: {}, sy: {}",
-						playerIndex, posX, posY, speedX, speedY);
+					LOGD("[MP] ServerPacketType::PlayerMoveInstantly - playerIndex: {}, x: {}, y: {}, sx: {}, sy: {}, seqNum: {}",
+						playerIndex, posX, posY, speedX, speedY, seqNum);
 
-					InvokeAsync([this, posX, posY, speedX, speedY]() {
-						if (!_players.empty()) {
-							auto* player = static_cast<RemotablePlayer*>(_players[0]);
-							player->MoveRemotely(Vector2f(posX, posY), Vector2f(speedX, speedY));
-						}
+					InvokeAsync([this, posX, posY, speedX, speedY, seqNum]() {
+						ReconcileLocalPlayer(Vector2f(posX, posY), Vector2f(speedX, speedY), seqNum, true);
+					});
+					return true;
+				}
+				case ServerPacketType::PlayerAckInput: {
+					MemoryStream packet(data);
+					std::uint32_t playerIndex = packet.ReadVariableUint32();
+					if (_lastSpawnedActorId != playerIndex) {
+						return true;
+					}
+
+					std::uint32_t seqNum = packet.ReadVariableUint32();
+					float posX = packet.ReadValue<std::int32_t>() / 512.0f;
+					float posY = packet.ReadValue<std::int32_t>() / 512.0f;
+					float speedX = packet.ReadValue<std::int16_t>() / 512.0f;
+					float speedY = packet.ReadValue<std::int16_t>() / 512.0f;
+
+					InvokeAsync([this, posX, posY, speedX, speedY, seqNum]() {
+						ReconcileLocalPlayer(Vector2f(posX, posY), Vector2f(speedX, speedY), seqNum, false);
 					});
 					return true;
 				}
@@ -4511,14 +4820,14 @@ namespace Jazz2::Multiplayer
 		if (_isServer && (prevLeft != _limitCameraLeft || prevWidth != _limitCameraWidth)) {
 			for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
 				if (peerDesc->RemotePeer && peerDesc->Player) {
-					MemoryStream packet(21);
+					MemoryStream packet = NetworkManager::CreatePacket(21);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::LimitCameraView);
 					packet.WriteVariableUint32(peerDesc->Player->_playerIndex);
 					packet.WriteVariableInt32(left);
 					packet.WriteVariableInt32(width);
 					packet.WriteVariableInt32((std::int32_t)playerPos.X);
 					packet.WriteVariableInt32((std::int32_t)playerPos.Y);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}
 			}
 		}
@@ -4531,13 +4840,13 @@ namespace Jazz2::Multiplayer
 
 		if (_isServer) {
 			if (auto* mpPlayer = runtime_cast<RemotePlayerOnServer>(player)) {
-				MemoryStream packet(14);
+				MemoryStream packet = NetworkManager::CreatePacket(14);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::OverrideCameraView);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)(x * 100.0f));
 				packet.WriteVariableInt32((std::int32_t)(y * 100.0f));
 				packet.WriteValue<std::uint8_t>(topLeft ? 1 : 0);
-				_networkManager->SendTo(mpPlayer->GetPeerDescriptor()->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(mpPlayer->GetPeerDescriptor()->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -4548,11 +4857,11 @@ namespace Jazz2::Multiplayer
 
 		if (_isServer) {
 			if (auto* mpPlayer = runtime_cast<RemotePlayerOnServer>(player)) {
-				MemoryStream packet(9);
+				MemoryStream packet = NetworkManager::CreatePacket(9);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::ShakeCameraView);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteVariableInt32((std::int32_t)(duration * 100.0f));
-				_networkManager->SendTo(mpPlayer->GetPeerDescriptor()->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(mpPlayer->GetPeerDescriptor()->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -4567,11 +4876,11 @@ namespace Jazz2::Multiplayer
 		if (_isServer) {
 			for (auto& [peer, peerDesc] : *_networkManager->GetPeers()) {
 				if (peerDesc->RemotePeer && peerDesc->Player && (peerDesc->Player->_pos - pos).Length() <= MaxDistance) {
-					MemoryStream packet(9);
+					MemoryStream packet = NetworkManager::CreatePacket(9);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::ShakeCameraView);
 					packet.WriteVariableUint32(peerDesc->Player->_playerIndex);
 					packet.WriteVariableInt32((std::int32_t)(duration * 100.0f));
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}
 			}
 		}
@@ -4582,14 +4891,14 @@ namespace Jazz2::Multiplayer
 		LevelHandler::SetTrigger(triggerId, newState);
 
 		if (_isServer) {
-			MemoryStream packet(2);
+			MemoryStream packet = NetworkManager::CreatePacket(2);
 			packet.WriteValue<std::uint8_t>(triggerId);
 			packet.WriteValue<std::uint8_t>(newState);
 
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SetTrigger, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SetTrigger, std::move(packet));
 		}
 	}
 
@@ -4609,7 +4918,7 @@ namespace Jazz2::Multiplayer
 			if (setDefault) flags |= 0x01;
 			if (forceReload) flags |= 0x02;
 
-			MemoryStream packet(6 + path.size());
+			MemoryStream packet = NetworkManager::CreatePacket(6 + path.size());
 			packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::Music);
 			packet.WriteValue<std::uint8_t>(flags);
 			packet.WriteVariableUint32((std::uint32_t)path.size());
@@ -4618,7 +4927,7 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 		}
 
 		return success;
@@ -4643,13 +4952,13 @@ namespace Jazz2::Multiplayer
 			_remoteActors.erase(actorId);
 		}
 
-		MemoryStream packet(4);
+		MemoryStream packet = NetworkManager::CreatePacket(4);
 		packet.WriteVariableUint32(actorId);
 
 		_networkManager->SendTo([this](const Peer& peer) {
 			auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 			return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::DestroyRemoteActor, packet);
+		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::DestroyRemoteActor, std::move(packet));
 	}
 
 	void MpLevelHandler::ProcessEvents(float timeMult)
@@ -4705,32 +5014,32 @@ namespace Jazz2::Multiplayer
 
 				// Synchronize level state
 				{
-					MemoryStream packet(6);
+					MemoryStream packet = NetworkManager::CreatePacket(6);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::State);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)_levelState);
 					packet.WriteVariableInt32(_levelState == LevelState::WaitingForMinPlayers
 						? _waitingForPlayerCount : (std::int32_t)(_gameTimeLeft * 100.0f));
 
-					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 				}
 
 				// Synchronize tilemap
 				{
 					// TODO: Use deflate compression here?
-					MemoryStream packet(40 * 1024);
+					MemoryStream packet = NetworkManager::CreatePacket(40 * 1024);
 					_tileMap->SerializeResumableToStream(packet);
-					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SyncTileMap, packet);
+					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SyncTileMap, std::move(packet));
 				}
 
 				// Synchronize music
 				if (_musicCurrentPath != _musicDefaultPath) {
-					MemoryStream packet(6 + _musicCurrentPath.size());
+					MemoryStream packet = NetworkManager::CreatePacket(6 + _musicCurrentPath.size());
 					packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::Music);
 					packet.WriteValue<std::uint8_t>(0);
 					packet.WriteVariableUint32((std::uint32_t)_musicCurrentPath.size());
 					packet.Write(_musicCurrentPath.data(), (std::uint32_t)_musicCurrentPath.size());
 
-					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 				}
 
 				// Synchronize actors
@@ -4745,12 +5054,12 @@ namespace Jazz2::Multiplayer
 
 					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateRemoteActor, packet);
 					
-					MemoryStream packet2(5 + otherPeerDesc->PlayerName.size());
+					MemoryStream packet2 = NetworkManager::CreatePacket(5 + otherPeerDesc->PlayerName.size());
 					packet2.WriteVariableUint32(mpOtherPlayer->_playerIndex);
 					packet2.WriteValue<std::uint8_t>((std::uint8_t)otherPeerDesc->PlayerName.size());
 					packet2.Write(otherPeerDesc->PlayerName.data(), (std::uint32_t)otherPeerDesc->PlayerName.size());
 
-					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::MarkRemoteActorAsPlayer, packet2);
+					_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::MarkRemoteActorAsPlayer, std::move(packet2));
 				}
 
 				// TODO: Does this need to be locked?
@@ -4760,7 +5069,7 @@ namespace Jazz2::Multiplayer
 						Vector2i originTile = remotingActor->_originTile;
 						const auto& eventTile = _eventMap->GetEventTile(originTile.X, originTile.Y);
 						if (eventTile.Event != EventType::Empty) {
-							MemoryStream packet(24 + Events::EventSpawner::SpawnParamsSize);
+							MemoryStream packet = NetworkManager::CreatePacket(24 + Events::EventSpawner::SpawnParamsSize);
 							packet.WriteVariableUint32(remotingActorInfo.ActorID);
 							packet.WriteVariableUint32((std::uint32_t)eventTile.Event);
 							packet.Write(eventTile.EventParams, Events::EventSpawner::SpawnParamsSize);
@@ -4769,7 +5078,7 @@ namespace Jazz2::Multiplayer
 							packet.WriteVariableInt32((std::int32_t)originTile.Y);
 							packet.WriteVariableInt32((std::int32_t)remotingActor->_renderer.layer());
 
-							_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateMirroredActor, packet);
+							_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateMirroredActor, std::move(packet));
 						}
 					} else {
 						MemoryStream packet;
@@ -4829,7 +5138,7 @@ namespace Jazz2::Multiplayer
 							flags |= 0x02;
 						}
 
-						MemoryStream packet(16);
+						MemoryStream packet = NetworkManager::CreatePacket(16);
 						packet.WriteVariableUint32(playerIndex);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)player->_playerType);
 						packet.WriteVariableInt32(player->_health);
@@ -4838,7 +5147,7 @@ namespace Jazz2::Multiplayer
 						packet.WriteVariableInt32((std::int32_t)player->_pos.X);
 						packet.WriteVariableInt32((std::int32_t)player->_pos.Y);
 
-						_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateControllablePlayer, packet);
+						_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::CreateControllablePlayer, std::move(packet));
 					}
 
 					// The player is invulnerable for a short time after spawning
@@ -4853,14 +5162,14 @@ namespace Jazz2::Multiplayer
 							}
 						}
 
-						MemoryStream packet(21);
+						MemoryStream packet = NetworkManager::CreatePacket(21);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::LimitCameraView);
 						packet.WriteVariableUint32(playerIndex);
 						packet.WriteVariableInt32(_limitCameraLeft);
 						packet.WriteVariableInt32(_limitCameraWidth);
 						packet.WriteVariableInt32((std::int32_t)otherPlayerPos.X);
 						packet.WriteVariableInt32((std::int32_t)otherPlayerPos.Y);
-						_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+						_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 					}
 
 					// Create the player also on all other clients
@@ -4878,7 +5187,7 @@ namespace Jazz2::Multiplayer
 					}
 
 					{
-						MemoryStream packet(5 + peerDesc->PlayerName.size());
+						MemoryStream packet = NetworkManager::CreatePacket(5 + peerDesc->PlayerName.size());
 						packet.WriteVariableUint32(playerIndex);
 						packet.WriteValue<std::uint8_t>((std::uint8_t)peerDesc->PlayerName.size());
 						packet.Write(peerDesc->PlayerName.data(), (std::uint32_t)peerDesc->PlayerName.size());
@@ -4886,7 +5195,7 @@ namespace Jazz2::Multiplayer
 						_networkManager->SendTo([this](const Peer& peer) {
 							auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 							return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-						}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::MarkRemoteActorAsPlayer, packet);
+						}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::MarkRemoteActorAsPlayer, std::move(packet));
 					}
 
 					if DEATH_UNLIKELY(_levelState == LevelState::WaitingForMinPlayers) {
@@ -5019,7 +5328,7 @@ namespace Jazz2::Multiplayer
 
 		std::uint8_t flags = 0;
 
-		MemoryStream packet(5 + text.size());
+		MemoryStream packet = NetworkManager::CreatePacket(5 + text.size());
 		packet.WriteValue<std::uint8_t>(flags);
 		packet.WriteVariableUint32((std::uint32_t)text.size());
 		packet.Write(text.data(), (std::uint32_t)text.size());
@@ -5027,7 +5336,7 @@ namespace Jazz2::Multiplayer
 		_networkManager->SendTo([this](const Peer& peer) {
 			auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 			return (peerDesc && peerDesc->LevelState != PeerLevelState::Unknown);
-		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowAlert, packet);
+		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowAlert, std::move(packet));
 	}
 
 	void MpLevelHandler::SetControllableToAllPlayers(bool enable)
@@ -5041,18 +5350,18 @@ namespace Jazz2::Multiplayer
 			mpPlayer->_controllableExternal = enable;
 
 			if (peerDesc->RemotePeer) {
-				MemoryStream packet(6);
+				MemoryStream packet = NetworkManager::CreatePacket(6);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Controllable);
 				packet.WriteVariableUint32(mpPlayer->_playerIndex);
 				packet.WriteValue<std::uint8_t>(enable ? 1 : 0);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
 
 	void MpLevelHandler::SendLevelStateToAllPlayers()
 	{
-		MemoryStream packet(6);
+		MemoryStream packet = NetworkManager::CreatePacket(6);
 		packet.WriteValue<std::uint8_t>((std::uint8_t)LevelPropertyType::State);
 		packet.WriteValue<std::uint8_t>((std::uint8_t)_levelState);
 		packet.WriteVariableInt32(_levelState == LevelState::WaitingForMinPlayers
@@ -5061,7 +5370,7 @@ namespace Jazz2::Multiplayer
 		_networkManager->SendTo([this](const Peer& peer) {
 			auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 			return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelLoaded);
-		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, packet);
+		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::LevelSetProperty, std::move(packet));
 	}
 
 	void MpLevelHandler::ResetAllPlayerStats()
@@ -5096,15 +5405,15 @@ namespace Jazz2::Multiplayer
 
 				if (peerDesc->RemotePeer) {
 					// TODO: Send it also to peers without assigned player
-					MemoryStream packet1(4);
+					MemoryStream packet1 = NetworkManager::CreatePacket(4);
 					packet1.WriteVariableUint32(peerDesc->Player->_playerIndex);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerResetProperties, packet1);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerResetProperties, std::move(packet1));
 
-					MemoryStream packet2(9);
+					MemoryStream packet2 = NetworkManager::CreatePacket(9);
 					packet2.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Health);
 					packet2.WriteVariableUint32(peerDesc->Player->_playerIndex);
 					packet2.WriteVariableInt32(peerDesc->Player->_health);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet2);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet2));
 				}
 			}
 		}
@@ -5213,12 +5522,12 @@ namespace Jazz2::Multiplayer
 		// Synchronize tilemap
 		{
 			// TODO: Use deflate compression here?
-			MemoryStream packet(40 * 1024);
+			MemoryStream packet = NetworkManager::CreatePacket(40 * 1024);
 			_tileMap->SerializeResumableToStream(packet);
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SyncTileMap, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::SyncTileMap, std::move(packet));
 		}
 
 		for (auto& actor : _actors) {
@@ -5327,11 +5636,11 @@ namespace Jazz2::Multiplayer
 				positionsChanged = true;
 
 				/*if (peerDesc->RemotePeer) {
-					MemoryStream packet(9);
+					MemoryStream packet = NetworkManager::CreatePacket(9);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::PositionInRound);
 					packet.WriteVariableUint32(sortedPlayers[i].first()->_playerIndex);
 					packet.WriteVariableUint32(peerDesc->PositionInRound);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}*/
 			}
 		}
@@ -5356,17 +5665,17 @@ namespace Jazz2::Multiplayer
 				positionsChanged = true;
 
 				/*if (peerDesc->RemotePeer) {
-					MemoryStream packet(9);
+					MemoryStream packet = NetworkManager::CreatePacket(9);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::PositionInRound);
 					packet.WriteVariableUint32(sortedDeadPlayers[i].first()->_playerIndex);
 					packet.WriteVariableUint32(peerDesc->PositionInRound);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}*/
 			}
 		}
 
 		if (positionsChanged || forceSend) {
-			MemoryStream packet(4 + (sortedPlayers.size() + sortedDeadPlayers.size()) * 12);
+			MemoryStream packet = NetworkManager::CreatePacket(4 + (sortedPlayers.size() + sortedDeadPlayers.size()) * 12);
 			packet.WriteVariableUint32(sortedPlayers.size() + sortedDeadPlayers.size());
 			for (std::int32_t i = 0; i < sortedPlayers.size(); i++) {
 				auto peerDesc = sortedPlayers[i].first()->GetPeerDescriptor();
@@ -5383,7 +5692,7 @@ namespace Jazz2::Multiplayer
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState != PeerLevelState::Unknown);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::UpdatePositionsInRound, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::UpdatePositionsInRound, std::move(packet));
 		}
 	}
 
@@ -5480,13 +5789,13 @@ namespace Jazz2::Multiplayer
 
 			_hud->BeginFadeOut(fadeOutDelay);
 
-			MemoryStream packet(4);
+			MemoryStream packet = NetworkManager::CreatePacket(4);
 			packet.WriteVariableInt32((std::int32_t)fadeOutDelay);
 
 			_networkManager->SendTo([this](const Peer& peer) {
 				auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 				return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelLoaded);
-			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::FadeOut, packet);
+			}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::FadeOut, std::move(packet));
 		}
 
 		if (winner != nullptr) {
@@ -5505,12 +5814,12 @@ namespace Jazz2::Multiplayer
 				if (peerDesc->RemotePeer) {
 					auto& serverConfig = _networkManager->GetServerConfiguration();
 
-					MemoryStream packet(13);
+					MemoryStream packet = NetworkManager::CreatePacket(13);
 					packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Points);
 					packet.WriteVariableUint32(mpPlayer->_playerIndex);
 					packet.WriteVariableUint32(peerDesc->Points);
 					packet.WriteVariableUint32(serverConfig.TotalPlayerPoints);
-					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+					_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 				}
 			}
 		}
@@ -5659,12 +5968,12 @@ namespace Jazz2::Multiplayer
 			if (peerDesc->RemotePeer) {
 				auto& serverConfig = _networkManager->GetServerConfiguration();
 
-				MemoryStream packet(13);
+				MemoryStream packet = NetworkManager::CreatePacket(13);
 				packet.WriteValue<std::uint8_t>((std::uint8_t)PlayerPropertyType::Points);
 				packet.WriteVariableUint32(peerDesc->Player->_playerIndex);
 				packet.WriteVariableUint32(peerDesc->Points);
 				packet.WriteVariableUint32(serverConfig.TotalPlayerPoints);
-				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, packet);
+				_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerSetProperty, std::move(packet));
 			}
 		}
 	}
@@ -5680,7 +5989,7 @@ namespace Jazz2::Multiplayer
 
 		std::uint8_t flags = 0x04; // SetLobbyMessage
 
-		MemoryStream packet(6 + serverConfig.WelcomeMessage.size());
+		MemoryStream packet = NetworkManager::CreatePacket(6 + serverConfig.WelcomeMessage.size());
 		packet.WriteValue<std::uint8_t>(flags);
 		packet.WriteValue<std::uint8_t>(0x00);
 		packet.WriteVariableUint32(serverConfig.WelcomeMessage.size());
@@ -5689,7 +5998,7 @@ namespace Jazz2::Multiplayer
 		_networkManager->SendTo([this](const Peer& peer) {
 			auto peerDesc = _networkManager->GetPeerDescriptor(peer);
 			return (peerDesc && peerDesc->LevelState >= PeerLevelState::LevelSynchronized);
-		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowInGameLobby, packet);
+		}, NetworkChannel::Main, (std::uint8_t)ServerPacketType::ShowInGameLobby, std::move(packet));
 	}
 
 	void MpLevelHandler::SetPlayerReady(PlayerType playerType)
@@ -5700,12 +6009,12 @@ namespace Jazz2::Multiplayer
 
 		_inGameLobby->Hide();
 
-		MemoryStream packet(2);
+		MemoryStream packet = NetworkManager::CreatePacket(2);
 		packet.WriteValue<std::uint8_t>((std::uint8_t)playerType);
 		// TODO: Preferred team
 		packet.WriteValue<std::uint8_t>(0);
 
-		_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerReady, packet);
+		_networkManager->SendTo(AllPeers, NetworkChannel::Main, (std::uint8_t)ClientPacketType::PlayerReady, std::move(packet));
 	}
 
 	void MpLevelHandler::EndActivePoll()
@@ -5750,6 +6059,282 @@ namespace Jazz2::Multiplayer
 		_activePoll = VoteType::None;
 	}
 
+	void MpLevelHandler::SendUpdateStatistics(const Peer& peer)
+	{
+		char infoBuffer[256];
+
+		if (_updateStats.UpdateCount == 0) {
+			SendMessage(peer, UI::MessageLevel::Confirm, "No updates were sent since the last reset"_s);
+			return;
+		}
+
+		const auto& s = _updateStats;
+		std::size_t length = formatInto(infoBuffer, "Updates: {} ({} packets, {:.1f} actors per packet)", s.UpdateCount, s.PacketCount,
+			s.PacketCount > 0 ? (float)s.TotalActorCount / s.PacketCount : 0.0f);
+		SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+		length = formatInto(infoBuffer, "Server time per update: {:.3f} ms (max. {:.3f} ms)", s.TotalTimeMs / s.UpdateCount, s.MaxTimeMs);
+		SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+		if (s.PacketCount > 0) {
+			length = formatInto(infoBuffer, "Packet size: {} bytes, compressed {} bytes (max. {} bytes, {:.1f}%)",
+				(std::uint32_t)(s.TotalSize / s.PacketCount), (std::uint32_t)(s.TotalCompressedSize / s.PacketCount), s.MaxCompressedSize,
+				s.TotalSize > 0 ? s.TotalCompressedSize * 100.0f / s.TotalSize : 0.0f);
+			SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+			length = formatInto(infoBuffer, "Outbound bandwidth: {:.1f} kB/s per peer",
+				(float)s.TotalCompressedSize / s.PacketCount * UpdatesPerSecond / 1024.0f);
+			SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+		}
+
+		_updateStats = {};
+	}
+
+	void MpLevelHandler::UpdateRemoteRenderDelay(std::uint32_t updateId, std::uint32_t lastUpdateId)
+	{
+		Clock& c = nCine::clock();
+		std::int64_t arrivalTime = c.now() * 1000 / c.frequency();
+
+		// Inter-arrival jitter is smoothed the same way as in RTP (RFC 3550), lost updates are accounted by their IDs
+		if (lastUpdateId != 0 && _lastUpdateArrivalTime != 0) {
+			float expectedMs = (updateId - lastUpdateId) * 1000.0f / UpdatesPerSecond;
+			float deviationMs = std::abs((float)(arrivalTime - _lastUpdateArrivalTime) - expectedMs);
+			_arrivalJitterMs += (deviationMs - _arrivalJitterMs) / 16.0f;
+		}
+		_lastUpdateArrivalTime = arrivalTime;
+
+		std::uint32_t roundTripTimeMs = _networkManager->GetRoundTripTimeMs();
+		if (_lastRoundTripTimeMs != 0) {
+			float deviationMs = (float)std::abs((std::int32_t)roundTripTimeMs - (std::int32_t)_lastRoundTripTimeMs);
+			_roundTripJitterMs += (deviationMs - _roundTripJitterMs) / 16.0f;
+		}
+		_lastRoundTripTimeMs = roundTripTimeMs;
+
+		// One-way variation is roughly half of the round-trip variation
+		float jitterMs = std::max(_arrivalJitterMs, _roundTripJitterMs * 0.5f);
+		float targetMs = std::clamp(1000.0f / UpdatesPerSecond + jitterMs * RemoteRenderDelayJitterFactor,
+			MinRemoteRenderDelayMs, MaxRemoteRenderDelayMs);
+
+		// Increase quickly to stop stuttering as soon as possible, but decrease slowly to avoid visible time jumps
+		_remoteRenderDelayMs = lerp(_remoteRenderDelayMs, targetMs, targetMs > _remoteRenderDelayMs ? 0.2f : 0.02f);
+		_remoteRenderDelay.store((std::int32_t)(_remoteRenderDelayMs + 0.5f), std::memory_order_relaxed);
+
+		TracyPlot("Remote Render Delay (ms)", static_cast<std::int64_t>(_remoteRenderDelayMs));
+		TracyPlot("Remote Arrival Jitter (ms)", static_cast<std::int64_t>(_arrivalJitterMs));
+	}
+
+	void MpLevelHandler::SendPlayerHardMove(PeerDescriptor* peerDesc)
+	{
+		auto* player = peerDesc->Player;
+
+		// Hard move is not smoothed by the client, it's used when the player is moved by the server (e.g., warped),
+		// input frames after the last applied one are replayed from the new position
+		MemoryStream packet = NetworkManager::CreatePacket(24);
+		packet.WriteVariableUint32(player->_playerIndex);
+		packet.WriteValue<std::int32_t>((std::int32_t)(player->_pos.X * 512.0f));
+		packet.WriteValue<std::int32_t>((std::int32_t)(player->_pos.Y * 512.0f));
+		packet.WriteValue<std::int16_t>((std::int16_t)(player->_speed.X * 512.0f));
+		packet.WriteValue<std::int16_t>((std::int16_t)(player->_speed.Y * 512.0f));
+		packet.WriteVariableUint32(peerDesc->LastInputSeqNum);
+		_networkManager->SendTo(peerDesc->RemotePeer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::PlayerMoveInstantly, std::move(packet));
+	}
+
+	void MpLevelHandler::ReconcileLocalPlayer(Vector2f pos, Vector2f speed, std::uint32_t seqNum, bool hardMove)
+	{
+		if (_players.empty()) {
+			return;
+		}
+
+		// Acknowledgements are unreliable, so older ones can arrive later, hard move can share the sequence number with them
+		if (hardMove ? (seqNum < _lastAckedInputSeqNum) : (seqNum <= _lastAckedInputSeqNum)) {
+			return;
+		}
+		_lastAckedInputSeqNum = seqNum;
+
+		auto* player = static_cast<RemotablePlayer*>(_players[0]);
+
+		if (!hardMove) {
+			if (player->IsWarpPending()) {
+				// Warping is finished by the hard move
+				return;
+			}
+
+			const auto* predicted = _inputHistory.Find(seqNum);
+			if (predicted != nullptr) {
+				// Replay models only walking on the ground (see RemotablePlayer::ReplayInput()), so if the player was airborne
+				// in any of the frames, smaller errors are left to be reconciled after landing
+				bool isGrounded = predicted->IsGrounded;
+				for (std::uint32_t i = seqNum + 1; i <= _inputSeqNum && isGrounded; i++) {
+					const auto* frame = _inputHistory.Find(i);
+					if (frame == nullptr) {
+						break;
+					}
+					isGrounded = frame->IsGrounded;
+				}
+
+				float maxError = (isGrounded ? MaxPredictionError : MaxAirbornePredictionError);
+				if ((pos - predicted->Pos).SqrLength() <= maxError * maxError) {
+					return;
+				}
+			}
+		}
+
+		// Rewind to the authoritative state and replay all input frames the server hasn't applied yet
+		Vector2f predictedPos = player->_pos;
+		player->MoveInstantly(pos, Actors::MoveType::Absolute | Actors::MoveType::Force);
+		player->_speed = speed;
+
+		for (std::uint32_t i = seqNum + 1; i <= _inputSeqNum; i++) {
+			auto* frame = _inputHistory.Find(i);
+			if (frame == nullptr) {
+				break;
+			}
+
+			player->ReplayInput(frame->PressedActions, frame->TimeMult);
+			// Recorded prediction is corrected too, so the following acknowledgements are compared against it
+			frame->Pos = player->_pos;
+			frame->Speed = player->_speed;
+		}
+
+		Vector2f correctedPos = player->_pos;
+		Vector2f correctedSpeed = player->_speed;
+		player->MoveInstantly(predictedPos, Actors::MoveType::Absolute | Actors::MoveType::Force);
+
+		if (hardMove) {
+			player->MoveRemotely(correctedPos, correctedSpeed);
+		} else {
+			player->ReconcileWithServer(correctedPos, correctedSpeed);
+		}
+	}
+
+	void MpLevelHandler::ToggleSnapshotRecording(const Peer& peer)
+	{
+		if (_recordSnapshotSamples) {
+			_recordSnapshotSamples = false;
+
+			char infoBuffer[128];
+			std::size_t length = formatInto(infoBuffer, "Recording of updates stopped with {} samples", _snapshotSampleCount);
+			SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+			return;
+		}
+
+		// The whole ring is allocated upfront, so recording doesn't allocate during updates
+		if (_snapshotSampleBuffer.empty()) {
+			_snapshotSampleBuffer = Array<std::uint8_t>(NoInit, MaxSnapshotSamples * MaxSnapshotSampleSize);
+			_snapshotSampleSizes = Array<std::uint32_t>(ValueInit, MaxSnapshotSamples);
+		}
+		_snapshotSampleCount = 0;
+		_nextSnapshotSample = 0;
+		_recordSnapshotSamples = true;
+
+		SendMessage(peer, UI::MessageLevel::Confirm, "Recording of updates started, use /netbench record again to stop it"_s);
+	}
+
+	void MpLevelHandler::RecordSnapshotSample(ArrayView<const std::uint8_t> data)
+	{
+		// Keep a ring of recent snapshots, so /netbench can measure the real traffic of the current level
+		if (data.size() > MaxSnapshotSampleSize) {
+			return;
+		}
+
+		std::memcpy(&_snapshotSampleBuffer[_nextSnapshotSample * MaxSnapshotSampleSize], data.data(), data.size());
+		_snapshotSampleSizes[_nextSnapshotSample] = std::uint32_t(data.size());
+		_nextSnapshotSample = (_nextSnapshotSample + 1) % MaxSnapshotSamples;
+		if (_snapshotSampleCount < MaxSnapshotSamples) {
+			_snapshotSampleCount++;
+		}
+	}
+
+	ArrayView<const std::uint8_t> MpLevelHandler::GetSnapshotSample(std::uint32_t index) const
+	{
+		return _snapshotSampleBuffer.sliceSize(index * MaxSnapshotSampleSize, _snapshotSampleSizes[index]);
+	}
+
+	void MpLevelHandler::SendCompressionBenchmark(const Peer& peer)
+	{
+		char infoBuffer[256];
+
+		if (_snapshotSampleCount == 0) {
+			SendMessage(peer, UI::MessageLevel::Confirm, "No updates were recorded yet, use /netbench record first"_s);
+			return;
+		}
+
+		std::uint64_t totalSize = 0;
+		for (std::uint32_t i = 0; i < _snapshotSampleCount; i++) {
+			totalSize += _snapshotSampleSizes[i];
+		}
+
+		std::size_t length = formatInto(infoBuffer, "Samples: {} ({} bytes per packet)", _snapshotSampleCount,
+			(std::uint32_t)(totalSize / _snapshotSampleCount));
+		SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+
+		std::uint32_t supportedMethods = SnapshotCompressor::GetSupportedMethods();
+		for (std::uint32_t i = 0; i < std::uint32_t(SnapshotCompression::Count); i++) {
+			if ((supportedMethods & (1u << i)) == 0) {
+				continue;
+			}
+
+			for (std::int32_t j = 0; j < 2; j++) {
+				bool useDictionary = (j != 0);
+				if (useDictionary && (_snapshotCompressor.GetDictionaryId() == 0 || SnapshotCompression(i) == SnapshotCompression::Deflate)) {
+					continue;
+				}
+
+				std::uint64_t totalCompressedSize = 0;
+				float compressTimeUs = 0.0f, decompressTimeUs = 0.0f;
+				MemoryStream compressed(4096);
+				MemoryStream decompressed(4096);
+				for (std::uint32_t k = 0; k < _snapshotSampleCount; k++) {
+					ArrayView<const std::uint8_t> sample = GetSnapshotSample(k);
+					compressed.Seek(0, SeekOrigin::Begin);
+					TimeStamp begin = TimeStamp::now();
+					_snapshotCompressor.Compress(SnapshotCompression(i), useDictionary, sample, compressed);
+					compressTimeUs += begin.microsecondsSince();
+					totalCompressedSize += compressed.GetPosition();
+
+					decompressed.Seek(0, SeekOrigin::Begin);
+					begin = TimeStamp::now();
+					_snapshotCompressor.Decompress({ compressed.GetBuffer(), (std::size_t)compressed.GetPosition() }, decompressed);
+					decompressTimeUs += begin.microsecondsSince();
+				}
+
+				length = formatInto(infoBuffer, "{}{}: {} bytes ({:.1f}%), compress {:.1f} us, decompress {:.1f} us",
+					SnapshotCompressor::GetMethodName(SnapshotCompression(i)), useDictionary ? " + dictionary"_s : ""_s,
+					(std::uint32_t)(totalCompressedSize / _snapshotSampleCount), totalCompressedSize * 100.0f / totalSize,
+					compressTimeUs / _snapshotSampleCount, decompressTimeUs / _snapshotSampleCount);
+				SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+			}
+		}
+	}
+
+	void MpLevelHandler::TrainSnapshotDictionary(const Peer& peer)
+	{
+		SmallVector<ArrayView<const std::uint8_t>, 0> samples(_snapshotSampleCount);
+		for (std::uint32_t i = 0; i < _snapshotSampleCount; i++) {
+			samples[i] = GetSnapshotSample(i);
+		}
+
+		Array<std::uint8_t> dictionary = SnapshotCompressor::TrainDictionary(samples, SnapshotCompressor::MaxDictionarySize);
+		if (dictionary.empty()) {
+			SendMessage(peer, UI::MessageLevel::Error, "Failed to train the dictionary, more samples are needed"_s);
+			return;
+		}
+
+		auto& resolver = ContentResolver::Get();
+		String targetPath = fs::CombinePath({ resolver.GetCachePath(), "Multiplayer"_s });
+		fs::CreateDirectories(targetPath);
+		targetPath = fs::CombinePath(targetPath, "Snapshots.dict"_s);
+
+		auto s = fs::Open(targetPath, FileAccess::Write);
+		if (!s->IsValid()) {
+			SendMessage(peer, UI::MessageLevel::Error, "Failed to save the dictionary"_s);
+			return;
+		}
+		s->Write(dictionary.data(), (std::int64_t)dictionary.size());
+
+		char infoBuffer[256];
+		std::size_t length = formatInto(infoBuffer, "Dictionary with {} bytes was trained from {} samples, it will be used after the level is reloaded",
+			dictionary.size(), _snapshotSampleCount);
+		SendMessage(peer, UI::MessageLevel::Confirm, { infoBuffer, length });
+	}
+
 	bool MpLevelHandler::ActorShouldBeMirrored(Actors::ActorBase* actor)
 	{
 		// If actor has no animation, it's probably some special object (usually lights and ambient sounds)
@@ -5866,6 +6451,65 @@ namespace Jazz2::Multiplayer
 		packet.WriteValue<std::uint8_t>((std::uint8_t)actor->_renderer.GetRendererType());
 	}
 
+	MpLevelHandler::UpdateStatistics::UpdateStatistics()
+		: UpdateCount(0), PacketCount(0), TotalTimeMs(0.0f), MaxTimeMs(0.0f), TotalActorCount(0), TotalSize(0),
+			TotalCompressedSize(0), MaxCompressedSize(0)
+	{
+	}
+
+	MpLevelHandler::InterpolationStatistics::InterpolationStatistics()
+		: UnderrunCount(0), StalledFrameCount(0)
+	{
+	}
+
+	const MpLevelHandler::ActorSnapshot* MpLevelHandler::FindActorSnapshot(ArrayView<const ActorSnapshot> sortedActors, std::size_t& cursor, std::uint32_t actorId)
+	{
+		// Actor IDs must be queried in ascending order, so the cursor only moves forward
+		while (cursor < sortedActors.size() && sortedActors[cursor].ActorID < actorId) {
+			cursor++;
+		}
+		return (cursor < sortedActors.size() && sortedActors[cursor].ActorID == actorId ? &sortedActors[cursor] : nullptr);
+	}
+
+	const MpLevelHandler::SnapshotHistory::Entry* MpLevelHandler::SnapshotHistory::Find(std::uint32_t updateId, std::uint32_t newerUpdateId) const
+	{
+		if (updateId == 0 || updateId >= newerUpdateId || newerUpdateId - updateId >= Length) {
+			return nullptr;
+		}
+
+		const auto& entry = Entries[updateId % Length];
+		return (entry.UpdateId == updateId ? &entry : nullptr);
+	}
+
+	MpLevelHandler::SnapshotHistory::Entry& MpLevelHandler::SnapshotHistory::Reset(std::uint32_t updateId)
+	{
+		auto& entry = Entries[updateId % Length];
+		entry.UpdateId = updateId;
+		entry.Actors.clear();
+		return entry;
+	}
+
+	MpLevelHandler::InputHistory::Entry* MpLevelHandler::InputHistory::Find(std::uint32_t seqNum)
+	{
+		if (seqNum == 0) {
+			return nullptr;
+		}
+
+		auto& entry = Entries[seqNum % Length];
+		return (entry.SeqNum == seqNum ? &entry : nullptr);
+	}
+
+	void MpLevelHandler::InputHistory::Record(std::uint32_t seqNum, std::uint64_t pressedActions, float timeMult, Vector2f pos, Vector2f speed, bool isGrounded)
+	{
+		auto& entry = Entries[seqNum % Length];
+		entry.SeqNum = seqNum;
+		entry.PressedActions = pressedActions;
+		entry.TimeMult = timeMult;
+		entry.Pos = pos;
+		entry.Speed = speed;
+		entry.IsGrounded = isGrounded;
+	}
+
 	String MpLevelHandler::GetAssetFullPath(AssetType type, StringView path, StaticArrayView<Uuid::Size, Uuid::Type> remoteServerId, bool forWrite)
 	{
 		const auto& resolver = ContentResolver::Get();
@@ -6078,6 +6722,9 @@ namespace Jazz2::Multiplayer
 		ImGui::Text("%.0f", _remotingActorsCount[_plotIndex]);
 
 		ImGui::Text("Last spawned ID: %u", _lastSpawnedActorId);
+		ImGui::Text("Remote render delay: %d ms (jitter: %.1f ms, RTT jitter: %.1f ms)", _remoteRenderDelay.load(std::memory_order_relaxed),
+			_arrivalJitterMs, _roundTripJitterMs);
+		ImGui::Text("Interpolation underruns: %u (stalled frames: %u)", _interpolationStats.UnderrunCount, _interpolationStats.StalledFrameCount);
 
 		ImGui::SeparatorText("Peers");
 
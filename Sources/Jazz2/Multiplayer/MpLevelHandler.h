@@ -5,11 +5,14 @@
 #include "../LevelHandler.h"
 #include "MpGameMode.h"
 #include "NetworkManager.h"
+#include "SnapshotCompressor.h"
 #include "../Actors/Player.h"
 #include "../UI/InGameConsole.h"
 
 #include <Threading/Spinlock.h>
 
+#include <atomic>
+
 namespace Jazz2::Actors::Multiplayer
 {
 	class MpPlayer;
@@ -42,10 +45,14 @@ namespace Jazz2::Multiplayer
 #endif
 		friend class Actors::Multiplayer::PlayerOnServer;
 		friend class Actors::Multiplayer::RemotablePlayer;
+		friend class Actors::Multiplayer::RemoteActor;
 		friend class Actors::Multiplayer::RemotePlayerOnServer;
 		friend class UI::Multiplayer::MpInGameCanvasLayer;
 		friend class UI::Multiplayer::MpInGameLobby;
 		friend class UI::Multiplayer::MpHUD;
+#if defined(MULTIPLAYER_BENCHMARK)
+		friend class MpBenchmark;
+#endif
 
 	public:
 		/** @brief Level state */
@@ -71,6 +78,9 @@ namespace Jazz2::Multiplayer
 			Script
 		};
 
+		/** @brief Scale of fixed-point time multiplier of input frames in @ref ClientPacketType::PlayerUpdate */
+		static constexpr float InputTimeMultScale = 64.0f;
+
 		MpLevelHandler(IRootController* root, NetworkManager* networkManager, LevelState levelState, bool enableLedgeClimb);
 		~MpLevelHandler() override;
 
@@ -209,18 +219,95 @@ namespace Jazz2::Multiplayer
 		/** @brief Called when a player changes their current weapon */
 		void HandlePlayerWeaponChanged(Actors::Player* player, Actors::Player::SetCurrentWeaponReason reason);
 
+		/** @brief Returns how long remote actors are rendered behind the received updates (in milliseconds) */
+		std::int64_t GetRemoteActorRenderDelay() const;
+		/** @brief Returns `true` if a remote actor last updated by the specified update is still relevant to the local player */
+		bool IsRemoteActorRelevant(std::uint32_t lastUpdateId) const;
+		/** @brief Called when a remote actor ran out of received states and started to extrapolate */
+		void HandleRemoteActorUnderrun();
+		/** @brief Called when a remote actor reached the extrapolation limit and it's stalled */
+		void HandleRemoteActorStalled();
+
 	private:
 #ifndef DOXYGEN_GENERATING_OUTPUT
 		// Doxygen 1.12.0 outputs also private structs/unions even if it shouldn't
 		struct RemotingActorInfo {
 			std::uint32_t ActorID;
-			std::int32_t LastPosX;
-			std::int32_t LastPosY;
-			std::uint32_t LastAnimation;
-			std::uint16_t LastRotation;
-			std::uint16_t LastScaleX;
-			std::uint16_t LastScaleY;
-			std::uint8_t LastRendererType;
+		};
+
+		struct ActorSnapshot {
+			std::uint32_t ActorID;
+			Vector2f Pos;
+			std::int32_t PosX; // Quantized by ActorPositionScale
+			std::int32_t PosY; // Quantized by ActorPositionScale
+			std::uint32_t Animation;
+			std::uint16_t Rotation;
+			std::uint16_t ScaleX;
+			std::uint16_t ScaleY;
+			std::uint8_t RendererType;
+			std::uint8_t Flags; // Visible | AnimPaused | FlippedX | FlippedY
+		};
+
+		struct SnapshotHistory {
+			// Number of sent/received snapshots kept for delta encoding (~1 second)
+			static constexpr std::uint32_t Length = 32;
+
+			struct Entry {
+				std::uint32_t UpdateId;
+				SmallVector<ActorSnapshot, 0> Actors; // Sorted by Actor ID
+
+				Entry() : UpdateId(0) {}
+			};
+
+			Entry Entries[Length];
+
+			// Returns the entry of the specified update if it's still available and not going to be overwritten by the newer update
+			const Entry* Find(std::uint32_t updateId, std::uint32_t newerUpdateId) const;
+			// Returns the cleared entry for the specified update, the oldest entry is overwritten
+			Entry& Reset(std::uint32_t updateId);
+		};
+
+		struct InputHistory {
+			// Number of input frames of the local player kept for reconciliation (~2 seconds)
+			static constexpr std::uint32_t Length = 128;
+
+			struct Entry {
+				std::uint32_t SeqNum;
+				std::uint64_t PressedActions;
+				float TimeMult;
+				Vector2f Pos;
+				Vector2f Speed;
+				bool IsGrounded;
+
+				Entry() : SeqNum(0), IsGrounded(false) {}
+			};
+
+			Entry Entries[Length];
+
+			// Returns the specified input frame if it wasn't overwritten yet
+			Entry* Find(std::uint32_t seqNum);
+			// Stores the input frame and the predicted state after it was applied
+			void Record(std::uint32_t seqNum, std::uint64_t pressedActions, float timeMult, Vector2f pos, Vector2f speed, bool isGrounded);
+		};
+
+		struct UpdateStatistics {
+			std::uint32_t UpdateCount;
+			std::uint32_t PacketCount;
+			float TotalTimeMs;
+			float MaxTimeMs;
+			std::uint64_t TotalActorCount;
+			std::uint64_t TotalSize;
+			std::uint64_t TotalCompressedSize;
+			std::uint32_t MaxCompressedSize;
+
+			UpdateStatistics();
+		};
+
+		struct InterpolationStatistics {
+			std::uint32_t UnderrunCount;
+			std::uint32_t StalledFrameCount;
+
+			InterpolationStatistics();
 		};
 
 		struct PlayerPositionInRound {
@@ -270,17 +357,56 @@ namespace Jazz2::Multiplayer
 		//static constexpr float UpdatesPerSecond = 16.0f; // ~62 ms interval
 		static constexpr float UpdatesPerSecond = 30.0f; // ~33 ms interval
 		static constexpr std::int64_t ServerDelay = 64;
+		// Render delay of remote actors adapts to the measured jitter within these limits (in milliseconds)
+		static constexpr float MinRemoteRenderDelayMs = 40.0f;
+		static constexpr float MaxRemoteRenderDelayMs = 250.0f;
+		// Render delay covers this multiple of the jitter on top of the update interval
+		static constexpr float RemoteRenderDelayJitterFactor = 2.5f;
+		// Maximum number of input frames in one update, input frames not acknowledged by the server yet are sent repeatedly
+		static constexpr std::uint32_t MaxInputFramesPerUpdate = 16;
+		// Predicted position of the local player on the ground can differ from the server state at most by this distance (in pixels),
+		// the server merges input frames and uses its own frame time, so it's about one frame of dashing
+		static constexpr float MaxPredictionError = 8.0f;
+		// Only simplified movement can be replayed, so airborne players are reconciled only if the error is bigger than this distance
+		static constexpr float MaxAirbornePredictionError = 48.0f;
 		static constexpr float EndingDuration = 10 * FrameTimer::FramesPerSecond;
+		// Actors are relevant to a peer if they are in its view extended by this margin (in pixels)
+		static constexpr float RelevancyEnterMargin = 128.0f;
+		// Relevant actors stay relevant until they leave the view extended by this (larger) margin
+		static constexpr float RelevancyLeaveMargin = 320.0f;
+		// Positions of remoting actors in UpdateAllActors are quantized to 1/16 px
+		static constexpr float ActorPositionScale = 16.0f;
+		// Number of recent UpdateAllActors packets kept for /netbench
+		static constexpr std::uint32_t MaxSnapshotSamples = 256;
+		// Larger UpdateAllActors packets are not recorded for /netbench
+		static constexpr std::uint32_t MaxSnapshotSampleSize = 16384;
 
 		NetworkManager* _networkManager;
 		float _updateTimeLeft;
 		float _gameTimeLeft;
 		LevelState _levelState;
 		bool _isServer;
-		bool _forceResyncPending;
 		bool _enableSpawning;
 		HashMap<std::uint32_t, std::shared_ptr<Actors::ActorBase>> _remoteActors; // Client: Actor ID -> Remote Actor created by server
 		HashMap<Actors::ActorBase*, RemotingActorInfo> _remotingActors; // Server: Local Actor created by server -> Info
+		SmallVector<ActorSnapshot, 0> _remotingActorStates; // Server: Current states of remoting actors sorted by Actor ID
+		HashMap<Peer, SnapshotHistory> _peerSnapshots; // Server: Peer -> Snapshots sent to the peer
+		SnapshotHistory _receivedSnapshots; // Client: Snapshots received from the server
+		std::int64_t _lastUpdateArrivalTime; // Client: Time when the last UpdateAllActors was received
+		std::uint32_t _lastRoundTripTimeMs; // Client: Round-trip time when the last UpdateAllActors was received
+		float _arrivalJitterMs; // Client: Smoothed jitter of UpdateAllActors inter-arrival times
+		float _roundTripJitterMs; // Client: Smoothed variation of round-trip time
+		float _remoteRenderDelayMs; // Client: Render delay of remote actors adapted to the jitter
+		std::atomic<std::int32_t> _remoteRenderDelay; // Client: Rounded _remoteRenderDelayMs for the main thread
+		std::atomic<std::uint32_t> _lastAppliedUpdate; // Client: ID of the last UpdateAllActors applied to remote actors
+		InterpolationStatistics _interpolationStats; // Client: Underruns of remote actor interpolation
+		UpdateStatistics _updateStats; // Server: Cost of UpdateAllActors since the last reset
+		SnapshotCompressor _snapshotCompressor; // Server/Client: Compression of UpdateAllActors
+		Array<std::uint8_t> _snapshotSampleBuffer; // Server: Ring of recent uncompressed UpdateAllActors, allocated only while recording
+		Array<std::uint32_t> _snapshotSampleSizes; // Server: Size of each sample in _snapshotSampleBuffer
+		std::uint32_t _snapshotSampleCount; // Server: Number of valid samples in _snapshotSampleBuffer
+		std::uint32_t _nextSnapshotSample; // Server: Index of the sample to be overwritten next
+		bool _recordSnapshotSamples; // Server: Whether UpdateAllActors are recorded for /netbench
 		HashMap<std::uint32_t, String> _playerNames; // Client: Actor ID -> Player name
 		SmallVector<PlayerPositionInRound, 0> _positionsInRound; // Client: Actor ID -> Position In Round
 		SmallVector<MultiplayerSpawnPoint, 0> _multiplayerSpawnPoints;
@@ -288,8 +414,11 @@ namespace Jazz2::Multiplayer
 		SmallVector<PendingSfx, 0> _pendingSfx;
 		std::uint32_t _lastSpawnedActorId;	// Server: last assigned actor/player ID, Client: ID assigned by server
 		std::int32_t _waitingForPlayerCount;	// Client: number of players needed to start the game
-		std::uint32_t _lastUpdated; // Server/Client: last update from the server
+		std::uint32_t _lastUpdated; // Server/Client: last update from the server, 0 if no update was sent/received yet
 		std::uint64_t _seqNumWarped; // Client: set to _seqNum from HandlePlayerWarped() when warped
+		std::uint32_t _inputSeqNum; // Client: Sequence number of the last recorded input frame
+		std::uint32_t _lastAckedInputSeqNum; // Client: Sequence number of the last input frame acknowledged by the server
+		InputHistory _inputHistory; // Client: Input frames of the local player by sequence number
 		Threading::Spinlock _lock;
 		bool _suppressRemoting; // Server: if true, actor will not be automatically remoted to other players
 		bool _ignorePackets;
@@ -342,6 +471,15 @@ namespace Jazz2::Multiplayer
 		void SetPlayerReady(PlayerType playerType);
 
 		void EndActivePoll();
+		void SendUpdateStatistics(const Peer& peer);
+		void UpdateRemoteRenderDelay(std::uint32_t updateId, std::uint32_t lastUpdateId);
+		void SendPlayerHardMove(PeerDescriptor* peerDesc);
+		void ReconcileLocalPlayer(Vector2f pos, Vector2f speed, std::uint32_t seqNum, bool hardMove);
+		void ToggleSnapshotRecording(const Peer& peer);
+		void RecordSnapshotSample(ArrayView<const std::uint8_t> data);
+		ArrayView<const std::uint8_t> GetSnapshotSample(std::uint32_t index) const;
+		void SendCompressionBenchmark(const Peer& peer);
+		void TrainSnapshotDictionary(const Peer& peer);
 
 		static bool ActorShouldBeMirrored(Actors::ActorBase* actor);
 		static std::int32_t GetTreasureWeight(std::uint8_t gemType);
@@ -349,6 +487,7 @@ namespace Jazz2::Multiplayer
 		void InitializeValidateAssetsPacket(MemoryStream& packet);
 		void InitializeLoadLevelPacket(MemoryStream& packet);
 		static void InitializeCreateRemoteActorPacket(MemoryStream& packet, std::uint32_t actorId, const Actors::ActorBase* actor);
+		static const ActorSnapshot* FindActorSnapshot(ArrayView<const ActorSnapshot> sortedActors, std::size_t& cursor, std::uint32_t actorId);
 
 #if defined(DEATH_DEBUG) && defined(WITH_IMGUI)
 		static constexpr std::int32_t PlotValueCount = 512;
@@ -23,23 +23,64 @@
 #	include <ifaddrs.h>
 #endif
 
+#if !defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_SWITCH)
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <unistd.h>
+#endif
+
 using namespace Death;
 using namespace Death::Containers::Literals;
 
 namespace Jazz2::Multiplayer
 {
 	static std::atomic_int32_t _initializeCount{0};
+	static Spinlock _packetPoolLock;
+	static SmallVector<Array<std::uint8_t>, 0> _packetPool;
+
+	static enet_uint32 GetPacketFlags(NetworkChannel channel)
+	{
+		return (channel == NetworkChannel::Main ? ENET_PACKET_FLAG_RELIABLE : ENET_PACKET_FLAG_UNSEQUENCED);
+	}
 
 	NetworkManagerBase::NetworkManagerBase()
-		: _host(nullptr), _state(NetworkState::None), _handler(nullptr)
+		: _host(nullptr), _state(NetworkState::None), _handler(nullptr), _wakeupPipe{-1, -1}, _wakeupPending(false),
+			_sendQueueHead(&_sendQueueStub), _sendQueueTail(&_sendQueueStub), _connectionGeneration(0)
 	{
 		InitializeBackend();
+
+#if !defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_SWITCH)
+		// Network thread waits on the socket and this pipe, so outgoing packets can be flushed immediately
+		if (::pipe(_wakeupPipe) == 0) {
+			for (std::int32_t fd : _wakeupPipe) {
+				::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+				::fcntl(fd, F_SETFD, FD_CLOEXEC);
+			}
+		} else {
+			LOGW("[MP] Failed to create wakeup pipe with error {}", errno);
+			_wakeupPipe[0] = -1;
+			_wakeupPipe[1] = -1;
+		}
+#endif
 	}
 
 	NetworkManagerBase::~NetworkManagerBase()
 	{
 		Dispose();
+		ClearOutgoingPackets();
 		ReleaseBackend();
+
+		for (OutgoingPacket* item : _outgoingPacketPool) {
+			delete item;
+		}
+
+#if !defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_SWITCH)
+		for (std::int32_t fd : _wakeupPipe) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+		}
+#endif
 	}
 
 	void NetworkManagerBase::CreateClient(INetworkHandler* handler, StringView endpoints, std::uint16_t defaultPort, std::uint32_t clientData)
@@ -142,6 +183,7 @@ namespace Jazz2::Multiplayer
 		}
 
 		_state = NetworkState::None;
+		SignalWakeup();
 		_thread.Join();
 
 		_host = nullptr;
@@ -287,103 +329,104 @@ namespace Jazz2::Multiplayer
 
 	void NetworkManagerBase::SendTo(const Peer& peer, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
 	{
-		ENetPeer* target;
-		if (peer == nullptr) {
-			if (_state != NetworkState::Connected || _peers.empty()) {
-				return;
-			}
-			target = _peers[0];
-		} else {
-			target = peer._enet;
-		}
-
-		enet_uint32 flags;
-		if (channel == NetworkChannel::Main) {
-			flags = ENET_PACKET_FLAG_RELIABLE;
-		} else {
-			flags = ENET_PACKET_FLAG_UNSEQUENCED;
+		OutgoingPacket* item = CreateOutgoingPacket(peer);
+		if (item == nullptr) {
+			return;
 		}
 
-		ENetPacket* packet = enet_packet_create(packetType, data.data(), data.size(), flags);
+		item->Packet = enet_packet_create(packetType, data.data(), data.size(), GetPacketFlags(channel));
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
+	}
 
-		bool success;
-		{
-			std::unique_lock lock(_lock);
-			success = enet_peer_send(target, std::uint8_t(channel), packet) >= 0;
+	void NetworkManagerBase::SendTo(Function<bool(const Peer&)>&& predicate, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
+	{
+		OutgoingPacket* item = CreateOutgoingPacket(predicate);
+		if (item == nullptr) {
+			return;
 		}
 
-		if (!success) {
-			enet_packet_destroy(packet);
-		}
+		item->Packet = enet_packet_create(packetType, data.data(), data.size(), GetPacketFlags(channel));
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
 	}
 
-	void NetworkManagerBase::SendTo(Function<bool(const Peer&)>&& predicate, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
+	void NetworkManagerBase::SendTo(AllPeersT, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
 	{
 		if (_peers.empty()) {
 			return;
 		}
 
-		enet_uint32 flags;
-		if (channel == NetworkChannel::Main) {
-			flags = ENET_PACKET_FLAG_RELIABLE;
-		} else {
-			flags = ENET_PACKET_FLAG_UNSEQUENCED;
+		OutgoingPacket* item = AcquireOutgoingPacket();
+		item->Packet = enet_packet_create(packetType, data.data(), data.size(), GetPacketFlags(channel));
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
+	}
+
+	void NetworkManagerBase::SendTo(const Peer& peer, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet)
+	{
+		OutgoingPacket* item = CreateOutgoingPacket(peer);
+		if (item == nullptr) {
+			RecyclePacketBuffer(packet.ReleaseBuffer());
+			return;
 		}
 
-		ENetPacket* packet = enet_packet_create(packetType, data.data(), data.size(), flags);
+		item->Packet = CreatePacketFromStream(packetType, packet, channel);
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
+	}
 
-		bool success = false;
-		{
-			std::unique_lock lock(_lock);
-			for (ENetPeer* peer : _peers) {
-				if (predicate(Peer(peer))) {
-					if (enet_peer_send(peer, std::uint8_t(channel), packet) >= 0) {
-						success = true;
-					}
-				}
-			}
+	void NetworkManagerBase::SendTo(Function<bool(const Peer&)>&& predicate, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet)
+	{
+		OutgoingPacket* item = CreateOutgoingPacket(predicate);
+		if (item == nullptr) {
+			RecyclePacketBuffer(packet.ReleaseBuffer());
+			return;
 		}
 
-		if (!success) {
-			enet_packet_destroy(packet);
-		}
+		item->Packet = CreatePacketFromStream(packetType, packet, channel);
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
 	}
 
-	void NetworkManagerBase::SendTo(AllPeersT, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data)
+	void NetworkManagerBase::SendTo(AllPeersT, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet)
 	{
 		if (_peers.empty()) {
+			RecyclePacketBuffer(packet.ReleaseBuffer());
 			return;
 		}
 
-		enet_uint32 flags;
-		if (channel == NetworkChannel::Main) {
-			flags = ENET_PACKET_FLAG_RELIABLE;
-		} else {
-			flags = ENET_PACKET_FLAG_UNSEQUENCED;
-		}
-
-		ENetPacket* packet = enet_packet_create(packetType, data.data(), data.size(), flags);
+		OutgoingPacket* item = AcquireOutgoingPacket();
+		item->Packet = CreatePacketFromStream(packetType, packet, channel);
+		item->Channel = std::uint8_t(channel);
+		EnqueueOutgoingPacket(item);
+	}
 
-		bool success = false;
+	MemoryStream NetworkManagerBase::CreatePacket(std::int64_t initialCapacity)
+	{
+		Array<std::uint8_t> buffer;
 		{
-			std::unique_lock lock(_lock);
-			for (ENetPeer* peer : _peers) {
-				if (enet_peer_send(peer, std::uint8_t(channel), packet) >= 0) {
-					success = true;
-				}
+			std::unique_lock lock(_packetPoolLock);
+			if (!_packetPool.empty()) {
+				buffer = std::move(_packetPool.back());
+				_packetPool.pop_back();
 			}
 		}
 
-		if (!success) {
-			enet_packet_destroy(packet);
-		}
+		// The first byte is reserved for the packet type, it's filled in SendTo()
+		arrayReserve(buffer, 1 + initialCapacity);
+		arrayResize(buffer, NoInit, 1);
+		return MemoryStream(std::move(buffer));
 	}
 
 	void NetworkManagerBase::Kick(const Peer& peer, Reason reason)
 	{
 		if (peer != nullptr) {
-			std::unique_lock lock(_lock);
-			enet_peer_disconnect(peer._enet, std::uint32_t(reason));
+			OutgoingPacket* item = AcquireOutgoingPacket();
+			item->Targets.push_back(peer._enet);
+			item->Data = std::uint32_t(reason);
+			item->Disconnect = true;
+			EnqueueOutgoingPacket(item);
 		}
 	}
 
@@ -591,6 +634,277 @@ namespace Jazz2::Multiplayer
 		}
 	}
 
+	NetworkManagerBase::OutgoingPacket* NetworkManagerBase::CreateOutgoingPacket(const Peer& peer)
+	{
+		if (peer == nullptr) {
+			// Client sends to its server, the server peer is resolved by the network thread
+			if (_state != NetworkState::Connected) {
+				return nullptr;
+			}
+			return AcquireOutgoingPacket();
+		}
+
+		OutgoingPacket* item = AcquireOutgoingPacket();
+		item->Targets.push_back(peer._enet);
+		return item;
+	}
+
+	NetworkManagerBase::OutgoingPacket* NetworkManagerBase::CreateOutgoingPacket(Function<bool(const Peer&)>& predicate)
+	{
+		if (_peers.empty()) {
+			return nullptr;
+		}
+
+		OutgoingPacket* item = AcquireOutgoingPacket();
+		{
+			// The lock is held only by the network thread while the list of peers is being changed
+			std::unique_lock lock(_lock);
+			for (ENetPeer* peer : _peers) {
+				if (predicate(Peer(peer))) {
+					item->Targets.push_back(peer);
+				}
+			}
+		}
+
+		if (item->Targets.empty()) {
+			ReleaseOutgoingPacket(item);
+			return nullptr;
+		}
+		return item;
+	}
+
+	NetworkManagerBase::OutgoingPacket* NetworkManagerBase::AcquireOutgoingPacket()
+	{
+		OutgoingPacket* item = nullptr;
+		{
+			std::unique_lock lock(_outgoingPacketPoolLock);
+			if (!_outgoingPacketPool.empty()) {
+				item = _outgoingPacketPool.back();
+				_outgoingPacketPool.pop_back();
+			}
+		}
+		if (item == nullptr) {
+			item = new OutgoingPacket();
+		}
+
+		// Peers connected after this point can't be targets of the packet, their slot could be reused
+		item->Generation = _connectionGeneration.load(std::memory_order_acquire);
+		return item;
+	}
+
+	void NetworkManagerBase::ReleaseOutgoingPacket(OutgoingPacket* item)
+	{
+		// Targets keep their capacity, so the item can be reused without allocation
+		item->Packet = nullptr;
+		item->Targets.clear();
+		item->Data = 0;
+		item->Channel = 0;
+		item->Disconnect = false;
+
+		{
+			std::unique_lock lock(_outgoingPacketPoolLock);
+			if (_outgoingPacketPool.size() < MaxPooledOutgoingPacketCount) {
+				_outgoingPacketPool.push_back(item);
+				return;
+			}
+		}
+		delete item;
+	}
+
+	void NetworkManagerBase::AssignConnectionGeneration(ENetPeer* peer)
+	{
+		// Can be called only from the network thread before the peer is announced
+		std::uint32_t generation = _connectionGeneration.load(std::memory_order_relaxed) + 1;
+		peer->data = reinterpret_cast<void*>(std::uintptr_t(generation));
+		_connectionGeneration.store(generation, std::memory_order_release);
+	}
+
+	bool NetworkManagerBase::IsValidTarget(ENetPeer* peer, std::uint32_t generation, bool allowNotConnected) const
+	{
+		// Can be called only from the network thread, the handle could outlive the host, so it's checked before dereferencing
+		if (_host == nullptr || peer < _host->peers || peer >= _host->peers + _host->peerCount) {
+			return false;
+		}
+		// The slot could be reused by another connection after the packet was enqueued
+		if (std::uint32_t(std::uintptr_t(peer->data)) > generation) {
+			return false;
+		}
+		return (allowNotConnected ? peer->state != ENET_PEER_STATE_DISCONNECTED : peer->state == ENET_PEER_STATE_CONNECTED);
+	}
+
+	ENetPacket* NetworkManagerBase::CreatePacketFromStream(std::uint8_t packetType, MemoryStream& packet, NetworkChannel channel)
+	{
+		Array<std::uint8_t> buffer = packet.ReleaseBuffer();
+		DEATH_ASSERT(!buffer.empty() && arrayIsGrowable(buffer), "Packet must be created by CreatePacket()", nullptr);
+
+		// ENet takes ownership of the buffer without copying, it's returned to the pool when the packet is destroyed
+		buffer[0] = packetType;
+		ENetPacket* result = enet_packet_create_raw(buffer.data(), buffer.size(), GetPacketFlags(channel) | ENET_PACKET_FLAG_NO_ALLOCATE);
+		if (result == nullptr) {
+			return nullptr;
+		}
+		result->freeCallback = OnPooledPacketDestroyed;
+		buffer.release();
+		return result;
+	}
+
+	void NetworkManagerBase::RecyclePacketBuffer(Array<std::uint8_t>&& buffer)
+	{
+		if (!arrayIsGrowable(buffer) || arrayCapacity(buffer) > MaxPooledPacketCapacity) {
+			return;
+		}
+
+		arrayClear(buffer);
+
+		std::unique_lock lock(_packetPoolLock);
+		if (_packetPool.size() < MaxPooledPacketCount) {
+			_packetPool.push_back(std::move(buffer));
+		}
+	}
+
+	void ENET_CALLBACK NetworkManagerBase::OnPooledPacketDestroyed(void* packet)
+	{
+		ENetPacket* p = static_cast<ENetPacket*>(packet);
+		RecyclePacketBuffer(Array<std::uint8_t>(p->data, p->dataLength, ArrayAllocator<std::uint8_t>::deleter));
+		p->data = nullptr;
+	}
+
+	NetworkManagerBase::OutgoingPacket::OutgoingPacket()
+		: Next(nullptr), Packet(nullptr), Data(0), Channel(0), Disconnect(false)
+	{
+	}
+
+	void NetworkManagerBase::EnqueueOutgoingPacket(OutgoingPacket* item)
+	{
+		item->Next.store(nullptr, std::memory_order_relaxed);
+		OutgoingPacket* prev = _sendQueueHead.exchange(item, std::memory_order_acq_rel);
+		prev->Next.store(item, std::memory_order_release);
+
+		SignalWakeup();
+	}
+
+	NetworkManagerBase::OutgoingPacket* NetworkManagerBase::DequeueOutgoingPacket()
+	{
+		// Can be called only from the network thread (single consumer)
+		OutgoingPacket* tail = _sendQueueTail;
+		OutgoingPacket* next = tail->Next.load(std::memory_order_acquire);
+		if (tail == &_sendQueueStub) {
+			if (next == nullptr) {
+				return nullptr;
+			}
+			_sendQueueTail = next;
+			tail = next;
+			next = next->Next.load(std::memory_order_acquire);
+		}
+
+		if (next != nullptr) {
+			_sendQueueTail = next;
+			return tail;
+		}
+
+		if (tail != _sendQueueHead.load(std::memory_order_acquire)) {
+			// Producer is in the middle of enqueueing, the item will be processed after the next wakeup
+			return nullptr;
+		}
+
+		// Re-insert the stub item, so the last item can be detached from the queue
+		_sendQueueStub.Next.store(nullptr, std::memory_order_relaxed);
+		OutgoingPacket* prev = _sendQueueHead.exchange(&_sendQueueStub, std::memory_order_acq_rel);
+		prev->Next.store(&_sendQueueStub, std::memory_order_release);
+
+		next = tail->Next.load(std::memory_order_acquire);
+		if (next != nullptr) {
+			_sendQueueTail = next;
+			return tail;
+		}
+		return nullptr;
+	}
+
+	void NetworkManagerBase::ProcessOutgoingPackets()
+	{
+		while (OutgoingPacket* item = DequeueOutgoingPacket()) {
+			if (item->Disconnect) {
+				for (ENetPeer* peer : item->Targets) {
+					if (IsValidTarget(peer, item->Generation, true)) {
+						enet_peer_disconnect(peer, item->Data);
+					}
+				}
+			} else if (item->Packet != nullptr) {
+				bool success = false;
+				if (item->Targets.empty()) {
+					for (ENetPeer* peer : _peers) {
+						if (IsValidTarget(peer, item->Generation, false) && enet_peer_send(peer, item->Channel, item->Packet) >= 0) {
+							success = true;
+						}
+					}
+				} else {
+					for (ENetPeer* peer : item->Targets) {
+						// Peer could disconnect (and its slot could be reused) while the packet was in the queue
+						if (IsValidTarget(peer, item->Generation, false) && enet_peer_send(peer, item->Channel, item->Packet) >= 0) {
+							success = true;
+						}
+					}
+				}
+				if (!success) {
+					enet_packet_destroy(item->Packet);
+				}
+			}
+			ReleaseOutgoingPacket(item);
+		}
+	}
+
+	void NetworkManagerBase::ClearOutgoingPackets()
+	{
+		while (OutgoingPacket* item = DequeueOutgoingPacket()) {
+			if (item->Packet != nullptr) {
+				enet_packet_destroy(item->Packet);
+			}
+			ReleaseOutgoingPacket(item);
+		}
+	}
+
+	void NetworkManagerBase::WaitForEvents(_ENetHost* host, std::uint32_t timeoutMs)
+	{
+#if !defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_SWITCH)
+		if DEATH_LIKELY(_wakeupPipe[0] >= 0) {
+			struct pollfd fds[2];
+			fds[0].fd = host->socket;
+			fds[0].events = POLLIN;
+			fds[0].revents = 0;
+			fds[1].fd = _wakeupPipe[0];
+			fds[1].events = POLLIN;
+			fds[1].revents = 0;
+
+			std::int32_t result = ::poll(fds, 2, std::int32_t(timeoutMs));
+			if (result > 0 && (fds[1].revents & POLLIN) != 0) {
+				std::uint8_t buffer[64];
+				while (::read(_wakeupPipe[0], buffer, sizeof(buffer)) > 0) {
+					// Drain all pending signals
+				}
+				// The flag must be cleared only after the pipe is drained, otherwise a signal written in between would be
+				// drained too and the flag would stay set with empty pipe, so no other signal would be ever written.
+				// Packets enqueued before this point are processed right after returning, so no wakeup is lost.
+				_wakeupPending.store(false);
+			}
+			return;
+		}
+#endif
+		// Wakeup pipe is not supported, wait only for incoming packets and flush outgoing packets periodically
+		enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+		enet_socket_wait(host->socket, &condition, std::min(timeoutMs, ProcessingIntervalMs));
+	}
+
+	void NetworkManagerBase::SignalWakeup()
+	{
+#if !defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_SWITCH)
+		// Only the first signal is written to the pipe until the network thread wakes up
+		if (_wakeupPipe[1] >= 0 && !_wakeupPending.exchange(true)) {
+			std::uint8_t value = 1;
+			(void)::write(_wakeupPipe[1], &value, sizeof(value));
+		}
+#endif
+	}
+
 	void NetworkManagerBase::InitializeBackend()
 	{
 		if (++_initializeCount == 1) {
@@ -615,6 +929,7 @@ namespace Jazz2::Multiplayer
 
 		ENetHost* host = nullptr;
 		_this->_host = host;
+		_this->ClearOutgoingPackets();
 
 		// Try to connect to each specified endpoint
 		ENetEvent ev{};
@@ -655,6 +970,7 @@ namespace Jazz2::Multiplayer
 			}
 
 			if (n != 0) {
+				_this->AssignConnectionGeneration(ev.peer);
 				_this->_peers.push_back(ev.peer);
 				break;
 			}
@@ -671,11 +987,9 @@ namespace Jazz2::Multiplayer
 			reason = Reason::Unknown;
 
 			while DEATH_LIKELY(_this->_state != NetworkState::None) {
-				std::int32_t result;
-				{
-					std::unique_lock lock(_this->_lock);
-					result = enet_host_service(host, &ev, 0);
-				}
+				// All queued packets are sent at once by the following enet_host_service() call
+				_this->ProcessOutgoingPackets();
+				std::int32_t result = enet_host_service(host, &ev, 0);
 
 				if DEATH_UNLIKELY(result <= 0) {
 					if DEATH_UNLIKELY(result < 0) {
@@ -683,7 +997,7 @@ namespace Jazz2::Multiplayer
 						reason = Reason::ConnectionLost;
 						break;
 					}
-					Thread::Sleep(ProcessingIntervalMs);
+					_this->WaitForEvents(host, MaxWaitIntervalMs);
 					continue;
 				}
 
@@ -717,6 +1031,7 @@ namespace Jazz2::Multiplayer
 			_this->OnPeerDisconnected({}, reason);
 		}
 
+		_this->ClearOutgoingPackets();
 		enet_host_destroy(_this->_host);
 		_this->_host = nullptr;
 		_this->_handler = nullptr;
@@ -735,14 +1050,13 @@ namespace Jazz2::Multiplayer
 		ENetHost* host = _this->_host;
 
 		_this->_peers.reserve(16);
+		_this->ClearOutgoingPackets();
 
 		ENetEvent ev{};
 		while DEATH_LIKELY(_this->_state != NetworkState::None) {
-			std::int32_t result;
-			{
-				std::unique_lock lock(_this->_lock);
-				result = enet_host_service(host, &ev, 0);
-			}
+			// All queued packets are sent at once by the following enet_host_service() call
+			_this->ProcessOutgoingPackets();
+			std::int32_t result = enet_host_service(host, &ev, 0);
 
 			if DEATH_UNLIKELY(result <= 0) {
 				if DEATH_UNLIKELY(result < 0) {
@@ -761,18 +1075,21 @@ namespace Jazz2::Multiplayer
 						host = enet_host_create(&addr, MaxPeerCount, std::size_t(NetworkChannel::Count), 0, 0);
 						_this->_host = host;
 					}
+					_this->ClearOutgoingPackets();
 
 					if (host == nullptr) {
 						LOGE("[MP] Failed to recreate the server");
 						break;
 					}
 				}
-				Thread::Sleep(ProcessingIntervalMs);
+				// Idle server without any peers can sleep until a new connection request arrives
+				_this->WaitForEvents(host, _this->_peers.empty() ? MaxIdleWaitIntervalMs : MaxWaitIntervalMs);
 				continue;
 			}
 
 			switch (ev.type) {
 				case ENET_EVENT_TYPE_CONNECT: {
+					_this->AssignConnectionGeneration(ev.peer);
 					ConnectionResult result = _this->OnPeerConnected(ev.peer, ev.data);
 					if DEATH_LIKELY(result.IsSuccessful()) {
 						std::unique_lock lock(_this->_lock);
@@ -789,7 +1106,6 @@ namespace Jazz2::Multiplayer
 							_this->_peers.push_back(ev.peer);
 						}
 					} else {
-						std::unique_lock lock(_this->_lock);
 						enet_peer_disconnect(ev.peer, std::uint32_t(result.FailureReason));
 					}
 					break;
@@ -814,6 +1130,7 @@ namespace Jazz2::Multiplayer
 		}
 		_this->_peers.clear();
 
+		_this->ClearOutgoingPackets();
 		enet_host_destroy(_this->_host);
 		_this->_host = nullptr;
 		_this->_handler = nullptr;
@@ -16,6 +16,8 @@
 #include <IO/MemoryStream.h>
 #include <Threading/Spinlock.h>
 
+#include <atomic>
+
 struct _ENetHost;
 
 using namespace Death::Containers;
@@ -121,9 +123,23 @@ namespace Jazz2::Multiplayer
 		void SendTo(Function<bool(const Peer&)>&& predicate, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data);
 		/** @brief Sends a packet to all connected peers or the remote server peer */
 		void SendTo(AllPeersT, NetworkChannel channel, std::uint8_t packetType, ArrayView<const std::uint8_t> data);
+		/** @brief Sends a packet created by @ref CreatePacket() to a given peer without copying */
+		void SendTo(const Peer& peer, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet);
+		/** @brief Sends a packet created by @ref CreatePacket() to all connected peers that match a given predicate without copying */
+		void SendTo(Function<bool(const Peer&)>&& predicate, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet);
+		/** @brief Sends a packet created by @ref CreatePacket() to all connected peers or the remote server peer without copying */
+		void SendTo(AllPeersT, NetworkChannel channel, std::uint8_t packetType, MemoryStream&& packet);
 		/** @brief Kicks a given peer from the server */
 		void Kick(const Peer& peer, Reason reason);
 
+		/**
+		 * @brief Creates a growable packet backed by a pooled buffer
+		 *
+		 * The first byte is reserved for the packet type. The packet must be sent using one of the @ref SendTo()
+		 * overloads that take ownership of the packet, the buffer is then returned to the pool once it's sent.
+		 */
+		static MemoryStream CreatePacket(std::int64_t initialCapacity);
+
 		/** @brief Converts the specified IPv4 endpoint to the string representation */
 		static String AddressToString(const struct in_addr& address, std::uint16_t port = 0);
 #if ENET_IPV6
@@ -150,7 +166,30 @@ namespace Jazz2::Multiplayer
 		virtual void OnPeerDisconnected(const Peer& peer, Reason reason);
 
 	private:
+#ifndef DOXYGEN_GENERATING_OUTPUT
+		// Outgoing packet or disconnect request queued by SendTo()/Kick() and processed by the network thread
+		struct OutgoingPacket {
+			std::atomic<OutgoingPacket*> Next;
+			_ENetPacket* Packet;
+			// Target peers or empty to send to all connected peers, they are validated by the network thread before use
+			SmallVector<_ENetPeer*, 1> Targets;
+			// Reason of disconnection if the targets should be disconnected instead
+			std::uint32_t Data;
+			// Connection generation at the time of enqueueing, peers connected later are not valid targets
+			std::uint32_t Generation;
+			std::uint8_t Channel;
+			bool Disconnect;
+
+			OutgoingPacket();
+		};
+#endif
+
 		static constexpr std::uint32_t ProcessingIntervalMs = 4;
+		static constexpr std::uint32_t MaxWaitIntervalMs = 20;
+		static constexpr std::uint32_t MaxIdleWaitIntervalMs = 1000;
+		static constexpr std::size_t MaxPooledPacketCount = 256;
+		static constexpr std::size_t MaxPooledPacketCapacity = 16384;
+		static constexpr std::size_t MaxPooledOutgoingPacketCount = 256;
 
 		_ENetHost* _host;
 		Thread _thread;
@@ -160,6 +199,35 @@ namespace Jazz2::Multiplayer
 		INetworkHandler* _handler;
 		SmallVector<ENetAddress, 0> _desiredEndpoints;
 		Spinlock _lock;
+		std::int32_t _wakeupPipe[2];
+		std::atomic_bool _wakeupPending;
+		// Lock-free multiple-producer single-consumer queue of outgoing packets
+		std::atomic<OutgoingPacket*> _sendQueueHead;
+		OutgoingPacket* _sendQueueTail;
+		OutgoingPacket _sendQueueStub;
+		// Recycled queue items, so no allocation is needed per packet
+		SmallVector<OutgoingPacket*, 0> _outgoingPacketPool;
+		Spinlock _outgoingPacketPoolLock;
+		// Incremented by the network thread for each new connection, the value is also stored in ENetPeer::data
+		std::atomic<std::uint32_t> _connectionGeneration;
+
+		void EnqueueOutgoingPacket(OutgoingPacket* item);
+		OutgoingPacket* DequeueOutgoingPacket();
+		void ProcessOutgoingPackets();
+		void ClearOutgoingPackets();
+		OutgoingPacket* AcquireOutgoingPacket();
+		void ReleaseOutgoingPacket(OutgoingPacket* item);
+		OutgoingPacket* CreateOutgoingPacket(const Peer& peer);
+		OutgoingPacket* CreateOutgoingPacket(Function<bool(const Peer&)>& predicate);
+		void AssignConnectionGeneration(_ENetPeer* peer);
+		bool IsValidTarget(_ENetPeer* peer, std::uint32_t generation, bool allowNotConnected) const;
+
+		static _ENetPacket* CreatePacketFromStream(std::uint8_t packetType, MemoryStream& packet, NetworkChannel channel);
+		static void RecyclePacketBuffer(Array<std::uint8_t>&& buffer);
+		static void ENET_CALLBACK OnPooledPacketDestroyed(void* packet);
+
+		void WaitForEvents(_ENetHost* host, std::uint32_t timeoutMs);
+		void SignalWakeup();
 
 		static void InitializeBackend();
 		static void ReleaseBackend();
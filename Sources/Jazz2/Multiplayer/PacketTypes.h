@@ -31,7 +31,7 @@ namespace Jazz2::Multiplayer
 
 		PlayerReady = 30,
 		PlayerUpdate,
-		PlayerKeyPress,
+		PlayerKeyPress,				// Unused, input frames are part of PlayerUpdate
 		PlayerChangeWeaponRequest,
 		PlayerSpectate,				// TODO
 		PlayerAckWarped
@@ -84,7 +84,18 @@ namespace Jazz2::Multiplayer
 		PlayerChangeWeapon,
 		PlayerTakeDamage,
 		PlayerActivateSpring,
-		PlayerWarpIn
+		PlayerWarpIn,
+		PlayerAckInput
+	};
+
+	/** @brief Compression method of @ref ServerPacketType::UpdateAllActors */
+	enum class SnapshotCompression : std::uint8_t
+	{
+		Deflate,
+		Lz4,
+		Zstd,
+
+		Count
 	};
 
 	/** @brief Peer property type from @ref ServerPacketType::PeerSetProperty */
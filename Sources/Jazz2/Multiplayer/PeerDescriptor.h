@@ -2,10 +2,12 @@
 
 #if defined(WITH_MULTIPLAYER) || defined(DOXYGEN_GENERATING_OUTPUT)
 
+#include "PacketTypes.h"
 #include "Peer.h"
 #include "../PlayerType.h"
 #include "../PreferencesCache.h"
 #include "../../nCine/Base/TimeStamp.h"
+#include "../../nCine/Primitives/Vector2.h"
 
 #include <Containers/String.h>
 
@@ -66,6 +68,16 @@ namespace Jazz2::Multiplayer
 		Actors::Multiplayer::MpPlayer* Player;
 		/** @brief Last update of the player from client */
 		std::uint64_t LastUpdated;
+		/** @brief Size of the viewport reported by the peer, used to determine relevant actors */
+		Vector2i ViewSize;
+		/** @brief Last update of actors acknowledged by the peer, 0 if none */
+		std::uint32_t LastAckedUpdate;
+		/** @brief Sequence number of the last input frame of the player applied by the server */
+		std::uint32_t LastInputSeqNum;
+		/** @brief Compression method of actor updates negotiated with the peer */
+		SnapshotCompression UpdateCompression;
+		/** @brief Whether the peer has the same shared dictionary for compression of actor updates */
+		bool UseUpdateDictionary;
 
 		/** @brief Deaths of the player in the current round */
 		std::uint32_t Deaths;
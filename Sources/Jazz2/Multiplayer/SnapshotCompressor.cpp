@@ -0,0 +1,349 @@
+﻿#include "SnapshotCompressor.h"
+
+#if defined(WITH_MULTIPLAYER)
+
+#include <Cryptography/xxHash.h>
+#include <IO/FileSystem.h>
+#include <IO/Compression/DeflateStream.h>
+
+#if defined(WITH_ZSTD)
+#	if !defined(CMAKE_BUILD) && defined(__has_include)
+#		if __has_include("zstd/zstd.h")
+#			define __HAS_LOCAL_ZSTD
+#		endif
+#	endif
+#	ifdef __HAS_LOCAL_ZSTD
+#		include "zstd/zstd.h"
+#		include "zstd/zdict.h"
+#	else
+#		include <zstd.h>
+#		include <zdict.h>
+#	endif
+#endif
+
+#if defined(WITH_LZ4)
+#	if !defined(CMAKE_BUILD) && defined(__has_include)
+#		if __has_include("lz4/lz4.h")
+#			define __HAS_LOCAL_LZ4
+#		endif
+#	endif
+#	ifdef __HAS_LOCAL_LZ4
+#		include "lz4/lz4.h"
+#	else
+#		include <lz4.h>
+#	endif
+#endif
+
+#include <cstring>
+
+using namespace Death::Containers::Literals;
+using namespace Death::IO::Compression;
+
+namespace Jazz2::Multiplayer
+{
+	// Snapshots must be compressed quickly, the ratio is improved mainly by the dictionary
+	static constexpr std::int32_t DeflateCompressionLevel = 6;
+	static constexpr std::int32_t ZstdCompressionLevel = 3;
+	// Decompressed snapshots larger than this are considered malformed
+	static constexpr std::int64_t MaxSnapshotSize = 1024 * 1024;
+
+	SnapshotCompressor::SnapshotCompressor()
+		: _dictionaryId(0)
+	{
+#if defined(WITH_ZSTD)
+		_zstdCompressCtx = ZSTD_createCCtx();
+		_zstdDecompressCtx = ZSTD_createDCtx();
+		_zstdCompressDict = nullptr;
+		_zstdDecompressDict = nullptr;
+#endif
+#if defined(WITH_LZ4)
+		_lz4Stream = LZ4_createStream();
+		_lz4DictionaryStream = nullptr;
+#endif
+	}
+
+	SnapshotCompressor::~SnapshotCompressor()
+	{
+		ReleaseDictionary();
+
+#if defined(WITH_ZSTD)
+		ZSTD_freeCCtx(_zstdCompressCtx);
+		ZSTD_freeDCtx(_zstdDecompressCtx);
+#endif
+#if defined(WITH_LZ4)
+		LZ4_freeStream(_lz4Stream);
+#endif
+	}
+
+	std::uint32_t SnapshotCompressor::GetSupportedMethods()
+	{
+		std::uint32_t methods = (1u << std::uint32_t(SnapshotCompression::Deflate));
+#if defined(WITH_LZ4)
+		methods |= (1u << std::uint32_t(SnapshotCompression::Lz4));
+#endif
+#if defined(WITH_ZSTD)
+		methods |= (1u << std::uint32_t(SnapshotCompression::Zstd));
+#endif
+		return methods;
+	}
+
+	SnapshotCompression SnapshotCompressor::SelectMethod(std::uint32_t remoteMethods)
+	{
+		std::uint32_t methods = GetSupportedMethods() & remoteMethods;
+		// LZ4 is preferred, because it's the fastest and the ratio is similar with the dictionary on such small packets
+		if (methods & (1u << std::uint32_t(SnapshotCompression::Lz4))) {
+			return SnapshotCompression::Lz4;
+		}
+		if (methods & (1u << std::uint32_t(SnapshotCompression::Zstd))) {
+			return SnapshotCompression::Zstd;
+		}
+		return SnapshotCompression::Deflate;
+	}
+
+	StringView SnapshotCompressor::GetMethodName(SnapshotCompression method)
+	{
+		switch (method) {
+			case SnapshotCompression::Deflate: return "Deflate"_s;
+			case SnapshotCompression::Lz4: return "LZ4"_s;
+			case SnapshotCompression::Zstd: return "Zstd"_s;
+			default: return "Unknown"_s;
+		}
+	}
+
+	bool SnapshotCompressor::LoadDictionary(StringView path)
+	{
+		auto s = fs::Open(path, FileAccess::Read);
+		if (!s->IsValid()) {
+			return false;
+		}
+
+		std::int64_t size = s->GetSize();
+		if (size <= 0 || size > std::int64_t(MaxDictionarySize)) {
+			LOGW("Dictionary \"{}\" has invalid size", path);
+			return false;
+		}
+
+		Array<std::uint8_t> dictionary(NoInit, std::size_t(size));
+		if (s->Read(dictionary.data(), size) != size) {
+			return false;
+		}
+
+		ReleaseDictionary();
+
+		_dictionary = std::move(dictionary);
+		// ID 0 is reserved for no dictionary
+		_dictionaryId = std::uint32_t(Death::Cryptography::xxHash3(_dictionary.data(), _dictionary.size())) | 1u;
+
+#if defined(WITH_ZSTD)
+		_zstdCompressDict = ZSTD_createCDict(_dictionary.data(), _dictionary.size(), ZstdCompressionLevel);
+		_zstdDecompressDict = ZSTD_createDDict(_dictionary.data(), _dictionary.size());
+#endif
+#if defined(WITH_LZ4)
+		// The dictionary is hashed only once, the prepared stream is then copied before each compression
+		_lz4DictionaryStream = LZ4_createStream();
+		LZ4_loadDict(_lz4DictionaryStream, reinterpret_cast<const char*>(_dictionary.data()), std::int32_t(_dictionary.size()));
+#endif
+		return true;
+	}
+
+	bool SnapshotCompressor::Compress(SnapshotCompression method, bool useDictionary, ArrayView<const std::uint8_t> data, MemoryStream& target)
+	{
+		switch (method) {
+#if defined(WITH_LZ4)
+			case SnapshotCompression::Lz4: {
+				bool withDictionary = (useDictionary && _dictionaryId != 0);
+				target.WriteValue<std::uint8_t>(std::uint8_t(method) | (withDictionary ? DictionaryFlag : 0));
+				target.WriteVariableUint32(std::uint32_t(data.size()));
+
+				std::int64_t offset = target.GetPosition();
+				std::int32_t bound = LZ4_compressBound(std::int32_t(data.size()));
+				target.SetSize(offset + bound);
+
+				if (withDictionary) {
+					std::memcpy(_lz4Stream, _lz4DictionaryStream, sizeof(LZ4_stream_t));
+				} else {
+					LZ4_resetStream_fast(_lz4Stream);
+				}
+				std::int32_t compressedSize = LZ4_compress_fast_continue(_lz4Stream, reinterpret_cast<const char*>(data.data()),
+					reinterpret_cast<char*>(target.GetBuffer() + offset), std::int32_t(data.size()), bound, 1);
+				if (compressedSize <= 0) {
+					return false;
+				}
+
+				target.SetSize(offset + compressedSize);
+				target.Seek(0, SeekOrigin::End);
+				return true;
+			}
+#endif
+#if defined(WITH_ZSTD)
+			case SnapshotCompression::Zstd: {
+				bool withDictionary = (useDictionary && _dictionaryId != 0);
+				target.WriteValue<std::uint8_t>(std::uint8_t(method) | (withDictionary ? DictionaryFlag : 0));
+
+				std::int64_t offset = target.GetPosition();
+				std::size_t bound = ZSTD_compressBound(data.size());
+				target.SetSize(offset + bound);
+
+				std::size_t compressedSize = (withDictionary
+					? ZSTD_compress_usingCDict(_zstdCompressCtx, target.GetBuffer() + offset, bound, data.data(), data.size(), _zstdCompressDict)
+					: ZSTD_compressCCtx(_zstdCompressCtx, target.GetBuffer() + offset, bound, data.data(), data.size(), ZstdCompressionLevel));
+				if (ZSTD_isError(compressedSize)) {
+					return false;
+				}
+
+				target.SetSize(offset + compressedSize);
+				target.Seek(0, SeekOrigin::End);
+				return true;
+			}
+#endif
+			default: {
+				// Deflate doesn't support the shared dictionary
+				static_cast<void>(useDictionary);
+				target.WriteValue<std::uint8_t>(std::uint8_t(SnapshotCompression::Deflate));
+
+				DeflateWriter dw(target, DeflateCompressionLevel);
+				dw.Write(data.data(), std::int64_t(data.size()));
+				return true;
+			}
+		}
+	}
+
+	bool SnapshotCompressor::Decompress(ArrayView<const std::uint8_t> data, MemoryStream& target)
+	{
+		if (data.empty()) {
+			return false;
+		}
+
+		SnapshotCompression method = SnapshotCompression(data[0] & ~DictionaryFlag);
+		bool useDictionary = (data[0] & DictionaryFlag) != 0;
+		if (useDictionary && _dictionaryId == 0) {
+			return false;
+		}
+
+		switch (method) {
+			case SnapshotCompression::Deflate: {
+				MemoryStream compressed(data.exceptPrefix(1));
+				DeflateStream ds(compressed);
+				std::uint8_t buffer[4096];
+				while (true) {
+					std::int64_t bytesRead = ds.Read(buffer, sizeof(buffer));
+					if (bytesRead <= 0) {
+						break;
+					}
+					target.Write(buffer, bytesRead);
+				}
+				return ds.IsValid();
+			}
+#if defined(WITH_LZ4)
+			case SnapshotCompression::Lz4: {
+				MemoryStream compressed(data.exceptPrefix(1));
+				std::int32_t size = std::int32_t(compressed.ReadVariableUint32());
+				std::int64_t headerSize = compressed.GetPosition();
+				if (size <= 0 || size > MaxSnapshotSize) {
+					return false;
+				}
+
+				std::int64_t offset = target.GetPosition();
+				target.SetSize(offset + size);
+
+				std::int32_t decompressedSize = (useDictionary
+					? LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(data.data() + 1 + headerSize), reinterpret_cast<char*>(target.GetBuffer() + offset),
+						std::int32_t(data.size() - 1 - headerSize), size, reinterpret_cast<const char*>(_dictionary.data()), std::int32_t(_dictionary.size()))
+					: LZ4_decompress_safe(reinterpret_cast<const char*>(data.data() + 1 + headerSize), reinterpret_cast<char*>(target.GetBuffer() + offset),
+						std::int32_t(data.size() - 1 - headerSize), size));
+				if (decompressedSize != size) {
+					return false;
+				}
+
+				target.Seek(0, SeekOrigin::End);
+				return true;
+			}
+#endif
+#if defined(WITH_ZSTD)
+			case SnapshotCompression::Zstd: {
+				auto compressed = data.exceptPrefix(1);
+				unsigned long long size = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+				if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > (unsigned long long)MaxSnapshotSize) {
+					return false;
+				}
+
+				std::int64_t offset = target.GetPosition();
+				target.SetSize(offset + std::int64_t(size));
+
+				std::size_t decompressedSize = (useDictionary
+					? ZSTD_decompress_usingDDict(_zstdDecompressCtx, target.GetBuffer() + offset, std::size_t(size), compressed.data(), compressed.size(), _zstdDecompressDict)
+					: ZSTD_decompressDCtx(_zstdDecompressCtx, target.GetBuffer() + offset, std::size_t(size), compressed.data(), compressed.size()));
+				if (ZSTD_isError(decompressedSize) || decompressedSize != size) {
+					return false;
+				}
+
+				target.Seek(0, SeekOrigin::End);
+				return true;
+			}
+#endif
+			default: {
+				// Compression method not supported by this build
+				return false;
+			}
+		}
+	}
+
+	Array<std::uint8_t> SnapshotCompressor::TrainDictionary(ArrayView<const ArrayView<const std::uint8_t>> samples, std::size_t dictionarySize)
+	{
+#if defined(WITH_ZSTD)
+		std::size_t totalSize = 0;
+		for (const auto& sample : samples) {
+			totalSize += sample.size();
+		}
+
+		Array<std::uint8_t> samplesBuffer(NoInit, totalSize);
+		Array<std::size_t> sampleSizes(NoInit, samples.size());
+		std::size_t offset = 0;
+		for (std::size_t i = 0; i < samples.size(); i++) {
+			std::memcpy(samplesBuffer.data() + offset, samples[i].data(), samples[i].size());
+			sampleSizes[i] = samples[i].size();
+			offset += samples[i].size();
+		}
+
+		Array<std::uint8_t> dictionary(NoInit, std::min(dictionarySize, MaxDictionarySize));
+		std::size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samplesBuffer.data(), sampleSizes.data(), std::uint32_t(samples.size()));
+		if (ZDICT_isError(size)) {
+			LOGW("Failed to train dictionary: {}", ZDICT_getErrorName(size));
+			return {};
+		}
+
+		Array<std::uint8_t> result(NoInit, size);
+		std::memcpy(result.data(), dictionary.data(), size);
+		return result;
+#else
+		static_cast<void>(samples);
+		static_cast<void>(dictionarySize);
+		return {};
+#endif
+	}
+
+	void SnapshotCompressor::ReleaseDictionary()
+	{
+#if defined(WITH_ZSTD)
+		if (_zstdCompressDict != nullptr) {
+			ZSTD_freeCDict(_zstdCompressDict);
+			_zstdCompressDict = nullptr;
+		}
+		if (_zstdDecompressDict != nullptr) {
+			ZSTD_freeDDict(_zstdDecompressDict);
+			_zstdDecompressDict = nullptr;
+		}
+#endif
+#if defined(WITH_LZ4)
+		if (_lz4DictionaryStream != nullptr) {
+			LZ4_freeStream(_lz4DictionaryStream);
+			_lz4DictionaryStream = nullptr;
+		}
+#endif
+
+		_dictionary = {};
+		_dictionaryId = 0;
+	}
+}
+
+#endif
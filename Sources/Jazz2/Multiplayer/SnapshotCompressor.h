@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#if defined(WITH_MULTIPLAYER) || defined(DOXYGEN_GENERATING_OUTPUT)
+
+#include "PacketTypes.h"
+
+#include <Containers/Array.h>
+#include <Containers/ArrayView.h>
+#include <Containers/StringView.h>
+#include <IO/MemoryStream.h>
+
+#if defined(WITH_ZSTD)
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+#endif
+#if defined(WITH_LZ4)
+union LZ4_stream_u;
+#endif
+
+using namespace Death::Containers;
+using namespace Death::IO;
+
+namespace Jazz2::Multiplayer
+{
+	/**
+		@brief Compresses actor snapshots of @ref ServerPacketType::UpdateAllActors
+
+		Snapshots are small and highly repetitive, so LZ4 and Zstandard can optionally use a shared dictionary
+		trained from recorded snapshots. The dictionary must be the same on both sides, so it's identified by its ID.
+		Deflate is always supported and it's used as a fallback if the remote side doesn't support anything better.
+	*/
+	class SnapshotCompressor
+	{
+	public:
+		/** @brief Flag of compression method that indicates that the shared dictionary was used */
+		static constexpr std::uint8_t DictionaryFlag = 0x80;
+		/** @brief Maximum size of the shared dictionary */
+		static constexpr std::size_t MaxDictionarySize = 64 * 1024;
+
+		SnapshotCompressor();
+		~SnapshotCompressor();
+
+		SnapshotCompressor(const SnapshotCompressor&) = delete;
+		SnapshotCompressor& operator=(const SnapshotCompressor&) = delete;
+
+		/** @brief Returns bitmask of compression methods supported by this build */
+		static std::uint32_t GetSupportedMethods();
+		/** @brief Returns the best compression method supported by both sides */
+		static SnapshotCompression SelectMethod(std::uint32_t remoteMethods);
+		/** @brief Returns name of the specified compression method */
+		static StringView GetMethodName(SnapshotCompression method);
+
+		/** @brief Loads the shared dictionary from a file */
+		bool LoadDictionary(StringView path);
+		/** @brief Returns ID of the loaded dictionary or 0 if no dictionary is loaded */
+		std::uint32_t GetDictionaryId() const {
+			return _dictionaryId;
+		}
+
+		/** @brief Compresses the data and appends the method followed by the compressed data to the target stream */
+		bool Compress(SnapshotCompression method, bool useDictionary, ArrayView<const std::uint8_t> data, MemoryStream& target);
+		/** @brief Decompresses data produced by @ref Compress() and appends them to the target stream */
+		bool Decompress(ArrayView<const std::uint8_t> data, MemoryStream& target);
+
+		/** @brief Trains a new dictionary from the specified samples, requires Zstandard with `dictBuilder` */
+		static Array<std::uint8_t> TrainDictionary(ArrayView<const ArrayView<const std::uint8_t>> samples, std::size_t dictionarySize);
+
+	private:
+		Array<std::uint8_t> _dictionary;
+		std::uint32_t _dictionaryId;
+#if defined(WITH_ZSTD)
+		ZSTD_CCtx_s* _zstdCompressCtx;
+		ZSTD_DCtx_s* _zstdDecompressCtx;
+		ZSTD_CDict_s* _zstdCompressDict;
+		ZSTD_DDict_s* _zstdDecompressDict;
+#endif
+#if defined(WITH_LZ4)
+		LZ4_stream_u* _lz4Stream;
+		LZ4_stream_u* _lz4DictionaryStream;
+#endif
+
+		void ReleaseDictionary();
+	};
+}
+
+#endif
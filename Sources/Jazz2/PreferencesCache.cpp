@@ -71,6 +71,8 @@ namespace Jazz2
 	EpisodeEndOverwriteMode PreferencesCache::OverwriteEpisodeEnd = EpisodeEndOverwriteMode::Always;
 	char PreferencesCache::Language[6]{};
 	bool PreferencesCache::BypassCache = false;
+	bool PreferencesCache::EnableParallelUpdate = false;
+	bool PreferencesCache::EnableAsyncLoading = false;
 	float PreferencesCache::MasterVolume = 0.7f;
 	float PreferencesCache::SfxVolume = 0.8f;
 	float PreferencesCache::MusicVolume = 0.4f;
@@ -484,6 +486,10 @@ namespace Jazz2
 			auto arg = config.argv(i);
 			if (arg == "/bypass-cache"_s) {
 				BypassCache = true;
+			} else if (arg == "/parallel-update"_s) {
+				EnableParallelUpdate = true;
+			} else if (arg == "/async-loading"_s) {
+				EnableAsyncLoading = true;
 			} else if (arg == "/cheats"_s) {
 				AllowCheats = true;
 			} else if (arg == "/cheats-lives"_s) {
@@ -203,6 +203,10 @@ namespace Jazz2
 		static char Language[6];
 		/** @brief Whether the cache should be bypassed */
 		static bool BypassCache;
+		/** @brief Whether actors that support it are updated in parallel on worker threads */
+		static bool EnableParallelUpdate;
+		/** @brief Whether metadata and graphics are loaded asynchronously on worker threads */
+		static bool EnableAsyncLoading;
 
 		// Sounds
 		/** @brief Master sound volume */
@@ -3,10 +3,41 @@
 namespace Jazz2::Resources
 {
 	GenericGraphicResource::GenericGraphicResource() noexcept
-		: Flags(GenericGraphicResourceFlags::None)
+		: Flags(GenericGraphicResourceFlags::None), PackedMaskStride(0)
 	{
 	}
 
+	void GenericGraphicResource::CreatePackedMask()
+	{
+		if (Mask == nullptr || FrameDimensions.X <= 0 || FrameDimensions.Y <= 0) {
+			return;
+		}
+
+		std::int32_t width = FrameDimensions.X;
+		std::int32_t height = FrameDimensions.Y;
+		std::int32_t frameCount = FrameConfiguration.X * FrameConfiguration.Y;
+		std::int32_t stride = FrameConfiguration.X * width;
+
+		PackedMaskStride = (width + 63) / 64;
+		PackedMask = std::make_unique<std::uint64_t[]>((std::size_t)frameCount * 2 * height * PackedMaskStride);
+
+		for (std::int32_t frame = 0; frame < frameCount; frame++) {
+			const std::uint8_t* src = &Mask[(frame / FrameConfiguration.X) * height * stride + (frame % FrameConfiguration.X) * width];
+			std::uint64_t* dst = &PackedMask[(std::size_t)frame * 2 * height * PackedMaskStride];
+			std::uint64_t* dstFlipped = dst + height * PackedMaskStride;
+
+			for (std::int32_t y = 0; y < height; y++) {
+				for (std::int32_t x = 0; x < width; x++) {
+					if (src[y * stride + x] > AlphaThreshold) {
+						std::int32_t xf = width - 1 - x;
+						dst[y * PackedMaskStride + (x >> 6)] |= (1ull << (x & 63));
+						dstFlipped[y * PackedMaskStride + (xf >> 6)] |= (1ull << (xf & 63));
+					}
+				}
+			}
+		}
+	}
+
 	GraphicResource::GraphicResource() noexcept
 	{
 	}
@@ -25,7 +25,9 @@ namespace Jazz2::Resources
 	{
 		None = 0x00,
 
-		Referenced = 0x01
+		Referenced = 0x01,
+		PaletteApplied = 0x02,
+		PaletteStale = 0x04
 	};
 
 	DEATH_ENUM_FLAGS(GenericGraphicResourceFlags);
@@ -33,6 +35,9 @@ namespace Jazz2::Resources
 	/** @brief Shared graphic resource */
 	struct GenericGraphicResource
 	{
+		/** @brief Alpha value above which a pixel of @ref Mask is considered solid */
+		static constexpr std::uint8_t AlphaThreshold = 40;
+
 		/** @brief Resource flags */
 		GenericGraphicResourceFlags Flags;
 		/** @brief Diffuse texture */
@@ -40,6 +45,10 @@ namespace Jazz2::Resources
 		//std::unique_ptr<Texture> TextureNormal;
 		/** @brief Collision mask */
 		std::unique_ptr<uint8_t[]> Mask;
+		/** @brief Collision mask packed to bit rows for each frame, see @ref CreatePackedMask() */
+		std::unique_ptr<std::uint64_t[]> PackedMask;
+		/** @brief Number of 64-bit words per row of @ref PackedMask */
+		std::int32_t PackedMaskStride;
 		/** @brief Frame dimensions */
 		Vector2i FrameDimensions;
 		/** @brief Frame configuration */
@@ -56,6 +65,23 @@ namespace Jazz2::Resources
 		Vector2i Gunspot;
 
 		GenericGraphicResource() noexcept;
+
+		/**
+		 * @brief Packs @ref Mask to bit rows, must be called after frame dimensions and configuration are set
+		 *
+		 * Each frame is stored twice, as is and horizontally flipped, so that bit @f$ x @f$ of a row always
+		 * corresponds to horizontal offset @f$ x @f$ from the left edge of the rendered frame.
+		 */
+		void CreatePackedMask();
+
+		/** @brief Returns packed rows of the specified frame or @cpp nullptr @ce if the resource has no mask */
+		const std::uint64_t* GetPackedMask(std::int32_t frame, bool flipX) const noexcept
+		{
+			if (PackedMask == nullptr) {
+				return nullptr;
+			}
+			return &PackedMask[(std::size_t)(frame * 2 + (flipX ? 1 : 0)) * FrameDimensions.Y * PackedMaskStride];
+		}
 	};
 
 	/** @brief Specific graphic resource (from metadata) */
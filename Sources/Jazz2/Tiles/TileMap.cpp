@@ -13,8 +13,8 @@
 namespace Jazz2::Tiles
 {
 	TileMap::TileMap(StringView tileSetPath, std::uint16_t captionTileId, bool applyPalette)
-		: _owner(nullptr), _sprLayerIndex(-1), _pitType(PitType::FallForever), _renderCommandsCount(0), _collapsingTimer(0.0f),
-			_animatedTilesOffset(0), _triggerState(ValueInit, TriggerCount), _triggerStateForRollback(ValueInit, TriggerCount),
+		: _owner(nullptr), _sprLayerIndex(-1), _pitType(PitType::FallForever), _collapsingTimer(0.0f), _animatedTilesOffset(0),
+			_triggerState(ValueInit, TriggerCount), _triggerStateForRollback(ValueInit, TriggerCount), _debrisCommandsCount(0), _renderCommandsCount(0),
 			_texturedBackgroundLayer(-1), _texturedBackgroundPass(this)
 	{
 		auto& tileSetPart = _tileSets.emplace_back();
@@ -86,16 +86,18 @@ namespace Jazz2::Tiles
 	{
 		ZoneScopedC(0xA09359);
 
-		// Update animated tiles
-		for (auto& animTile : _animatedTiles) {
+		// Update animated tiles, current frames are resolved once here, so tiles can be resolved with a single lookup
+		for (std::size_t i = 0; i < _animatedTiles.size(); i++) {
+			auto& animTile = _animatedTiles[i];
 			if (animTile.FrameDuration <= 0.0f || animTile.Tiles.size() < 2) {
 				continue;
 			}
 
+			std::int32_t prevTileIdx = animTile.CurrentTileIdx;
 			animTile.FramesLeft -= timeMult;
 			while (animTile.FramesLeft <= 0.0f) {
 				if (animTile.Forwards) {
-					if (animTile.CurrentTileIdx == animTile.Tiles.size() - 1) {
+					if (animTile.CurrentTileIdx == (std::int32_t)animTile.Tiles.size() - 1) {
 						if (animTile.IsPingPong) {
 							animTile.Forwards = false;
 							animTile.FramesLeft += (animTile.FrameDuration * (1 + animTile.PingPongDelay));
@@ -126,6 +128,10 @@ namespace Jazz2::Tiles
 					}
 				}
 			}
+
+			if (animTile.CurrentTileIdx != prevTileIdx) {
+				_animatedTileFrames[i] = animTile.Tiles[animTile.CurrentTileIdx].TileID;
+			}
 		}
 
 		// Update layer scrolling
@@ -169,6 +175,12 @@ namespace Jazz2::Tiles
 		// The command cache must be reset every frame,
 		// OnDraw() is called multiple times if multiple viewports are active
 		_renderCommandsCount = 0;
+		_debrisCommandsCount = 0;
+
+		for (TileChunk* chunk : _usedTileChunks) {
+			chunk->CommandsUsed = 0;
+		}
+		_usedTileChunks.clear();
 	}
 
 	bool TileMap::OnDraw(RenderQueue& renderQueue)
@@ -362,16 +374,8 @@ namespace Jazz2::Tiles
 						bottom = (TileSet::DefaultTileSize - 1 - top2);
 					}
 
-					top *= TileSet::DefaultTileSize;
-					bottom *= TileSet::DefaultTileSize;
-
-					std::uint8_t* mask = tileSet->GetTileMask(tileId);
-					for (std::int32_t ry = top; ry <= bottom; ry += TileSet::DefaultTileSize) {
-						for (std::int32_t rx = left; rx <= right; rx++) {
-							if (mask[ry | rx]) {
-								return false;
-							}
-						}
+					if (tileSet->IsTileMaskSetInRect(tileId, left, top, right, bottom)) {
+						return false;
 					}
 				}
 			}
@@ -473,16 +477,8 @@ namespace Jazz2::Tiles
 						bottom = (TileSet::DefaultTileSize - 1 - top2);
 					}
 
-					top *= TileSet::DefaultTileSize;
-					bottom *= TileSet::DefaultTileSize;
-
-					std::uint8_t* mask = tileSet->GetTileMask(tileId);
-					for (std::int32_t ry = top; ry <= bottom; ry += TileSet::DefaultTileSize) {
-						for (std::int32_t rx = left; rx <= right; rx++) {
-							if (mask[ry | rx]) {
-								return false;
-							}
-						}
+					if (tileSet->IsTileMaskSetInRect(tileId, left, top, right, bottom)) {
+						return false;
 					}
 				}
 			}
@@ -519,8 +515,6 @@ namespace Jazz2::Tiles
 			return SuspendType::None;
 		}
 
-		std::uint8_t* mask = tileSet->GetTileMask(tileId);
-
 		std::int32_t rx = (std::int32_t)x & 31;
 		std::int32_t ry = (std::int32_t)y & 31;
 
@@ -531,13 +525,11 @@ namespace Jazz2::Tiles
 			ry = (TileSet::DefaultTileSize - 1 - ry);
 		}
 
-		std::int32_t top = std::max(ry - Tolerance, 0) << 5;
-		std::int32_t bottom = std::min(ry + Tolerance, TileSet::DefaultTileSize - 1) << 5;
+		std::int32_t top = std::max(ry - Tolerance, 0);
+		std::int32_t bottom = std::min(ry + Tolerance, TileSet::DefaultTileSize - 1);
 
-		for (std::int32_t ti = bottom | rx; ti >= top; ti -= TileSet::DefaultTileSize) {
-			if (mask[ti]) {
-				return tile.HasSuspendType;
-			}
+		if (tileSet->IsTileMaskSetInRect(tileId, rx, top, rx, bottom)) {
+			return tile.HasSuspendType;
 		}
 
 		return SuspendType::None;
@@ -565,6 +557,7 @@ namespace Jazz2::Tiles
 
 				tile.DestructFrameIndex += frameCount;
 				tile.TileID = anim.Tiles[tile.DestructFrameIndex].TileID;
+				InvalidateTileChunk(tx, ty);
 				if (tile.DestructFrameIndex >= max) {
 					if (!soundName.empty()) {
 						_owner->PlayCommonSfx(soundName, Vector3f(tx * TileSet::DefaultTileSize + (TileSet::DefaultTileSize / 2),
@@ -583,6 +576,7 @@ namespace Jazz2::Tiles
 				std::int32_t frameCount = 1;
 				tile.DestructFrameIndex += frameCount;
 				tile.TileID = 0; // Set to empty tile
+				InvalidateTileChunk(tx, ty);
 
 				if (!soundName.empty()) {
 					_owner->PlayCommonSfx(soundName, Vector3f(tx * TileSet::DefaultTileSize + (TileSet::DefaultTileSize / 2),
@@ -754,6 +748,14 @@ namespace Jazz2::Tiles
 			float x3 = x1 + (TileSet::DefaultTileSize * 2) + cullingRect.W;
 			float y3 = y1 + (TileSet::DefaultTileSize * 2) + cullingRect.H;
 
+			if (layer.Description.RendererType == LayerRendererType::Default) {
+				// Static tiles are drawn from cached chunks, so the number of render commands doesn't depend on the resolution
+				std::int32_t tileCountX = (std::int32_t)((x3 - x1) / TileSet::DefaultTileSize) + 1;
+				std::int32_t tileCountY = (std::int32_t)((y3 - y1) / TileSet::DefaultTileSize) + 1;
+				DrawLayerChunks(renderQueue, layer, x1, y1, tileAbsX + 1, tileAbsY + 1, tileCountX, tileCountY);
+				return;
+			}
+
 			std::int32_t tile_xo = -1;
 			for (float x2 = x1; x2 <= x3; x2 += TileSet::DefaultTileSize) {
 				tileX = (tileX + 1) % tileCount.X;
@@ -779,53 +781,311 @@ namespace Jazz2::Tiles
 						}
 					}
 
-					std::int32_t tileId = ResolveTileID(tile);
-					if (tileId == 0 || tile.Alpha == 0) {
-						continue;
-					}
-					TileSet* tileSet = ResolveTileSet(tileId);
+					DrawTile(renderQueue, layer, tile, x2, y2);
+				}
+			}
+		}
+	}
+
+	void TileMap::DrawTile(RenderQueue& renderQueue, TileMapLayer& layer, LayerTile tile, float x, float y)
+	{
+		std::int32_t tileId = ResolveTileID(tile);
+		if (tileId == 0 || tile.Alpha == 0) {
+			return;
+		}
+		TileSet* tileSet = ResolveTileSet(tileId);
+		if (tileSet == nullptr) {
+			return;
+		}
+
+		auto command = RentRenderCommand(layer.Description.RendererType);
+		command->SetType(RenderCommand::Type::TileMap);
+		command->GetMaterial().SetBlendingFactors(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		Vector2i texSize = tileSet->TextureDiffuse->GetSize();
+		float texScaleX = TileSet::DefaultTileSize / float(texSize.X);
+		float texBiasX = ((tileId % tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.X);
+		float texScaleY = TileSet::DefaultTileSize / float(texSize.Y);
+		float texBiasY = ((tileId / tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.Y);
+
+		// ToDo: Flip normal map somehow
+		if ((tile.Flags & LayerTileFlags::FlipX) == LayerTileFlags::FlipX) {
+			texBiasX += texScaleX;
+			texScaleX *= -1;
+		}
+		if ((tile.Flags & LayerTileFlags::FlipY) == LayerTileFlags::FlipY) {
+			texBiasY += texScaleY;
+			texScaleY *= -1;
+		}
+
+		auto instanceBlock = command->GetMaterial().UniformBlock(Material::InstanceBlockName);
+		instanceBlock->GetUniform(Material::TexRectUniformName)->SetFloatValue(texScaleX, texBiasX, texScaleY, texBiasY);
+		instanceBlock->GetUniform(Material::SpriteSizeUniformName)->SetFloatValue(TileSet::DefaultTileSize, TileSet::DefaultTileSize);
+
+		Vector4f color = layer.Description.Color;
+		color.W *= tile.Alpha / 255.0f;
+		instanceBlock->GetUniform(Material::ColorUniformName)->SetFloatVector(color.Data());
+
+		if (!PreferencesCache::UnalignedViewport) {
+			x = std::floor(x); y = std::floor(y);
+		}
+
+		command->SetTransformation(Matrix4x4f::Translation(x, y, 0.0f));
+		command->SetLayer(layer.Description.Depth);
+		command->GetMaterial().SetTexture(*tileSet->TextureDiffuse);
+
+		renderQueue.AddCommand(command);
+	}
+
+	void TileMap::DrawLayerChunks(RenderQueue& renderQueue, TileMapLayer& layer, float x1, float y1, std::int32_t firstTileX, std::int32_t firstTileY, std::int32_t tileCountX, std::int32_t tileCountY)
+	{
+		std::size_t layerIndex = (std::size_t)(&layer - _layers.data());
+		if (_layerChunks.size() != _layers.size()) {
+			_layerChunks.resize(_layers.size());
+		}
+
+		Vector2i layoutSize = layer.LayoutSize;
+		LayerChunks& chunks = _layerChunks[layerIndex];
+		if (chunks.Chunks == nullptr) {
+			chunks.Count = Vector2i((layoutSize.X + TileChunkSize - 1) / TileChunkSize, (layoutSize.Y + TileChunkSize - 1) / TileChunkSize);
+			chunks.Chunks = std::make_unique<TileChunk[]>(chunks.Count.X * chunks.Count.Y);
+			for (std::int32_t i = 0; i < chunks.Count.X * chunks.Count.Y; i++) {
+				chunks.Chunks[i].IsDirty = true;
+			}
+		}
+
+		// Tile coordinates are absolute, so they can be outside of the layout if the layer is repeated
+		std::int32_t tx1 = firstTileX, tx2 = firstTileX + tileCountX - 1;
+		std::int32_t ty1 = firstTileY, ty2 = firstTileY + tileCountY - 1;
+		if (!layer.Description.RepeatX) {
+			tx1 = std::max(tx1, 0);
+			tx2 = std::min(tx2, layoutSize.X - 1);
+		}
+		if (!layer.Description.RepeatY) {
+			ty1 = std::max(ty1, 0);
+			ty2 = std::min(ty2, layoutSize.Y - 1);
+		}
+
+		std::int32_t tx = tx1;
+		while (tx <= tx2) {
+			std::int32_t layoutX = ((tx % layoutSize.X) + layoutSize.X) % layoutSize.X;
+			std::int32_t cx = layoutX / TileChunkSize;
+			std::int32_t chunkStartX = tx - (layoutX - cx * TileChunkSize);
+			float x = x1 + (chunkStartX - firstTileX) * TileSet::DefaultTileSize;
+
+			std::int32_t ty = ty1;
+			while (ty <= ty2) {
+				std::int32_t layoutY = ((ty % layoutSize.Y) + layoutSize.Y) % layoutSize.Y;
+				std::int32_t cy = layoutY / TileChunkSize;
+				std::int32_t chunkStartY = ty - (layoutY - cy * TileChunkSize);
+				float y = y1 + (chunkStartY - firstTileY) * TileSet::DefaultTileSize;
+
+				DrawTileChunk(renderQueue, layer, chunks, cx, cy, x, y);
+
+				ty = chunkStartY + std::min(TileChunkSize, layoutSize.Y - cy * TileChunkSize);
+			}
+
+			tx = chunkStartX + std::min(TileChunkSize, layoutSize.X - cx * TileChunkSize);
+		}
+	}
+
+	void TileMap::DrawTileChunk(RenderQueue& renderQueue, TileMapLayer& layer, LayerChunks& chunks, std::int32_t cx, std::int32_t cy, float x, float y)
+	{
+		TileChunk& chunk = chunks.Chunks[cx + cy * chunks.Count.X];
+		if (chunk.IsDirty) {
+			RebuildTileChunk(layer, chunk, cx, cy);
+		}
+
+		if (!chunk.Vertices.empty()) {
+			auto* command = RentTileChunkCommand(chunk);
+			auto* instanceBlock = command->GetMaterial().UniformBlock(Material::InstanceBlockName);
+			instanceBlock->GetUniform(Material::ColorUniformName)->SetFloatVector(layer.Description.Color.Data());
+
+			float xr = x, yr = y;
+			if (!PreferencesCache::UnalignedViewport) {
+				xr = std::floor(xr); yr = std::floor(yr);
+			}
+
+			command->SetTransformation(Matrix4x4f::Translation(xr, yr, 0.0f));
+			command->SetLayer(layer.Description.Depth);
+			command->GetMaterial().SetTexture(*chunk.StaticTileSet->TextureDiffuse);
+
+			renderQueue.AddCommand(command);
+		}
+
+		std::int32_t tx = cx * TileChunkSize;
+		std::int32_t ty = cy * TileChunkSize;
+		for (std::uint16_t i : chunk.DynamicTiles) {
+			std::int32_t ox = i % TileChunkSize;
+			std::int32_t oy = i / TileChunkSize;
+			LayerTile tile = layer.Layout[(tx + ox) + (ty + oy) * layer.LayoutSize.X];
+			DrawTile(renderQueue, layer, tile, x + ox * TileSet::DefaultTileSize, y + oy * TileSet::DefaultTileSize);
+		}
+	}
+
+	void TileMap::RebuildTileChunk(TileMapLayer& layer, TileChunk& chunk, std::int32_t cx, std::int32_t cy)
+	{
+		ZoneScopedC(0xA09359);
+
+		chunk.Vertices.clear();
+		chunk.DynamicTiles.clear();
+		chunk.StaticTileSet = nullptr;
+
+		std::int32_t tx = cx * TileChunkSize;
+		std::int32_t ty = cy * TileChunkSize;
+		std::int32_t width = std::min(TileChunkSize, layer.LayoutSize.X - tx);
+		std::int32_t height = std::min(TileChunkSize, layer.LayoutSize.Y - ty);
+
+		for (std::int32_t oy = 0; oy < height; oy++) {
+			for (std::int32_t ox = 0; ox < width; ox++) {
+				const LayerTile& tile = layer.Layout[(tx + ox) + (ty + oy) * layer.LayoutSize.X];
+				if (tile.TileID == 0 || tile.Alpha == 0) {
+					continue;
+				}
+
+				// Animated and translucent tiles are drawn separately, tiles from a different tile set too
+				std::int32_t tileId = tile.TileID;
+				TileSet* tileSet = nullptr;
+				if (tileId < (std::int32_t)_animatedTilesOffset && tile.Alpha == 255) {
+					tileSet = ResolveTileSet(tileId);
 					if (tileSet == nullptr) {
 						continue;
 					}
+					if (chunk.StaticTileSet == nullptr) {
+						chunk.StaticTileSet = tileSet;
+					} else if (chunk.StaticTileSet != tileSet) {
+						tileSet = nullptr;
+					}
+				}
 
-					auto command = RentRenderCommand(layer.Description.RendererType);
-					command->SetType(RenderCommand::Type::TileMap);
-					command->GetMaterial().SetBlendingFactors(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				if (tileSet == nullptr) {
+					chunk.DynamicTiles.push_back((std::uint16_t)(ox + oy * TileChunkSize));
+					continue;
+				}
 
-					Vector2i texSize = tileSet->TextureDiffuse->GetSize();
-					float texScaleX = TileSet::DefaultTileSize / float(texSize.X);
-					float texBiasX = ((tileId % tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.X);
-					float texScaleY = TileSet::DefaultTileSize / float(texSize.Y);
-					float texBiasY = ((tileId / tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.Y);
+				Vector2i texSize = tileSet->TextureDiffuse->GetSize();
+				float texScaleX = TileSet::DefaultTileSize / float(texSize.X);
+				float texBiasX = ((tileId % tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.X);
+				float texScaleY = TileSet::DefaultTileSize / float(texSize.Y);
+				float texBiasY = ((tileId / tileSet->TilesPerRow) * (TileSet::DefaultTileSize + 2.0f) + 1.0f) / float(texSize.Y);
 
-					// ToDo: Flip normal map somehow
-					if ((tile.Flags & LayerTileFlags::FlipX) == LayerTileFlags::FlipX) {
-						texBiasX += texScaleX;
-						texScaleX *= -1;
-					}
-					if ((tile.Flags & LayerTileFlags::FlipY) == LayerTileFlags::FlipY) {
-						texBiasY += texScaleY;
-						texScaleY *= -1;
-					}
+				if ((tile.Flags & LayerTileFlags::FlipX) == LayerTileFlags::FlipX) {
+					texBiasX += texScaleX;
+					texScaleX *= -1;
+				}
+				if ((tile.Flags & LayerTileFlags::FlipY) == LayerTileFlags::FlipY) {
+					texBiasY += texScaleY;
+					texScaleY *= -1;
+				}
 
-					auto instanceBlock = command->GetMaterial().UniformBlock(Material::InstanceBlockName);
-					instanceBlock->GetUniform(Material::TexRectUniformName)->SetFloatValue(texScaleX, texBiasX, texScaleY, texBiasY);
-					instanceBlock->GetUniform(Material::SpriteSizeUniformName)->SetFloatValue(TileSet::DefaultTileSize, TileSet::DefaultTileSize);
+				// Quads are joined into a single triangle strip with degenerate triangles,
+				// the vertex order is the same as in the sprite shader
+				float left = (float)(ox * TileSet::DefaultTileSize);
+				float top = (float)(oy * TileSet::DefaultTileSize);
+				float right = left + TileSet::DefaultTileSize;
+				float bottom = top + TileSet::DefaultTileSize;
+				float quad[4][4] = {
+					{ right, top, texBiasX + texScaleX, texBiasY },
+					{ right, bottom, texBiasX + texScaleX, texBiasY + texScaleY },
+					{ left, top, texBiasX, texBiasY },
+					{ left, bottom, texBiasX, texBiasY + texScaleY }
+				};
+
+				if (!chunk.Vertices.empty()) {
+					float lastVertex[4];
+					std::memcpy(lastVertex, chunk.Vertices.end() - 4, sizeof(lastVertex));
+					chunk.Vertices.append(lastVertex, lastVertex + 4);
+					chunk.Vertices.append(quad[0], quad[0] + 4);
+				}
+				chunk.Vertices.append(quad[0], quad[0] + 16);
+			}
+		}
 
-					Vector4f color = layer.Description.Color;
-					color.W *= tile.Alpha / 255.0f;
-					instanceBlock->GetUniform(Material::ColorUniformName)->SetFloatVector(color.Data());
+		chunk.Version++;
+		chunk.IsDirty = false;
+	}
 
-					float x2r = x2, y2r = y2;
-					if (!PreferencesCache::UnalignedViewport) {
-						x2r = std::floor(x2r); y2r = std::floor(y2r);
-					}
+	RenderCommand* TileMap::RentTileChunkCommand(TileChunk& chunk)
+	{
+		constexpr std::uint32_t FloatsPerVertex = 4;
 
-					command->SetTransformation(Matrix4x4f::Translation(x2r, y2r, 0.0f));
-					command->SetLayer(layer.Description.Depth);
-					command->GetMaterial().SetTexture(*tileSet->TextureDiffuse);
+		// Each command can be used only once per frame, so the chunk can have more of them
+		// if it's visible multiple times (e.g., repeated layer or multiple viewports)
+		if (chunk.CommandsUsed == 0) {
+			_usedTileChunks.push_back(&chunk);
+		}
 
-					renderQueue.AddCommand(command);
+		TileChunkCommand* chunkCommand;
+		if (chunk.CommandsUsed < (std::int32_t)chunk.Commands.size()) {
+			chunkCommand = &chunk.Commands[chunk.CommandsUsed];
+		} else {
+			chunkCommand = &chunk.Commands.emplace_back();
+			chunkCommand->Command = std::make_unique<RenderCommand>();
+			chunkCommand->Version = chunk.Version - 1;
+			chunkCommand->VertexCapacity = 0;
+
+			auto* command = chunkCommand->Command.get();
+			command->SetType(RenderCommand::Type::TileMap);
+			// Vertices of the whole chunk are uploaded only when the chunk changes, batching would copy them every frame
+			command->SetBatchingEnabled(false);
+
+			auto& material = command->GetMaterial();
+			material.SetBlendingEnabled(true);
+			material.SetBlendingFactors(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			material.SetShaderProgramType(Material::ShaderProgramType::MeshSprite);
+			material.ReserveUniformsDataMemory();
+			material.SetDefaultAttributesParameters();
+
+			auto* textureUniform = material.Uniform(Material::TextureUniformName);
+			if (textureUniform && textureUniform->GetIntValue(0) != 0) {
+				textureUniform->SetIntValue(0); // GL_TEXTURE0
+			}
+
+			// Vertices are already in pixels and texture coordinates are already normalized
+			auto* instanceBlock = material.UniformBlock(Material::InstanceBlockName);
+			instanceBlock->GetUniform(Material::TexRectUniformName)->SetFloatValue(1.0f, 0.0f, 1.0f, 0.0f);
+			instanceBlock->GetUniform(Material::SpriteSizeUniformName)->SetFloatValue(1.0f, 1.0f);
+
+			command->GetGeometry().SetPrimitiveType(GL_TRIANGLE_STRIP);
+			command->GetGeometry().SetElementsPerVertex(FloatsPerVertex);
+		}
+		chunk.CommandsUsed++;
+
+		auto* command = chunkCommand->Command.get();
+		if (chunkCommand->Version != chunk.Version) {
+			// Vertices are uploaded to the custom VBO only when the chunk changes
+			chunkCommand->Version = chunk.Version;
+			std::uint32_t numFloats = (std::uint32_t)chunk.Vertices.size();
+			if (chunkCommand->VertexCapacity != numFloats) {
+				// The whole buffer is uploaded at once if mapping is not available, so it must have the exact size
+				chunkCommand->VertexCapacity = numFloats;
+				command->GetGeometry().CreateCustomVbo(numFloats, GL_STATIC_DRAW);
+			}
+			command->GetGeometry().SetDrawParameters(GL_TRIANGLE_STRIP, 0, numFloats / FloatsPerVertex);
+			command->GetGeometry().SetHostVertexPointer(chunk.Vertices.data());
+		}
+
+		return command;
+	}
+
+	void TileMap::InvalidateTileChunk(std::int32_t tx, std::int32_t ty)
+	{
+		if (_sprLayerIndex < 0 || _sprLayerIndex >= (std::int32_t)_layerChunks.size()) {
+			return;
+		}
+
+		LayerChunks& chunks = _layerChunks[_sprLayerIndex];
+		if (chunks.Chunks != nullptr) {
+			chunks.Chunks[(tx / TileChunkSize) + (ty / TileChunkSize) * chunks.Count.X].IsDirty = true;
+		}
+	}
+
+	void TileMap::InvalidateTileChunks()
+	{
+		for (LayerChunks& chunks : _layerChunks) {
+			if (chunks.Chunks != nullptr) {
+				for (std::int32_t i = 0; i < chunks.Count.X * chunks.Count.Y; i++) {
+					chunks.Chunks[i].IsDirty = true;
 				}
 			}
 		}
@@ -840,7 +1100,7 @@ namespace Jazz2::Tiles
 	RenderCommand* TileMap::RentRenderCommand(LayerRendererType type)
 	{
 		RenderCommand* command;
-		if (_renderCommandsCount < _renderCommands.size()) {
+		if (_renderCommandsCount < (std::int32_t)_renderCommands.size()) {
 			command = _renderCommands[_renderCommandsCount].get();
 			_renderCommandsCount++;
 		} else {
@@ -880,6 +1140,8 @@ namespace Jazz2::Tiles
 		if (tileSetPart.Data == nullptr) {
 			LOGE("Cannot load extra tileset \"{}\"", tileSetPath);
 		}
+
+		InvalidateTileChunks();
 	}
 
 	void TileMap::ReadLayerConfiguration(Stream& s)
@@ -982,6 +1244,7 @@ namespace Jazz2::Tiles
 		std::int32_t count = s.ReadValueAsLE<std::uint16_t>();
 
 		_animatedTiles.reserve(count);
+		_animatedTileFrames.reserve(count);
 
 		for (std::int32_t i = 0; i < count; i++) {
 			std::uint8_t frameCount = s.ReadValue<std::uint8_t>();
@@ -1005,6 +1268,8 @@ namespace Jazz2::Tiles
 				/*std::uint8_t flag =*/ s.ReadValue<std::uint8_t>();
 				frame.TileID = s.ReadValueAsLE<std::uint16_t>();
 			}
+
+			_animatedTileFrames.push_back(animTile.Tiles[animTile.CurrentTileIdx].TileID);
 		}
 	}
 
@@ -1122,7 +1387,7 @@ namespace Jazz2::Tiles
 			}
 		}
 
-		_debrisList.push_back(debris);
+		_debrisList.Add(debris);
 	}
 
 	void TileMap::CreateTileDebris(std::int32_t tileId, std::int32_t x, std::int32_t y)
@@ -1159,7 +1424,7 @@ namespace Jazz2::Tiles
 		}*/
 
 		for (std::int32_t i = 0; i < 4; i++) {
-			DestructibleDebris& debris = _debrisList.emplace_back();
+			DestructibleDebris debris;
 			debris.Pos = Vector2f(x * TileSet::DefaultTileSize + (i % 2) * QuarterSize, y * TileSet::DefaultTileSize + (i / 2) * QuarterSize);
 			debris.Depth = z;
 			debris.Size = Vector2f(QuarterSize, QuarterSize);
@@ -1183,6 +1448,7 @@ namespace Jazz2::Tiles
 
 			debris.DiffuseTexture = tileSet->TextureDiffuse.get();
 			debris.Flags = DebrisFlags::None;
+			_debrisList.Add(debris);
 		}
 	}
 
@@ -1202,7 +1468,7 @@ namespace Jazz2::Tiles
 			for (std::int32_t fx = 0; fx < res->Base->FrameDimensions.X; fx += DebrisSize + 1) {
 				float currentSize = DebrisSize * Random().FastFloat(0.2f, 1.1f);
 
-				DestructibleDebris& debris = _debrisList.emplace_back();
+				DestructibleDebris debris;
 				debris.Pos = Vector2f(x + (isFacingLeft ? res->Base->FrameDimensions.X - fx : fx), y + fy);
 				debris.Depth = (std::uint16_t)pos.Z;
 				debris.Size = Vector2f(currentSize, currentSize);
@@ -1227,6 +1493,7 @@ namespace Jazz2::Tiles
 
 				debris.DiffuseTexture = res->Base->TextureDiffuse.get();
 				debris.Flags = DebrisFlags::Bounce;
+				_debrisList.Add(debris);
 			}
 		}
 	}
@@ -1244,7 +1511,7 @@ namespace Jazz2::Tiles
 		for (std::int32_t i = 0; i < count; i++) {
 			float speedX = Random().FastFloat(-1.0f, 1.0f) * Random().FastFloat(0.2f, 0.8f) * count;
 
-			DestructibleDebris& debris = _debrisList.emplace_back();
+			DestructibleDebris debris;
 			debris.Pos = Vector2f(x, y);
 			debris.Depth = (std::uint16_t)pos.Z;
 			debris.Size = Vector2f((float)res->Base->FrameDimensions.X, (float)res->Base->FrameDimensions.Y);
@@ -1271,6 +1538,7 @@ namespace Jazz2::Tiles
 
 			debris.DiffuseTexture = res->Base->TextureDiffuse.get();
 			debris.Flags = DebrisFlags::Bounce;
+			_debrisList.Add(debris);
 		}
 	}
 
@@ -1278,77 +1546,93 @@ namespace Jazz2::Tiles
 	{
 		ZoneScopedC(0xA09359);
 
-		std::int32_t size = (std::int32_t)_debrisList.size();
-		for (std::int32_t i = 0; i < size; i++) {
-			DestructibleDebris& debris = _debrisList[i];
+		DebrisList& d = _debrisList;
 
-			if (debris.Scale <= 0.0f || debris.Alpha <= 0.0f) {
-				std::swap(debris, _debrisList[size - 1]);
-				_debrisList.pop_back();
-				i--;
-				size--;
-				continue;
+		for (std::int32_t i = d.GetCount() - 1; i >= 0; i--) {
+			if (d.Scale[i] <= 0.0f || d.Alpha[i] <= 0.0f) {
+				d.RemoveAt(i);
 			}
+		}
 
-			debris.Time -= timeMult;
-			if (debris.Time <= 0.0f) {
-				debris.Alpha = -std::min(0.02f, debris.Alpha);
+		std::int32_t count = d.GetCount();
+		float* time = d.Time.data();
+		float* alpha = d.Alpha.data();
+		for (std::int32_t i = 0; i < count; i++) {
+			time[i] -= timeMult;
+			alpha[i] = (time[i] <= 0.0f ? -std::min(0.02f, alpha[i]) : alpha[i]);
+		}
+
+		// Only flagged debris should collide with tilemap, it must be resolved before the integration below
+		for (std::int32_t i = 0; i < count; i++) {
+			if ((d.Flags[i] & (DebrisFlags::Disappear | DebrisFlags::Bounce)) == DebrisFlags::None) {
+				continue;
 			}
 
-			if ((debris.Flags & (DebrisFlags::Disappear | DebrisFlags::Bounce)) != DebrisFlags::None) {
-				// Debris should collide with tilemap
-				float nx = debris.Pos.X + debris.Speed.X * timeMult;
-				float ny = debris.Pos.Y + debris.Speed.Y * timeMult;
-				AABB aabb = AABBf(nx - 1, ny - 1, nx + 1, ny + 1);
-				TileCollisionParams params = { TileDestructType::None, true };
+			float nx = d.PosX[i] + d.SpeedX[i] * timeMult;
+			float ny = d.PosY[i] + d.SpeedY[i] * timeMult;
+			AABB aabb = AABBf(nx - 1, ny - 1, nx + 1, ny + 1);
+			TileCollisionParams params = { TileDestructType::None, true };
+			if (IsTileEmpty(aabb, params)) {
+				// Nothing...
+			} else if ((d.Flags[i] & DebrisFlags::Disappear) == DebrisFlags::Disappear) {
+				d.ScaleSpeed[i] = -0.02f;
+				d.AlphaSpeed[i] = -0.006f;
+				d.SpeedX[i] = 0.0f;
+				d.SpeedY[i] = 0.0f;
+				d.AccelerationX[i] = 0.0f;
+				d.AccelerationY[i] = 0.0f;
+			} else {
+				// Place us to the ground only if no horizontal movement was
+				// involved (this prevents speeds resetting if the actor
+				// collides with a wall from the side while in the air)
+				aabb.T = d.PosY[i] - 1;
+				aabb.B = d.PosY[i] + 1;
+
 				if (IsTileEmpty(aabb, params)) {
-					// Nothing...
-				} else if ((debris.Flags & DebrisFlags::Disappear) == DebrisFlags::Disappear) {
-					debris.ScaleSpeed = -0.02f;
-					debris.AlphaSpeed = -0.006f;
-					debris.Speed = Vector2f::Zero;
-					debris.Acceleration = Vector2f::Zero;
-				} else {
-					// Place us to the ground only if no horizontal movement was
-					// involved (this prevents speeds resetting if the actor
-					// collides with a wall from the side while in the air)
-					aabb.T = debris.Pos.Y - 1;
-					aabb.B = debris.Pos.Y + 1;
-
-					if (IsTileEmpty(aabb, params)) {
-						if (debris.Speed.Y > 0.0f) {
-							debris.Speed.Y = -(0.8f/*elasticity*/ * debris.Speed.Y);
-							//OnHitFloorHook();
-						} else {
-							debris.Speed.Y = 0;
-							//OnHitCeilingHook();
-						}
+					if (d.SpeedY[i] > 0.0f) {
+						d.SpeedY[i] = -(0.8f/*elasticity*/ * d.SpeedY[i]);
+						//OnHitFloorHook();
+					} else {
+						d.SpeedY[i] = 0;
+						//OnHitCeilingHook();
 					}
+				}
 
-					// If the actor didn't move all the way horizontally,
-					// it hit a wall (or was already touching it)
-					aabb = AABBf(debris.Pos.X - 1, ny - 1, debris.Pos.X + 1, ny + 1);
-					if (IsTileEmpty(aabb, params)) {
-						debris.Speed.X = -(0.8f/*elasticity*/ * debris.Speed.X);
-						debris.AngleSpeed = -(0.8f/*elasticity*/ * debris.AngleSpeed);
-						//OnHitWallHook();
-					}
+				// If the actor didn't move all the way horizontally,
+				// it hit a wall (or was already touching it)
+				aabb = AABBf(d.PosX[i] - 1, ny - 1, d.PosX[i] + 1, ny + 1);
+				if (IsTileEmpty(aabb, params)) {
+					d.SpeedX[i] = -(0.8f/*elasticity*/ * d.SpeedX[i]);
+					d.AngleSpeed[i] = -(0.8f/*elasticity*/ * d.AngleSpeed[i]);
+					//OnHitWallHook();
 				}
 			}
+		}
 
-			debris.Pos.X += debris.Speed.X * timeMult + 0.5f * debris.Acceleration.X * timeMult * timeMult;
-			debris.Pos.Y += debris.Speed.Y * timeMult + 0.5f * debris.Acceleration.Y * timeMult * timeMult;
-
-			if (debris.Acceleration.X != 0.0f) {
-				debris.Speed.X = std::min(debris.Speed.X + debris.Acceleration.X * timeMult, 10.0f);
-			}
-			if (debris.Acceleration.Y != 0.0f) {
-				debris.Speed.Y = std::min(debris.Speed.Y + debris.Acceleration.Y * timeMult, 10.0f);
-			}
+		// Integration of all debris is branchless, so the compiler can vectorize these loops
+		float halfTimeMultSqr = 0.5f * timeMult * timeMult;
+		float* posX = d.PosX.data();
+		float* posY = d.PosY.data();
+		float* speedX = d.SpeedX.data();
+		float* speedY = d.SpeedY.data();
+		const float* accelerationX = d.AccelerationX.data();
+		const float* accelerationY = d.AccelerationY.data();
+		for (std::int32_t i = 0; i < count; i++) {
+			posX[i] += speedX[i] * timeMult + accelerationX[i] * halfTimeMultSqr;
+			posY[i] += speedY[i] * timeMult + accelerationY[i] * halfTimeMultSqr;
+			speedX[i] = (accelerationX[i] != 0.0f ? std::min(speedX[i] + accelerationX[i] * timeMult, 10.0f) : speedX[i]);
+			speedY[i] = (accelerationY[i] != 0.0f ? std::min(speedY[i] + accelerationY[i] * timeMult, 10.0f) : speedY[i]);
+		}
 
-			debris.Scale += debris.ScaleSpeed * timeMult;
-			debris.Angle += debris.AngleSpeed * timeMult;
-			debris.Alpha += debris.AlphaSpeed * timeMult;
+		float* scale = d.Scale.data();
+		float* angle = d.Angle.data();
+		const float* scaleSpeed = d.ScaleSpeed.data();
+		const float* angleSpeed = d.AngleSpeed.data();
+		const float* alphaSpeed = d.AlphaSpeed.data();
+		for (std::int32_t i = 0; i < count; i++) {
+			scale[i] += scaleSpeed[i] * timeMult;
+			angle[i] += angleSpeed[i] * timeMult;
+			alpha[i] += alphaSpeed[i] * timeMult;
 		}
 	}
 
@@ -1358,41 +1642,199 @@ namespace Jazz2::Tiles
 
 		constexpr float MaxDebrisSize = 128.0f;
 
+		// Layout of a single instance in the uniform block of the batched sprite shader (std140)
+		struct DebrisInstance {
+			float ModelMatrix[16];
+			float Color[4];
+			float TexRect[4];
+			float SpriteSize[2];
+			float Padding[2];
+		};
+
 		Rectf viewportRect = RenderResources::GetCurrentViewport()->GetCullingRect();
 		viewportRect.X -= MaxDebrisSize;
 		viewportRect.Y -= MaxDebrisSize;
 		viewportRect.W += MaxDebrisSize * 2.0f;
 		viewportRect.H += MaxDebrisSize * 2.0f;
 
-		for (const auto& debris : _debrisList) {
-			if (!viewportRect.Contains(debris.Pos)) {
-				continue;
+		const DebrisList& d = _debrisList;
+		std::int32_t count = d.GetCount();
+
+		_visibleDebris.clear();
+		for (std::int32_t i = 0; i < count; i++) {
+			if (viewportRect.Contains(Vector2f(d.PosX[i], d.PosY[i]))) {
+				_visibleDebris.push_back(i);
 			}
+		}
 
-			auto command = RentRenderCommand(LayerRendererType::Default);
-			command->SetType(RenderCommand::Type::Particle);
+		if (_visibleDebris.empty()) {
+			return;
+		}
 
-			if ((debris.Flags & DebrisFlags::AdditiveBlending) == DebrisFlags::AdditiveBlending) {
+		// Debris with the same texture, blending and depth are drawn by a single command
+		auto isAdditive = [&d](std::int32_t i) {
+			return (d.Flags[i] & DebrisFlags::AdditiveBlending) == DebrisFlags::AdditiveBlending;
+		};
+		std::sort(_visibleDebris.begin(), _visibleDebris.end(), [&d, &isAdditive](std::int32_t a, std::int32_t b) {
+			const DebrisSprite& sa = d.Sprites[a];
+			const DebrisSprite& sb = d.Sprites[b];
+			if (sa.DiffuseTexture != sb.DiffuseTexture) {
+				return std::less<Texture*>()(sa.DiffuseTexture, sb.DiffuseTexture);
+			}
+			if (isAdditive(a) != isAdditive(b)) {
+				return isAdditive(b);
+			}
+			return (sa.Depth < sb.Depth);
+		});
+
+		const Camera::ProjectionValues cameraValues = RenderResources::GetCurrentCamera()->GetProjectionValues();
+
+		std::size_t first = 0;
+		while (first < _visibleDebris.size()) {
+			std::int32_t refIndex = _visibleDebris[first];
+			const DebrisSprite& refSprite = d.Sprites[refIndex];
+			bool refAdditive = isAdditive(refIndex);
+
+			auto* command = RentDebrisCommand();
+			auto* instancesBlock = command->GetMaterial().UniformBlock(Material::InstancesBlockName);
+			std::size_t maxInstances = (instancesBlock->GetSize() - instancesBlock->GetAlignAmount()) / sizeof(DebrisInstance);
+			auto* instances = reinterpret_cast<DebrisInstance*>(instancesBlock->GetDataPointer());
+			if (maxInstances == 0) {
+				break;
+			}
+			float depth = RenderCommand::CalculateDepth(refSprite.Depth, cameraValues.nearClip, cameraValues.farClip);
+
+			std::size_t last = first;
+			while (last < _visibleDebris.size() && last - first < maxInstances) {
+				std::int32_t i = _visibleDebris[last];
+				const DebrisSprite& sprite = d.Sprites[i];
+				if (sprite.DiffuseTexture != refSprite.DiffuseTexture || isAdditive(i) != refAdditive || sprite.Depth != refSprite.Depth) {
+					break;
+				}
+
+				// Equivalent to Translation(Pos) * RotationZ(Angle) * Scaling(Scale) * Translation(-Size / 2)
+				float c = std::cos(d.Angle[i]) * d.Scale[i];
+				float s = std::sin(d.Angle[i]) * d.Scale[i];
+				float hx = sprite.Size.X * 0.5f;
+				float hy = sprite.Size.Y * 0.5f;
+
+				DebrisInstance& instance = instances[last - first];
+				instance.ModelMatrix[0] = c;
+				instance.ModelMatrix[1] = s;
+				instance.ModelMatrix[2] = 0.0f;
+				instance.ModelMatrix[3] = 0.0f;
+				instance.ModelMatrix[4] = -s;
+				instance.ModelMatrix[5] = c;
+				instance.ModelMatrix[6] = 0.0f;
+				instance.ModelMatrix[7] = 0.0f;
+				instance.ModelMatrix[8] = 0.0f;
+				instance.ModelMatrix[9] = 0.0f;
+				instance.ModelMatrix[10] = 1.0f;
+				instance.ModelMatrix[11] = 0.0f;
+				instance.ModelMatrix[12] = d.PosX[i] - (c * hx - s * hy);
+				instance.ModelMatrix[13] = d.PosY[i] - (s * hx + c * hy);
+				instance.ModelMatrix[14] = depth;
+				instance.ModelMatrix[15] = 1.0f;
+				instance.Color[0] = 1.0f;
+				instance.Color[1] = 1.0f;
+				instance.Color[2] = 1.0f;
+				instance.Color[3] = d.Alpha[i];
+				instance.TexRect[0] = sprite.TexScaleX;
+				instance.TexRect[1] = sprite.TexBiasX;
+				instance.TexRect[2] = sprite.TexScaleY;
+				instance.TexRect[3] = sprite.TexBiasY;
+				instance.SpriteSize[0] = sprite.Size.X;
+				instance.SpriteSize[1] = sprite.Size.Y;
+
+				last++;
+			}
+
+			std::int32_t instanceCount = (std::int32_t)(last - first);
+			instancesBlock->SetUsedSize(instanceCount * sizeof(DebrisInstance));
+
+			if (refAdditive) {
 				command->GetMaterial().SetBlendingFactors(GL_SRC_ALPHA, GL_ONE);
 			} else {
 				command->GetMaterial().SetBlendingFactors(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			}
 
-			auto instanceBlock = command->GetMaterial().UniformBlock(Material::InstanceBlockName);
-			instanceBlock->GetUniform(Material::TexRectUniformName)->SetFloatValue(debris.TexScaleX, debris.TexBiasX, debris.TexScaleY, debris.TexBiasY);
-			instanceBlock->GetUniform(Material::SpriteSizeUniformName)->SetFloatValue(debris.Size.X, debris.Size.Y);
-			instanceBlock->GetUniform(Material::ColorUniformName)->SetFloatVector(Colorf(1.0f, 1.0f, 1.0f, debris.Alpha).Data());
-
-			Matrix4x4f worldMatrix = Matrix4x4f::Translation(debris.Pos.X, debris.Pos.Y, 0.0f);
-			worldMatrix.RotateZ(debris.Angle);
-			worldMatrix.Scale(debris.Scale, debris.Scale, 1.0f);
-			worldMatrix.Translate(debris.Size.X  * -0.5f, debris.Size.Y * -0.5f, 0.0f);
-			command->SetTransformation(worldMatrix);
-			command->SetLayer(debris.Depth);
-			command->GetMaterial().SetTexture(*debris.DiffuseTexture);
+			command->GetGeometry().SetDrawParameters(GL_TRIANGLES, 0, 6 * instanceCount);
+			command->SetBatchSize(instanceCount);
+			command->SetLayer(refSprite.Depth);
+			command->GetMaterial().SetTexture(*refSprite.DiffuseTexture);
 
 			renderQueue.AddCommand(command);
+
+			first = last;
+		}
+	}
+
+	RenderCommand* TileMap::RentDebrisCommand()
+	{
+		if (_debrisCommandsCount < (std::int32_t)_debrisCommands.size()) {
+			return _debrisCommands[_debrisCommandsCount++].get();
+		}
+
+		// Instances are written directly to the uniform block of the batched shader, so all debris
+		// in the command are drawn at once without going through the render batcher
+		auto* command = _debrisCommands.emplace_back(std::make_unique<RenderCommand>()).get();
+		_debrisCommandsCount++;
+
+		command->SetType(RenderCommand::Type::Particle);
+
+		auto& material = command->GetMaterial();
+		material.SetBlendingEnabled(true);
+		material.SetShaderProgramType(Material::ShaderProgramType::BatchedSprites);
+		material.ReserveUniformsDataMemory();
+
+		auto* textureUniform = material.Uniform(Material::TextureUniformName);
+		if (textureUniform && textureUniform->GetIntValue(0) != 0) {
+			textureUniform->SetIntValue(0); // GL_TEXTURE0
 		}
+
+		return command;
+	}
+
+	void TileMap::DebrisList::Add(const DestructibleDebris& debris)
+	{
+		PosX.push_back(debris.Pos.X);
+		PosY.push_back(debris.Pos.Y);
+		SpeedX.push_back(debris.Speed.X);
+		SpeedY.push_back(debris.Speed.Y);
+		AccelerationX.push_back(debris.Acceleration.X);
+		AccelerationY.push_back(debris.Acceleration.Y);
+		Scale.push_back(debris.Scale);
+		ScaleSpeed.push_back(debris.ScaleSpeed);
+		Angle.push_back(debris.Angle);
+		AngleSpeed.push_back(debris.AngleSpeed);
+		Alpha.push_back(debris.Alpha);
+		AlphaSpeed.push_back(debris.AlphaSpeed);
+		Time.push_back(debris.Time);
+		Flags.push_back(debris.Flags);
+
+		DebrisSprite& sprite = Sprites.emplace_back();
+		sprite.Size = debris.Size;
+		sprite.TexScaleX = debris.TexScaleX;
+		sprite.TexBiasX = debris.TexBiasX;
+		sprite.TexScaleY = debris.TexScaleY;
+		sprite.TexBiasY = debris.TexBiasY;
+		sprite.DiffuseTexture = debris.DiffuseTexture;
+		sprite.Depth = debris.Depth;
+	}
+
+	void TileMap::DebrisList::RemoveAt(std::int32_t index)
+	{
+		// Order of debris doesn't matter, so the last one is moved to the removed index
+		auto removeUnordered = [index](auto& values) {
+			values[index] = values.back();
+			values.pop_back();
+		};
+
+		for (auto* values : { &PosX, &PosY, &SpeedX, &SpeedY, &AccelerationX, &AccelerationY, &Scale, &ScaleSpeed, &Angle, &AngleSpeed, &Alpha, &AlphaSpeed, &Time }) {
+			removeUnordered(*values);
+		}
+		removeUnordered(Flags);
+		removeUnordered(Sprites);
 	}
 
 	bool TileMap::GetTrigger(std::uint8_t triggerId)
@@ -1423,6 +1865,7 @@ namespace Jazz2::Tiles
 					tile.DestructFrameIndex = (newState ? 1 : 0);
 					tile.TileID = (newState ? 0 /*Empty*/ : tile.DestructAnimation);
 				}
+				InvalidateTileChunk(i % layoutSize.X, i / layoutSize.X);
 			}
 		}
 	}
@@ -1447,6 +1890,7 @@ namespace Jazz2::Tiles
 		Vector2i layoutSize = _layers[_sprLayerIndex].LayoutSize;
 		std::memcpy(_layers[_sprLayerIndex].Layout.get(), _sprLayerForRollback.get(), layoutSize.X * layoutSize.Y * sizeof(LayerTile));
 		std::memcpy(_triggerState.data(), _triggerStateForRollback.data(), _triggerState.sizeInBytes());
+		InvalidateTileChunks();
 	}
 
 	void TileMap::InitializeFromStream(Stream& src)
@@ -1492,6 +1936,7 @@ namespace Jazz2::Tiles
 		}
 
 		src.Read(_triggerState.data(), _triggerState.sizeInBytes());
+		InvalidateTileChunks();
 	}
 
 	void TileMap::SerializeResumableToStream(Stream& dest, bool fromCheckpoint)
@@ -1563,16 +2008,12 @@ namespace Jazz2::Tiles
 		return nullptr;
 	}
 
-	std::int32_t TileMap::ResolveTileID(LayerTile& tile)
+	std::int32_t TileMap::ResolveTileID(const LayerTile& tile) const
 	{
 		std::int32_t tileId = tile.TileID;
 		if (tileId >= _animatedTilesOffset) {
-			tileId -= _animatedTilesOffset;
-			if (tileId >= (std::int32_t)_animatedTiles.size()) {
-				return 0;
-			}
-			auto& animTile = _animatedTiles[tileId];
-			tileId = animTile.Tiles[animTile.CurrentTileIdx].TileID;
+			std::uint32_t animIdx = (std::uint32_t)tileId - _animatedTilesOffset;
+			return (animIdx < _animatedTileFrames.size() ? _animatedTileFrames[animIdx] : 0);
 		}
 
 		return tileId;
@@ -310,6 +310,9 @@ namespace Jazz2::Tiles
 		void OnInitializeViewport();
 
 	private:
+		/** @brief Size of a chunk of cached static tiles */
+		static constexpr std::int32_t TileChunkSize = 16;
+
 		enum class LayerType {
 			Other,
 			Sky,
@@ -324,6 +327,65 @@ namespace Jazz2::Tiles
 			std::int32_t Count;
 		};
 
+		struct TileChunkCommand {
+			std::unique_ptr<RenderCommand> Command;
+			std::uint32_t Version;
+			std::uint32_t VertexCapacity;
+		};
+
+		// Static tiles of a chunk are cached in a single vertex buffer, other tiles are drawn separately
+		struct TileChunk {
+			SmallVector<float, 0> Vertices;
+			SmallVector<std::uint16_t, 0> DynamicTiles;
+			SmallVector<TileChunkCommand, 0> Commands;
+			TileSet* StaticTileSet;
+			std::uint32_t Version;
+			std::int32_t CommandsUsed;
+			bool IsDirty;
+		};
+
+		struct LayerChunks {
+			Vector2i Count;
+			std::unique_ptr<TileChunk[]> Chunks;
+		};
+
+		struct DebrisSprite {
+			Vector2f Size;
+			float TexScaleX;
+			float TexBiasX;
+			float TexScaleY;
+			float TexBiasY;
+			Texture* DiffuseTexture;
+			std::uint16_t Depth;
+		};
+
+		// Debris are stored as structure of arrays, so the simulation can be vectorized
+		struct DebrisList {
+			SmallVector<float, 0> PosX;
+			SmallVector<float, 0> PosY;
+			SmallVector<float, 0> SpeedX;
+			SmallVector<float, 0> SpeedY;
+			SmallVector<float, 0> AccelerationX;
+			SmallVector<float, 0> AccelerationY;
+			SmallVector<float, 0> Scale;
+			SmallVector<float, 0> ScaleSpeed;
+			SmallVector<float, 0> Angle;
+			SmallVector<float, 0> AngleSpeed;
+			SmallVector<float, 0> Alpha;
+			SmallVector<float, 0> AlphaSpeed;
+			SmallVector<float, 0> Time;
+			SmallVector<DebrisFlags, 0> Flags;
+			// Properties that are needed only for drawing
+			SmallVector<DebrisSprite, 0> Sprites;
+
+			std::int32_t GetCount() const {
+				return (std::int32_t)PosX.size();
+			}
+
+			void Add(const DestructibleDebris& debris);
+			void RemoveAt(std::int32_t index);
+		};
+
 		class TexturedBackgroundPass : public SceneNode
 		{
 			friend class TileMap;
@@ -356,15 +418,22 @@ namespace Jazz2::Tiles
 		SmallVector<TileMapLayer, 0> _layers;
 		std::unique_ptr<LayerTile[]> _sprLayerForRollback;
 		SmallVector<AnimatedTile, 0> _animatedTiles;
+		// Current frame tile ID of each animated tile, indexed by `tileId - _animatedTilesOffset`
+		SmallVector<std::int32_t, 0> _animatedTileFrames;
 		SmallVector<Vector2i, 0> _activeCollapsingTiles;
 		float _collapsingTimer;
 		std::uint32_t _animatedTilesOffset;
 		BitArray _triggerState;
 		BitArray _triggerStateForRollback;
 
-		SmallVector<DestructibleDebris, 0> _debrisList;
+		DebrisList _debrisList;
+		SmallVector<std::int32_t, 0> _visibleDebris;
+		SmallVector<std::unique_ptr<RenderCommand>, 0> _debrisCommands;
+		std::int32_t _debrisCommandsCount;
 		SmallVector<std::unique_ptr<RenderCommand>, 0> _renderCommands;
 		std::int32_t _renderCommandsCount;
+		SmallVector<LayerChunks, 0> _layerChunks;
+		SmallVector<TileChunk*, 0> _usedTileChunks;
 
 		std::int32_t _texturedBackgroundLayer;
 		TexturedBackgroundPass _texturedBackgroundPass;
@@ -372,6 +441,13 @@ namespace Jazz2::Tiles
 		void DrawLayer(RenderQueue& renderQueue, TileMapLayer& layer, const Rectf& cullingRect, Vector2f viewCenter);
 		static float TranslateCoordinate(float coordinate, float speed, float offset, std::int32_t viewSize, bool isY);
 		RenderCommand* RentRenderCommand(LayerRendererType type);
+		void DrawTile(RenderQueue& renderQueue, TileMapLayer& layer, LayerTile tile, float x, float y);
+		void DrawLayerChunks(RenderQueue& renderQueue, TileMapLayer& layer, float x1, float y1, std::int32_t firstTileX, std::int32_t firstTileY, std::int32_t tileCountX, std::int32_t tileCountY);
+		void DrawTileChunk(RenderQueue& renderQueue, TileMapLayer& layer, LayerChunks& chunks, std::int32_t cx, std::int32_t cy, float x, float y);
+		void RebuildTileChunk(TileMapLayer& layer, TileChunk& chunk, std::int32_t cx, std::int32_t cy);
+		RenderCommand* RentTileChunkCommand(TileChunk& chunk);
+		void InvalidateTileChunk(std::int32_t tx, std::int32_t ty);
+		void InvalidateTileChunks();
 
 		bool AdvanceDestructibleTileAnimation(LayerTile& tile, std::int32_t tx, std::int32_t ty, std::int32_t& amount, StringView soundName);
 		void AdvanceCollapsingTileTimers(float timeMult);
@@ -380,10 +456,11 @@ namespace Jazz2::Tiles
 
 		void UpdateDebris(float timeMult);
 		void DrawDebris(RenderQueue& renderQueue);
+		RenderCommand* RentDebrisCommand();
 
 		void RenderTexturedBackground(RenderQueue& renderQueue, const Rectf& cullingRect, Vector2f viewCenter, TileMapLayer& layer, float x, float y);
 
 		TileSet* ResolveTileSet(std::int32_t& tileId);
-		std::int32_t ResolveTileID(LayerTile& tile);
+		std::int32_t ResolveTileID(const LayerTile& tile) const;
 	};
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 namespace Jazz2::Tiles
 {
-	TileSet::TileSet(StringView path, std::uint16_t tileCount, std::unique_ptr<Texture> textureDiffuse, std::unique_ptr<uint8_t[]> mask, std::uint32_t maskSize, std::unique_ptr<Color[]> captionTile)
+	TileSet::TileSet(StringView path, std::uint16_t tileCount, std::unique_ptr<Texture> textureDiffuse, std::unique_ptr<std::uint32_t[]> mask, std::unique_ptr<Color[]> captionTile)
 		: FilePath(path), TextureDiffuse(std::move(textureDiffuse)), _mask(std::move(mask)), _captionTile(std::move(captionTile)),
 			_isMaskEmpty(), _isMaskFilled(), _isTileFilled()
 	{
@@ -19,21 +19,17 @@ namespace Jazz2::Tiles
 		_isMaskFilled.resize(ValueInit, TileCount);
 		_isTileFilled.resize(ValueInit, TileCount);
 
-		std::uint32_t maskMaxTiles = maskSize / (DefaultTileSize * DefaultTileSize);
-
 		for (std::uint32_t i = 0; i < tileCount; i++) {
-			bool maskEmpty = true;
-			bool maskFilled = true;
-
-			if (i < maskMaxTiles) {
-				auto* maskOffset = &_mask[i * DefaultTileSize * DefaultTileSize];
-				for (std::int32_t j = 0; j < DefaultTileSize * DefaultTileSize; j++) {
-					bool masked = (maskOffset[j] > 0);
-					maskEmpty &= !masked;
-					maskFilled &= masked;
-				}
+			auto* maskOffset = &_mask[i * DefaultTileSize];
+			std::uint32_t anySet = 0;
+			std::uint32_t allSet = ~0u;
+			for (std::int32_t j = 0; j < DefaultTileSize; j++) {
+				anySet |= maskOffset[j];
+				allSet &= maskOffset[j];
 			}
 
+			bool maskEmpty = (anySet == 0);
+			bool maskFilled = (allSet == ~0u);
 			if (maskEmpty) {
 				_isMaskEmpty.set(i);
 			}
@@ -67,19 +63,24 @@ namespace Jazz2::Tiles
 			return false;
 		}
 
-		auto* maskOffset = &_mask[tileId * DefaultTileSize * DefaultTileSize];
+		auto* maskOffset = &_mask[tileId * DefaultTileSize];
 
-		bool maskEmpty = true;
-		bool maskFilled = true;
-		for (std::int32_t j = 0; j < DefaultTileSize * DefaultTileSize; j++) {
-			maskOffset[j] = tileMask[j];
-			bool masked = (tileMask[j] > 0);
-			maskEmpty &= !masked;
-			maskFilled &= masked;
+		std::uint32_t anySet = 0;
+		std::uint32_t allSet = ~0u;
+		for (std::int32_t y = 0; y < DefaultTileSize; y++) {
+			std::uint32_t row = 0;
+			for (std::int32_t x = 0; x < DefaultTileSize; x++) {
+				if (tileMask[y * DefaultTileSize + x] > 0) {
+					row |= (1u << x);
+				}
+			}
+			maskOffset[y] = row;
+			anySet |= row;
+			allSet &= row;
 		}
 
-		_isMaskEmpty.set(tileId, maskEmpty);
-		_isMaskFilled.set(tileId, maskFilled);
+		_isMaskEmpty.set(tileId, anySet == 0);
+		_isMaskFilled.set(tileId, allSet == ~0u);
 
 		return true;
 	}
@@ -23,7 +23,7 @@ namespace Jazz2::Tiles
 		/** @brief Size of a tile */
 		static constexpr std::int32_t DefaultTileSize = 32;
 
-		TileSet(StringView path, std::uint16_t tileCount, std::unique_ptr<Texture> textureDiffuse, std::unique_ptr<std::uint8_t[]> mask, std::uint32_t maskSize, std::unique_ptr<Color[]> captionTile);
+		TileSet(StringView path, std::uint16_t tileCount, std::unique_ptr<Texture> textureDiffuse, std::unique_ptr<std::uint32_t[]> mask, std::unique_ptr<Color[]> captionTile);
 
 		/** @brief Relative path to source file */
 		String FilePath;
@@ -34,14 +34,41 @@ namespace Jazz2::Tiles
 		/** @brief Number of tiles per row */
 		std::int32_t TilesPerRow;
 
-		/** @brief Returns mask for specified tile */
-		std::uint8_t* GetTileMask(std::int32_t tileId) const
+		/**
+		 * @brief Returns mask for specified tile
+		 *
+		 * The mask consists of @ref DefaultTileSize rows, each row is packed into a single word,
+		 * where bit @f$ x @f$ of the word corresponds to pixel @f$ x @f$ of the row.
+		 */
+		const std::uint32_t* GetTileMask(std::int32_t tileId) const
 		{
 			if (tileId >= TileCount) {
 				return nullptr;
 			}
 
-			return &_mask[tileId * DefaultTileSize * DefaultTileSize];
+			return &_mask[tileId * DefaultTileSize];
+		}
+
+		/** @brief Returns `true` if any pixel of the mask of a tile is set in the specified (inclusive) rectangle */
+		bool IsTileMaskSetInRect(std::int32_t tileId, std::int32_t left, std::int32_t top, std::int32_t right, std::int32_t bottom) const
+		{
+			if (tileId >= TileCount) {
+				return false;
+			}
+
+			const std::uint32_t* mask = &_mask[tileId * DefaultTileSize];
+			std::uint32_t columns = GetColumnMask(left, right);
+			std::uint32_t result = 0;
+			for (std::int32_t ry = top; ry <= bottom; ry++) {
+				result |= mask[ry];
+			}
+			return (result & columns) != 0;
+		}
+
+		/** @brief Returns a row word with all bits from @p left to @p right (inclusive) set */
+		static constexpr std::uint32_t GetColumnMask(std::int32_t left, std::int32_t right)
+		{
+			return (std::uint32_t)(((2ull << right) - 1) & ~((1ull << left) - 1));
 		}
 
 		/** @brief Returns `true` if the mask of a tile is completely empty */
@@ -86,7 +113,7 @@ namespace Jazz2::Tiles
 		bool OverrideTileMask(std::int32_t tileId, StaticArrayView<DefaultTileSize * DefaultTileSize, std::uint8_t> tileMask);
 
 	private:
-		std::unique_ptr<uint8_t[]> _mask;
+		std::unique_ptr<std::uint32_t[]> _mask;
 		std::unique_ptr<Color[]> _captionTile;
 		BitArray _isMaskEmpty;
 		BitArray _isMaskFilled;
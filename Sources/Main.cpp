@@ -46,6 +46,10 @@
 #	include "Jazz2/Multiplayer/INetworkHandler.h"
 #	include "Jazz2/Multiplayer/MpLevelHandler.h"
 #	include "Jazz2/Multiplayer/PacketTypes.h"
+#	if defined(MULTIPLAYER_BENCHMARK)
+#		include "Jazz2/Multiplayer/ContentBenchmark.h"
+#		include "Jazz2/Multiplayer/MpBenchmark.h"
+#	endif
 using namespace Jazz2::Multiplayer;
 #endif
 
@@ -90,7 +94,9 @@ public:
 
 #if defined(WITH_MULTIPLAYER)
 	static constexpr std::uint16_t MultiplayerDefaultPort = 7438;
-	static constexpr std::uint32_t MultiplayerProtocolVersion = 1;
+	static constexpr std::uint32_t MultiplayerProtocolVersion = 2;
+	// Older clients are not compatible, because actor updates use different wire format since version 2
+	static constexpr std::uint32_t MultiplayerMinProtocolVersion = 2;
 #endif
 
 	void OnPreInitialize(AppConfiguration& config) override;
@@ -153,6 +159,9 @@ private:
 #if defined(WITH_MULTIPLAYER)
 	std::unique_ptr<NetworkManager> _networkManager;
 	std::unique_ptr<Stream> _streamedAsset;
+#	if defined(MULTIPLAYER_BENCHMARK)
+	std::unique_ptr<MpBenchmark> _benchmark;
+#	endif
 #endif
 
 	void OnBeginInitialize();
@@ -172,6 +181,9 @@ private:
 #if defined(WITH_MULTIPLAYER) && defined(WITH_THREADS)
 	void RunDedicatedServer(StringView configPath);
 	void StartProcessingStdin();
+#	if defined(MULTIPLAYER_BENCHMARK)
+	void RunBenchmark(const AppConfiguration& config);
+#	endif
 #endif
 	static void WriteCacheDescriptor(StringView path, std::uint64_t currentVersion, std::int64_t animsModified);
 	static void SaveEpisodeEnd(const LevelInitialization& levelInit);
@@ -250,6 +262,20 @@ void GameEventHandler::OnPreInitialize(AppConfiguration& config)
 		config.withDebugOverlay = true;
 #endif
 	}
+
+#if defined(WITH_THREADS)
+	// Thread pool is used by parallel update of actors and by asynchronous loading of assets,
+	// without it, all assets are loaded synchronously on the main thread
+	if (PreferencesCache::EnableParallelUpdate || PreferencesCache::EnableAsyncLoading) {
+		config.withThreads = true;
+	}
+#	if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+	// Level loading benchmark compares synchronous and asynchronous loading, so worker threads are always needed
+	if (config.argc() > 0 && config.argv(0) == "/load-level"_s) {
+		config.withThreads = true;
+	}
+#	endif
+#endif
 }
 
 void GameEventHandler::OnInitialize()
@@ -293,11 +319,15 @@ void GameEventHandler::OnInitialize()
 
 #if defined(WITH_MULTIPLAYER) && defined(DEDICATED_SERVER)
 	const AppConfiguration& config = theApplication().GetAppConfiguration();
+#	if defined(MULTIPLAYER_BENCHMARK)
+	RunBenchmark(config);
+#	else
 	StringView configPath;
 	if (config.argc() > 0) {
 		configPath = config.argv(0);
 	}
 	RunDedicatedServer(configPath);
+#	endif
 #else
 #	if defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
 	const AppConfiguration& config = theApplication().GetAppConfiguration();
@@ -403,6 +433,12 @@ void GameEventHandler::OnInitialize()
 
 void GameEventHandler::OnBeginFrame()
 {
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+	if (_benchmark != nullptr) {
+		_benchmark->OnBeginTick();
+	}
+#endif
+
 	if (!_pendingCallbacks.empty()) {
 		ZoneScopedNC("Pending callbacks", 0x888888);
 
@@ -439,6 +475,8 @@ void GameEventHandler::OnBeginFrame()
 		_pendingCallbacks.clear();
 	}
 
+	ContentResolver::Get().ProcessPendingLoads();
+
 	_currentHandler->OnBeginFrame();
 }
 
@@ -454,6 +492,14 @@ void GameEventHandler::OnPostUpdate()
 			_currentHandler->OnKeyReleased(event);
 		}
 	}
+
+#if defined(WITH_MULTIPLAYER) && defined(MULTIPLAYER_BENCHMARK)
+	if (_benchmark != nullptr && !_benchmark->OnEndTick(runtime_cast<MpLevelHandler>(_currentHandler.get()))) {
+		_benchmark->PrintReport();
+		_benchmark = nullptr;
+		theApplication().Quit();
+	}
+#endif
 }
 
 void GameEventHandler::OnResizeWindow(std::int32_t width, std::int32_t height)
@@ -884,6 +930,109 @@ void GameEventHandler::RunDedicatedServer(StringView configPath)
 	}
 }
 
+#	if defined(MULTIPLAYER_BENCHMARK)
+void GameEventHandler::RunBenchmark(const AppConfiguration& config)
+{
+	constexpr std::uint32_t DefaultBotCount = 8;
+	constexpr std::uint32_t DefaultTickCount = 1800;
+	constexpr std::uint32_t DefaultRunCount = 5;
+
+	if (config.argc() < 1) {
+		fputs("Usage: " NCINE_APP " <level> [bot count] [tick count]\n"
+			"       " NCINE_APP " /load-animations [run count]\n"
+			"       " NCINE_APP " /load-level <level> [run count]\n", stdout);
+		theApplication().Quit();
+		return;
+	}
+
+	if (config.argv(0) == "/load-animations"_s) {
+		std::uint32_t runCount = DefaultRunCount;
+		if (config.argc() > 1) {
+			auto value = config.argv(1);
+			runCount = std::max(stou32(value.data(), value.size()), 1u);
+		}
+
+		WaitForVerify();
+		if (!ContentBenchmark::RunAnimations(runCount)) {
+			LOGE("Animations benchmark failed");
+		}
+		theApplication().Quit();
+		return;
+	}
+
+	if (config.argv(0) == "/load-level"_s) {
+		if (config.argc() < 2) {
+			fputs("Usage: " NCINE_APP " /load-level <level> [run count]\n", stdout);
+			theApplication().Quit();
+			return;
+		}
+
+		String levelName = config.argv(1);
+		StringUtils::lowercaseInPlace(levelName);
+		if (!levelName.contains('/')) {
+			levelName = "unknown/"_s + levelName;
+		}
+
+		std::uint32_t runCount = DefaultRunCount;
+		if (config.argc() > 2) {
+			auto value = config.argv(2);
+			runCount = std::max(stou32(value.data(), value.size()), 1u);
+		}
+
+		WaitForVerify();
+		if (!ContentBenchmark::RunLevel(levelName, runCount)) {
+			LOGE("Level loading benchmark failed");
+		}
+		theApplication().Quit();
+		return;
+	}
+
+	String levelName = config.argv(0);
+	StringUtils::lowercaseInPlace(levelName);
+	if (!levelName.contains('/')) {
+		levelName = "unknown/"_s + levelName;
+	}
+
+	std::uint32_t botCount = DefaultBotCount;
+	if (config.argc() > 1) {
+		auto value = config.argv(1);
+		botCount = std::clamp(stou32(value.data(), value.size()), 1u, NetworkManagerBase::MaxPeerCount - 1);
+	}
+	std::uint32_t tickCount = DefaultTickCount;
+	if (config.argc() > 2) {
+		auto value = config.argv(2);
+		tickCount = std::max(stou32(value.data(), value.size()), 1u);
+	}
+
+	// The server is always private and open only to bots, so the results don't depend on any configuration file
+	ServerInitialization serverInit;
+	serverInit.Configuration = NetworkManager::CreateDefaultServerConfiguration();
+	serverInit.Configuration.ServerName = "Benchmark"_s;
+	serverInit.Configuration.ServerPassword = {};
+	serverInit.Configuration.IsPrivate = true;
+	serverInit.Configuration.RequiresDiscordAuth = false;
+	serverInit.Configuration.WhitelistedUniquePlayerIDs.clear();
+	serverInit.Configuration.MaxPlayerCount = botCount;
+	serverInit.Configuration.IdleKickTimeSecs = -1;
+	serverInit.Configuration.GameMode = MpGameMode::Cooperation;
+	serverInit.Configuration.Playlist.clear();
+	serverInit.Configuration.PlaylistIndex = -1;
+	serverInit.InitialLevel.LevelName = std::move(levelName);
+	serverInit.InitialLevel.IsLocalSession = false;
+
+	WaitForVerify();
+	if (!CreateServer(std::move(serverInit))) {
+		LOGE("Benchmark cannot be started because of invalid configuration");
+		theApplication().Quit();
+		return;
+	}
+
+	constexpr std::uint64_t currentVersion = parseVersion(NCINE_VERSION_s);
+	_benchmark = std::make_unique<MpBenchmark>(_networkManager->GetServerPort(), botCount, tickCount,
+		0xDEA00000 | (MultiplayerProtocolVersion & 0x000FFFFF), currentVersion);
+}
+#	endif
+
 #	if defined(WITH_THREADS)
 void GameEventHandler::StartProcessingStdin()
 {
@@ -1008,8 +1157,9 @@ ConnectionResult GameEventHandler::OnPeerConnected(const Peer& peer, std::uint32
 	LOGI("[MP] Peer connected ({}) [{:.8x}]", NetworkManagerBase::AddressToString(peer), std::uint64_t(peer._enet));
 
 	if (_networkManager->GetState() == NetworkState::Listening) {
-		if ((clientData & 0xFFF00000) != 0xDEA00000 || (clientData & 0x000FFFFF) > MultiplayerProtocolVersion) {
-			// Connected client is newer than server, reject it
+		std::uint32_t clientVersion = (clientData & 0x000FFFFF);
+		if ((clientData & 0xFFF00000) != 0xDEA00000 || clientVersion > MultiplayerProtocolVersion || clientVersion < MultiplayerMinProtocolVersion) {
+			// Connected client is newer or too old, reject it
 			LOGI("[MP] Peer kicked ({}) [{:.8x}]: Incompatible protocol version", NetworkManagerBase::AddressToString(peer), std::uint64_t(peer._enet));
 			return Reason::IncompatibleVersion;
 		}
@@ -1136,7 +1286,7 @@ void GameEventHandler::OnPacketReceived(const Peer& peer, std::uint8_t channelId
 	if (isServer) {
 		switch ((ClientPacketType)packetType) {
 			case ClientPacketType::Ping: {
-				_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::Pong, {});
+				_networkManager->SendTo(peer, NetworkChannel::Main, (std::uint8_t)ServerPacketType::Pong, ArrayView<const std::uint8_t>{});
 				return;
 			}
 			case ClientPacketType::Auth: {
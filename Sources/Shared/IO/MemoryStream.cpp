@@ -2,6 +2,7 @@
 #include "../Containers/GrowableArray.h"
 
 #include <cstring>
+#include <utility>
 
 using namespace Death::Containers;
 
@@ -62,6 +63,13 @@ namespace Death { namespace IO {
 		_size = std::int64_t(buffer.size());
 	}
 
+	MemoryStream::MemoryStream(Array<std::uint8_t>&& buffer)
+		: _data(std::move(buffer)), _mode(AccessMode::Growable)
+	{
+		_size = std::int64_t(_data.size());
+		_pos = _size;
+	}
+
 	void MemoryStream::Dispose()
 	{
 		_size = Stream::Invalid;
@@ -167,6 +175,18 @@ namespace Death { namespace IO {
 		}
 	}
 
+	Array<std::uint8_t> MemoryStream::ReleaseBuffer()
+	{
+		if (_mode != AccessMode::Growable) {
+			return {};
+		}
+
+		_size = Stream::Invalid;
+		_pos = 0;
+		_mode = AccessMode::None;
+		return std::move(_data);
+	}
+
 	std::int64_t MemoryStream::FetchFromStream(Stream& source, std::int64_t bytesToRead)
 	{
 		std::int64_t bytesReadTotal = 0;
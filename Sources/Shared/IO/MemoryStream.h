@@ -31,6 +31,14 @@ namespace Death { namespace IO {
 		/** @overload */
 		explicit MemoryStream(Containers::InPlaceInitT, Containers::ArrayView<const std::uint8_t> buffer);
 
+		/**
+		 * @brief Construct a growable stream that takes ownership of the specified buffer
+		 *
+		 * The position is set to the end of the buffer, so the stream can be used to append data to it. If the buffer
+		 * is growable, its capacity is reused.
+		 */
+		explicit MemoryStream(Containers::Array<std::uint8_t>&& buffer);
+
 		MemoryStream(const MemoryStream&) = delete;
 		MemoryStream& operator=(const MemoryStream&) = delete;
 
@@ -48,6 +56,8 @@ namespace Death { namespace IO {
 		void ReserveCapacity(std::int64_t bytes);
 		/** @brief Copies a specified number of bytes from a source stream to the current position */
 		std::int64_t FetchFromStream(Stream& source, std::int64_t bytesToRead);
+		/** @brief Releases ownership of the underlying buffer of growable memory stream, the stream is invalid afterwards */
+		Containers::Array<std::uint8_t> ReleaseBuffer();
 
 		/** @brief Returns a pointer to underlying buffer */
 		DEATH_ALWAYS_INLINE std::uint8_t* GetBuffer() {
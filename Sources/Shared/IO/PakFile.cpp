@@ -1,6 +1,7 @@
 #include "PakFile.h"
 #include "BoundedFileStream.h"
 #include "FileSystem.h"
+#include "MemoryStream.h"
 #include "Compression/DeflateStream.h"
 #include "Compression/Lz4Stream.h"
 #include "Compression/ZstdStream.h"
@@ -61,15 +62,33 @@ namespace Death { namespace IO {
 		return xxHash3(normalizedFileName.data(), i);
 	}
 
+#if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+	class MappedFileStream : public MemoryStream
+	{
+	public:
+		MappedFileStream(std::shared_ptr<Array<char, FileSystem::MapDeleter>> mappedFile, std::uint64_t offset, std::uint32_t size);
+
+	private:
+		// Keeps the file mapped while the stream is alive
+		std::shared_ptr<Array<char, FileSystem::MapDeleter>> _mappedFile;
+	};
+
+	MappedFileStream::MappedFileStream(std::shared_ptr<Array<char, FileSystem::MapDeleter>> mappedFile, std::uint64_t offset, std::uint32_t size)
+		: MemoryStream(static_cast<const void*>(mappedFile->data() + offset), std::int64_t(size)), _mappedFile(std::move(mappedFile))
+	{
+	}
+#endif
+
 #if defined(WITH_ZLIB) || defined(WITH_MINIZ) || defined(WITH_LZ4) || defined(WITH_ZSTD)
 
 	using namespace Death::IO::Compression;
 
-	template<class T>
+	template<class T, class TInput>
 	class CompressedBoundedStream : public Stream
 	{
 	public:
-		CompressedBoundedStream(StringView path, std::uint64_t offset, std::uint32_t uncompressedSize, std::uint32_t compressedSize);
+		template<class ...Args>
+		CompressedBoundedStream(std::uint32_t uncompressedSize, std::uint32_t compressedSize, Args&&... args);
 
 		CompressedBoundedStream(const CompressedBoundedStream&) = delete;
 		CompressedBoundedStream& operator=(const CompressedBoundedStream&) = delete;
@@ -85,71 +104,72 @@ namespace Death { namespace IO {
 		std::int64_t SetSize(std::int64_t size) override;
 
 	private:
-		BoundedFileStream _underlyingStream;
+		TInput _underlyingStream;
 		T _compressedStream;
 		std::int64_t _uncompressedSize;
 	};
 
-	template<class T>
-	CompressedBoundedStream<T>::CompressedBoundedStream(StringView path, std::uint64_t offset, std::uint32_t uncompressedSize, std::uint32_t compressedSize)
-		: _underlyingStream(path, offset, compressedSize), _uncompressedSize(uncompressedSize)
+	template<class T, class TInput>
+	template<class ...Args>
+	CompressedBoundedStream<T, TInput>::CompressedBoundedStream(std::uint32_t uncompressedSize, std::uint32_t compressedSize, Args&&... args)
+		: _underlyingStream(std::forward<Args>(args)...), _uncompressedSize(uncompressedSize)
 	{
 		_compressedStream.Open(_underlyingStream, static_cast<std::int32_t>(compressedSize));
 	}
 
-	template<class T>
-	void CompressedBoundedStream<T>::Dispose()
+	template<class T, class TInput>
+	void CompressedBoundedStream<T, TInput>::Dispose()
 	{
 		_compressedStream.Dispose();
 		_underlyingStream.Dispose();
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::Seek(std::int64_t offset, SeekOrigin origin)
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::Seek(std::int64_t offset, SeekOrigin origin)
 	{
 		return _compressedStream.Seek(offset, origin);
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::GetPosition() const
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::GetPosition() const
 	{
 		return _compressedStream.GetPosition();
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::Read(void* destination, std::int64_t bytesToRead)
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::Read(void* destination, std::int64_t bytesToRead)
 	{
 		return _compressedStream.Read(destination, bytesToRead);
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::Write(const void* source, std::int64_t bytesToWrite)
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::Write(const void* source, std::int64_t bytesToWrite)
 	{
 		// Not supported
 		return Stream::Invalid;
 	}
 
-	template<class T>
-	bool CompressedBoundedStream<T>::Flush()
+	template<class T, class TInput>
+	bool CompressedBoundedStream<T, TInput>::Flush()
 	{
 		// Not supported
 		return true;
 	}
 
-	template<class T>
-	bool CompressedBoundedStream<T>::IsValid()
+	template<class T, class TInput>
+	bool CompressedBoundedStream<T, TInput>::IsValid()
 	{
 		return _underlyingStream.IsValid() && _compressedStream.IsValid();
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::GetSize() const
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::GetSize() const
 	{
 		return _uncompressedSize;
 	}
 
-	template<class T>
-	std::int64_t CompressedBoundedStream<T>::SetSize(std::int64_t size)
+	template<class T, class TInput>
+	std::int64_t CompressedBoundedStream<T, TInput>::SetSize(std::int64_t size)
 	{
 		return Stream::Invalid;
 	}
@@ -179,7 +199,17 @@ namespace Death { namespace IO {
 
 	PakFile::PakFile(StringView path)
 	{
-		std::unique_ptr<Stream> s = std::make_unique<FileStream>(path, FileAccess::Read);
+		std::unique_ptr<Stream> s;
+#if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+		// The whole file is mapped only once and shared by all opened streams, if mapping fails
+		// (e.g., not enough address space on 32-bit platforms), the file is opened again for each stream
+		auto mappedFile = fs::OpenAsMemoryMapped(path, FileAccess::Read);
+		if (mappedFile) {
+			_mappedFile = std::make_shared<Array<char, FileSystem::MapDeleter>>(std::move(*mappedFile));
+			s = std::make_unique<MemoryStream>(static_cast<const void*>(_mappedFile->data()), std::int64_t(_mappedFile->size()));
+		} else
+#endif
+		s = std::make_unique<FileStream>(path, FileAccess::Read);
 		DEATH_ASSERT(s->GetSize() > FooterSize + 8, "Invalid .pak file", );
 
 		// Header size is 18 bytes
@@ -222,6 +252,24 @@ namespace Death { namespace IO {
 		return !_path.empty();
 	}
 
+	std::int64_t PakFile::GetFileOffset(StringView path)
+	{
+		Item* foundItem = FindItem(path);
+		if (foundItem == nullptr || (foundItem->Flags & ItemFlags::Directory) == ItemFlags::Directory) {
+			return Stream::Invalid;
+		}
+		return static_cast<std::int64_t>(foundItem->Offset);
+	}
+
+	bool PakFile::IsMemoryMapped() const
+	{
+#if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+		return (_mappedFile != nullptr);
+#else
+		return false;
+#endif
+	}
+
 	bool PakFile::FileExists(StringView path)
 	{
 		Item* foundItem = FindItem(path);
@@ -247,7 +295,7 @@ namespace Death { namespace IO {
 
 		if ((foundItem->Flags & ItemFlags::DeflateCompressed) == ItemFlags::DeflateCompressed) {
 #if defined(WITH_ZLIB) || defined(WITH_MINIZ)
-			return std::make_unique<CompressedBoundedStream<DeflateStream>>(_path, foundItem->Offset, foundItem->UncompressedSize, foundItem->Size);
+			return OpenCompressedFile<DeflateStream>(*foundItem);
 #else
 #	if defined(DEATH_TRACE_VERBOSE_IO)
 			LOGE("File \"{}\" was compressed using an unsupported compression method (Deflate)", path);
@@ -258,7 +306,7 @@ namespace Death { namespace IO {
 
 		if ((foundItem->Flags & ItemFlags::Lz4Compressed) == ItemFlags::Lz4Compressed) {
 #if defined(WITH_LZ4)
-			return std::make_unique<CompressedBoundedStream<Lz4Stream>>(_path, foundItem->Offset, foundItem->UncompressedSize, foundItem->Size);
+			return OpenCompressedFile<Lz4Stream>(*foundItem);
 #else
 #	if defined(DEATH_TRACE_VERBOSE_IO)
 			LOGE("File \"{}\" was compressed using an unsupported compression method (LZ4)", path);
@@ -269,7 +317,7 @@ namespace Death { namespace IO {
 
 		if ((foundItem->Flags & ItemFlags::ZstdCompressed) == ItemFlags::ZstdCompressed) {
 #if defined(WITH_ZSTD)
-			return std::make_unique<CompressedBoundedStream<ZstdStream>>(_path, foundItem->Offset, foundItem->UncompressedSize, foundItem->Size);
+			return OpenCompressedFile<ZstdStream>(*foundItem);
 #else
 #	if defined(DEATH_TRACE_VERBOSE_IO)
 			LOGE("File \"{}\" was compressed using an unsupported compression method (Zstd)", path);
@@ -278,9 +326,34 @@ namespace Death { namespace IO {
 #endif
 		}
 
+#if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+		if (_mappedFile != nullptr) {
+			if DEATH_UNLIKELY(foundItem->Offset + foundItem->UncompressedSize > _mappedFile->size()) {
+				return nullptr;
+			}
+			// Uncompressed files are read directly from the mapped memory without any copying
+			return std::make_unique<MappedFileStream>(_mappedFile, foundItem->Offset, foundItem->UncompressedSize);
+		}
+#endif
 		return std::make_unique<BoundedFileStream>(_path, foundItem->Offset, foundItem->UncompressedSize);
 	}
 
+#if defined(WITH_ZLIB) || defined(WITH_MINIZ) || defined(WITH_LZ4) || defined(WITH_ZSTD)
+	template<class T>
+	std::unique_ptr<Stream> PakFile::OpenCompressedFile(const Item& item)
+	{
+#	if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+		if (_mappedFile != nullptr) {
+			if DEATH_UNLIKELY(item.Offset + item.Size > _mappedFile->size()) {
+				return nullptr;
+			}
+			return std::make_unique<CompressedBoundedStream<T, MappedFileStream>>(item.UncompressedSize, item.Size, _mappedFile, item.Offset, item.Size);
+		}
+#	endif
+		return std::make_unique<CompressedBoundedStream<T, BoundedFileStream>>(item.UncompressedSize, item.Size, _path, item.Offset, item.Size);
+	}
+#endif
+
 	void PakFile::ConstructsItemsFromIndex(Stream& s, Item* parentItem, bool deflateCompressed, std::uint32_t depth)
 	{
 		DEATH_ASSERT(depth < MaxDepth, "Maximum directory structure depth reached", );
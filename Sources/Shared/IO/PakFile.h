@@ -22,6 +22,10 @@ namespace Death { namespace IO {
 
 	/**
 		@brief Provides read-only access to contents of `.pak` file
+
+		If supported by the platform, the file is memory-mapped only once and all files are read directly
+		from the mapping, otherwise the `.pak` file is opened again for each file. Opened streams keep
+		the mapping alive, so they can outlive the @ref PakFile instance.
 	*/
 	class PakFile
 	{
@@ -49,6 +53,12 @@ namespace Death { namespace IO {
 		/** @brief Returns `true` if the specified path is a directory */
 		bool DirectoryExists(Containers::StringView path);
 
+		/** @brief Returns offset of the file data in the `.pak` file, or @ref Stream::Invalid if the file doesn't exist */
+		std::int64_t GetFileOffset(Containers::StringView path);
+
+		/** @brief Returns `true` if the `.pak` file is memory-mapped */
+		bool IsMemoryMapped() const;
+
 		/** @brief Opens a file stream */
 		std::unique_ptr<Stream> OpenFile(Containers::StringView path);
 
@@ -143,12 +153,17 @@ namespace Death { namespace IO {
 		Containers::String _path;
 		Containers::String _mountPoint;
 		Containers::Array<Item> _rootItems;
+#if defined(DEATH_TARGET_ANDROID) || defined(DEATH_TARGET_APPLE) || defined(DEATH_TARGET_UNIX) || (defined(DEATH_TARGET_WINDOWS) && !defined(DEATH_TARGET_WINDOWS_RT))
+		std::shared_ptr<Containers::Array<char, FileSystem::MapDeleter>> _mappedFile;
+#endif
 		bool _useHashIndex;
 
 		void ConstructsItemsFromIndex(Stream& s, Item* parentItem, bool deflateCompressed, std::uint32_t depth);
 		Containers::Array<Item>* ReadIndexFromStream(Stream& s, Item* parentItem);
 		DEATH_NEVER_INLINE Containers::Array<Item>* ReadIndexFromStreamDeflateCompressed(Stream& s, Item* parentItem);
 		Item* FindItem(Containers::StringView path);
+		template<class T>
+		std::unique_ptr<Stream> OpenCompressedFile(const Item& item);
 
 		static DEATH_ALWAYS_INLINE bool HasCompressedSize(ItemFlags itemFlags);
 	};
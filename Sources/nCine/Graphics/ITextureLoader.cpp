@@ -72,6 +72,11 @@ namespace nCine
 		return createLoader(fs::Open(path, FileAccess::Read), path);
 	}
 
+	std::unique_ptr<ITextureLoader> ITextureLoader::createFromStream(std::unique_ptr<Stream> fileHandle, const StringView path)
+	{
+		return createLoader(std::move(fileHandle), path);
+	}
+
 	std::unique_ptr<ITextureLoader> ITextureLoader::createLoader(std::unique_ptr<Stream> fileHandle, const StringView path)
 	{
 		auto extension = fs::GetExtension(path);
@@ -58,6 +58,8 @@ namespace nCine
 		//static std::unique_ptr<ITextureLoader> createFromMemory(const unsigned char* bufferPtr, unsigned long int bufferSize);
 		/// Returns the proper texture loader according to the file extension
 		static std::unique_ptr<ITextureLoader> createFromFile(const Death::Containers::StringView filename);
+		/// Returns the proper texture loader according to the path extension
+		static std::unique_ptr<ITextureLoader> createFromStream(std::unique_ptr<Death::IO::Stream> fileHandle, const Death::Containers::StringView path);
 
 	protected:
 #ifndef DOXYGEN_GENERATING_OUTPUT
@@ -48,8 +48,9 @@ namespace nCine
 			const GLenum prevPrimitive = prevCommand->GetGeometry().GetPrimitiveType();
 
 			// Should split if material sort key (that takes into account shader program, textures and blending) or primitive type differs
-			// GL_LINE_STRIP is split always, because it cannot be batched
-			const bool shouldSplit = (command->GetLowerMaterialSortKey() != prevCommand->GetLowerMaterialSortKey() || prevPrimitive != primitive || primitive == GL_LINE_STRIP);
+			// GL_LINE_STRIP is split always, because it cannot be batched, commands with disabled batching are always split too
+			const bool shouldSplit = (command->GetLowerMaterialSortKey() != prevCommand->GetLowerMaterialSortKey() || prevPrimitive != primitive || primitive == GL_LINE_STRIP ||
+				!command->IsBatchingEnabled() || !prevCommand->IsBatchingEnabled());
 
 			// Also collect the very last command if it can be batched with the previous one
 			std::uint32_t endSplit = (i == srcQueue.size() - 1 && !shouldSplit ? i + 1 : i);
@@ -9,7 +9,7 @@
 namespace nCine
 {
 	RenderCommand::RenderCommand(Type type)
-		: materialSortKey_(0), layer_(0), numInstances_(0), batchSize_(0), transformationCommitted_(false), modelMatrix_(Matrix4x4f::Identity)
+		: materialSortKey_(0), layer_(0), numInstances_(0), batchSize_(0), transformationCommitted_(false), batchingEnabled_(true), modelMatrix_(Matrix4x4f::Identity)
 #if defined(NCINE_PROFILING)
 			, type_(type)
 #endif
@@ -47,6 +47,15 @@ namespace nCine
 		inline void SetBatchSize(std::int32_t batchSize) {
 			batchSize_ = batchSize;
 		}
+		/// Returns `true` if the command can be merged with other commands into a batch
+		inline bool IsBatchingEnabled() const {
+			return batchingEnabled_;
+		}
+		/// Sets whether the command can be merged with other commands into a batch
+		/*! Batching should be disabled for commands with large geometry, because the batch copies all vertices every frame. */
+		inline void SetBatchingEnabled(bool value) {
+			batchingEnabled_ = value;
+		}
 
 		/// Returns the drawing layer for this command
 		inline std::uint16_t GetLayer() const {
@@ -153,6 +162,7 @@ namespace nCine
 		std::int32_t batchSize_;
 
 		bool transformationCommitted_;
+		bool batchingEnabled_;
 
 #if defined(NCINE_PROFILING)
 		Type type_;
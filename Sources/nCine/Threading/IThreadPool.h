@@ -2,10 +2,56 @@
 
 #include "IThreadCommand.h"
 
+#include <atomic>
 #include <memory>
 
+#include <Containers/ArrayView.h>
+#include <Containers/Function.h>
+#include <Containers/SmallVector.h>
+
+using namespace Death::Containers;
+
 namespace nCine
 {
+#ifndef DOXYGEN_GENERATING_OUTPUT
+	namespace Implementation
+	{
+		/// Shared state of a scheduled job
+		struct Job
+		{
+			Function<void()> Callback;
+			std::atomic<std::int32_t> PendingDependencies;
+			std::atomic<bool> IsCompleted;
+			std::atomic_flag ContinuationsLock = ATOMIC_FLAG_INIT;
+			SmallVector<std::shared_ptr<Job>, 0> Continuations;
+
+			Job(Function<void()>&& callback)
+				: Callback(std::move(callback)), PendingDependencies(1), IsCompleted(false) {}
+		};
+	}
+#endif
+
+	/// Handle to a job scheduled by a thread pool
+	/*! An empty handle is considered to be already completed. */
+	class JobHandle
+	{
+		friend class ThreadPool;
+
+	public:
+		JobHandle() noexcept {}
+
+		/// Returns `true` if the job has finished
+		bool IsCompleted() const noexcept {
+			return (job_ == nullptr || job_->IsCompleted.load(std::memory_order_acquire));
+		}
+
+	private:
+		std::shared_ptr<Implementation::Job> job_;
+
+		explicit JobHandle(std::shared_ptr<Implementation::Job> job) noexcept
+			: job_(std::move(job)) {}
+	};
+
 	/// Thread pool interface
 	class IThreadPool
 	{
@@ -14,16 +60,56 @@ namespace nCine
 
 		/// Enqueues a command request for a worker thread
 		virtual void EnqueueCommand(std::unique_ptr<IThreadCommand>&& threadCommand) = 0;
+
+		/// Schedules a job, which is executed after all specified dependencies are completed
+		virtual JobHandle Schedule(Function<void()>&& job, ArrayView<const JobHandle> dependencies = {}) = 0;
+		/// Schedules a job, which is executed after the specified job is completed
+		JobHandle ContinueWith(const JobHandle& handle, Function<void()>&& job) {
+			return Schedule(std::move(job), ArrayView<const JobHandle>(&handle, 1));
+		}
+		/// Blocks until the job is completed, the calling thread executes other queued jobs in the meantime
+		virtual void Wait(const JobHandle& handle) = 0;
+		/// Calls the function for all consecutive batches of the range `[0, count)` in parallel and waits for completion
+		/*! The function is called with `first` and `last` (exclusive) index of the batch, each batch except
+		 *  the last one contains exactly `batchSize` items, so `first / batchSize` can be used as batch index.
+		 *  Unlike Wait(), the calling thread doesn't execute unrelated queued jobs while waiting for the batches. */
+		virtual void ParallelFor(std::size_t count, std::size_t batchSize, Function<void(std::size_t, std::size_t)>&& body) = 0;
+		/// Returns number of worker threads
+		virtual std::uint32_t GetWorkerCount() const = 0;
 	};
 
 	inline IThreadPool::~IThreadPool() { }
 
 #ifndef DOXYGEN_GENERATING_OUTPUT
-	/// A fake thread pool which doesn't execute any commands
+	/// A fake thread pool which executes all commands and jobs immediately on the calling thread
 	class NullThreadPool : public IThreadPool
 	{
 	public:
-		void EnqueueCommand(std::unique_ptr<IThreadCommand>&& threadCommand) override { }
+		void EnqueueCommand(std::unique_ptr<IThreadCommand>&& threadCommand) override {
+			threadCommand->Execute();
+		}
+
+		JobHandle Schedule(Function<void()>&& job, ArrayView<const JobHandle> dependencies = {}) override {
+			// All dependencies are already completed, because everything is executed immediately
+			job();
+			return {};
+		}
+
+		void Wait(const JobHandle& handle) override { }
+
+		void ParallelFor(std::size_t count, std::size_t batchSize, Function<void(std::size_t, std::size_t)>&& body) override {
+			// Batches are processed serially, but they are still split, because callers can rely on batch indices
+			if (batchSize == 0) {
+				batchSize = 1;
+			}
+			for (std::size_t first = 0; first < count; first += batchSize) {
+				body(first, (count - first > batchSize ? first + batchSize : count));
+			}
+		}
+
+		std::uint32_t GetWorkerCount() const override {
+			return 0;
+		}
 	};
 #endif
-}
\ No newline at end of file
+}
@@ -3,76 +3,317 @@
 #include "ThreadPool.h"
 #include "../../Main.h"
 
+#include <algorithm>
+
 namespace nCine
 {
+	namespace
+	{
+		// Worker index of the calling thread or -1 if it's not a worker thread of the pool
+		thread_local const ThreadPool* CurrentPool = nullptr;
+		thread_local std::int32_t CurrentWorkerIndex = -1;
+
+		void LockContinuations(Implementation::Job& job)
+		{
+			while (job.ContinuationsLock.test_and_set(std::memory_order_acquire)) {
+				Thread::YieldExecution();
+			}
+		}
+
+		void UnlockContinuations(Implementation::Job& job)
+		{
+			job.ContinuationsLock.clear(std::memory_order_release);
+		}
+	}
+
 	ThreadPool::ThreadPool()
 		: ThreadPool(Thread::GetProcessorCount())
 	{
 	}
 
 	ThreadPool::ThreadPool(std::size_t numThreads)
-		: threads_(numThreads), numThreads_(numThreads)
+		: queues_(std::make_unique<JobQueue[]>(numThreads + 1)), numThreads_(numThreads), queuedJobs_(0),
+			waitingThreads_(0), shouldQuit_(false)
 	{
-		threadStruct_.queue = &queue_;
-		threadStruct_.queueMutex = &queueMutex_;
-		threadStruct_.queueCV = &queueCV_;
-		threadStruct_.shouldQuit = false;
-
-		quitMutex_.Lock();
-
+		threads_.reserve(numThreads_);
 		for (std::size_t i = 0; i < numThreads_; i++) {
-			threads_.emplace_back(WorkerFunction, &threadStruct_);
+			threads_.emplace_back([this, i]() {
+				WorkerFunction((std::int32_t)i);
+			});
 		}
 	}
 
 	ThreadPool::~ThreadPool()
 	{
-		threadStruct_.shouldQuit = true;
-		queueCV_.Broadcast();
+		sleepMutex_.Lock();
+		shouldQuit_ = true;
+		sleepCV_.Broadcast();
+		sleepMutex_.Unlock();
 
 		for (std::size_t i = 0; i < numThreads_; i++) {
 			threads_[i].Join();
 		}
+
+		// Jobs that weren't processed by workers (or if there are no workers) are executed on the calling thread,
+		// so their captured resources are released and all their continuations are executed too
+		while (std::shared_ptr<Implementation::Job> job = TryDequeue()) {
+			Execute(job);
+		}
 	}
 
 	void ThreadPool::EnqueueCommand(std::unique_ptr<IThreadCommand>&& threadCommand)
 	{
 		DEATH_ASSERT(threadCommand);
 
-		queueMutex_.Lock();
-		queue_.push_back(std::move(threadCommand));
-		queueCV_.Broadcast();
-		queueMutex_.Unlock();
+		Schedule([command = std::move(threadCommand)]() mutable {
+			command->Execute();
+		});
+	}
+
+	JobHandle ThreadPool::Schedule(Function<void()>&& job, ArrayView<const JobHandle> dependencies)
+	{
+		auto newJob = std::make_shared<Implementation::Job>(std::move(job));
+
+		for (const JobHandle& dependency : dependencies) {
+			if (dependency.job_ == nullptr) {
+				continue;
+			}
+
+			Implementation::Job& dependencyJob = *dependency.job_;
+			LockContinuations(dependencyJob);
+			if (!dependencyJob.IsCompleted.load(std::memory_order_acquire)) {
+				newJob->PendingDependencies.fetch_add(1, std::memory_order_relaxed);
+				dependencyJob.Continuations.push_back(newJob);
+			}
+			UnlockContinuations(dependencyJob);
+		}
+
+		// Release the initial reference, the job is enqueued when the last dependency is completed
+		if (newJob->PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			Enqueue(newJob);
+		}
+
+		return JobHandle(std::move(newJob));
+	}
+
+	void ThreadPool::Wait(const JobHandle& handle)
+	{
+		while (!handle.IsCompleted()) {
+			std::shared_ptr<Implementation::Job> job = TryDequeue();
+			if (job != nullptr) {
+				Execute(job);
+				continue;
+			}
+
+			// Nothing to help with, sleep until any job is completed
+			WaitForCompletion(handle, true);
+		}
+	}
+
+	void ThreadPool::ParallelFor(std::size_t count, std::size_t batchSize, Function<void(std::size_t, std::size_t)>&& body)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		batchSize = std::max(batchSize, std::size_t(1));
+		std::size_t batchCount = (count + batchSize - 1) / batchSize;
+		if (batchCount == 1 || numThreads_ == 0) {
+			// Batches are processed serially, but they are still split, because callers can rely on batch indices
+			for (std::size_t first = 0; first < count; first += batchSize) {
+				body(first, std::min(first + batchSize, count));
+			}
+			return;
+		}
+
+		// Batches are claimed dynamically, so the work is balanced even if some batches take longer
+		std::atomic<std::size_t> nextBatch(0);
+		auto processBatches = [&nextBatch, &body, count, batchSize, batchCount]() {
+			std::size_t batch;
+			while ((batch = nextBatch.fetch_add(1, std::memory_order_relaxed)) < batchCount) {
+				std::size_t first = batch * batchSize;
+				body(first, std::min(first + batchSize, count));
+			}
+		};
+
+		std::size_t helperCount = std::min(batchCount - 1, numThreads_);
+		SmallVector<JobHandle, 16> helpers;
+		helpers.reserve(helperCount);
+		for (std::size_t i = 0; i < helperCount; i++) {
+			helpers.push_back(Schedule(processBatches));
+		}
+
+		processBatches();
+
+		// Only helpers of this call are executed while waiting, other queued jobs (e.g., loading of assets) could take
+		// much longer than the batches themselves. All batches are already claimed, so helpers that haven't started yet
+		// finish immediately and the others are only waited for.
+		for (JobHandle& helper : helpers) {
+			if (TryRemove(*helper.job_)) {
+				Execute(helper.job_);
+			} else {
+				WaitForCompletion(helper, false);
+			}
+		}
+	}
+
+	std::uint32_t ThreadPool::GetWorkerCount() const
+	{
+		return (std::uint32_t)numThreads_;
+	}
+
+	void ThreadPool::Enqueue(std::shared_ptr<Implementation::Job> job)
+	{
+		std::size_t queueIndex = (CurrentPool == this ? (std::size_t)CurrentWorkerIndex : numThreads_);
+		JobQueue& queue = queues_[queueIndex];
+
+		queue.Lock.Lock();
+		queue.Jobs.push_back(std::move(job));
+		queue.Lock.Unlock();
+
+		queuedJobs_.fetch_add(1, std::memory_order_acq_rel);
+
+		sleepMutex_.Lock();
+		sleepCV_.Signal();
+		sleepMutex_.Unlock();
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waitingThreads_.load(std::memory_order_acquire) > 0) {
+			completedMutex_.Lock();
+			completedCV_.Broadcast();
+			completedMutex_.Unlock();
+		}
+	}
+
+	std::shared_ptr<Implementation::Job> ThreadPool::TryDequeue()
+	{
+		if (queuedJobs_.load(std::memory_order_acquire) <= 0) {
+			return nullptr;
+		}
+
+		std::shared_ptr<Implementation::Job> job;
+
+		// The most recent job from the own queue is likely to have its data still in cache
+		if (CurrentPool == this) {
+			JobQueue& queue = queues_[CurrentWorkerIndex];
+			queue.Lock.Lock();
+			if (!queue.Jobs.empty()) {
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+			}
+			queue.Lock.Unlock();
+		}
+
+		// Then take the oldest job from the shared queue or steal it from other workers
+		std::size_t startIndex = (CurrentPool == this ? (std::size_t)CurrentWorkerIndex + 1 : 0);
+		for (std::size_t i = 0; i <= numThreads_ && job == nullptr; i++) {
+			JobQueue& queue = queues_[i == 0 ? numThreads_ : (startIndex + i - 1) % numThreads_];
+			queue.Lock.Lock();
+			if (!queue.Jobs.empty()) {
+				job = std::move(queue.Jobs.front());
+				queue.Jobs.pop_front();
+			}
+			queue.Lock.Unlock();
+		}
+
+		if (job != nullptr) {
+			queuedJobs_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+		return job;
+	}
+
+	bool ThreadPool::TryRemove(const Implementation::Job& job)
+	{
+		if (queuedJobs_.load(std::memory_order_acquire) <= 0) {
+			return false;
+		}
+
+		bool removed = false;
+		for (std::size_t i = 0; i <= numThreads_ && !removed; i++) {
+			JobQueue& queue = queues_[i];
+			queue.Lock.Lock();
+			for (auto it = queue.Jobs.begin(); it != queue.Jobs.end(); ++it) {
+				if (it->get() == &job) {
+					queue.Jobs.erase(it);
+					removed = true;
+					break;
+				}
+			}
+			queue.Lock.Unlock();
+		}
+
+		if (removed) {
+			queuedJobs_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+		return removed;
+	}
+
+	void ThreadPool::WaitForCompletion(const JobHandle& handle, bool wakeOnQueuedJobs)
+	{
+		completedMutex_.Lock();
+		waitingThreads_.fetch_add(1, std::memory_order_acq_rel);
+		// Pairs with the fences in Enqueue() and Execute(), so either this thread sees the change or it gets notified
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!handle.IsCompleted() && (!wakeOnQueuedJobs || queuedJobs_.load(std::memory_order_acquire) == 0)) {
+			completedCV_.Wait(completedMutex_);
+		}
+		waitingThreads_.fetch_sub(1, std::memory_order_acq_rel);
+		completedMutex_.Unlock();
+	}
+
+	void ThreadPool::Execute(std::shared_ptr<Implementation::Job>& job)
+	{
+		job->Callback();
+		// Release captured resources as soon as possible
+		job->Callback = nullptr;
+
+		LockContinuations(*job);
+		job->IsCompleted.store(true, std::memory_order_release);
+		SmallVector<std::shared_ptr<Implementation::Job>, 0> continuations = std::move(job->Continuations);
+		UnlockContinuations(*job);
+
+		for (auto& continuation : continuations) {
+			if (continuation->PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Enqueue(std::move(continuation));
+			}
+		}
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waitingThreads_.load(std::memory_order_acquire) > 0) {
+			completedMutex_.Lock();
+			completedCV_.Broadcast();
+			completedMutex_.Unlock();
+		}
 	}
 
-	void ThreadPool::WorkerFunction(void* arg)
+	void ThreadPool::WorkerFunction(std::int32_t workerIndex)
 	{
-		ThreadStruct* threadStruct = static_cast<ThreadStruct*>(arg);
+		CurrentPool = this;
+		CurrentWorkerIndex = workerIndex;
 
 		LOGD("Worker thread {} is starting", Thread::GetCurrentId());
 
 		while (true) {
-			threadStruct->queueMutex->Lock();
-			while (threadStruct->queue->empty() && !threadStruct->shouldQuit) {
-				threadStruct->queueCV->Wait(*(threadStruct->queueMutex));
+			std::shared_ptr<Implementation::Job> job = TryDequeue();
+			if (job != nullptr) {
+				Execute(job);
+				continue;
 			}
 
-			if (threadStruct->shouldQuit) {
-				threadStruct->queueMutex->Unlock();
-				break;
+			sleepMutex_.Lock();
+			while (queuedJobs_.load(std::memory_order_acquire) <= 0 && !shouldQuit_) {
+				sleepCV_.Wait(sleepMutex_);
 			}
+			bool shouldQuit = shouldQuit_;
+			sleepMutex_.Unlock();
 
-			std::unique_ptr<IThreadCommand> threadCommand = std::move(threadStruct->queue->front());
-			threadStruct->queue->pop_front();
-			threadStruct->queueMutex->Unlock();
-
-			LOGD("Worker thread {} is executing its command", Thread::GetCurrentId());
-			threadCommand->Execute();
+			if (shouldQuit) {
+				break;
+			}
 		}
 
 		LOGD("Worker thread {} is exiting", Thread::GetCurrentId());
 	}
-
 }
 
-#endif
\ No newline at end of file
+#endif
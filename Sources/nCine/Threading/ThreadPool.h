@@ -4,7 +4,7 @@
 #include "ThreadSync.h"
 #include "Thread.h"
 
-#include <list>
+#include <deque>
 
 #include <Containers/SmallVector.h>
 
@@ -12,7 +12,10 @@ using namespace Death::Containers;
 
 namespace nCine
 {
-	/// Thread pool
+	/// Work-stealing thread pool
+	/*! Each worker thread has its own queue. Jobs scheduled from a worker thread are pushed to its queue
+	 *  and processed in LIFO order, jobs scheduled from other threads are pushed to a shared queue.
+	 *  Idle workers take jobs from the shared queue first and then steal the oldest jobs from other workers. */
 	class ThreadPool : public IThreadPool
 	{
 	public:
@@ -25,31 +28,46 @@ namespace nCine
 		/// Enqueues a command request for a worker thread
 		void EnqueueCommand(std::unique_ptr<IThreadCommand>&& threadCommand) override;
 
+		JobHandle Schedule(Function<void()>&& job, ArrayView<const JobHandle> dependencies = {}) override;
+		void Wait(const JobHandle& handle) override;
+		void ParallelFor(std::size_t count, std::size_t batchSize, Function<void(std::size_t, std::size_t)>&& body) override;
+		std::uint32_t GetWorkerCount() const override;
+
 	private:
 #ifndef DOXYGEN_GENERATING_OUTPUT
 		// Doxygen 1.12.0 outputs also private structs/unions even if it shouldn't
-		struct ThreadStruct
+		struct JobQueue
 		{
-			std::list<std::unique_ptr<IThreadCommand>>* queue;
-			Mutex* queueMutex;
-			CondVariable* queueCV;
-			bool shouldQuit;
+			Mutex Lock;
+			std::deque<std::shared_ptr<Implementation::Job>> Jobs;
 		};
 #endif
 
-		std::list<std::unique_ptr<IThreadCommand>> queue_;
+		// Queues of all workers followed by the shared queue
+		std::unique_ptr<JobQueue[]> queues_;
 		SmallVector<Thread, 0> threads_;
-		Mutex queueMutex_;
-		CondVariable queueCV_;
-		Mutex quitMutex_;
 		std::size_t numThreads_;
 
-		ThreadStruct threadStruct_;
-		static void WorkerFunction(void* arg);
+		std::atomic<std::int32_t> queuedJobs_;
+		std::atomic<std::int32_t> waitingThreads_;
+		std::atomic<bool> shouldQuit_;
+		Mutex sleepMutex_;
+		CondVariable sleepCV_;
+		Mutex completedMutex_;
+		CondVariable completedCV_;
+
+		void Enqueue(std::shared_ptr<Implementation::Job> job);
+		std::shared_ptr<Implementation::Job> TryDequeue();
+		/// Removes the specified job from the queues if it hasn't been started yet
+		bool TryRemove(const Implementation::Job& job);
+		/// Blocks until the job is completed, optionally wakes up earlier if there is any queued job to help with
+		void WaitForCompletion(const JobHandle& handle, bool wakeOnQueuedJobs);
+		void Execute(std::shared_ptr<Implementation::Job>& job);
+		void WorkerFunction(std::int32_t workerIndex);
 
 		/// Deleted copy constructor
 		ThreadPool(const ThreadPool&) = delete;
 		/// Deleted assignment operator
 		ThreadPool& operator=(const ThreadPool&) = delete;
 	};
-}
\ No newline at end of file
+}
@@ -46,13 +46,10 @@ if(NOT TARGET Zstd)
 		file(GLOB DictBuilderHeaders "${ZSTD_DIR}/dictBuilder/*.h")
 		file(GLOB DeprecatedHeaders "${ZSTD_DIR}/deprecated/*.h")
 
-		set(ZSTD_SOURCES ${CommonSources} ${CompressSources} ${DecompressSources})
-		set(ZSTD_HEADERS ${PublicHeaders} ${CommonHeaders} ${CompressHeaders} ${DecompressHeaders})
+		# Dictionary builder is required by SnapshotCompressor::TrainDictionary()
+		set(ZSTD_SOURCES ${CommonSources} ${CompressSources} ${DecompressSources} ${DictBuilderSources})
+		set(ZSTD_HEADERS ${PublicHeaders} ${CommonHeaders} ${CompressHeaders} ${DecompressHeaders} ${DictBuilderHeaders})
 
-		#if (ZSTD_BUILD_DICTBUILDER)
-		#	set(ZSTD_SOURCES ${ZSTD_SOURCES} ${DictBuilderSources})
-		#	set(ZSTD_HEADERS ${ZSTD_HEADERS} ${DictBuilderHeaders})
-		#endif()
 		#if (ZSTD_BUILD_DEPRECATED)
 		#	set(ZSTD_SOURCES ${ZSTD_SOURCES} ${DeprecatedSources})
 		#	set(ZSTD_HEADERS ${ZSTD_HEADERS} ${DeprecatedHeaders})
@@ -84,7 +84,9 @@ if(WIN32)
 		endif()
 	else()
 		# Override output executable name
-		if(DEDICATED_SERVER)
+		if(MULTIPLAYER_BENCHMARK)
+			set_target_properties(${NCINE_APP} PROPERTIES OUTPUT_NAME "Jazz2.Benchmark")
+		elseif(DEDICATED_SERVER)
 			set_target_properties(${NCINE_APP} PROPERTIES OUTPUT_NAME "Jazz2.Server")
 		else()
 			set_target_properties(${NCINE_APP} PROPERTIES OUTPUT_NAME "Jazz2")
@@ -682,7 +682,11 @@ endif()
 
 if(WITH_MULTIPLAYER)
 	target_compile_definitions(${NCINE_APP} PUBLIC "WITH_MULTIPLAYER")
-	if(DEDICATED_SERVER)
+	if(MULTIPLAYER_BENCHMARK)
+		message(STATUS "Building the game with multiplayer support as headless benchmark")
+		target_compile_definitions(${NCINE_APP} PUBLIC "DEDICATED_SERVER")
+		target_compile_definitions(${NCINE_APP} PUBLIC "MULTIPLAYER_BENCHMARK")
+	elseif(DEDICATED_SERVER)
 		message(STATUS "Building the game with multiplayer support as dedicated server")
 		target_compile_definitions(${NCINE_APP} PUBLIC "DEDICATED_SERVER")
 	else()
@@ -705,10 +709,13 @@ if(WITH_MULTIPLAYER)
 		${NCINE_SOURCE_DIR}/Jazz2/Actors/Multiplayer/RemotablePlayer.h
 		${NCINE_SOURCE_DIR}/Jazz2/Actors/Multiplayer/RemoteActor.h
 		${NCINE_SOURCE_DIR}/Jazz2/Actors/Multiplayer/RemotePlayerOnServer.h
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/BitStream.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ConnectionResult.h
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ContentBenchmark.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/INetworkHandler.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/MpGameMode.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/MpLevelHandler.h
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/MpBenchmark.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/NetworkManager.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/NetworkManagerBase.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/PacketTypes.h
@@ -717,6 +724,7 @@ if(WITH_MULTIPLAYER)
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/Reason.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ServerDiscovery.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ServerInitialization.h
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/SnapshotCompressor.h
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/Backends/enet.h
 		${NCINE_SOURCE_DIR}/Jazz2/UI/Menu/CreateServerOptionsSection.h
 		${NCINE_SOURCE_DIR}/Jazz2/UI/Menu/MultiplayerGameModeSelectSection.h
@@ -735,10 +743,13 @@ if(WITH_MULTIPLAYER)
 		${NCINE_SOURCE_DIR}/Jazz2/Actors/Multiplayer/RemoteActor.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Actors/Multiplayer/RemotePlayerOnServer.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ConnectionResult.cpp
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ContentBenchmark.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/MpLevelHandler.cpp
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/MpBenchmark.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/NetworkManager.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/NetworkManagerBase.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/ServerDiscovery.cpp
+		${NCINE_SOURCE_DIR}/Jazz2/Multiplayer/SnapshotCompressor.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/UI/Menu/CreateServerOptionsSection.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/UI/Menu/MultiplayerGameModeSelectSection.cpp
 		${NCINE_SOURCE_DIR}/Jazz2/UI/Menu/PlayMultiplayerSection.cpp